@@ -0,0 +1,54 @@
+#ifndef INCLUDE_CAMERA_HPP
+#define INCLUDE_CAMERA_HPP
+
+#include <SDL.h>
+
+#include "units.hpp"
+#include "util.hpp"
+
+#include <Geometry2D/Geometry.hpp>
+
+// Where the world is seen from: the world point drawn at the top left of the screen, and how many pixels a world unit takes.
+// The default camera draws the world as it is, so examples that fit on the screen don't need one.
+class Camera {
+public:
+	Camera() = default;
+	explicit Camera(const ctp::Coord2& position, float scale=1) : position_(position), scale_(scale) {}
+	// A camera with a world point in the middle of a view of the given size.
+	static Camera centeredOn(const ctp::Coord2& center, game::Pixel viewWidth, game::Pixel viewHeight, float scale=1) {
+		return Camera(ctp::Coord2(center.x - viewWidth * 0.5f / scale, center.y - viewHeight * 0.5f / scale), scale);
+	}
+
+	const ctp::Coord2& getPosition() const { return position_; }
+	float getScale() const { return scale_; }
+	SDL_Point toScreen(const ctp::Coord2& world) const { return game::util::coord2DToSDLPoint((world - position_) * scale_); }
+	ctp::Coord2 toWorld(const SDL_Point& screen) const {
+		return ctp::Coord2(position_.x + game::util::pixelToCoord(screen.x) / scale_, position_.y + game::util::pixelToCoord(screen.y) / scale_);
+	}
+	// The part of the world a view of the given size shows.
+	ctp::Rect getView(game::Pixel viewWidth, game::Pixel viewHeight) const {
+		return ctp::Rect(position_.x, position_.y, viewWidth / scale_, viewHeight / scale_);
+	}
+
+	bool operator==(const Camera& other) const {
+		return position_.x == other.position_.x && position_.y == other.position_.y && scale_ == other.scale_;
+	}
+	bool operator!=(const Camera& other) const { return !(*this == other); }
+
+private:
+	ctp::Coord2 position_{0, 0};
+	float scale_{1};
+};
+
+// How the user has moved the view from where the example puts it: panned by a world offset, and zoomed about the middle of the screen.
+struct ViewControl {
+	ctp::Coord2 pan{0, 0};
+	float zoom{1};
+
+	// The camera for a view of the given size, centered on a world point moved by the pan.
+	Camera apply(const ctp::Coord2& center, game::Pixel viewWidth, game::Pixel viewHeight) const {
+		return Camera::centeredOn(center + pan, viewWidth, viewHeight, zoom);
+	}
+};
+
+#endif // INCLUDE_CAMERA_HPP
@@ -8,3 +8,4 @@ const Colour Colour::FUCHSIA         {255,   0, 255};
 const Colour Colour::LIGHT_BLUE      {  0, 100, 255};
 const Colour Colour::CYAN            {  0, 240, 255};
 const Colour Colour::LIGHT_GREEN     {  0, 255, 100};
+const Colour Colour::WHITE           {255, 255, 255};
@@ -12,6 +12,7 @@ struct Colour {
 	static const Colour LIGHT_BLUE;
 	static const Colour CYAN;
 	static const Colour LIGHT_GREEN;
+	static const Colour WHITE;
 
 	Uint8 r{ 0 }, g{ 0 }, b{ 0 }, a{ 255 };
 };
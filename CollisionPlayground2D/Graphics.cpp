@@ -1,136 +1,218 @@
 #include "Graphics.hpp"
 
 #include <SDL.h>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
 #include <string>
 #include <iostream>
 
+#include "SDLBackend.hpp"
 #include "util.hpp"
 
-Graphics::Graphics() : window_(nullptr), renderer_(nullptr) {}
-Graphics::~Graphics() {
-	// Free renderer and window.
-	SDL_DestroyRenderer(renderer_);
-	SDL_DestroyWindow(window_);
+namespace {
+// 3x5 glyphs, one bit per pixel: the top row is in bits 14-12, and the leftmost pixel of a row is its high bit.
+constexpr int GLYPH_WIDTH = 3;
+constexpr int GLYPH_HEIGHT = 5;
+constexpr Uint16 DIGIT_GLYPHS[10] = {0x7B6F, 0x2C97, 0x73E7, 0x73CF, 0x5BC9, 0x79CF, 0x79EF, 0x7249, 0x7BEF, 0x7BCF};
+constexpr Uint16 LETTER_GLYPHS[26] = {
+	0x2BED, 0x6BAE, 0x3923, 0x6B6E, 0x79A7, 0x79A4, 0x396B, 0x5BED, 0x7497, 0x126A, 0x5BAD, 0x4927, 0x5FED,
+	0x6B6D, 0x2B6A, 0x6BA4, 0x2B73, 0x6BAD, 0x388E, 0x7492, 0x5B6F, 0x5B6A, 0x5BFD, 0x5AAD, 0x5A92, 0x72A7,
+};
+Uint16 getGlyph(char c) {
+	if (c >= '0' && c <= '9')
+		return DIGIT_GLYPHS[c - '0'];
+	if (c >= 'A' && c <= 'Z')
+		return LETTER_GLYPHS[c - 'A'];
+	if (c >= 'a' && c <= 'z')
+		return LETTER_GLYPHS[c - 'a'];
+	switch (c) {
+	case '.': return 0x0002;
+	case ':': return 0x0410;
+	case '/': return 0x12A4;
+	case '-': return 0x01C0;
+	case '%': return 0x52A5;
+	default:  return 0; // Spaces, and anything unsupported.
+	}
+}
 }
 
+const float Graphics::LOD_POINT_SIZE = 2.0f;
+const float Graphics::LOD_BOX_SIZE = 4.0f;
+const float Graphics::LOD_EDGE_LENGTH = 4.0f;
+
+Graphics::Graphics() {}
+Graphics::~Graphics() {}
+
 bool Graphics::init(game::Pixel screenWidth, game::Pixel screenHeight) {
-	if ( !SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "1") ) { // Set to linear filtering.
-		std::cout << "Warning: Linear filtering could not be enabled.\n";
-	}
-	window_ = SDL_CreateWindow("Collision Playground 2D",
-		SDL_WINDOWPOS_UNDEFINED,
-		SDL_WINDOWPOS_UNDEFINED,
-		screenWidth,
-		screenHeight,
-		SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
-	if (!window_) {
-		std::cerr << "Error: The window could not be created.\nSDL Error: " << SDL_GetError() << "\n";
+	auto backend(std::make_unique<SDLBackend>());
+	if (!backend->init(screenWidth, screenHeight))
 		return false;
-	}
-	renderer_ = SDL_CreateRenderer(window_, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-	if (!renderer_) {
-		std::cerr << "Error: The renderer could not be created.\nSDL Error: " << SDL_GetError() << "\n";
-		return false;
-	}
-	if (SDL_SetRenderDrawBlendMode(renderer_, SDL_BLENDMODE_BLEND) != 0) {
-		std::cerr << "Warning: SDL blending could not be enabled.\n";
-	}
+	init(std::move(backend));
 	return true;
 }
+void Graphics::init(std::unique_ptr<RenderBackend> backend) {
+	backend_ = std::move(backend);
+	_update_clip();
+}
 
 void Graphics::setRenderColour(Uint8 r, Uint8 g, Uint8 b, Uint8 a) const {
-	SDL_SetRenderDrawColor(renderer_, r, g, b, a);
+	setRenderColour(Colour{r, g, b, a});
 }
 void Graphics::setRenderColour(const Colour& c) const {
-	SDL_SetRenderDrawColor(renderer_, c.r, c.g, c.b, c.a);
+	if (c.r != colour_.r || c.g != colour_.g || c.b != colour_.b || c.a != colour_.a) {
+		colour_ = c;
+		current_batch_ = NO_BATCH;
+	}
 }
 
 void Graphics::renderRect(const SDL_Rect& rect, Uint8 thickness) const {
-	std::vector<SDL_Rect> rects;
-	rects.reserve(thickness + 1);
-	rects.push_back(rect);
+	Batch& batch(_batch());
+	batch.outlines.push_back(rect);
 	for (Uint8 i = 1; i < thickness; ++i)
-		rects.push_back(SDL_Rect{rect.x+i, rect.y+i, rect.w-i*2, rect.h-i*2 });
-	SDL_RenderDrawRects(renderer_, rects.data(), rects.size());
+		batch.outlines.push_back(SDL_Rect{rect.x+i, rect.y+i, rect.w-i*2, rect.h-i*2 });
+}
+
+void Graphics::renderFilledRect(const SDL_Rect& rect) const {
+	_batch().fills.push_back(rect);
 }
 
 void Graphics::renderLine(const SDL_Point& start, const SDL_Point& end) const {
-	SDL_RenderDrawLine(renderer_, start.x, start.y, end.x, end.y);
+	_add_line(start.x, start.y, end.x, end.y);
 }
 void Graphics::renderLines(const std::vector<SDL_Point>& points) const {
-	SDL_RenderDrawLines(renderer_, points.data(), points.size());
+	for (std::size_t i = 1; i < points.size(); ++i)
+		_add_line(points[i-1].x, points[i-1].y, points[i].x, points[i].y);
 }
 void Graphics::renderRay(const SDL_Point& origin, float dirx, float diry, Uint16 length, Uint8 thickness) const {
-	std::vector<SDL_Point> points;
-	points.reserve(length/(2*thickness));
 	for (int i = 0; i < length; i+=2*thickness)
-		points.push_back(SDL_Point{ static_cast<int>(origin.x + dirx * i), static_cast<int>(origin.y + diry * i) });
-	renderPoints(points, thickness);
+		renderPoint(SDL_Point{ static_cast<int>(origin.x + dirx * i), static_cast<int>(origin.y + diry * i) }, thickness);
 }
 void Graphics::renderPoly(const std::vector<SDL_Point>& points) const {
-	std::vector<SDL_Point> drawPoints = points;
-	drawPoints.push_back(points[0]); // Duplicate the first vertex to close the shape.
-	renderLines(drawPoints);
+	if (points.empty())
+		return;
+	renderLines(points);
+	_add_line(points.back().x, points.back().y, points[0].x, points[0].y); // Close the shape.
 }
-void Graphics::renderPoint(const SDL_Point& point, Uint8 pointSize) const {
-	std::vector<SDL_Point> points;
-	const int r = static_cast<int>(pointSize) - 1;
-	const int r2 = r * r;
-	for (int i = -r; i <= r; ++i) {
-		for (int j = -r; j <= r; ++j) {
-			if (i*i + j * j <= r2) // Check if inside the circle.
-				points.push_back(SDL_Point{ point.x + i, point.y + j });
+void Graphics::renderFilledPoly(const std::vector<SDL_Point>& points) const {
+	if (points.size() < 3)
+		return;
+	int top(points[0].y), bottom(points[0].y);
+	for (const SDL_Point& p : points) {
+		top = std::min(top, p.y);
+		bottom = std::max(bottom, p.y);
+	}
+	int left(INT_MIN), right(INT_MAX);
+	if (clip_.w > 0) {
+		top = std::max(top, clip_.y);
+		bottom = std::min(bottom, clip_.y + clip_.h);
+		left = clip_.x;
+		right = clip_.x + clip_.w;
+	}
+	std::vector<SDL_Rect>& fills(_batch().fills);
+	for (int y = top; y < bottom; ++y) {
+		// Spans run between pairs of crossings, by the even-odd rule.
+		const float rowY(y + 0.5f);
+		crossings_.clear();
+		for (std::size_t i = 0, k = points.size() - 1; i < points.size(); k = i++) {
+			const SDL_Point& a(points[k]);
+			const SDL_Point& b(points[i]);
+			if ((a.y <= rowY) != (b.y <= rowY))
+				crossings_.push_back(a.x + (rowY - a.y) * (b.x - a.x) / static_cast<float>(b.y - a.y));
+		}
+		std::sort(crossings_.begin(), crossings_.end());
+		for (std::size_t i = 0; i + 1 < crossings_.size(); i += 2) {
+			const int start(std::max(static_cast<int>(std::ceil(crossings_[i] - 0.5f)), left));
+			const int end(std::min(static_cast<int>(std::ceil(crossings_[i + 1] - 0.5f)), right));
+			if (start < end)
+				fills.push_back(SDL_Rect{start, y, end - start, 1});
 		}
 	}
-	SDL_RenderDrawPoints(renderer_, points.data(), points.size());
+}
+void Graphics::renderPoint(const SDL_Point& point, Uint8 pointSize) const {
+	if (pointSize <= 1)
+		_batch().points.push_back(point);
+	else
+		_add_disc(point, static_cast<int>(pointSize) - 1);
 }
 void Graphics::renderPoints(const std::vector<SDL_Point>& points, Uint8 pointSize) const {
-	std::vector<SDL_Point> drawPoints;
-	const int r = static_cast<int>(pointSize) - 1;
-	const int r2 = r * r;
-	for (std::size_t h = 0; h < points.size(); ++h) {
-		for (int i = -r; i <= r; ++i) {
-			for (int j = -r; j <= r; ++j) {
-				if (i*i + j*j <= r2) // Check if inside the circle.
-					drawPoints.push_back(SDL_Point{ points[h].x + i, points[h].y + j });
-			}
-		}
+	if (pointSize <= 1) {
+		std::vector<SDL_Point>& batch(_batch().points);
+		batch.insert(batch.end(), points.begin(), points.end());
+		return;
 	}
-	SDL_RenderDrawPoints(renderer_, drawPoints.data(), drawPoints.size());
+	for (std::size_t h = 0; h < points.size(); ++h)
+		_add_disc(points[h], static_cast<int>(pointSize) - 1);
 }
 void Graphics::renderCircle(const SDL_Point& center, Uint16 radius, Uint8 thickness) const {
-	std::vector<SDL_Point> points;
-	int r = static_cast<int>(radius);
-	int r2 = r*r;
-	int minRad = r - static_cast<int>(thickness);
-	int minRad2 = minRad < 0 ? 0 : minRad * minRad;
-	for (int i = -r; i <= r; ++i) {
-		for (int j = -r; j <= r; ++j) {
-			const int hypotenuse2(i*i + j*j);
-			if (hypotenuse2 <= r2 && hypotenuse2 >= minRad2)
-				points.push_back(SDL_Point{ center.x + i, center.y + j });
+	_add_ring(center, static_cast<int>(radius), static_cast<int>(thickness));
+}
+game::Pixel Graphics::renderText(const SDL_Point& pos, std::string_view text, Uint8 scale) const {
+	std::vector<SDL_Rect>& fills(_batch().fills);
+	const int advance((GLYPH_WIDTH + 1) * scale);
+	for (std::size_t i = 0; i < text.size(); ++i) {
+		const Uint16 glyph(getGlyph(text[i]));
+		const int x(pos.x + static_cast<int>(i) * advance);
+		for (int row = 0; row < GLYPH_HEIGHT; ++row) {
+			const int bits((glyph >> ((GLYPH_HEIGHT - 1 - row) * GLYPH_WIDTH)) & 0x7);
+			for (int col = 0; col < GLYPH_WIDTH;) { // One rectangle per run of pixels.
+				if (!(bits & (0x4 >> col))) {
+					++col;
+					continue;
+				}
+				const int start(col);
+				while (col < GLYPH_WIDTH && (bits & (0x4 >> col)))
+					++col;
+				fills.push_back(SDL_Rect{x + start * scale, pos.y + row * scale, (col - start) * scale, scale});
+			}
 		}
 	}
-	SDL_RenderDrawPoints(renderer_, points.data(), points.size());
+	return text.empty() ? 0 : static_cast<game::Pixel>(text.size()) * advance - scale;
 }
 
 void Graphics::renderRect(const ctp::Rect& r, const ctp::Coord2& pos, Uint8 thickness) const {
-	SDL_Rect rect = { static_cast<int>(r.x+pos.x), static_cast<int>(r.y+pos.y), static_cast<int>(r.w), static_cast<int>(r.h) };
+	const float scale(camera_.getScale());
+	const ctp::Coord2 at(pos - camera_.getPosition());
+	const ctp::Coord2 low((ctp::Coord2(r.x, r.y) + at) * scale);
+	const ctp::Coord2 high(low.x + r.w * scale, low.y + r.h * scale);
+	if (_render_lod(low, high, 0)) // A box is as cheap as it gets.
+		return;
+	SDL_Rect rect = { static_cast<int>(low.x), static_cast<int>(low.y), static_cast<int>(r.w * scale), static_cast<int>(r.h * scale) };
 	renderRect(rect, thickness);
 }
 
+// Small polygons keep every stride-th vertex, so their edges stay around LOD_EDGE_LENGTH long on screen.
 void Graphics::renderPoly(const ctp::Polygon& p, const ctp::Coord2& pos) const {
-	std::vector<SDL_Point> points;
-	points.reserve(p.size() + 1);
-	for (std::size_t i = 0; i < p.size(); ++i)
-		points.push_back(game::util::coord2DToSDLPoint(p[i] + pos));
-	points.push_back(game::util::coord2DToSDLPoint(p[0] + pos)); // Close the polygon.
-	renderLines(points);
+	const std::size_t size = p.size();
+	if (size == 0)
+		return;
+	const float scale(camera_.getScale());
+	const ctp::Coord2 at(pos - camera_.getPosition());
+	ctp::Coord2 low(p[0]), high(p[0]);
+	for (std::size_t i = 1; i < size; ++i) {
+		low = ctp::Coord2(std::min(low.x, p[i].x), std::min(low.y, p[i].y));
+		high = ctp::Coord2(std::max(high.x, p[i].x), std::max(high.y, p[i].y));
+	}
+	low = (low + at) * scale;
+	high = (high + at) * scale;
+	if (_render_lod(low, high, LOD_BOX_SIZE))
+		return;
+	const std::size_t keep(std::max<std::size_t>(3, static_cast<std::size_t>(2 * ((high.x - low.x) + (high.y - low.y)) / LOD_EDGE_LENGTH)));
+	const std::size_t stride(keep >= size ? 1 : (size + keep - 1) / keep);
+	SDL_Point start(game::util::coord2DToSDLPoint((p[0] + at) * scale));
+	const SDL_Point first(start);
+	for (std::size_t i = stride; i < size; i += stride) {
+		const SDL_Point end(game::util::coord2DToSDLPoint((p[i] + at) * scale));
+		_add_line(start.x, start.y, end.x, end.y);
+		start = end;
+	}
+	_add_line(start.x, start.y, first.x, first.y); // Close the shape.
 }
 void Graphics::renderPolyVerts(const ctp::Polygon& p, const ctp::Coord2& pos, Uint8 pointSize) const {
 	const size_t size = p.size();
 	for (std::size_t i = 0; i < size; ++i)
-		renderPoint(game:: util::coord2DToSDLPoint(p[i]+pos), pointSize);
+		renderPoint(camera_.toScreen(p[i]+pos), pointSize);
 }
 void Graphics::renderPolyEdgeNormals(const ctp::Polygon& p, const ctp::Coord2& pos, Uint16 length) const {
 	const size_t size = p.size();
@@ -138,11 +220,16 @@ void Graphics::renderPolyEdgeNormals(const ctp::Polygon& p, const ctp::Coord2& p
 	for (std::size_t i = 0, k = size - 1; i < size; k = i++) {
 		const ctp::Coord2 start((p[k] + p[i] + twoPos) * 0.5f);
 		const ctp::Coord2 end(start + p.getEdgeNorm(k) * length);
-		renderLine(game::util::coord2DToSDLPoint(start), game::util::coord2DToSDLPoint(end));
+		renderLine(camera_.toScreen(start), camera_.toScreen(end));
 	}
 }
 void Graphics::renderCircle(const ctp::Circle& c, const ctp::Coord2& pos, Uint8 thickness) const {
-	renderCircle(game::util::coord2DToSDLPoint(c.center+pos), static_cast<Uint16>(c.radius), thickness);
+	const float scale(camera_.getScale());
+	const ctp::Coord2 center((c.center + pos - camera_.getPosition()) * scale);
+	const float radius(c.radius * scale);
+	if (_render_lod(ctp::Coord2(center.x - radius, center.y - radius), ctp::Coord2(center.x + radius, center.y + radius), LOD_BOX_SIZE))
+		return;
+	renderCircle(game::util::coord2DToSDLPoint(center), static_cast<Uint16>(radius), thickness);
 }
 void Graphics::renderShape(ctp::ConstShapeRef s, const ctp::Coord2& pos, Uint8 thickness) const {
 	switch (s.type()) {
@@ -160,17 +247,184 @@ void Graphics::renderShape(ctp::ConstShapeRef s, const ctp::Coord2& pos, Uint8 t
 	}
 }
 
+std::unique_ptr<RenderBackend::Target> Graphics::createRenderTarget(game::Pixel width, game::Pixel height) const {
+	return backend_->createTarget(width, height);
+}
+void Graphics::beginRenderTarget(RenderBackend::Target& target) const {
+	flush();
+	backend_->setTarget(&target);
+	backend_->setDrawColour(Colour{0, 0, 0, 0});
+	backend_->clear();
+}
+void Graphics::endRenderTarget() const {
+	flush();
+	backend_->setTarget(nullptr);
+}
+void Graphics::renderTarget(RenderBackend::Target& target) const {
+	flush();
+	++stats_.drawCalls;
+	backend_->copyTarget(target);
+}
+void Graphics::getOutputSize(game::Pixel& out_width, game::Pixel& out_height) const {
+	backend_->getOutputSize(out_width, out_height);
+}
+
 void Graphics::setWindowTitle(const std::string& text) {
-	SDL_SetWindowTitle(window_, text.data());
+	backend_->setTitle(text);
 }
 
 void Graphics::clear(const Colour& c) {
-	SDL_SetRenderDrawColor(renderer_, c.r, c.g, c.b, c.a);
-	SDL_RenderClear(renderer_);
+	flush();
+	_update_clip();
+	backend_->setDrawColour(c);
+	backend_->clear();
 }
 void Graphics::clear() {
-	SDL_RenderClear(renderer_);
+	flush();
+	_update_clip();
+	backend_->clear();
 }
 void Graphics::present() {
-	SDL_RenderPresent(renderer_);
+	flush();
+	backend_->present();
+	last_stats_ = stats_;
+	stats_ = RenderStats();
+}
+void Graphics::flush() const {
+	for (std::size_t i = 0; i < num_batches_; ++i) {
+		Batch& batch(batches_[i]);
+		backend_->setDrawColour(batch.colour);
+		if (!batch.points.empty()) {
+			backend_->drawPoints(batch.points.data(), static_cast<int>(batch.points.size()));
+			++stats_.drawCalls;
+		}
+		if (!batch.outlines.empty()) {
+			backend_->drawRects(batch.outlines.data(), static_cast<int>(batch.outlines.size()));
+			++stats_.drawCalls;
+		}
+		if (!batch.fills.empty()) {
+			backend_->fillRects(batch.fills.data(), static_cast<int>(batch.fills.size()));
+			++stats_.drawCalls;
+		}
+		stats_.primitives += batch.points.size() + batch.outlines.size() + batch.fills.size();
+		batch.points.clear();
+		batch.outlines.clear();
+		batch.fills.clear();
+	}
+	num_batches_ = 0;
+	current_batch_ = NO_BATCH;
+}
+
+Graphics::Batch& Graphics::_batch() const {
+	if (current_batch_ != NO_BATCH)
+		return batches_[current_batch_];
+	for (std::size_t i = 0; i < num_batches_; ++i) {
+		const Colour& c(batches_[i].colour);
+		if (c.r == colour_.r && c.g == colour_.g && c.b == colour_.b && c.a == colour_.a) {
+			current_batch_ = i;
+			return batches_[i];
+		}
+	}
+	if (num_batches_ == batches_.size())
+		batches_.emplace_back();
+	current_batch_ = num_batches_++;
+	batches_[current_batch_].colour = colour_;
+	return batches_[current_batch_];
+}
+void Graphics::_update_clip() {
+	game::Pixel width, height;
+	getOutputSize(width, height);
+	clip_ = SDL_Rect{0, 0, width, height};
+}
+// Bresenham's line algorithm, after clipping the line to the output.
+void Graphics::_add_line(int x0, int y0, int x1, int y1) const {
+	if (clip_.w > 0 && !SDL_IntersectRectAndLine(&clip_, &x0, &y0, &x1, &y1))
+		return;
+	std::vector<SDL_Point>& points(_batch().points);
+	const int dx(std::abs(x1 - x0)), dy(-std::abs(y1 - y0));
+	const int sx(x0 < x1 ? 1 : -1), sy(y0 < y1 ? 1 : -1);
+	int err(dx + dy);
+	for (;;) {
+		points.push_back(SDL_Point{x0, y0});
+		if (x0 == x1 && y0 == y1)
+			return;
+		const int e2(2 * err);
+		if (e2 >= dy) {
+			err += dy;
+			x0 += sx;
+		}
+		if (e2 <= dx) {
+			err += dx;
+			y0 += sy;
+		}
+	}
+}
+bool Graphics::_render_lod(const ctp::Coord2& low, const ctp::Coord2& high, float boxSize) const {
+	if (clip_.w > 0 && (high.x < clip_.x || high.y < clip_.y || low.x >= clip_.x + clip_.w || low.y >= clip_.y + clip_.h))
+		return true;
+	const float size(std::max(high.x - low.x, high.y - low.y));
+	if (size < LOD_POINT_SIZE) {
+		_batch().points.push_back(game::util::coord2DToSDLPoint((low + high) * 0.5f));
+		return true;
+	}
+	if (size < boxSize) {
+		const SDL_Point corner(game::util::coord2DToSDLPoint(low));
+		_batch().outlines.push_back(SDL_Rect{corner.x, corner.y, static_cast<int>(high.x - low.x) + 1, static_cast<int>(high.y - low.y) + 1});
+		return true;
+	}
+	return false;
+}
+// A filled disc as one horizontal span per row.
+void Graphics::_add_disc(const SDL_Point& center, int radius) const {
+	std::vector<SDL_Rect>& fills(_batch().fills);
+	const int r2(radius * radius);
+	for (int dy = -radius, halfWidth = 0; dy <= radius; ++dy) {
+		// Widest span with x*x + dy*dy <= r2, grown or shrunk from the last row's.
+		while ((halfWidth + 1) * (halfWidth + 1) + dy * dy <= r2)
+			++halfWidth;
+		while (halfWidth > 0 && halfWidth * halfWidth + dy * dy > r2)
+			--halfWidth;
+		fills.push_back(SDL_Rect{center.x - halfWidth, center.y + dy, halfWidth * 2 + 1, 1});
+	}
+}
+// A circle outline. A single pixel thick outline uses the midpoint circle algorithm. Thicker ones are drawn as two spans per row.
+void Graphics::_add_ring(const SDL_Point& center, int radius, int thickness) const {
+	if (thickness <= 1) {
+		std::vector<SDL_Point>& points(_batch().points);
+		int x(radius), y(0), err(1 - radius);
+		while (x >= y) {
+			points.push_back(SDL_Point{center.x + x, center.y + y});
+			points.push_back(SDL_Point{center.x + y, center.y + x});
+			points.push_back(SDL_Point{center.x - y, center.y + x});
+			points.push_back(SDL_Point{center.x - x, center.y + y});
+			points.push_back(SDL_Point{center.x - x, center.y - y});
+			points.push_back(SDL_Point{center.x - y, center.y - x});
+			points.push_back(SDL_Point{center.x + y, center.y - x});
+			points.push_back(SDL_Point{center.x + x, center.y - y});
+			++y;
+			if (err < 0) {
+				err += 2 * y + 1;
+			} else {
+				--x;
+				err += 2 * (y - x) + 1;
+			}
+		}
+		return;
+	}
+	std::vector<SDL_Rect>& fills(_batch().fills);
+	const int inner(std::max(radius - thickness, 0));
+	const int r2(radius * radius), inner2(inner * inner);
+	for (int dy = -radius; dy <= radius; ++dy) {
+		const int outerHalf(static_cast<int>(std::sqrt(static_cast<float>(r2 - dy * dy))));
+		if (inner2 - dy * dy <= 0) { // The row is entirely inside the ring.
+			fills.push_back(SDL_Rect{center.x - outerHalf, center.y + dy, outerHalf * 2 + 1, 1});
+			continue;
+		}
+		// Pixels closer than the inner radius are left out.
+		const int innerHalf(static_cast<int>(std::ceil(std::sqrt(static_cast<float>(inner2 - dy * dy)))));
+		if (innerHalf > outerHalf)
+			continue;
+		fills.push_back(SDL_Rect{center.x - outerHalf, center.y + dy, outerHalf - innerHalf + 1, 1});
+		fills.push_back(SDL_Rect{center.x + innerHalf, center.y + dy, outerHalf - innerHalf + 1, 1});
+	}
 }
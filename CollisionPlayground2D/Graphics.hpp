@@ -2,34 +2,64 @@
 #define INCLUDE_GRAPHICS_HPP
 
 #include <SDL.h>
+#include <memory>
 #include <vector>
 #include <string>
+#include <string_view>
 
 #include "units.hpp"
+#include "Camera.hpp"
 #include "Colour.hpp"
+#include "RenderBackend.hpp"
 
 #include <Geometry2D/Geometry.hpp>
 
+// Primitives are not drawn straight away: they are rasterized into per-colour batches, which are drawn with a few backend calls
+// when the frame is presented (or flush is called). The batches' buffers are reused, so a frame doesn't allocate once they are big enough.
+// Batches are drawn in the order their colour was first used since the last flush.
 class Graphics {
 public:
 	static const std::string DEFAULT_WINDOW_TITLE;
+	// Level of detail for shapes drawn through the camera, in screen pixels.
+	static const float LOD_POINT_SIZE;  // Shapes smaller than this are drawn as a point.
+	static const float LOD_BOX_SIZE;    // Circles and polygons smaller than this are drawn as the box around them.
+	static const float LOD_EDGE_LENGTH; // Polygons drop vertices until their edges average about this long.
+
+	struct RenderStats {
+		std::size_t drawCalls{0};  // Backend draw calls made.
+		std::size_t primitives{0}; // Points and rectangles drawn.
+	};
+
 	Graphics();
 	~Graphics();
 
-	// Initialize the Window, Renderer. Returns true on success, false if there was an error.
+	// Draw to a new window, with an SDLBackend. Returns true on success, false if there was an error.
 	bool init(game::Pixel screenWidth, game::Pixel screenHeight);
+	// Draw with another backend, e.g. a SoftwareBackend to draw without a window.
+	void init(std::unique_ptr<RenderBackend> backend);
+	RenderBackend& getBackend() const { return *backend_; }
 	// Render SDL structs.
 	void setRenderColour(Uint8 r, Uint8 g, Uint8 b, Uint8 a=255) const;
 	void setRenderColour(const Colour& c) const;
 	void renderRect(const SDL_Rect& rect, Uint8 thickness=1) const;
+	void renderFilledRect(const SDL_Rect& rect) const;
 	void renderLine(const SDL_Point& start, const SDL_Point& end) const;
 	void renderLines(const std::vector<SDL_Point>& points) const;
 	void renderRay(const SDL_Point& origin, float dirx, float diry, Uint16 length=1000, Uint8 thickness=1) const;
 	void renderPoly(const std::vector<SDL_Point>& points) const;
+	// Fill a polygon, which needn't be convex, as a span per row. Pixels whose centers are inside are filled.
+	void renderFilledPoly(const std::vector<SDL_Point>& points) const;
 	void renderPoint(const SDL_Point& point, Uint8 pointSize=1) const;
 	void renderPoints(const std::vector<SDL_Point>& points, Uint8 pointSize=1) const;
 	void renderCircle(const SDL_Point& center, Uint16 radius, Uint8 thickness=1) const;
-	// Render Geometry shapes.
+	// Render text in a built-in 3x5 pixel font, scaled up by scale. Supports letters (drawn in upper case), digits, and . : / - %.
+	// The top left of the text is at pos. Returns the width drawn.
+	game::Pixel renderText(const SDL_Point& pos, std::string_view text, Uint8 scale=1) const;
+	// Draw the shapes below as the camera sees them. Everything else is drawn in screen coordinates.
+	void setCamera(const Camera& camera) const { camera_ = camera; }
+	const Camera& getCamera() const { return camera_; }
+	// Render Geometry shapes, at world positions. Shapes that are off screen are skipped,
+	// and small ones are drawn with less detail, as set by the LOD sizes.
 	void renderRect(const ctp::Rect& r, const ctp::Coord2& pos, Uint8 thickness=1) const;
 	void renderPoly(const ctp::Polygon& p, const ctp::Coord2& pos) const;
 	void renderPolyVerts(const ctp::Polygon& p, const ctp::Coord2& pos, Uint8 pointSize=1) const;
@@ -37,15 +67,56 @@ public:
 	void renderCircle(const ctp::Circle& c, const ctp::Coord2& pos, Uint8 thickness=1) const;
 	void renderShape(ctp::ConstShapeRef s, const ctp::Coord2& pos, Uint8 thickness = 1) const;
 
+	// Render targets: textures that can be drawn into once and copied to the screen every frame.
+	// Returns nullptr if the backend doesn't support them.
+	std::unique_ptr<RenderBackend::Target> createRenderTarget(game::Pixel width, game::Pixel height) const;
+	// Draw into a render target, cleared to transparent, until endRenderTarget.
+	void beginRenderTarget(RenderBackend::Target& target) const;
+	void endRenderTarget() const;
+	void renderTarget(RenderBackend::Target& target) const;
+	void getOutputSize(game::Pixel& out_width, game::Pixel& out_height) const;
+
 	void setWindowTitle(const std::string& text);
 
 	void clear(const Colour& c);
 	void clear();
 	void present();
+	// Draw everything batched so far.
+	void flush() const;
+	// Stats for the last presented frame.
+	const RenderStats& getFrameStats() const { return last_stats_; }
 
 private:
-	SDL_Window* window_;
-	SDL_Renderer* renderer_;
+	static constexpr std::size_t NO_BATCH = ~std::size_t(0);
+
+	struct Batch {
+		Colour colour;
+		std::vector<SDL_Point> points;
+		std::vector<SDL_Rect> outlines;
+		std::vector<SDL_Rect> fills;
+	};
+
+	std::unique_ptr<RenderBackend> backend_;
+
+	mutable Colour colour_;
+	mutable Camera camera_;
+	mutable std::vector<Batch> batches_; // Only the first num_batches_ are in use this frame.
+	mutable std::size_t num_batches_{0};
+	mutable std::size_t current_batch_{NO_BATCH};
+	mutable RenderStats stats_;
+	RenderStats last_stats_;
+	SDL_Rect clip_{0, 0, 0, 0}; // Lines and filled polygons are clipped to the output.
+	mutable std::vector<float> crossings_; // Where a row crosses a filled polygon's edges.
+
+	Batch& _batch() const;
+	void _update_clip();
+	// Rasterizers.
+	void _add_line(int x0, int y0, int x1, int y1) const;
+	void _add_disc(const SDL_Point& center, int radius) const;
+	void _add_ring(const SDL_Point& center, int radius, int thickness) const;
+	// Skip a shape that is off screen, or draw one smaller than boxSize as something cheaper.
+	// low and high are the corners of the box around it, in screen pixels. Returns false if the shape should be drawn in full.
+	bool _render_lod(const ctp::Coord2& low, const ctp::Coord2& high, float boxSize) const;
 };
 
 #endif // INCLUDE_GRAPHICS_HPP
@@ -27,19 +27,31 @@ bool Input::poll() {
 void Input::clearFrame() {
 	pressed_keys_.clear();
 	released_keys_.clear();
+	events_.clear();
 }
 void Input::clear() {
 	pressed_keys_.clear();
 	released_keys_.clear();
 	held_keys_.clear();
+	events_.clear();
+}
+void Input::merge(const Input& other) {
+	held_keys_ = other.held_keys_;
+	for (const auto& key : other.pressed_keys_)
+		pressed_keys_[key.first] = pressed_keys_[key.first] || key.second;
+	for (const auto& key : other.released_keys_)
+		released_keys_[key.first] = released_keys_[key.first] || key.second;
+	events_.insert(events_.end(), other.events_.begin(), other.events_.end());
 }
 void Input::keyDownEvent(SDL_Keycode k) {
 	pressed_keys_[k] = true;
 	held_keys_[k] = true;
+	events_.push_back(KeyEvent{k, true});
 }
 void Input::keyUpEvent(SDL_Keycode k) {
 	released_keys_[k] = true;
 	held_keys_[k] = false;
+	events_.push_back(KeyEvent{k, false});
 }
 
 bool Input::isKeyHeld(SDL_Keycode k) const {
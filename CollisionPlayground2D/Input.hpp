@@ -2,10 +2,16 @@
 #define INCLUDE_INPUT_HPP
 
 #include <unordered_map>
+#include <vector>
 #include <SDL.h>
 
 class Input {
 public:
+	struct KeyEvent {
+		SDL_Keycode key;
+		bool down;
+	};
+
 	// Clear old input and poll for new input.
 	// Returns false if the window was closed, otherwise returns true.
 	bool refresh();
@@ -14,6 +20,8 @@ public:
 	void clearFrame();
 	// Clear all events.
 	void clear();
+	// Add another input's events to this one's: keys pressed or released in either count, and other's held keys replace these.
+	void merge(const Input& other);
 
 	// Poll for new input.
 	// Returns false if the window was closed, otherwise returns true.
@@ -29,11 +37,14 @@ public:
 	bool wasKeyPressed(SDL_Keycode k) const;
 	// See if a key stopped being pressed/held down.
 	bool wasKeyReleased(SDL_Keycode k) const;
+	// Key events since the frame was cleared, in order. Replaying them onto an input with the same held keys reproduces it.
+	const std::vector<KeyEvent>& getEvents() const { return events_; }
 
 private:
 	std::unordered_map<SDL_Keycode, bool> held_keys_;
 	std::unordered_map<SDL_Keycode, bool> pressed_keys_;
 	std::unordered_map<SDL_Keycode, bool> released_keys_;
+	std::vector<KeyEvent> events_;
 };
 
 #endif // INCLUDE_INPUT_HPP
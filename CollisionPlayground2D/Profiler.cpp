@@ -0,0 +1,150 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+namespace game {
+const std::int64_t Profiler::BUCKET_MIN_NS = 128;
+const std::size_t Profiler::HISTORY = 256;
+const std::size_t Profiler::MAX_TRACE_EVENTS = 1 << 20;
+
+namespace {
+constexpr const char* PHASE_NAMES[Profiler::NUM_PHASES] = {"frame", "input", "update", "collision", "draw", "present"};
+
+double nsToMillis(std::int64_t ns) {
+	return ns / 1.0e6;
+}
+}
+
+Profiler& getProfiler() {
+	static Profiler profiler;
+	return profiler;
+}
+
+const char* Profiler::getPhaseName(Phase phase) {
+	return PHASE_NAMES[static_cast<std::size_t>(phase)];
+}
+
+void Profiler::record(Phase phase, Clock::time_point start, Clock::time_point end) {
+	const std::int64_t duration(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+	const std::uint32_t thread(_thread_id());
+	std::lock_guard<std::mutex> lock(mutex_);
+	History& history(history_[static_cast<std::size_t>(phase)]);
+	if (history.samples.size() < HISTORY) {
+		history.samples.push_back(duration);
+	} else { // Overwrite the oldest sample.
+		--history.buckets[_bucket(history.samples[history.next])];
+		history.samples[history.next] = duration;
+	}
+	history.next = (history.next + 1) % HISTORY;
+	++history.buckets[_bucket(duration)];
+
+	if (!tracing_.load(std::memory_order_relaxed))
+		return;
+	if (trace_.size() >= MAX_TRACE_EVENTS) {
+		++dropped_events_;
+		return;
+	}
+	trace_.push_back(TraceEvent{phase, thread,
+		std::chrono::duration_cast<std::chrono::nanoseconds>(start - trace_start_).count(), duration});
+}
+
+void Profiler::setThreadName(const std::string& name) {
+	const std::uint32_t thread(_thread_id());
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (thread_names_.size() <= thread)
+		thread_names_.resize(thread + 1);
+	thread_names_[thread] = name;
+}
+
+void Profiler::getStats(Phase phase, PhaseStats& out) const {
+	std::vector<std::int64_t> sorted;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		const History& history(history_[static_cast<std::size_t>(phase)]);
+		sorted = history.samples;
+		out.buckets = history.buckets;
+	}
+	out.samples = sorted.size();
+	if (sorted.empty()) {
+		out.meanMS = out.p50MS = out.p99MS = out.maxMS = 0;
+		return;
+	}
+	std::sort(sorted.begin(), sorted.end());
+	std::int64_t total(0);
+	for (std::int64_t s : sorted)
+		total += s;
+	out.meanMS = nsToMillis(total) / sorted.size();
+	out.p50MS = nsToMillis(sorted[sorted.size() / 2]);
+	out.p99MS = nsToMillis(sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)]);
+	out.maxMS = nsToMillis(sorted.back());
+}
+
+void Profiler::startTrace() {
+	std::lock_guard<std::mutex> lock(mutex_);
+	trace_.clear();
+	dropped_events_ = 0;
+	trace_start_ = Clock::now();
+	tracing_.store(true, std::memory_order_relaxed);
+}
+
+bool Profiler::stopTrace(const std::string& path) {
+	std::vector<TraceEvent> events;
+	std::vector<std::string> threadNames;
+	std::size_t dropped;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		tracing_.store(false, std::memory_order_relaxed);
+		events.swap(trace_);
+		threadNames = thread_names_;
+		dropped = dropped_events_;
+	}
+	if (dropped > 0)
+		std::cerr << "Warning: The trace was full, and " << dropped << " events were dropped.\n";
+
+	std::ofstream file(path, std::ios::trunc);
+	if (!file) {
+		std::cerr << "Error: Could not create trace file \"" << path << "\".\n";
+		return false;
+	}
+	// Timestamps and durations are in microseconds.
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first(true);
+	for (std::size_t i = 0; i < threadNames.size(); ++i) {
+		if (threadNames[i].empty())
+			continue;
+		file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i
+			<< ",\"args\":{\"name\":\"" << threadNames[i] << "\"}}";
+		first = false;
+	}
+	file.setf(std::ios::fixed);
+	file.precision(3);
+	for (const TraceEvent& e : events) {
+		file << (first ? "" : ",\n") << "{\"name\":\"" << getPhaseName(e.phase) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.thread
+			<< ",\"ts\":" << e.startNS / 1.0e3 << ",\"dur\":" << e.durationNS / 1.0e3 << "}";
+		first = false;
+	}
+	file << "\n]}\n";
+	if (!file) {
+		std::cerr << "Error: Could not write trace file \"" << path << "\".\n";
+		return false;
+	}
+	std::cout << "Wrote " << events.size() << " trace events to " << path << ".\n";
+	return true;
+}
+
+std::size_t Profiler::_bucket(std::int64_t durationNS) {
+	if (durationNS <= BUCKET_MIN_NS)
+		return 0;
+	const std::size_t bucket(static_cast<std::size_t>(2.0 * std::log2(static_cast<double>(durationNS) / BUCKET_MIN_NS)));
+	return std::min(bucket, NUM_BUCKETS - 1);
+}
+
+std::uint32_t Profiler::_thread_id() {
+	static std::atomic<std::uint32_t> nextID{0};
+	thread_local const std::uint32_t id(nextID.fetch_add(1, std::memory_order_relaxed));
+	return id;
+}
+}
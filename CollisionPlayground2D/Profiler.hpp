@@ -0,0 +1,123 @@
+#ifndef INCLUDE_GAME_PROFILER_HPP
+#define INCLUDE_GAME_PROFILER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Times the phases of a frame with scoped timers. Each phase keeps its last HISTORY samples, and a histogram of them,
+// for the on-screen overlay. While a trace is being captured, every sample is also kept as a Chrome trace event
+// (viewable in chrome://tracing or Perfetto), so the render and simulation threads can be seen side by side.
+// Timers can run on any thread. Nothing is recorded until the profiler is enabled.
+
+namespace game {
+class Profiler {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	enum class Phase {
+		FRAME,     // Time between frames.
+		INPUT,     // Polling input and running commands.
+		UPDATE,    // A simulation step.
+		COLLISION, // Collision queries, within a step.
+		DRAW,
+		PRESENT,   // Flushing the frame's draw calls, and waiting on vsync.
+		NUM_PHASES,
+	};
+	static constexpr std::size_t NUM_PHASES = static_cast<std::size_t>(Phase::NUM_PHASES);
+	// Histogram buckets are half an octave wide, starting at BUCKET_MIN_NS. Longer samples go in the last bucket.
+	static constexpr std::size_t NUM_BUCKETS = 40;
+	static const std::int64_t BUCKET_MIN_NS;
+	static const std::size_t HISTORY;          // Samples kept per phase.
+	static const std::size_t MAX_TRACE_EVENTS; // A trace stops recording once it is this long.
+
+	struct PhaseStats {
+		std::size_t samples{0};
+		double meanMS{0};
+		double p50MS{0};
+		double p99MS{0};
+		double maxMS{0};
+		std::array<std::uint32_t, NUM_BUCKETS> buckets{};
+	};
+
+	Profiler() = default;
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	void setEnabled(bool enabled) { enabled_.store(enabled, std::memory_order_relaxed); }
+	bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+	void record(Phase phase, Clock::time_point start, Clock::time_point end);
+	// Name the calling thread in traces.
+	void setThreadName(const std::string& name);
+
+	// Stats over a phase's last HISTORY samples.
+	void getStats(Phase phase, PhaseStats& out) const;
+	static const char* getPhaseName(Phase phase);
+
+	// Start keeping trace events, discarding any from an earlier trace.
+	void startTrace();
+	// Stop keeping trace events, and write them to a file as Chrome trace_event JSON. Returns false (printing why) if it fails.
+	bool stopTrace(const std::string& path);
+	bool isTracing() const { return tracing_.load(std::memory_order_relaxed); }
+
+private:
+	struct History {
+		std::vector<std::int64_t> samples; // Ring buffer of durations in ns.
+		std::size_t next{0};
+		std::array<std::uint32_t, NUM_BUCKETS> buckets{};
+	};
+	struct TraceEvent {
+		Phase phase;
+		std::uint32_t thread;
+		std::int64_t startNS; // Since the trace started.
+		std::int64_t durationNS;
+	};
+
+	std::atomic<bool> enabled_{false};
+	std::atomic<bool> tracing_{false};
+
+	mutable std::mutex mutex_;
+	std::array<History, NUM_PHASES> history_;
+	std::vector<TraceEvent> trace_;
+	Clock::time_point trace_start_;
+	std::size_t dropped_events_{0};
+	std::vector<std::string> thread_names_; // Indexed by trace thread id.
+
+	static std::size_t _bucket(std::int64_t durationNS);
+	static std::uint32_t _thread_id();
+};
+
+// The profiler used by ScopedTimer.
+Profiler& getProfiler();
+
+// Records the time from its construction to its destruction (or stop) as a sample of a phase.
+class ScopedTimer {
+public:
+	explicit ScopedTimer(Profiler::Phase phase) : phase_(phase), active_(getProfiler().isEnabled()) {
+		if (active_)
+			start_ = Profiler::Clock::now();
+	}
+	~ScopedTimer() { stop(); }
+	ScopedTimer(const ScopedTimer&) = delete;
+	ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+	// Record the sample now, rather than at the end of the scope.
+	void stop() {
+		if (active_)
+			getProfiler().record(phase_, start_, Profiler::Clock::now());
+		active_ = false;
+	}
+
+private:
+	Profiler::Phase phase_;
+	bool active_;
+	Profiler::Clock::time_point start_;
+};
+}
+
+#endif // INCLUDE_GAME_PROFILER_HPP
@@ -0,0 +1,85 @@
+#include "ProfilerOverlay.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "Graphics.hpp"
+
+namespace game {
+const Pixel ProfilerOverlay::WIDTH = 152;
+const Colour ProfilerOverlay::TEXT_COLOUR = Colour::WHITE;
+const Colour ProfilerOverlay::BAR_COLOUR = Colour::YELLOW;
+const Colour ProfilerOverlay::BACKGROUND = Colour{0, 0, 0, 160};
+const MS ProfilerOverlay::REFRESH_INTERVAL = 250;
+
+namespace {
+constexpr Uint8 TEXT_SCALE = 2;
+constexpr Pixel LINE_HEIGHT = 12;
+constexpr Pixel BUCKET_WIDTH = 3;
+constexpr Pixel HISTOGRAM_HEIGHT = 16;
+constexpr Pixel PADDING = 4;
+
+// Fit a time into 4 characters.
+void formatMillis(double ms, char (&out)[8]) {
+	if (ms < 10.0)
+		std::snprintf(out, sizeof(out), "%4.2f", ms);
+	else if (ms < 100.0)
+		std::snprintf(out, sizeof(out), "%4.1f", ms);
+	else
+		std::snprintf(out, sizeof(out), "%4.0f", std::min(ms, 9999.0));
+}
+}
+
+void ProfilerOverlay::render(const Graphics& graphics, const Profiler& profiler, const SDL_Point& pos, double stepsPerSecond) {
+	if (!visible_)
+		return;
+	const Profiler::Clock::time_point now(Profiler::Clock::now());
+	if (now - last_refresh_ >= std::chrono::milliseconds(REFRESH_INTERVAL)) {
+		for (std::size_t i = 0; i < Profiler::NUM_PHASES; ++i)
+			profiler.getStats(static_cast<Profiler::Phase>(i), stats_[i]);
+		steps_per_second_ = stepsPerSecond;
+		last_refresh_ = now;
+	}
+
+	const Pixel height(LINE_HEIGHT * 3 + PADDING + static_cast<Pixel>(Profiler::NUM_PHASES) * (LINE_HEIGHT + HISTOGRAM_HEIGHT + PADDING));
+	graphics.flush(); // Make sure the background goes under the text, whatever colours were used before.
+	graphics.setRenderColour(BACKGROUND);
+	graphics.renderFilledRect(SDL_Rect{pos.x - PADDING, pos.y - PADDING, WIDTH + PADDING * 2, height + PADDING * 2});
+
+	char line[32];
+	char p50[8], p99[8];
+	const Profiler::PhaseStats& frame(stats_[static_cast<std::size_t>(Profiler::Phase::FRAME)]);
+	std::snprintf(line, sizeof(line), "FPS %-4.0f STEP/S %.0f", frame.meanMS > 0 ? 1000.0 / frame.meanMS : 0.0, steps_per_second_);
+	graphics.setRenderColour(TEXT_COLOUR);
+	graphics.renderText(pos, line, TEXT_SCALE);
+	Pixel y(pos.y + LINE_HEIGHT);
+	graphics.renderText(SDL_Point{pos.x, y}, profiler.isTracing() ? "MS TRACE  P50  P99" : "MS        P50  P99", TEXT_SCALE);
+	y += LINE_HEIGHT + PADDING;
+
+	for (std::size_t i = 0; i < Profiler::NUM_PHASES; ++i) {
+		const Profiler::PhaseStats& stats(stats_[i]);
+		formatMillis(stats.p50MS, p50);
+		formatMillis(stats.p99MS, p99);
+		std::snprintf(line, sizeof(line), "%-9s %s %s", Profiler::getPhaseName(static_cast<Profiler::Phase>(i)), p50, p99);
+		graphics.setRenderColour(TEXT_COLOUR);
+		graphics.renderText(SDL_Point{pos.x, y}, line, TEXT_SCALE);
+		y += LINE_HEIGHT;
+
+		// Histogram, scaled so the most common bucket is full height.
+		const std::uint32_t most(*std::max_element(stats.buckets.begin(), stats.buckets.end()));
+		graphics.setRenderColour(BAR_COLOUR);
+		for (std::size_t b = 0; b < Profiler::NUM_BUCKETS && most > 0; ++b) {
+			if (stats.buckets[b] == 0)
+				continue;
+			const Pixel barHeight(std::max<Pixel>(1, static_cast<Pixel>(HISTOGRAM_HEIGHT * static_cast<std::uint64_t>(stats.buckets[b]) / most)));
+			graphics.renderFilledRect(SDL_Rect{pos.x + static_cast<Pixel>(b) * BUCKET_WIDTH, y + HISTOGRAM_HEIGHT - barHeight, BUCKET_WIDTH - 1, barHeight});
+		}
+		y += HISTOGRAM_HEIGHT + PADDING;
+	}
+	// Range of the histograms' log scale.
+	std::snprintf(line, sizeof(line), "BARS %lldNS - %.0fMS",
+		static_cast<long long>(Profiler::BUCKET_MIN_NS), Profiler::BUCKET_MIN_NS * static_cast<double>(1ull << (Profiler::NUM_BUCKETS / 2)) / 1.0e6);
+	graphics.setRenderColour(TEXT_COLOUR);
+	graphics.renderText(SDL_Point{pos.x, y}, line, TEXT_SCALE);
+}
+}
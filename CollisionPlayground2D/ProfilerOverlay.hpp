@@ -0,0 +1,36 @@
+#ifndef INCLUDE_GAME_PROFILER_OVERLAY_HPP
+#define INCLUDE_GAME_PROFILER_OVERLAY_HPP
+
+#include <array>
+#include <SDL.h>
+
+#include "Colour.hpp"
+#include "Profiler.hpp"
+#include "units.hpp"
+
+class Graphics;
+namespace game {
+// Draws the profiler's phases in a column: each phase's median and 99th percentile time, over a histogram of its recent samples.
+// The numbers are refreshed a few times a second, so they can be read.
+class ProfilerOverlay {
+public:
+	static const Pixel WIDTH;
+	static const Colour TEXT_COLOUR;
+	static const Colour BAR_COLOUR;
+	static const Colour BACKGROUND;
+	static const MS REFRESH_INTERVAL;
+
+	void render(const Graphics& graphics, const Profiler& profiler, const SDL_Point& pos, double stepsPerSecond);
+
+	void toggle() { visible_ = !visible_; }
+	bool isVisible() const { return visible_; }
+
+private:
+	bool visible_{true};
+	Profiler::Clock::time_point last_refresh_;
+	std::array<Profiler::PhaseStats, Profiler::NUM_PHASES> stats_;
+	double steps_per_second_{0};
+};
+}
+
+#endif // INCLUDE_GAME_PROFILER_OVERLAY_HPP
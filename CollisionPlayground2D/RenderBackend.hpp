@@ -0,0 +1,45 @@
+#ifndef INCLUDE_RENDER_BACKEND_HPP
+#define INCLUDE_RENDER_BACKEND_HPP
+
+#include <SDL.h>
+#include <memory>
+#include <string>
+
+#include "units.hpp"
+#include "Colour.hpp"
+
+// What Graphics draws with. Graphics rasterizes every shape into points and rectangles itself, so a backend only has to
+// draw those, blending with the colour's alpha. SDLBackend draws to a window, and SoftwareBackend to memory.
+class RenderBackend {
+public:
+	// An offscreen image that can be drawn into, then copied to the output.
+	class Target {
+	public:
+		virtual ~Target() {}
+	};
+
+	virtual ~RenderBackend() {}
+
+	virtual void getOutputSize(game::Pixel& out_width, game::Pixel& out_height) const = 0;
+	virtual void setTitle(const std::string& title) = 0;
+
+	virtual void setDrawColour(const Colour& c) = 0;
+	// Set every pixel to the draw colour, without blending.
+	virtual void clear() = 0;
+	virtual void drawPoints(const SDL_Point* points, int count) = 0;
+	// Rectangle outlines, one pixel thick.
+	virtual void drawRects(const SDL_Rect* rects, int count) = 0;
+	virtual void fillRects(const SDL_Rect* rects, int count) = 0;
+
+	// Returns nullptr if the backend doesn't support targets.
+	virtual std::unique_ptr<Target> createTarget(game::Pixel width, game::Pixel height) = 0;
+	// Draw into a target, or the output if target is nullptr.
+	virtual void setTarget(Target* target) = 0;
+	// Blend a target over the whole of whatever is being drawn into, stretching it to fit.
+	virtual void copyTarget(Target& target) = 0;
+
+	// Show the frame. Backends with vsync wait for it here.
+	virtual void present() = 0;
+};
+
+#endif // INCLUDE_RENDER_BACKEND_HPP
@@ -0,0 +1,173 @@
+#include "Replay.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+namespace game {
+ReplayWriter::~ReplayWriter() {
+	close();
+}
+
+bool ReplayWriter::open(const std::string& path, std::uint32_t seed) {
+	close();
+	file_.open(path, std::ios::binary | std::ios::trunc);
+	if (!file_) {
+		std::cerr << "Error: Couldn't write recording " << path << ".\n";
+		return false;
+	}
+	file_.write(REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+	_put(REPLAY_VERSION, 4);
+	_put(seed, 4);
+	return true;
+}
+void ReplayWriter::close() {
+	if (!file_.is_open())
+		return;
+	_flush_idle();
+	file_.close();
+}
+
+void ReplayWriter::writeCommand(const ReplayRecord& command) {
+	if (!file_.is_open())
+		return;
+	_flush_idle();
+	_put(static_cast<std::uint32_t>(command.type), 1);
+	if (command.type == ReplayRecord::Type::EXAMPLE) {
+		_put(command.exampleNum, 1);
+		_put(command.broadphase, 1);
+	}
+}
+
+void ReplayWriter::writeStep(MS elapsed, const Input& input) {
+	if (!file_.is_open())
+		return;
+	elapsed = std::min<MS>(elapsed, std::numeric_limits<std::uint16_t>::max());
+	const std::vector<Input::KeyEvent>& events(input.getEvents());
+	if (events.empty()) {
+		if (idle_steps_ > 0 && (idle_elapsed_ != elapsed || idle_steps_ == std::numeric_limits<std::uint32_t>::max()))
+			_flush_idle();
+		idle_elapsed_ = elapsed;
+		++idle_steps_;
+		return;
+	}
+	_flush_idle();
+	// Real input never comes close to the count's limit. Any events past it are dropped.
+	const std::size_t numEvents(std::min<std::size_t>(events.size(), std::numeric_limits<std::uint16_t>::max()));
+	_put(static_cast<std::uint32_t>(ReplayRecord::Type::STEP), 1);
+	_put(elapsed, 2);
+	_put(static_cast<std::uint32_t>(numEvents), 2);
+	for (std::size_t i = 0; i < numEvents; ++i) {
+		_put(static_cast<std::uint32_t>(events[i].key), 4);
+		_put(events[i].down ? 1 : 0, 1);
+	}
+}
+
+void ReplayWriter::_flush_idle() {
+	if (idle_steps_ == 0)
+		return;
+	_put(static_cast<std::uint32_t>(ReplayRecord::Type::IDLE_STEPS), 1);
+	_put(idle_elapsed_, 2);
+	_put(idle_steps_, 4);
+	idle_steps_ = 0;
+}
+void ReplayWriter::_put(std::uint32_t value, std::size_t bytes) {
+	char buffer[4];
+	for (std::size_t i = 0; i < bytes; ++i)
+		buffer[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+	file_.write(buffer, static_cast<std::streamsize>(bytes));
+}
+
+bool ReplayReader::open(const std::string& path) {
+	file_.close();
+	file_.clear();
+	path_ = path;
+	idle_steps_ = 0;
+	failed_ = false;
+	file_.open(path, std::ios::binary);
+	if (!file_) {
+		std::cerr << "Error: Couldn't open recording " << path << ".\n";
+		return false;
+	}
+	char magic[sizeof(REPLAY_MAGIC)];
+	std::uint32_t version(0);
+	if (!file_.read(magic, sizeof(magic)) || std::memcmp(magic, REPLAY_MAGIC, sizeof(magic)) != 0) {
+		std::cerr << "Error: " << path << " isn't a recording.\n";
+		return false;
+	}
+	if (!_get(4, version) || version != REPLAY_VERSION) {
+		std::cerr << "Error: " << path << " is a different version of recording (" << version << ", expected " << REPLAY_VERSION << ").\n";
+		return false;
+	}
+	if (!_get(4, seed_)) {
+		std::cerr << "Error: " << path << " is cut short.\n";
+		return false;
+	}
+	return true;
+}
+
+bool ReplayReader::next(ReplayRecord& out_record) {
+	out_record.events.clear();
+	if (idle_steps_ > 0) {
+		--idle_steps_;
+		out_record.type = ReplayRecord::Type::STEP;
+		out_record.elapsed = idle_elapsed_;
+		return true;
+	}
+	std::uint32_t type;
+	if (!_get(1, type))
+		return false; // The end.
+	bool ok(true);
+	std::uint32_t a(0), b(0);
+	switch (static_cast<ReplayRecord::Type>(type)) {
+	case ReplayRecord::Type::EXAMPLE:
+		ok = _get(1, a) && _get(1, b);
+		out_record.type = ReplayRecord::Type::EXAMPLE;
+		out_record.exampleNum = static_cast<std::uint8_t>(a);
+		out_record.broadphase = static_cast<std::uint8_t>(b);
+		break;
+	case ReplayRecord::Type::RESET:
+	case ReplayRecord::Type::LOAD_SCENE:
+		out_record.type = static_cast<ReplayRecord::Type>(type);
+		break;
+	case ReplayRecord::Type::STEP:
+		ok = _get(2, a) && _get(2, b);
+		out_record.type = ReplayRecord::Type::STEP;
+		out_record.elapsed = a;
+		for (std::uint32_t i = 0; ok && i < b; ++i) {
+			std::uint32_t key(0), down(0);
+			ok = _get(4, key) && _get(1, down);
+			out_record.events.push_back(Input::KeyEvent{static_cast<SDL_Keycode>(key), down != 0});
+		}
+		break;
+	case ReplayRecord::Type::IDLE_STEPS:
+		ok = _get(2, a) && _get(4, b);
+		if (ok) {
+			idle_elapsed_ = a;
+			idle_steps_ = b;
+			return next(out_record);
+		}
+		break;
+	default:
+		std::cerr << "Error: Unknown record type " << type << " in " << path_ << ".\n";
+		failed_ = true;
+		return false;
+	}
+	if (!ok) {
+		std::cerr << "Error: " << path_ << " is cut short.\n";
+		failed_ = true;
+	}
+	return ok;
+}
+
+bool ReplayReader::_get(std::size_t bytes, std::uint32_t& out_value) {
+	unsigned char buffer[4];
+	if (!file_.read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(bytes)))
+		return false;
+	out_value = 0;
+	for (std::size_t i = 0; i < bytes; ++i)
+		out_value |= static_cast<std::uint32_t>(buffer[i]) << (8 * i);
+	return true;
+}
+}
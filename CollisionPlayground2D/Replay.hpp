@@ -0,0 +1,87 @@
+#ifndef INCLUDE_GAME_REPLAY_HPP
+#define INCLUDE_GAME_REPLAY_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Input.hpp"
+#include "units.hpp"
+
+// Recordings of everything the simulation was given, so a run can be stepped again exactly, without a window and as fast as possible.
+// A recording is the random seed, then a record for each step (its elapsed time and key events) and each command run between steps
+// (changing example, resetting, loading the scene file). Loading records that the scene file was loaded, not its contents.
+//
+// Layout, little endian: REPLAY_MAGIC, u32 version, u32 seed, then records, each a u8 type followed by:
+//   EXAMPLE    - u8 example number, u8 broadphase
+//   RESET, LOAD_SCENE - nothing
+//   STEP       - u16 elapsed ms, u16 event count, then per event: i32 key, u8 down
+//   IDLE_STEPS - u16 elapsed ms, u32 count. A run of steps with no key events, which is most of them.
+
+namespace game {
+constexpr char REPLAY_MAGIC[4] = {'C', 'P', 'R', 'P'};
+constexpr std::uint32_t REPLAY_VERSION = 1;
+
+struct ReplayRecord {
+	enum class Type : std::uint8_t {
+		EXAMPLE = 0,
+		RESET = 1,
+		LOAD_SCENE = 2,
+		STEP = 3,
+		IDLE_STEPS = 4, // Only in files. Readers give each step as a STEP.
+	};
+	Type type{Type::STEP};
+	std::uint8_t exampleNum{0}; // EXAMPLE only, as is broadphase.
+	std::uint8_t broadphase{0};
+	MS elapsed{0};              // STEP only, as are events.
+	std::vector<Input::KeyEvent> events;
+};
+
+class ReplayWriter {
+public:
+	ReplayWriter() = default;
+	~ReplayWriter();
+	ReplayWriter(const ReplayWriter&) = delete;
+	ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+	// Start a recording. Returns false (printing why) if the file can't be written.
+	bool open(const std::string& path, std::uint32_t seed);
+	void close();
+	bool isOpen() const { return file_.is_open(); }
+
+	void writeCommand(const ReplayRecord& command);
+	void writeStep(MS elapsed, const Input& input);
+
+private:
+	std::ofstream file_;
+	MS idle_elapsed_{0};
+	std::uint32_t idle_steps_{0}; // Steps with no events not yet written.
+
+	void _flush_idle();
+	void _put(std::uint32_t value, std::size_t bytes);
+};
+
+class ReplayReader {
+public:
+	// Open a recording and read its header. Returns false (printing why) if it isn't one.
+	bool open(const std::string& path);
+	std::uint32_t getSeed() const { return seed_; }
+	// Read the next record. Returns false at the end of the recording, or if it's cut short or corrupt (printing why).
+	bool next(ReplayRecord& out_record);
+	// Whether reading stopped because the recording was cut short or corrupt.
+	bool hasFailed() const { return failed_; }
+
+private:
+	std::ifstream file_;
+	std::string path_;
+	std::uint32_t seed_{0};
+	MS idle_elapsed_{0};
+	std::uint32_t idle_steps_{0}; // Steps left in the current run of idle steps.
+	bool failed_{false};
+
+	bool _get(std::size_t bytes, std::uint32_t& out_value);
+};
+}
+
+#endif // INCLUDE_GAME_REPLAY_HPP
@@ -0,0 +1,90 @@
+#include "SDLBackend.hpp"
+
+#include <SDL.h>
+#include <iostream>
+
+namespace {
+class SDLTarget : public RenderBackend::Target {
+public:
+	explicit SDLTarget(SDL_Texture* texture) : texture(texture) {}
+	~SDLTarget() override { SDL_DestroyTexture(texture); }
+
+	SDL_Texture* const texture;
+};
+}
+
+SDLBackend::SDLBackend() : window_(nullptr), renderer_(nullptr) {}
+SDLBackend::~SDLBackend() {
+	// Free renderer and window.
+	SDL_DestroyRenderer(renderer_);
+	SDL_DestroyWindow(window_);
+}
+
+bool SDLBackend::init(game::Pixel screenWidth, game::Pixel screenHeight) {
+	if ( !SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "1") ) { // Set to linear filtering.
+		std::cout << "Warning: Linear filtering could not be enabled.\n";
+	}
+	window_ = SDL_CreateWindow("Collision Playground 2D",
+		SDL_WINDOWPOS_UNDEFINED,
+		SDL_WINDOWPOS_UNDEFINED,
+		screenWidth,
+		screenHeight,
+		SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
+	if (!window_) {
+		std::cerr << "Error: The window could not be created.\nSDL Error: " << SDL_GetError() << "\n";
+		return false;
+	}
+	renderer_ = SDL_CreateRenderer(window_, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_TARGETTEXTURE);
+	if (!renderer_) {
+		std::cerr << "Error: The renderer could not be created.\nSDL Error: " << SDL_GetError() << "\n";
+		return false;
+	}
+	if (SDL_SetRenderDrawBlendMode(renderer_, SDL_BLENDMODE_BLEND) != 0) {
+		std::cerr << "Warning: SDL blending could not be enabled.\n";
+	}
+	return true;
+}
+
+void SDLBackend::getOutputSize(game::Pixel& out_width, game::Pixel& out_height) const {
+	if (!renderer_ || SDL_GetRendererOutputSize(renderer_, &out_width, &out_height) != 0)
+		out_width = out_height = 0;
+}
+void SDLBackend::setTitle(const std::string& title) {
+	SDL_SetWindowTitle(window_, title.data());
+}
+
+void SDLBackend::setDrawColour(const Colour& c) {
+	SDL_SetRenderDrawColor(renderer_, c.r, c.g, c.b, c.a);
+}
+void SDLBackend::clear() {
+	SDL_RenderClear(renderer_);
+}
+void SDLBackend::drawPoints(const SDL_Point* points, int count) {
+	SDL_RenderDrawPoints(renderer_, points, count);
+}
+void SDLBackend::drawRects(const SDL_Rect* rects, int count) {
+	SDL_RenderDrawRects(renderer_, rects, count);
+}
+void SDLBackend::fillRects(const SDL_Rect* rects, int count) {
+	SDL_RenderFillRects(renderer_, rects, count);
+}
+
+std::unique_ptr<RenderBackend::Target> SDLBackend::createTarget(game::Pixel width, game::Pixel height) {
+	SDL_Texture* texture(SDL_CreateTexture(renderer_, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height));
+	if (!texture) {
+		std::cerr << "Warning: A render target could not be created.\nSDL Error: " << SDL_GetError() << "\n";
+		return nullptr;
+	}
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+	return std::make_unique<SDLTarget>(texture);
+}
+void SDLBackend::setTarget(Target* target) {
+	SDL_SetRenderTarget(renderer_, target ? static_cast<SDLTarget*>(target)->texture : nullptr);
+}
+void SDLBackend::copyTarget(Target& target) {
+	SDL_RenderCopy(renderer_, static_cast<SDLTarget&>(target).texture, nullptr, nullptr);
+}
+
+void SDLBackend::present() {
+	SDL_RenderPresent(renderer_);
+}
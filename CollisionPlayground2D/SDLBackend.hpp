@@ -0,0 +1,39 @@
+#ifndef INCLUDE_SDL_BACKEND_HPP
+#define INCLUDE_SDL_BACKEND_HPP
+
+#include <SDL.h>
+
+#include "RenderBackend.hpp"
+
+// Draws to a window with an SDL renderer, synced to the display's refresh rate.
+class SDLBackend : public RenderBackend {
+public:
+	SDLBackend();
+	~SDLBackend() override;
+	SDLBackend(const SDLBackend&) = delete;
+	SDLBackend& operator=(const SDLBackend&) = delete;
+
+	// Create the window and renderer. Returns true on success, false if there was an error.
+	bool init(game::Pixel screenWidth, game::Pixel screenHeight);
+
+	void getOutputSize(game::Pixel& out_width, game::Pixel& out_height) const override;
+	void setTitle(const std::string& title) override;
+
+	void setDrawColour(const Colour& c) override;
+	void clear() override;
+	void drawPoints(const SDL_Point* points, int count) override;
+	void drawRects(const SDL_Rect* rects, int count) override;
+	void fillRects(const SDL_Rect* rects, int count) override;
+
+	std::unique_ptr<Target> createTarget(game::Pixel width, game::Pixel height) override;
+	void setTarget(Target* target) override;
+	void copyTarget(Target& target) override;
+
+	void present() override;
+
+private:
+	SDL_Window* window_;
+	SDL_Renderer* renderer_;
+};
+
+#endif // INCLUDE_SDL_BACKEND_HPP
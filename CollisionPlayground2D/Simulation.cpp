@@ -0,0 +1,131 @@
+#include "Simulation.hpp"
+
+#include <algorithm>
+
+#include "Graphics.hpp"
+#include "Profiler.hpp"
+
+namespace game {
+const MS Simulation::STEP = 8;
+const std::size_t Simulation::MAX_CATCH_UP = 25;
+
+Simulation::~Simulation() {
+	stop();
+}
+
+void Simulation::start() {
+	{
+		std::lock_guard<std::mutex> lock(sim_mutex_);
+		const Clock::time_point now(Clock::now());
+		next_step_ = now + std::chrono::milliseconds(STEP);
+		rate_start_ = now;
+		rate_steps_ = steps_;
+		_recapture();
+	}
+#ifndef __EMSCRIPTEN__
+	running_ = true;
+	thread_ = std::thread(&Simulation::_run, this);
+#endif
+}
+void Simulation::stop() {
+#ifndef __EMSCRIPTEN__
+	running_ = false;
+	if (thread_.joinable())
+		thread_.join();
+#endif
+}
+
+void Simulation::setRecorder(ReplayWriter* recorder) {
+	std::lock_guard<std::mutex> lock(sim_mutex_);
+	recorder_ = recorder;
+}
+
+void Simulation::setExample(const std::function<std::unique_ptr<Example>()>& makeExample, const ReplayRecord& command) {
+	std::lock_guard<std::mutex> lock(sim_mutex_);
+	if (recorder_)
+		recorder_->writeCommand(command);
+	example_.reset();
+	example_ = makeExample();
+	{
+		std::lock_guard<std::mutex> snapshotLock(snapshot_mutex_);
+		capture_ = ExampleSnapshot();
+		prev_ = ExampleSnapshot();
+		curr_ = ExampleSnapshot();
+	}
+	_recapture();
+}
+
+void Simulation::pushInput(const Input& input) {
+	std::lock_guard<std::mutex> lock(input_mutex_);
+	pending_input_.merge(input);
+}
+
+#ifdef __EMSCRIPTEN__
+void Simulation::advance() {
+	_run_due_steps();
+}
+#else
+void Simulation::_run() {
+	getProfiler().setThreadName("simulation");
+	while (running_)
+		std::this_thread::sleep_until(_run_due_steps());
+}
+#endif
+
+void Simulation::draw(const Graphics& graphics, const ViewControl& view) {
+	float alpha;
+	{
+		std::lock_guard<std::mutex> lock(snapshot_mutex_);
+		draw_prev_ = prev_;
+		draw_curr_ = curr_;
+		alpha = std::chrono::duration<float, std::milli>(Clock::now() - curr_time_).count() / STEP;
+	}
+	example_->draw(graphics, view, draw_prev_, draw_curr_, std::clamp(alpha, 0.0f, 1.0f));
+}
+
+Simulation::Clock::time_point Simulation::_run_due_steps() {
+	std::lock_guard<std::mutex> lock(sim_mutex_);
+	const Clock::time_point now(Clock::now());
+	const std::chrono::milliseconds step(STEP);
+	for (std::size_t i = 0; i < MAX_CATCH_UP && next_step_ <= now; ++i) {
+		_step(next_step_);
+		next_step_ += step;
+	}
+	if (next_step_ <= now) // Still behind: drop the lost time, rather than falling further behind trying to catch up.
+		next_step_ = now + step;
+	if (now - rate_start_ >= std::chrono::seconds(1)) {
+		steps_per_second_.store((steps_ - rate_steps_) / std::chrono::duration<double>(now - rate_start_).count(), std::memory_order_relaxed);
+		rate_start_ = now;
+		rate_steps_ = steps_;
+	}
+	return next_step_;
+}
+
+void Simulation::_step(Clock::time_point time) {
+	{
+		std::lock_guard<std::mutex> lock(input_mutex_);
+		step_input_ = pending_input_;
+		pending_input_.clearFrame();
+	}
+	if (recorder_)
+		recorder_->writeStep(STEP, step_input_);
+	{
+		ScopedTimer timer(Profiler::Phase::UPDATE);
+		example_->update(step_input_, STEP);
+		example_->capture(capture_);
+	}
+	capture_.step = ++steps_;
+	std::lock_guard<std::mutex> lock(snapshot_mutex_);
+	std::swap(prev_, curr_);
+	std::swap(curr_, capture_);
+	curr_time_ = time;
+}
+
+void Simulation::_recapture() {
+	std::lock_guard<std::mutex> lock(snapshot_mutex_);
+	example_->capture(curr_);
+	curr_.step = steps_;
+	prev_ = curr_;
+	curr_time_ = Clock::now();
+}
+}
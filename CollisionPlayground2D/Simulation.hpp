@@ -0,0 +1,127 @@
+#ifndef INCLUDE_GAME_SIMULATION_HPP
+#define INCLUDE_GAME_SIMULATION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#ifndef __EMSCRIPTEN__
+#include <thread>
+#endif
+
+#include "Input.hpp"
+#include "Replay.hpp"
+#include "units.hpp"
+
+#include "geom_examples/Example.hpp"
+#include "geom_examples/ExampleSnapshot.hpp"
+
+// Steps an example with a fixed timestep, independently of how fast frames are drawn.
+// Steps run on their own thread, and publish a snapshot after each one. The render thread draws between the last two snapshots,
+// so motion stays smooth when the frame rate and step rate differ.
+// Emscripten has no threads here: there, advance() runs the steps that are due from the main loop instead.
+// Given a recorder, every step's input and every recorded command are written in the order they run, so the run can be replayed.
+
+class Graphics;
+namespace game {
+class Simulation {
+public:
+	static const MS STEP;                   // Simulated time per step.
+	static const std::size_t MAX_CATCH_UP;  // Most steps run back to back when behind, before dropping the lost time.
+
+	Simulation() = default;
+	~Simulation();
+	Simulation(const Simulation&) = delete;
+	Simulation& operator=(const Simulation&) = delete;
+
+	// Start stepping. The example must have been set.
+	void start();
+	void stop();
+
+	// Record from the next step on. Pass nullptr to stop. The recorder is written from the simulation thread while stepping.
+	void setRecorder(ReplayWriter* recorder);
+
+	// Replace the example with one from makeExample, discarding the old one's snapshots. command is what made it, for the recording.
+	// makeExample is called between steps, after the command is recorded, as making an example may draw random numbers.
+	void setExample(const std::function<std::unique_ptr<Example>()>& makeExample, const ReplayRecord& command);
+	// Run f(Example&) between steps, e.g. to reset or load a scene. The example is recaptured afterwards.
+	template<typename Func>
+	void withExample(Func&& f);
+	// The same, recording the command first.
+	template<typename Func>
+	void withExample(const ReplayRecord& command, Func&& f);
+
+	// Hand a frame's input to the simulation. Keys pressed or released since the last step are kept until a step sees them.
+	void pushInput(const Input& input);
+
+#ifdef __EMSCRIPTEN__
+	// Run any steps that are due.
+	void advance();
+#endif
+
+	// Draw the example between the last two steps, as the view is panned and zoomed. Called on the render thread.
+	void draw(const Graphics& graphics, const ViewControl& view);
+
+	// Steps run over the last second.
+	double getStepsPerSecond() const { return steps_per_second_.load(std::memory_order_relaxed); }
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	std::unique_ptr<Example> example_;
+
+	// Guards the example while it steps.
+	std::mutex sim_mutex_;
+	Input step_input_;
+	ReplayWriter* recorder_{nullptr};
+
+	std::mutex input_mutex_;
+	Input pending_input_;
+
+	// Guards the published snapshots. capture_ is written by the simulation, then swapped in as curr_, and prev_ comes back to reuse.
+	std::mutex snapshot_mutex_;
+	ExampleSnapshot capture_, prev_, curr_;
+	Clock::time_point curr_time_;
+
+	// The render thread's copies.
+	ExampleSnapshot draw_prev_, draw_curr_;
+
+	Clock::time_point next_step_;
+	std::uint64_t steps_{0};
+	Clock::time_point rate_start_;
+	std::uint64_t rate_steps_{0};
+	std::atomic<double> steps_per_second_{0};
+
+#ifndef __EMSCRIPTEN__
+	std::thread thread_;
+	std::atomic<bool> running_{false};
+	void _run();
+#endif
+
+	// Run the steps due by now. Returns when the next one is due.
+	// Steps are timestamped with when they were due, so interpolation follows the fixed schedule rather than when the thread woke.
+	Clock::time_point _run_due_steps();
+	void _step(Clock::time_point time);
+	// Capture the example as both the previous and current snapshot, so nothing is interpolated across the change.
+	void _recapture();
+};
+
+template<typename Func>
+void Simulation::withExample(Func&& f) {
+	std::lock_guard<std::mutex> lock(sim_mutex_);
+	f(*example_);
+	_recapture();
+}
+template<typename Func>
+void Simulation::withExample(const ReplayRecord& command, Func&& f) {
+	std::lock_guard<std::mutex> lock(sim_mutex_);
+	if (recorder_)
+		recorder_->writeCommand(command);
+	f(*example_);
+	_recapture();
+}
+}
+
+#endif // INCLUDE_GAME_SIMULATION_HPP
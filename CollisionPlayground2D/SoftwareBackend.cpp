@@ -0,0 +1,247 @@
+#include "SoftwareBackend.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+namespace {
+// The same blending as SDL_BLENDMODE_BLEND.
+void blend(Colour& dst, const Colour& src) {
+	if (src.a == 255) {
+		dst = src;
+		return;
+	}
+	const unsigned a(src.a), inv(255 - src.a);
+	dst.r = static_cast<Uint8>((src.r * a + dst.r * inv + 127) / 255);
+	dst.g = static_cast<Uint8>((src.g * a + dst.g * inv + 127) / 255);
+	dst.b = static_cast<Uint8>((src.b * a + dst.b * inv + 127) / 255);
+	dst.a = static_cast<Uint8>(a + (dst.a * inv + 127) / 255);
+}
+
+bool hasExtension(const std::string& path, const std::string& ext) {
+	return path.size() >= ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+bool writePPM(std::ofstream& file, game::Pixel width, game::Pixel height, const std::vector<Colour>& pixels) {
+	file << "P6\n" << width << " " << height << "\n255\n";
+	std::vector<char> row(static_cast<std::size_t>(width) * 3);
+	for (game::Pixel y = 0; y < height; ++y) {
+		const Colour* src(&pixels[static_cast<std::size_t>(y) * width]);
+		for (game::Pixel x = 0; x < width; ++x) {
+			row[x * 3] = static_cast<char>(src[x].r);
+			row[x * 3 + 1] = static_cast<char>(src[x].g);
+			row[x * 3 + 2] = static_cast<char>(src[x].b);
+		}
+		file.write(row.data(), static_cast<std::streamsize>(row.size()));
+	}
+	return static_cast<bool>(file);
+}
+
+// PNG needs a zlib stream, but not a compressed one: the image goes in stored deflate blocks, so no zlib is needed to write it.
+std::uint32_t crc32(std::uint32_t crc, const std::uint8_t* data, std::size_t size) {
+	static const std::array<std::uint32_t, 256> TABLE = [] {
+		std::array<std::uint32_t, 256> table{};
+		for (std::uint32_t i = 0; i < 256; ++i) {
+			std::uint32_t c(i);
+			for (int k = 0; k < 8; ++k)
+				c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			table[i] = c;
+		}
+		return table;
+	}();
+	crc = ~crc;
+	for (std::size_t i = 0; i < size; ++i)
+		crc = TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+void putBigEndian(std::vector<std::uint8_t>& out, std::uint32_t value) {
+	out.push_back(static_cast<std::uint8_t>(value >> 24));
+	out.push_back(static_cast<std::uint8_t>(value >> 16));
+	out.push_back(static_cast<std::uint8_t>(value >> 8));
+	out.push_back(static_cast<std::uint8_t>(value));
+}
+void writeChunk(std::ofstream& file, const char* type, const std::vector<std::uint8_t>& data) {
+	std::vector<std::uint8_t> chunk;
+	chunk.reserve(data.size() + 12);
+	putBigEndian(chunk, static_cast<std::uint32_t>(data.size()));
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data.begin(), data.end());
+	putBigEndian(chunk, crc32(0, chunk.data() + 4, data.size() + 4)); // The type and data, not the length.
+	file.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+}
+bool writePNG(std::ofstream& file, game::Pixel width, game::Pixel height, const std::vector<Colour>& pixels) {
+	static const std::uint8_t SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	file.write(reinterpret_cast<const char*>(SIGNATURE), sizeof(SIGNATURE));
+
+	std::vector<std::uint8_t> header;
+	putBigEndian(header, static_cast<std::uint32_t>(width));
+	putBigEndian(header, static_cast<std::uint32_t>(height));
+	header.insert(header.end(), {8, 2, 0, 0, 0}); // 8 bit RGB, no interlacing.
+	writeChunk(file, "IHDR", header);
+
+	// Each row starts with its filter type, 0 for none.
+	std::vector<std::uint8_t> raw;
+	raw.reserve(static_cast<std::size_t>(height) * (width * 3 + 1));
+	for (game::Pixel y = 0; y < height; ++y) {
+		raw.push_back(0);
+		const Colour* src(&pixels[static_cast<std::size_t>(y) * width]);
+		for (game::Pixel x = 0; x < width; ++x)
+			raw.insert(raw.end(), {src[x].r, src[x].g, src[x].b});
+	}
+	constexpr std::size_t MAX_BLOCK = 65535;
+	std::vector<std::uint8_t> zlib{0x78, 0x01};
+	zlib.reserve(raw.size() + raw.size() / MAX_BLOCK * 5 + 16);
+	std::uint32_t adlerA(1), adlerB(0);
+	for (std::size_t pos = 0; pos < raw.size() || pos == 0;) {
+		const std::size_t size(std::min(MAX_BLOCK, raw.size() - pos));
+		const bool last(pos + size == raw.size());
+		zlib.insert(zlib.end(), {static_cast<std::uint8_t>(last ? 1 : 0),
+			static_cast<std::uint8_t>(size), static_cast<std::uint8_t>(size >> 8),
+			static_cast<std::uint8_t>(~size), static_cast<std::uint8_t>(~size >> 8)});
+		for (std::size_t i = pos; i < pos + size; ++i) {
+			adlerA = (adlerA + raw[i]) % 65521;
+			adlerB = (adlerB + adlerA) % 65521;
+		}
+		zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + size);
+		pos += size;
+		if (last)
+			break;
+	}
+	putBigEndian(zlib, (adlerB << 16) | adlerA);
+	writeChunk(file, "IDAT", zlib);
+	writeChunk(file, "IEND", {});
+	return static_cast<bool>(file);
+}
+}
+
+class SoftwareBackend::SurfaceTarget : public RenderBackend::Target {
+public:
+	Surface surface;
+};
+
+SoftwareBackend::SoftwareBackend(game::Pixel width, game::Pixel height)
+	: output_{width, height, std::vector<Colour>(static_cast<std::size_t>(width) * height, Colour{0, 0, 0, 255})}, surface_(&output_) {}
+
+void SoftwareBackend::getOutputSize(game::Pixel& out_width, game::Pixel& out_height) const {
+	out_width = output_.width;
+	out_height = output_.height;
+}
+
+void SoftwareBackend::clear() {
+	std::fill(surface_->pixels.begin(), surface_->pixels.end(), colour_);
+}
+void SoftwareBackend::drawPoints(const SDL_Point* points, int count) {
+	for (int i = 0; i < count; ++i) {
+		const SDL_Point& p(points[i]);
+		if (p.x >= 0 && p.y >= 0 && p.x < surface_->width && p.y < surface_->height)
+			blend(surface_->pixels[static_cast<std::size_t>(p.y) * surface_->width + p.x], colour_);
+	}
+}
+void SoftwareBackend::drawRects(const SDL_Rect* rects, int count) {
+	for (int i = 0; i < count; ++i) {
+		const SDL_Rect& r(rects[i]);
+		if (r.w <= 0 || r.h <= 0)
+			continue;
+		// Each pixel is blended once, so translucent corners aren't darker.
+		_fill_span(r.x, r.y, r.w);
+		if (r.h > 1)
+			_fill_span(r.x, r.y + r.h - 1, r.w);
+		for (int y = r.y + 1; y < r.y + r.h - 1; ++y) {
+			_fill_span(r.x, y, 1);
+			if (r.w > 1)
+				_fill_span(r.x + r.w - 1, y, 1);
+		}
+	}
+}
+void SoftwareBackend::fillRects(const SDL_Rect* rects, int count) {
+	for (int i = 0; i < count; ++i) {
+		const SDL_Rect& r(rects[i]);
+		for (int y = std::max(r.y, 0); y < std::min(r.y + r.h, surface_->height); ++y)
+			_fill_span(r.x, y, r.w);
+	}
+}
+
+std::unique_ptr<RenderBackend::Target> SoftwareBackend::createTarget(game::Pixel width, game::Pixel height) {
+	auto target(std::make_unique<SurfaceTarget>());
+	target->surface = Surface{width, height, std::vector<Colour>(static_cast<std::size_t>(width) * height)};
+	return target;
+}
+void SoftwareBackend::setTarget(Target* target) {
+	surface_ = target ? &static_cast<SurfaceTarget*>(target)->surface : &output_;
+}
+void SoftwareBackend::copyTarget(Target& target) {
+	const Surface& src(static_cast<SurfaceTarget&>(target).surface);
+	Surface& dst(*surface_);
+	if (src.width <= 0 || src.height <= 0)
+		return;
+	for (game::Pixel y = 0; y < dst.height; ++y) {
+		const Colour* srcRow(&src.pixels[static_cast<std::size_t>(y * src.height / dst.height) * src.width]);
+		Colour* dstRow(&dst.pixels[static_cast<std::size_t>(y) * dst.width]);
+		if (src.width == dst.width) {
+			for (game::Pixel x = 0; x < dst.width; ++x) {
+				if (srcRow[x].a != 0)
+					blend(dstRow[x], srcRow[x]);
+			}
+			continue;
+		}
+		for (game::Pixel x = 0; x < dst.width; ++x) {
+			const Colour& c(srcRow[x * src.width / dst.width]);
+			if (c.a != 0)
+				blend(dstRow[x], c);
+		}
+	}
+}
+
+void SoftwareBackend::present() {
+	frame_ = output_.pixels;
+	++frame_count_;
+	if (dump_format_ == FrameFormat::NONE)
+		return;
+	char number[16];
+	std::snprintf(number, sizeof(number), "%06zu", frame_count_);
+	saveFrame(dump_prefix_ + number + (dump_format_ == FrameFormat::PPM ? ".ppm" : ".png"));
+}
+
+void SoftwareBackend::dumpFrames(FrameFormat format, const std::string& prefix) {
+	dump_format_ = format;
+	dump_prefix_ = prefix;
+}
+bool SoftwareBackend::saveFrame(const std::string& path) const {
+	const bool png(hasExtension(path, ".png"));
+	if (!png && !hasExtension(path, ".ppm")) {
+		std::cerr << "Error: Frames can only be saved as .ppm or .png, not \"" << path << "\".\n";
+		return false;
+	}
+	if (frame_.empty()) {
+		std::cerr << "Error: No frame has been presented to save.\n";
+		return false;
+	}
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		std::cerr << "Error: Could not create image file \"" << path << "\".\n";
+		return false;
+	}
+	if (!(png ? writePNG(file, output_.width, output_.height, frame_) : writePPM(file, output_.width, output_.height, frame_))) {
+		std::cerr << "Error: Could not write image file \"" << path << "\".\n";
+		return false;
+	}
+	return true;
+}
+
+void SoftwareBackend::_fill_span(int x, int y, int width) {
+	if (y < 0 || y >= surface_->height)
+		return;
+	const int start(std::max(x, 0)), end(std::min(x + width, surface_->width));
+	if (start >= end)
+		return;
+	Colour* row(&surface_->pixels[static_cast<std::size_t>(y) * surface_->width]);
+	if (colour_.a == 255) {
+		std::fill(row + start, row + end, colour_);
+		return;
+	}
+	for (int i = start; i < end; ++i)
+		blend(row[i], colour_);
+}
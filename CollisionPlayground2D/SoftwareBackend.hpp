@@ -0,0 +1,66 @@
+#ifndef INCLUDE_SOFTWARE_BACKEND_HPP
+#define INCLUDE_SOFTWARE_BACKEND_HPP
+
+#include <SDL.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "RenderBackend.hpp"
+
+// Draws into a framebuffer in memory, with no window, so drawing can be timed and checked on machines without a display.
+// Present never waits. Each presented frame can be written out as an image, to diff against a known good run.
+class SoftwareBackend : public RenderBackend {
+public:
+	enum class FrameFormat {
+		NONE,
+		PPM, // Binary RGB.
+		PNG, // RGB, uncompressed.
+	};
+
+	SoftwareBackend(game::Pixel width, game::Pixel height);
+
+	void getOutputSize(game::Pixel& out_width, game::Pixel& out_height) const override;
+	void setTitle(const std::string&) override {}
+
+	void setDrawColour(const Colour& c) override { colour_ = c; }
+	void clear() override;
+	void drawPoints(const SDL_Point* points, int count) override;
+	void drawRects(const SDL_Rect* rects, int count) override;
+	void fillRects(const SDL_Rect* rects, int count) override;
+
+	std::unique_ptr<Target> createTarget(game::Pixel width, game::Pixel height) override;
+	void setTarget(Target* target) override;
+	void copyTarget(Target& target) override;
+
+	void present() override;
+
+	// Write each presented frame to prefix followed by the frame number, e.g. "frames/000001.png".
+	void dumpFrames(FrameFormat format, const std::string& prefix);
+	// Write the last presented frame. The format is picked from the extension, .ppm or .png. Returns false if it fails.
+	bool saveFrame(const std::string& path) const;
+	// The last presented frame, row by row.
+	const std::vector<Colour>& getFrame() const { return frame_; }
+	std::size_t getFrameCount() const { return frame_count_; }
+
+private:
+	struct Surface {
+		game::Pixel width;
+		game::Pixel height;
+		std::vector<Colour> pixels;
+	};
+	class SurfaceTarget;
+
+	Surface output_;
+	Surface* surface_; // The output or a target.
+	Colour colour_;
+	std::vector<Colour> frame_;
+	std::size_t frame_count_{0};
+	FrameFormat dump_format_{FrameFormat::NONE};
+	std::string dump_prefix_;
+
+	// Blend the draw colour over a horizontal run of pixels, clipped to the surface.
+	void _fill_span(int x, int y, int width);
+};
+
+#endif // INCLUDE_SOFTWARE_BACKEND_HPP
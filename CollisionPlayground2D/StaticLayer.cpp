@@ -0,0 +1,17 @@
+#include "StaticLayer.hpp"
+
+bool StaticLayer::_begin(const Graphics& graphics) {
+	game::Pixel width, height;
+	graphics.getOutputSize(width, height);
+	if (width <= 0 || height <= 0)
+		return false;
+	if (width != width_ || height != height_) { // Only try to make a new target when the size changes.
+		target_ = graphics.createRenderTarget(width, height);
+		width_ = width;
+		height_ = height;
+	}
+	if (!target_)
+		return false;
+	graphics.beginRenderTarget(*target_);
+	return true;
+}
@@ -0,0 +1,52 @@
+#ifndef INCLUDE_STATIC_LAYER_HPP
+#define INCLUDE_STATIC_LAYER_HPP
+
+#include <memory>
+
+#include "Graphics.hpp"
+#include "RenderBackend.hpp"
+#include "units.hpp"
+
+// A retained layer for things that don't change between frames, like an example's obstacles.
+// They are drawn into a render target once, and the target is copied to the screen each frame until the layer is invalidated.
+class StaticLayer {
+public:
+	StaticLayer() = default;
+	StaticLayer(const StaticLayer&) = delete;
+	StaticLayer& operator=(const StaticLayer&) = delete;
+
+	// Redraw the layer's contents the next time it is rendered.
+	void invalidate() { valid_ = false; }
+	bool isValid() const { return valid_; }
+
+	// Copy the layer to the screen. If it needs redrawing (or the window changed size), drawContents() is called first,
+	// with the graphics drawing into the layer. Without render target support, drawContents() draws to the screen every time.
+	template<typename DrawFunc>
+	void render(const Graphics& graphics, DrawFunc&& drawContents);
+
+private:
+	std::unique_ptr<RenderBackend::Target> target_;
+	game::Pixel width_{0};
+	game::Pixel height_{0};
+	bool valid_{false};
+
+	bool _begin(const Graphics& graphics); // Returns false if the layer can't be drawn into.
+};
+
+template<typename DrawFunc>
+void StaticLayer::render(const Graphics& graphics, DrawFunc&& drawContents) {
+	game::Pixel width, height;
+	graphics.getOutputSize(width, height);
+	if (!valid_ || width != width_ || height != height_) {
+		if (!_begin(graphics)) {
+			drawContents();
+			return;
+		}
+		drawContents();
+		graphics.endRenderTarget();
+		valid_ = true;
+	}
+	graphics.renderTarget(*target_);
+}
+
+#endif // INCLUDE_STATIC_LAYER_HPP
@@ -0,0 +1,123 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+namespace game {
+std::size_t ThreadPool::getDefaultThreadCount() {
+#ifdef __EMSCRIPTEN__
+	return 1;
+#else
+	return std::max(1u, std::thread::hardware_concurrency());
+#endif
+}
+
+ThreadPool::ThreadPool(std::size_t numThreads) {
+	_start(numThreads);
+}
+ThreadPool::~ThreadPool() {
+	_stop();
+}
+
+void ThreadPool::resize(std::size_t numThreads) {
+	if (numThreads == size())
+		return;
+	_stop();
+	_start(numThreads);
+}
+
+void ThreadPool::parallelFor(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& f) {
+	grain = std::max<std::size_t>(grain, 1);
+	const std::size_t numChunks((count + grain - 1) / grain);
+	if (numChunks <= 1 || threads_.empty()) {
+		for (std::size_t begin = 0; begin < count; begin += grain)
+			f(begin, std::min(begin + grain, count));
+		return;
+	}
+	job_ = &f;
+	remaining_.store(numChunks, std::memory_order_relaxed);
+	// Give each thread a contiguous share of the chunks, so neighbouring indices tend to stay on one thread.
+	const std::size_t numQueues(queues_.size());
+	for (std::size_t q = 0; q < numQueues; ++q) {
+		const std::size_t first(numChunks * q / numQueues), last(numChunks * (q + 1) / numQueues);
+		std::lock_guard<std::mutex> lock(queues_[q]->mutex);
+		for (std::size_t c = last; c-- > first;) // Reversed, so the owner works front to back popping from the back.
+			queues_[q]->chunks.push_back(Chunk{c * grain, std::min((c + 1) * grain, count)});
+	}
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex_);
+		++generation_;
+	}
+	wake_.notify_all();
+
+	while (remaining_.load(std::memory_order_acquire) > 0) {
+		if (!_run_chunk(0))
+			std::this_thread::yield(); // Everything left is running on other threads.
+	}
+	job_ = nullptr;
+}
+
+void ThreadPool::_start(std::size_t numThreads) {
+	numThreads = std::max<std::size_t>(numThreads, 1);
+#ifdef __EMSCRIPTEN__
+	numThreads = 1;
+#endif
+	stopping_ = false;
+	for (std::size_t i = 0; i < numThreads; ++i)
+		queues_.push_back(std::make_unique<Queue>());
+	for (std::size_t i = 1; i < numThreads; ++i)
+		threads_.emplace_back(&ThreadPool::_work, this, i);
+}
+void ThreadPool::_stop() {
+	{
+		std::lock_guard<std::mutex> lock(wake_mutex_);
+		stopping_ = true;
+	}
+	wake_.notify_all();
+	for (std::thread& thread : threads_)
+		thread.join();
+	threads_.clear();
+	queues_.clear();
+}
+
+void ThreadPool::_work(std::size_t index) {
+	std::uint64_t seen(0);
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(wake_mutex_);
+			wake_.wait(lock, [&]() { return stopping_ || generation_ != seen; });
+			if (stopping_)
+				return;
+			seen = generation_;
+		}
+		while (_run_chunk(index)) {}
+	}
+}
+
+bool ThreadPool::_run_chunk(std::size_t index) {
+	Chunk chunk;
+	bool found(false);
+	{
+		Queue& own(*queues_[index]);
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.chunks.empty()) {
+			chunk = own.chunks.back();
+			own.chunks.pop_back();
+			found = true;
+		}
+	}
+	for (std::size_t i = 1; !found && i < queues_.size(); ++i) {
+		Queue& victim(*queues_[(index + i) % queues_.size()]);
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.chunks.empty()) {
+			chunk = victim.chunks.front();
+			victim.chunks.pop_front();
+			found = true;
+		}
+	}
+	if (!found)
+		return false;
+	(*job_)(chunk.begin, chunk.end);
+	remaining_.fetch_sub(1, std::memory_order_acq_rel);
+	return true;
+}
+}
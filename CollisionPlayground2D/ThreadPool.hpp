@@ -0,0 +1,67 @@
+#ifndef INCLUDE_GAME_THREAD_POOL_HPP
+#define INCLUDE_GAME_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs loops in parallel on a fixed set of worker threads.
+// A loop's range is cut into chunks, and each thread is given a contiguous share of them on its own queue.
+// Threads take chunks from the back of their own queue, and when it runs dry steal from the front of the others',
+// so uneven chunks even out without a shared queue to contend on.
+// The calling thread works too, so a pool of one thread runs loops inline. Emscripten builds always do.
+
+namespace game {
+class ThreadPool {
+public:
+	// Threads to use by default: one per hardware thread.
+	static std::size_t getDefaultThreadCount();
+
+	explicit ThreadPool(std::size_t numThreads = getDefaultThreadCount());
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Threads that run loops, including the calling thread.
+	std::size_t size() const { return queues_.size(); }
+	void resize(std::size_t numThreads);
+
+	// Call f(begin, end) over chunks of at most grain indices, covering [0, count). Returns once every chunk is done.
+	// Chunks may run in any order and on any thread, so f must only write to what its indices own.
+	void parallelFor(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& f);
+
+private:
+	struct Chunk {
+		std::size_t begin, end;
+	};
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Chunk> chunks;
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues_; // One per thread. The calling thread's is the first.
+	std::vector<std::thread> threads_;
+
+	const std::function<void(std::size_t, std::size_t)>* job_{nullptr};
+	std::atomic<std::size_t> remaining_{0}; // Chunks not yet finished.
+
+	std::mutex wake_mutex_;
+	std::condition_variable wake_;
+	std::uint64_t generation_{0}; // Bumped for each loop, to wake the workers.
+	bool stopping_{false};
+
+	void _start(std::size_t numThreads);
+	void _stop();
+	void _work(std::size_t index);
+	// Run a chunk from the thread's own queue, or stolen from another. Returns false if there were none.
+	bool _run_chunk(std::size_t index);
+};
+}
+
+#endif // INCLUDE_GAME_THREAD_POOL_HPP
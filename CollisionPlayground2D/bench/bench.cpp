@@ -0,0 +1,596 @@
+// Headless benchmark for the collision maps. No window is opened: the example scenes are built directly,
+// and the mover and rotating ray are driven by scripted input.
+// Usage: examples_bench [--sizes 20,1000,...] [--frames N] [--maps simple,grid,tree,bvh,pool]
+//        examples_bench --pairs 1000,100000,... [--frames N]
+// --pairs benchmarks the sweep and prune pair finder on drifting shapes instead of the maps, on 1 thread up to one per hardware thread.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <new>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../constants.hpp"
+#include "../generator.hpp"
+#include "../Input.hpp"
+#include "../ThreadPool.hpp"
+#include "../geom_examples/CrowdGrid.hpp"
+#include "../geom_examples/Example.hpp"
+#include "../geom_examples/Mover.hpp"
+#include "../geom_examples/ObstacleMap.hpp"
+#include "../geom_examples/ObstaclePool.hpp"
+#include "../geom_examples/RayPacket.hpp"
+#include "../geom_examples/RotatingRay.hpp"
+#include "../geom_examples/ShapeBatch.hpp"
+#include "../geom_examples/ShapePlacer.hpp"
+#include "../geom_examples/SweepAndPrune.hpp"
+
+#include <Geometry2D/Geometry.hpp>
+
+// Count heap usage, to report the peak memory of each map. The pair finder allocates from several threads.
+namespace {
+constexpr std::size_t ALLOC_HEADER = alignof(std::max_align_t); // Room to store each allocation's size.
+std::atomic<std::size_t> currentBytes{0};
+std::atomic<std::size_t> peakBytes{0};
+
+void* countedAlloc(std::size_t size) noexcept {
+	void* block(std::malloc(size + ALLOC_HEADER));
+	if (!block)
+		return nullptr;
+	*static_cast<std::size_t*>(block) = size;
+	const std::size_t current(currentBytes.fetch_add(size, std::memory_order_relaxed) + size);
+	std::size_t peak(peakBytes.load(std::memory_order_relaxed));
+	while (current > peak && !peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {}
+	return static_cast<char*>(block) + ALLOC_HEADER;
+}
+void countedFree(void* ptr) noexcept {
+	if (!ptr)
+		return;
+	char* block(static_cast<char*>(ptr) - ALLOC_HEADER);
+	currentBytes.fetch_sub(*reinterpret_cast<std::size_t*>(block), std::memory_order_relaxed);
+	std::free(block);
+}
+}
+// Every form that pairs with the plain delete is replaced, e.g. std::stable_partition's buffer uses the nothrow new.
+void* operator new(std::size_t size) {
+	void* ptr(countedAlloc(size));
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	return countedAlloc(size);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	return countedAlloc(size);
+}
+void operator delete(void* ptr) noexcept {
+	countedFree(ptr);
+}
+void operator delete[](void* ptr) noexcept {
+	countedFree(ptr);
+}
+void operator delete(void* ptr, std::size_t) noexcept {
+	countedFree(ptr);
+}
+void operator delete[](void* ptr, std::size_t) noexcept {
+	countedFree(ptr);
+}
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+	countedFree(ptr);
+}
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+	countedFree(ptr);
+}
+
+namespace game {
+namespace {
+const ctp::Rect BASE_REGION(0, 0, SCREEN_WIDTH - 320, SCREEN_HEIGHT - 160); // The examples' level region.
+const MS FRAME_TIME = 16;
+const std::size_t SCRIPT_PHASE_FRAMES = 40;   // Frames before the mover changes direction.
+const std::size_t RAY_BOUNCES = 3;            // Reflections traced after each frame's ray.
+const ctp::gFloat CHECK_TOLERANCE = 0.01f;    // How far results may differ from the simple map's.
+const ctp::gFloat DRIFT_SPEED = 0.05f;        // Fastest a shape drifts in the pair benchmark, in pixels per ms.
+const ctp::gFloat CHECK_CELL_SIZE = 64;       // Of the grid the pair benchmark checks its pairs with.
+const std::uint64_t SCENE_SEED = 1;           // Scenes are the same every run, and on every build.
+const ctp::Rect EDGE_BOX(100, 100, 50, 50);   // The box the SIMD check traces along the edges of.
+const std::vector<ctp::Ray> EDGE_RAYS{
+	{ctp::Coord2(120, 100), ctp::Coord2(1, 0)},  // Starting on an edge, running along it.
+	{ctp::Coord2(120, 150), ctp::Coord2(-1, 0)},
+	{ctp::Coord2(100, 120), ctp::Coord2(0, 1)},
+	{ctp::Coord2(150, 120), ctp::Coord2(0, -1)},
+	{ctp::Coord2(120, 100), ctp::Coord2(0, -1)}, // Starting on an edge, leaving the box.
+	{ctp::Coord2(100, 100), ctp::Coord2(1, 0)},  // Starting on a corner.
+	{ctp::Coord2(150, 150), ctp::Coord2(0, -1)},
+	{ctp::Coord2(50, 100), ctp::Coord2(1, 0)},   // Starting outside, in line with an edge.
+	{ctp::Coord2(120, 200), ctp::Coord2(0, -1)}, // Crossing the box.
+	{ctp::Coord2(100, 200), ctp::Coord2(0, -1)}, // Grazing an edge from outside.
+	{ctp::Coord2(200, 150), ctp::Coord2(-1, 0)},
+};
+const std::vector<std::vector<SDL_Keycode>> MOVER_SCRIPT{
+	{SDLK_RIGHT}, {SDLK_RIGHT, SDLK_DOWN}, {SDLK_DOWN}, {SDLK_LEFT}, {SDLK_LEFT, SDLK_UP}, {SDLK_UP},
+};
+const std::vector<std::pair<Broadphase, std::string>> BROADPHASES{
+	{Broadphase::SIMPLE, "simple"}, {Broadphase::GRID, "grid"}, {Broadphase::TREE, "tree"}, {Broadphase::BVH, "bvh"}, {Broadphase::POOL, "pool"},
+};
+
+struct Options {
+	std::vector<std::size_t> sizes{Example::NUM_SHAPES, 1000, 10000, 100000, 1000000};
+	std::size_t frames{200};
+	std::vector<Broadphase> maps{Broadphase::SIMPLE, Broadphase::GRID, Broadphase::TREE, Broadphase::BVH, Broadphase::POOL};
+	std::vector<std::size_t> pairSizes; // Benchmark the pair finder with these numbers of shapes instead of the maps.
+};
+
+// The obstacles, mover and ray shared by every map, so they all see the same scene.
+struct Scene {
+	ctp::Rect region;
+	double generateMillis{0};
+	std::vector<std::pair<ctp::ShapeContainer, ctp::Coord2>> obstacles;
+	ctp::ShapeContainer moverCollider{ctp::Rect{}};
+	ctp::Coord2 moverPosition;
+};
+
+// What a map did each frame, to compare against the simple map.
+struct Results {
+	std::vector<ctp::Coord2> moverPositions;
+	std::vector<ctp::gFloat> rayDists; // -1 for a miss.
+};
+
+// What the pair finder did over a run.
+struct PairMeasurements {
+	double frameMeanMillis{0};
+	double frameP99Millis{0};
+	double moves{0};      // Per frame, as are the rest.
+	double candidates{0};
+	double pairs{0};
+	std::size_t mismatches{0}; // Frames where the pairs differ from the grid's.
+};
+
+struct Measurements {
+	double buildMillis{0};
+	double moveNanos{0};
+	double rayNanos{0};
+	double frameP50Micros{0};
+	double frameP99Micros{0};
+	std::size_t peakBytes{0};
+};
+
+double elapsedNanos(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool parseList(const std::string& arg, std::vector<std::string>& out_items) {
+	out_items.clear();
+	std::istringstream stream(arg);
+	std::string item;
+	while (std::getline(stream, item, ','))
+		out_items.push_back(item);
+	return !out_items.empty();
+}
+bool parseOptions(int argc, char* args[], Options& out_options) {
+	std::vector<std::string> items;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg(args[i]);
+		if (i + 1 >= argc) {
+			std::cerr << "Missing value for " << arg << ".\n";
+			return false;
+		}
+		const std::string value(args[++i]);
+		if (arg == "--frames") {
+			out_options.frames = std::strtoul(value.c_str(), nullptr, 10);
+			if (out_options.frames == 0) {
+				std::cerr << "Invalid frame count: " << value << "\n";
+				return false;
+			}
+		} else if (arg == "--sizes" && parseList(value, items)) {
+			out_options.sizes.clear();
+			for (const std::string& size : items) {
+				out_options.sizes.push_back(std::strtoul(size.c_str(), nullptr, 10));
+				if (out_options.sizes.back() == 0) {
+					std::cerr << "Invalid scene size: " << size << "\n";
+					return false;
+				}
+			}
+		} else if (arg == "--pairs" && parseList(value, items)) {
+			out_options.pairSizes.clear();
+			for (const std::string& size : items) {
+				out_options.pairSizes.push_back(std::strtoul(size.c_str(), nullptr, 10));
+				if (out_options.pairSizes.back() == 0) {
+					std::cerr << "Invalid shape count: " << size << "\n";
+					return false;
+				}
+			}
+		} else if (arg == "--maps" && parseList(value, items)) {
+			out_options.maps.clear();
+			for (const std::string& name : items) {
+				const auto found(std::find_if(BROADPHASES.begin(), BROADPHASES.end(), [&](const auto& b) { return b.second == name; }));
+				if (found == BROADPHASES.end()) {
+					std::cerr << "Unknown map: " << name << "\n";
+					return false;
+				}
+				out_options.maps.push_back(found->first);
+			}
+		} else {
+			std::cerr << "Unknown option: " << arg << "\n";
+			return false;
+		}
+	}
+	return true;
+}
+
+// Scale the level region with the number of shapes, so scenes keep the examples' density.
+Scene makeScene(std::size_t numShapes, ThreadPool& pool) {
+	Scene scene;
+	const ctp::gFloat scale(std::sqrt(static_cast<ctp::gFloat>(numShapes) / Example::NUM_SHAPES));
+	scene.region = ctp::Rect(BASE_REGION.x, BASE_REGION.y, BASE_REGION.w * scale, BASE_REGION.h * scale);
+	// Shapes are made in parallel, then placed one by one so they don't overlap, as the shape examples do.
+	const auto start(std::chrono::steady_clock::now());
+	gen::ShapeSoA batch;
+	gen::shapes(pool, SCENE_SEED, numShapes, Example::getShapeSpec(scene.region), batch);
+	ShapePlacer placer(scene.region, Example::SHAPE_MAX_SIZE);
+	scene.obstacles.reserve(numShapes);
+	for (std::size_t i = 0; i < numShapes; ++i) {
+		ctp::Coord2 position;
+		if (!placer.place(batch.getBoundingCircle(i), position))
+			break;
+		scene.obstacles.emplace_back(batch.makeShape(i), position);
+	}
+	scene.generateMillis = elapsedNanos(start) / 1e6;
+	if (scene.obstacles.size() < numShapes)
+		std::cerr << "Error: The scene filled up after " << scene.obstacles.size() << " of " << numShapes << " shapes.\n";
+	// Then the mover, somewhere free.
+	scene.moverCollider = Example::genShape();
+	if (!placer.place(scene.moverCollider, scene.moverPosition)) {
+		scene.moverPosition = scene.region.center();
+		std::cerr << "Error: The scene is full, so the mover may start inside a shape.\n";
+	}
+	return scene;
+}
+
+// Trace a ray and its reflections, like the reflecting ray example.
+void traceRay(const ObstacleMap& map, ctp::Ray ray, std::vector<ctp::gFloat>& out_dists) {
+	std::size_t ind;
+	ctp::gFloat near, far;
+	ctp::Coord2 normNear, normFar;
+	for (std::size_t bounce = 0; bounce <= RAY_BOUNCES; ++bounce) {
+		if (!map.findClosestHit(ray, ind, near, normNear, far, normFar)) {
+			out_dists.push_back(-1);
+			return;
+		}
+		out_dists.push_back(near);
+		if (near == 0.0f) { // Inside a shape: reflect off the inside of where it exits.
+			near = far;
+			normNear = -normFar;
+		}
+		ray = ctp::Ray{ray.origin + ray.dir * std::clamp(near - 0.1f, 0.0f, near), ctp::math::reflect(ray.dir, normNear)};
+	}
+}
+
+Measurements runMap(Broadphase broadphase, const Scene& scene, std::size_t frames, Results& out_results) {
+	Measurements m;
+	const std::size_t baseBytes(currentBytes.load());
+	peakBytes = baseBytes;
+	auto start(std::chrono::steady_clock::now());
+	std::unique_ptr<ObstacleMap> map(makeObstacleMap(broadphase));
+	for (const auto& obs : scene.obstacles)
+		map->addWall(obs.first, obs.second);
+	map->getColliding(ctp::Wall(scene.moverCollider, scene.moverPosition), ctp::Coord2(0, 0)); // Finish any lazy building.
+	m.buildMillis = elapsedNanos(start) / 1e6;
+
+	Mover mover(scene.moverCollider, scene.moverPosition);
+	RotatingRay rotatingRay(ctp::Ray{scene.region.center(), ctp::Coord2(1, 0)});
+	Input moverInput, rayInput;
+	rayInput.keyDownEvent(SDLK_d); // Keep the ray turning.
+	out_results = Results();
+	out_results.moverPositions.reserve(frames);
+	out_results.rayDists.reserve(frames * (RAY_BOUNCES + 1));
+	std::vector<double> frameNanos;
+	frameNanos.reserve(frames);
+	double moveNanos(0), rayNanos(0);
+	for (std::size_t frame = 0; frame < frames; ++frame) {
+		if (frame % SCRIPT_PHASE_FRAMES == 0) {
+			moverInput.clear();
+			for (SDL_Keycode key : MOVER_SCRIPT[frame / SCRIPT_PHASE_FRAMES % MOVER_SCRIPT.size()])
+				moverInput.keyDownEvent(key);
+		}
+		start = std::chrono::steady_clock::now();
+		mover.receiveInput(moverInput);
+		mover.update(FRAME_TIME, *map);
+		const double move(elapsedNanos(start));
+
+		rotatingRay.receiveInput(rayInput);
+		rotatingRay.update(FRAME_TIME);
+		start = std::chrono::steady_clock::now();
+		traceRay(*map, rotatingRay.getRay(), out_results.rayDists);
+		const double rays(elapsedNanos(start));
+
+		out_results.moverPositions.push_back(mover.getPosition());
+		moveNanos += move;
+		rayNanos += rays;
+		frameNanos.push_back(move + rays);
+	}
+	std::sort(frameNanos.begin(), frameNanos.end());
+	m.moveNanos = moveNanos / frames;
+	m.rayNanos = rayNanos / out_results.rayDists.size();
+	m.frameP50Micros = frameNanos[frameNanos.size() / 2] / 1e3;
+	m.frameP99Micros = frameNanos[std::min(frameNanos.size() - 1, frameNanos.size() * 99 / 100)] / 1e3;
+	m.peakBytes = peakBytes - baseBytes;
+	return m;
+}
+
+// Count the frames where a map's results differ from the reference's.
+std::size_t countMismatches(const Results& reference, const Results& results) {
+	std::size_t mismatches(0);
+	for (std::size_t i = 0; i < reference.moverPositions.size(); ++i) {
+		const ctp::Coord2 diff(reference.moverPositions[i] - results.moverPositions[i]);
+		if (std::abs(diff.x) > CHECK_TOLERANCE || std::abs(diff.y) > CHECK_TOLERANCE)
+			++mismatches;
+	}
+	// Ray counts can differ if one map misses where the other hits, so compare as far as both go.
+	const std::size_t numRays(std::min(reference.rayDists.size(), results.rayDists.size()));
+	mismatches += std::max(reference.rayDists.size(), results.rayDists.size()) - numRays;
+	for (std::size_t i = 0; i < numRays; ++i) {
+		const ctp::gFloat a(reference.rayDists[i]), b(results.rayDists[i]);
+		if ((a == -1) != (b == -1) || std::abs(a - b) > CHECK_TOLERANCE)
+			++mismatches;
+	}
+	return mismatches;
+}
+
+// Find the overlapping pairs the slow but simple way, with a grid, to check the pair finder against.
+void findPairsWithGrid(const std::vector<PooledWall>& bodies, const ctp::Rect& region, CrowdGrid& grid, std::vector<OverlapPair>& out_pairs) {
+	std::vector<ctp::Rect> bounds;
+	bounds.reserve(bodies.size());
+	for (const PooledWall& body : bodies)
+		bounds.push_back(getBounds(body));
+	grid.build(region, CHECK_CELL_SIZE, bounds);
+	out_pairs.clear();
+	for (std::uint32_t i = 0; i < bodies.size(); ++i) {
+		grid.query(bounds[i], [&](std::size_t j) {
+			if (j > i && ctp::overlaps(bodies[i].getCollider(), bodies[i].getPosition(), bodies[j].getCollider(), bodies[j].getPosition()))
+				out_pairs.push_back(OverlapPair{i, static_cast<std::uint32_t>(j)});
+		});
+	}
+	std::sort(out_pairs.begin(), out_pairs.end());
+}
+
+// Drift shapes around a region, bouncing off its edges, finding the overlapping pairs each frame.
+PairMeasurements runPairs(const Scene& scene, const std::vector<ctp::Coord2>& velocities, std::size_t frames, std::size_t numThreads) {
+	PairMeasurements m;
+	std::vector<PooledWall> bodies;
+	bodies.reserve(scene.obstacles.size());
+	for (const auto& obs : scene.obstacles)
+		bodies.emplace_back(obs.first, obs.second);
+	std::vector<ctp::Coord2> vel(velocities);
+	ThreadPool pool(numThreads);
+	SweepAndPrune pairFinder;
+	for (const PooledWall& body : bodies)
+		pairFinder.add(&body); // Ids match the bodies' indices.
+	CrowdGrid grid;
+	std::vector<OverlapPair> pairs, expected;
+	std::vector<double> frameNanos;
+	frameNanos.reserve(frames);
+	for (std::size_t frame = 0; frame < frames; ++frame) {
+		for (std::size_t i = 0; i < bodies.size(); ++i) {
+			ctp::Coord2 pos(bodies[i].getPosition() + vel[i] * static_cast<ctp::gFloat>(FRAME_TIME));
+			if (pos.x < scene.region.x || pos.x > scene.region.x + scene.region.w)
+				vel[i].x = -vel[i].x;
+			if (pos.y < scene.region.y || pos.y > scene.region.y + scene.region.h)
+				vel[i].y = -vel[i].y;
+			bodies[i].setPosition(pos);
+		}
+		const auto start(std::chrono::steady_clock::now());
+		pairFinder.findPairs(pool, pairs);
+		frameNanos.push_back(elapsedNanos(start));
+
+		const SweepAndPrune::Stats& stats(pairFinder.getStats());
+		m.moves += stats.moves;
+		m.candidates += stats.candidates;
+		m.pairs += stats.pairs;
+		findPairsWithGrid(bodies, scene.region, grid, expected);
+		std::sort(pairs.begin(), pairs.end());
+		if (pairs != expected)
+			++m.mismatches;
+	}
+	m.frameMeanMillis = std::accumulate(frameNanos.begin(), frameNanos.end(), 0.0) / frames / 1e6;
+	std::sort(frameNanos.begin(), frameNanos.end());
+	m.frameP99Millis = frameNanos[std::min(frameNanos.size() - 1, frameNanos.size() * 99 / 100)] / 1e6;
+	m.moves /= frames;
+	m.candidates /= frames;
+	m.pairs /= frames;
+	return m;
+}
+
+int runPairBenchmarks(const Options& options) {
+	std::vector<std::size_t> threadCounts{1};
+	while (threadCounts.back() * 2 <= ThreadPool::getDefaultThreadCount())
+		threadCounts.push_back(threadCounts.back() * 2);
+	std::size_t totalMismatches(0);
+	ThreadPool scenePool;
+	for (std::size_t size : options.pairSizes) {
+		const Scene scene(makeScene(size, scenePool));
+		std::vector<ctp::Coord2> velocities;
+		velocities.reserve(size);
+		for (std::size_t i = 0; i < size; ++i)
+			velocities.emplace_back(gen::gFloat(-DRIFT_SPEED, DRIFT_SPEED), gen::gFloat(-DRIFT_SPEED, DRIFT_SPEED));
+		std::cout << "\n" << std::defaultfloat << std::setprecision(6) << size << " shapes, " << options.frames << " frames, level region " << scene.region.w << "x" << scene.region.h
+			<< ", generated and placed in " << std::fixed << std::setprecision(1) << scene.generateMillis << "ms\n";
+		std::cout << std::right << std::setw(8) << "threads" << std::setw(12) << "mean ms" << std::setw(12) << "p99 ms"
+			<< std::setw(12) << "moves" << std::setw(14) << "candidates" << std::setw(12) << "pairs" << "  check\n";
+		for (std::size_t numThreads : threadCounts) {
+			const PairMeasurements m(runPairs(scene, velocities, options.frames, numThreads));
+			totalMismatches += m.mismatches;
+			std::cout << std::right << std::fixed << std::setprecision(2) << std::setw(8) << numThreads
+				<< std::setw(12) << m.frameMeanMillis << std::setw(12) << m.frameP99Millis << std::setprecision(0)
+				<< std::setw(12) << m.moves << std::setw(14) << m.candidates << std::setw(12) << m.pairs
+				<< "  " << (m.mismatches == 0 ? std::string("ok") : std::to_string(m.mismatches) + " mismatches") << std::endl;
+		}
+	}
+	if (totalMismatches > 0) {
+		std::cerr << "\nThe pair finder's pairs differ from the grid's.\n";
+		return 1;
+	}
+	return 0;
+}
+
+// Which rays hit the box, and where they enter it, with the packet kernel and the rectangle block kernel.
+// Also each ray's full hit from a ShapeBatch holding the box, with its normals. index is NO_EDGE_HIT for a miss.
+const std::size_t NO_EDGE_HIT = ~std::size_t(0);
+struct EdgeHits {
+	std::uint32_t packetMask{0};
+	std::uint32_t blockMask{0};
+	std::vector<float> packetEnter;
+	std::vector<float> blockNear;
+	std::vector<RayHit> batchHits;
+};
+EdgeHits traceEdgeRays() {
+	EdgeHits hits;
+	RayPacket packet;
+	packet.load(EDGE_RAYS.data(), EDGE_RAYS.size());
+	hits.packetEnter.resize(RayPacket::MAX_SIZE);
+	hits.packetMask = simd::intersectBox(packet, EDGE_BOX, hits.packetEnter.data());
+	RectBlock block;
+	block.size = 1;
+	for (std::size_t i = 0; i < RectBlock::SIZE; ++i) {
+		block.minX[i] = EDGE_BOX.x;
+		block.minY[i] = EDGE_BOX.y;
+		block.maxX[i] = EDGE_BOX.x + EDGE_BOX.w;
+		block.maxY[i] = EDGE_BOX.y + EDGE_BOX.h;
+		block.index[i] = 0;
+	}
+	ShapeBatch batch;
+	batch.addRect(0, EDGE_BOX);
+	float near[RectBlock::SIZE], far[RectBlock::SIZE];
+	std::vector<RayHit> found;
+	for (std::size_t i = 0; i < EDGE_RAYS.size(); ++i) {
+		const bool hit(simd::intersectRects(EDGE_RAYS[i], block, std::numeric_limits<float>::max(), near, far) != 0);
+		hits.blockMask |= hit ? 1u << i : 0u;
+		hits.blockNear.push_back(near[0]);
+		found.clear();
+		batch.findHits(EDGE_RAYS[i], found);
+		hits.batchHits.push_back(found.empty() ? RayHit{NO_EDGE_HIT, 0, 0, ctp::Coord2(0, 0), ctp::Coord2(0, 0)} : found[0]);
+	}
+	return hits;
+}
+// Whether a hit is finite, with its normals naming the sides of the box its entry and exit points are on.
+// A ray starting on the box enters it behind its origin, so only the exit is checked.
+bool isOnEdges(const ctp::Ray& ray, const RayHit& hit) {
+	const auto onSide([&ray](float dist, const ctp::Coord2& normal) {
+		const ctp::Coord2 point(ray.origin + ray.dir * dist);
+		if (normal.y == 0 && std::abs(normal.x) == 1)
+			return std::abs(point.x - (normal.x < 0 ? EDGE_BOX.left() : EDGE_BOX.right())) <= CHECK_TOLERANCE;
+		if (normal.x == 0 && std::abs(normal.y) == 1)
+			return std::abs(point.y - (normal.y < 0 ? EDGE_BOX.top() : EDGE_BOX.bottom())) <= CHECK_TOLERANCE;
+		return false;
+	});
+	return std::isfinite(hit.near) && std::isfinite(hit.far) && (hit.near <= 0 || onSide(hit.near, hit.normNear)) && onSide(hit.far, hit.normFar);
+}
+bool sameHit(const RayHit& a, const RayHit& b) {
+	return a.index == b.index && (a.index == NO_EDGE_HIT || (std::abs(a.near - b.near) <= CHECK_TOLERANCE
+		&& std::abs(a.far - b.far) <= CHECK_TOLERANCE && a.normNear == b.normNear && a.normFar == b.normFar));
+}
+// Check every SIMD level against the scalar kernels, on axis-parallel rays starting on or grazing a box's edges.
+// The scalar ShapeBatch hits must also be finite, with normals on the sides they enter and exit through.
+// Returns the number of rays some level gets wrong.
+std::size_t checkSimdLevels() {
+	const SimdLevel level(simd::getLevel());
+	simd::setLevel(SimdLevel::SCALAR);
+	const EdgeHits reference(traceEdgeRays());
+	std::size_t mismatches(0);
+	for (std::size_t i = 0; i < EDGE_RAYS.size(); ++i)
+		mismatches += reference.batchHits[i].index == NO_EDGE_HIT || isOnEdges(EDGE_RAYS[i], reference.batchHits[i]) ? 0 : 1;
+	for (int l = static_cast<int>(SimdLevel::SSE); l <= static_cast<int>(simd::getMaxLevel()); ++l) {
+		simd::setLevel(static_cast<SimdLevel>(l));
+		const EdgeHits hits(traceEdgeRays());
+		for (std::size_t i = 0; i < EDGE_RAYS.size(); ++i) {
+			const std::uint32_t bit(1u << i);
+			if ((hits.packetMask & bit) != (reference.packetMask & bit) || (hits.blockMask & bit) != (reference.blockMask & bit)
+				|| ((reference.packetMask & bit) != 0 && std::abs(hits.packetEnter[i] - reference.packetEnter[i]) > CHECK_TOLERANCE)
+				|| ((reference.blockMask & bit) != 0 && std::abs(hits.blockNear[i] - reference.blockNear[i]) > CHECK_TOLERANCE)
+				|| !sameHit(hits.batchHits[i], reference.batchHits[i]))
+				++mismatches;
+		}
+	}
+	simd::setLevel(level);
+	std::cout << "SIMD kernels (scalar up to " << simd::getLevelName(simd::getMaxLevel()) << ") on rays along a box's edges: "
+		<< (mismatches == 0 ? "ok" : std::to_string(mismatches) + " mismatches") << "\n";
+	return mismatches;
+}
+
+std::string formatBytes(std::size_t bytes) {
+	std::ostringstream stream;
+	stream << std::fixed << std::setprecision(1);
+	if (bytes >= 1024 * 1024)
+		stream << bytes / (1024.0 * 1024.0) << " MiB";
+	else
+		stream << bytes / 1024.0 << " KiB";
+	return stream.str();
+}
+const std::string& getName(Broadphase broadphase) {
+	return std::find_if(BROADPHASES.begin(), BROADPHASES.end(), [&](const auto& b) { return b.first == broadphase; })->second;
+}
+
+int runBenchmarks(int argc, char* args[]) {
+	Options options;
+	if (!parseOptions(argc, args, options))
+		return 2;
+#ifdef DEBUG
+	std::cout << "Warning: this is a debug build. Build with \"make bench CONFIG=release\" for meaningful timings.\n";
+#endif
+	if (!options.pairSizes.empty())
+		return runPairBenchmarks(options);
+	const std::size_t simdMismatches(checkSimdLevels());
+	const bool checking(std::find(options.maps.begin(), options.maps.end(), Broadphase::SIMPLE) != options.maps.end());
+	if (!checking)
+		std::cout << "The simple map isn't being run, so results won't be cross-checked.\n";
+	std::size_t totalMismatches(0);
+	ThreadPool scenePool;
+	for (std::size_t size : options.sizes) {
+		const Scene scene(makeScene(size, scenePool));
+		std::cout << "\n" << std::defaultfloat << std::setprecision(6) << size << " shapes, " << options.frames << " frames, level region " << scene.region.w << "x" << scene.region.h
+			<< ", generated and placed in " << std::fixed << std::setprecision(1) << scene.generateMillis << "ms\n";
+		std::cout << std::left << std::setw(8) << "map" << std::right
+			<< std::setw(12) << "build ms" << std::setw(12) << "ns/move" << std::setw(12) << "ns/ray"
+			<< std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::setw(14) << "peak mem" << "  check\n";
+		Results reference, results;
+		if (checking) // Run the simple map first so the others can be checked against it.
+			std::stable_partition(options.maps.begin(), options.maps.end(), [](Broadphase b) { return b == Broadphase::SIMPLE; });
+		for (Broadphase broadphase : options.maps) {
+			const Measurements m(runMap(broadphase, scene, options.frames, broadphase == Broadphase::SIMPLE ? reference : results));
+			std::string check("-");
+			if (checking && broadphase != Broadphase::SIMPLE) {
+				const std::size_t mismatches(countMismatches(reference, results));
+				totalMismatches += mismatches;
+				check = mismatches == 0 ? "ok" : std::to_string(mismatches) + " mismatches";
+			}
+			std::cout << std::left << std::setw(8) << getName(broadphase) << std::right << std::fixed << std::setprecision(1)
+				<< std::setw(12) << m.buildMillis << std::setw(12) << m.moveNanos << std::setw(12) << m.rayNanos
+				<< std::setw(12) << m.frameP50Micros << std::setw(12) << m.frameP99Micros << std::setw(14) << formatBytes(m.peakBytes)
+				<< "  " << check << std::endl;
+		}
+	}
+	if (simdMismatches > 0)
+		std::cerr << "\nThe SIMD kernels gave different results from the scalar ones.\n";
+	if (totalMismatches > 0)
+		std::cerr << "\nSome maps gave different results from the simple map.\n";
+	return simdMismatches > 0 || totalMismatches > 0 ? 1 : 0;
+}
+}
+}
+
+int main(int argc, char* args[]) {
+	return game::runBenchmarks(argc, args);
+}
@@ -1,14 +1,23 @@
 #include <SDL.h>
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
 #include <iostream>
 #include <memory>
-#include <numeric>
-#include <sstream>
+#include <string>
 #include <string_view>
 #include <vector>
 
 #include "Graphics.hpp"
 #include "Input.hpp"
+#include "Profiler.hpp"
+#include "ProfilerOverlay.hpp"
+#include "Replay.hpp"
+#include "Simulation.hpp"
+#include "SoftwareBackend.hpp"
 
 #include "constants.hpp"
 #include "game.hpp"
@@ -17,8 +26,12 @@
 #include "util.hpp"
 
 #include "geom_examples/Example.hpp"
+#include "geom_examples/ExampleCrowd.hpp"
 #include "geom_examples/ExampleRays.hpp"
 #include "geom_examples/ExampleShapes.hpp"
+#include "geom_examples/ExampleVisibility.hpp"
+#include "geom_examples/ExampleWorld.hpp"
+#include "geom_examples/ObstacleMap.hpp"
 
 #include <Geometry2D/Geometry.hpp>
 
@@ -29,7 +42,7 @@
 namespace game {
 namespace {
 const ctp::Rect LEVEL_REGION = ctp::Rect{160, 80, SCREEN_WIDTH - 320, SCREEN_HEIGHT - 160};
-constexpr std::array<std::string_view, 7> EXAMPLE_NAMES{
+constexpr std::array<std::string_view, 13> EXAMPLE_NAMES{
 	" - Example 1: Rectangles",
 	" - Example 2: Polygons",
 	" - Example 3: Circles",
@@ -37,17 +50,54 @@ constexpr std::array<std::string_view, 7> EXAMPLE_NAMES{
 	" - Example 5: Peircing ray",
 	" - Example 6: Closest ray",
 	" - Example 7: Reflecting ray",
+	" - Example 8: Drifting shapes",
+	" - Example 9: Ray fan",
+	" - Example 10: Crowd",
+	" - Example 11: Concave shapes",
+	" - Example 12: Visibility",
+	" - Example 13: Streamed world",
+};
+constexpr std::array<std::string_view, 5> BROADPHASE_NAMES{
+	" (simple map)",
+	" (grid map)",
+	" (tree map)",
+	" (BVH map)",
+	" (pool map)",
 };
 constexpr std::string_view WINDOW_TITLE = "Collision Playground 2D";
+const std::string SCENE_FILE = "scene.cpscene";
+const std::string TRACE_FILE = "trace.json";
+const SDL_Point OVERLAY_POS{4, 4};
+const float PAN_SPEED = 1.0f;  // Screen pixels per millisecond, however far the view is zoomed.
+const float ZOOM_SPEED = 2.0f; // Doublings per second.
+const float MIN_ZOOM = 1.0f / 512;
+const float MAX_ZOOM = 16.0f;
+
+struct Options {
+	bool seeded{false};
+	std::uint32_t seed{0};
+	std::string recordPath; // Record the run to this file.
+	std::string replayPath; // Replay this file headlessly instead of opening a window.
+	std::string tracePath;  // Write a trace of the replay to this file.
+	bool draw{false};       // Draw each step of the replay offscreen.
+	SoftwareBackend::FrameFormat frameFormat{SoftwareBackend::FrameFormat::NONE};
+	std::string framePrefix{"frame_"};
+	float zoom{1};          // How far the view is zoomed when drawing the replay.
+};
 
 Input input;
 Graphics graphics;
-MS previousTime = 0;
-MS elapsedTime = 0;
-std::unique_ptr<Example> example;
+ProfilerOverlay overlay;
+ViewControl view;
+Profiler::Clock::time_point frameStart;
+Simulation simulation;
+ReplayWriter recorder;
 std::size_t exampleNum = 0;
+Broadphase broadphase = Broadphase::BVH;
 
 void close() {
+	simulation.stop();
+	recorder.close();
 	SDL_Quit();
 }
 
@@ -57,17 +107,79 @@ void closeWithError() {
 	close();
 }
 
-constexpr int FPS_SMOOTHING = 20; // Get an average over several frames.
-std::vector<FPS> fps_counter_;
-std::string getFPS() {
-	if (fps_counter_.size() >= FPS_SMOOTHING)
-		fps_counter_.erase(fps_counter_.begin());
-	fps_counter_.emplace_back(util::millisToFPS(elapsedTime));
-
-	FPS ave = std::accumulate(fps_counter_.cbegin(), fps_counter_.cend(), 0);
-	std::ostringstream stream;
-	stream << "FPS: " << ave / fps_counter_.size() << " - ";
-	return stream.str();
+// Frame rates are shown by the profiler overlay, so the title only changes with the example.
+void updateWindowTitle() {
+	std::string windowTitle(WINDOW_TITLE);
+	windowTitle += EXAMPLE_NAMES[exampleNum];
+	windowTitle += BROADPHASE_NAMES[static_cast<std::size_t>(broadphase)];
+	graphics.setWindowTitle(windowTitle);
+}
+
+// A command for the recording, with the current example and broadphase.
+ReplayRecord makeCommand(ReplayRecord::Type type) {
+	ReplayRecord command;
+	command.type = type;
+	command.exampleNum = static_cast<std::uint8_t>(exampleNum);
+	command.broadphase = static_cast<std::uint8_t>(broadphase);
+	return command;
+}
+
+std::unique_ptr<Example> makeExample(std::size_t num, Broadphase broadphase) {
+	switch (num) {
+	case 0:
+		return std::make_unique<ExampleShapes>(ExampleShapes::ExampleType::RECT, LEVEL_REGION, broadphase);
+	case 1:
+		return std::make_unique<ExampleShapes>(ExampleShapes::ExampleType::POLY, LEVEL_REGION, broadphase);
+	case 2:
+		return std::make_unique<ExampleShapes>(ExampleShapes::ExampleType::CIRCLE, LEVEL_REGION, broadphase);
+	case 3:
+		return std::make_unique<ExampleShapes>(ExampleShapes::ExampleType::MIXED, LEVEL_REGION, broadphase);
+	case 4:
+		return std::make_unique<ExampleRays>(ExampleRays::ExampleType::PEIRCING, LEVEL_REGION, broadphase);
+	case 5:
+		return std::make_unique<ExampleRays>(ExampleRays::ExampleType::CLOSEST, LEVEL_REGION, broadphase);
+	case 6:
+		return std::make_unique<ExampleRays>(ExampleRays::ExampleType::REFLECTING, LEVEL_REGION, broadphase);
+	case 7:
+		return std::make_unique<ExampleShapes>(ExampleShapes::ExampleType::DRIFTING, LEVEL_REGION, broadphase);
+	case 8:
+		return std::make_unique<ExampleRays>(ExampleRays::ExampleType::FAN, LEVEL_REGION, broadphase);
+	case 9:
+		return std::make_unique<ExampleCrowd>(LEVEL_REGION, broadphase);
+	case 10:
+		return std::make_unique<ExampleShapes>(ExampleShapes::ExampleType::COMPOUND, LEVEL_REGION, broadphase);
+	case 11:
+		return std::make_unique<ExampleVisibility>(LEVEL_REGION, broadphase);
+	case 12:
+		return std::make_unique<ExampleWorld>();
+	default:
+		std::cerr << "Unhandled example number.\n";
+		return std::make_unique<ExampleShapes>(ExampleShapes::ExampleType::MIXED, LEVEL_REGION, broadphase);
+	}
+}
+
+// Makes the current example when called. Examples draw from gen::rng as they are made, so the simulation calls this between steps.
+std::function<std::unique_ptr<Example>()> exampleFactory() {
+	return [num = exampleNum, bp = broadphase]() { return makeExample(num, bp); };
+}
+
+// Pan and zoom the view while keys are held. The view only changes what is drawn, so it isn't part of the recording.
+void updateView(float frameMillis) {
+	if (input.wasKeyPressed(SDLK_HOME)) {
+		view = ViewControl();
+		return;
+	}
+	const float zoomDir((input.isKeyHeld(SDLK_PAGEUP) ? 1.0f : 0.0f) - (input.isKeyHeld(SDLK_PAGEDOWN) ? 1.0f : 0.0f));
+	view.zoom = std::clamp(view.zoom * std::exp2(zoomDir * ZOOM_SPEED * frameMillis / SECOND_MILLIS), MIN_ZOOM, MAX_ZOOM);
+	const float pan(PAN_SPEED * frameMillis / view.zoom);
+	if (input.isKeyHeld(SDLK_h))
+		view.pan.x -= pan;
+	if (input.isKeyHeld(SDLK_l))
+		view.pan.x += pan;
+	if (input.isKeyHeld(SDLK_k))
+		view.pan.y -= pan;
+	if (input.isKeyHeld(SDLK_j))
+		view.pan.y += pan;
 }
 
 #ifdef __EMSCRIPTEN__
@@ -76,7 +188,13 @@ void
 bool
 #endif
 update() {
+	const Profiler::Clock::time_point now(Profiler::Clock::now());
+	if (getProfiler().isEnabled())
+		getProfiler().record(Profiler::Phase::FRAME, frameStart, now);
+	const float frameMillis(std::min(std::chrono::duration<float, std::milli>(now - frameStart).count(), 100.0f));
+	frameStart = now;
 
+	ScopedTimer inputTimer(Profiler::Phase::INPUT);
 	if (!input.refresh() || input.wasKeyPressed(SDLK_ESCAPE)) {
 #ifdef __EMSCRIPTEN__
 		emscripten_cancel_main_loop();
@@ -86,53 +204,260 @@ update() {
 #endif
 	}
 
+	constexpr std::array<SDL_Keycode, EXAMPLE_NAMES.size()> EXAMPLE_KEYS{SDLK_1, SDLK_2, SDLK_3, SDLK_4, SDLK_5, SDLK_6, SDLK_7, SDLK_8, SDLK_9, SDLK_0, SDLK_MINUS, SDLK_EQUALS, SDLK_BACKQUOTE};
+	// Commands run between simulation steps. Everything else is passed on to the simulation.
 	if (input.wasKeyPressed(SDLK_r)) {
-		example->reset();
-	} else if (input.wasKeyPressed(SDLK_1)) {
-		example = std::make_unique<ExampleShapes>(ExampleShapes::ExampleType::RECT, LEVEL_REGION);
-		exampleNum = 0;
-	} else if (input.wasKeyPressed(SDLK_2)) {
-		example = std::make_unique<ExampleShapes>(ExampleShapes::ExampleType::POLY, LEVEL_REGION);
-		exampleNum = 1;
-	} else if (input.wasKeyPressed(SDLK_3)) {
-		example = std::make_unique<ExampleShapes>(ExampleShapes::ExampleType::CIRCLE, LEVEL_REGION);
-		exampleNum = 2;
-	} else if (input.wasKeyPressed(SDLK_4)) {
-		example = std::make_unique<ExampleShapes>(ExampleShapes::ExampleType::MIXED, LEVEL_REGION);
-		exampleNum = 3;
-	} else if (input.wasKeyPressed(SDLK_5)) {
-		example = std::make_unique<ExampleRays>(ExampleRays::ExampleType::PEIRCING, LEVEL_REGION);
-		exampleNum = 4;
-	} else if (input.wasKeyPressed(SDLK_6)) {
-		example = std::make_unique<ExampleRays>(ExampleRays::ExampleType::CLOSEST, LEVEL_REGION);
-		exampleNum = 5;
-	} else if (input.wasKeyPressed(SDLK_7)) {
-		example = std::make_unique<ExampleRays>(ExampleRays::ExampleType::REFLECTING, LEVEL_REGION);
-		exampleNum = 6;
-	}
-
-	MS currentTime = SDL_GetTicks();
-	elapsedTime = currentTime - previousTime;
-	previousTime = currentTime;
-	example->update(input, elapsedTime);
-
-	graphics.clear(BACKGROUND_COLOUR);
-	example->draw(graphics);
-	std::string windowTitle = getFPS();
-	windowTitle.reserve(windowTitle.size() + WINDOW_TITLE.size() + EXAMPLE_NAMES[exampleNum].size());
-	windowTitle += WINDOW_TITLE;
-	windowTitle += EXAMPLE_NAMES[exampleNum];
-	graphics.setWindowTitle(windowTitle);
-	graphics.present();
+		simulation.withExample(makeCommand(ReplayRecord::Type::RESET), [](Example& example) { example.reset(); });
+	} else if (input.wasKeyPressed(SDLK_F5)) {
+		simulation.withExample([](Example& example) {
+			if (example.saveScene(SCENE_FILE))
+				std::cout << "Saved scene to " << SCENE_FILE << ".\n";
+		});
+	} else if (input.wasKeyPressed(SDLK_F9)) {
+		simulation.withExample(makeCommand(ReplayRecord::Type::LOAD_SCENE), [](Example& example) {
+			const auto start(std::chrono::steady_clock::now());
+			if (example.loadScene(SCENE_FILE))
+				std::cout << "Loaded scene from " << SCENE_FILE << " in "
+					<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << "ms.\n";
+		});
+	} else if (input.wasKeyPressed(SDLK_b)) { // Cycle through broadphases, restarting the current example.
+		broadphase = static_cast<Broadphase>((static_cast<std::size_t>(broadphase) + 1) % BROADPHASE_NAMES.size());
+		simulation.setExample(exampleFactory(), makeCommand(ReplayRecord::Type::EXAMPLE));
+		updateWindowTitle();
+	} else if (input.wasKeyPressed(SDLK_F3)) {
+		overlay.toggle();
+	} else if (input.wasKeyPressed(SDLK_F4)) { // Start a trace, or stop and save it.
+		if (getProfiler().isTracing())
+			getProfiler().stopTrace(TRACE_FILE);
+		else
+			getProfiler().startTrace();
+	} else {
+		for (std::size_t i = 0; i < EXAMPLE_KEYS.size(); ++i) {
+			if (input.wasKeyPressed(EXAMPLE_KEYS[i])) {
+				exampleNum = i;
+				simulation.setExample(exampleFactory(), makeCommand(ReplayRecord::Type::EXAMPLE));
+				updateWindowTitle();
+				break;
+			}
+		}
+	}
+	updateView(frameMillis);
+	simulation.pushInput(input);
+	inputTimer.stop();
+#ifdef __EMSCRIPTEN__
+	simulation.advance();
+#endif
+
+	{
+		ScopedTimer timer(Profiler::Phase::DRAW);
+		graphics.clear(BACKGROUND_COLOUR);
+		simulation.draw(graphics, view);
+		overlay.render(graphics, getProfiler(), OVERLAY_POS, simulation.getStepsPerSecond());
+	}
+	{
+		ScopedTimer timer(Profiler::Phase::PRESENT);
+		graphics.present();
+	}
 
 #ifndef __EMSCRIPTEN__
 	return true;
 #endif
 }
+
+bool parseOptions(int argc, char* args[], Options& out_options) {
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg(args[i]);
+		if (i + 1 >= argc) {
+			std::cerr << "Error: Missing value for " << arg << ".\n";
+			return false;
+		}
+		const std::string value(args[++i]);
+		if (arg == "--seed") {
+			char* end;
+			out_options.seed = static_cast<std::uint32_t>(std::strtoul(value.c_str(), &end, 10));
+			out_options.seeded = true;
+			if (value.empty() || *end != '\0') {
+				std::cerr << "Error: Invalid seed: " << value << "\n";
+				return false;
+			}
+		} else if (arg == "--record") {
+			out_options.recordPath = value;
+		} else if (arg == "--replay") {
+			out_options.replayPath = value;
+		} else if (arg == "--trace") {
+			out_options.tracePath = value;
+		} else if (arg == "--draw") {
+			out_options.draw = true;
+			if (value == "ppm") {
+				out_options.frameFormat = SoftwareBackend::FrameFormat::PPM;
+			} else if (value == "png") {
+				out_options.frameFormat = SoftwareBackend::FrameFormat::PNG;
+			} else if (value != "none") {
+				std::cerr << "Error: Invalid frame format: " << value << "\n";
+				return false;
+			}
+		} else if (arg == "--frames") {
+			out_options.framePrefix = value;
+		} else if (arg == "--zoom") {
+			char* end;
+			out_options.zoom = std::strtof(value.c_str(), &end);
+			if (value.empty() || *end != '\0' || !(out_options.zoom >= MIN_ZOOM && out_options.zoom <= MAX_ZOOM)) {
+				std::cerr << "Error: Invalid zoom: " << value << "\n";
+				return false;
+			}
+		} else {
+			std::cerr << "Error: Unknown option: " << arg << "\n";
+			return false;
+		}
+	}
+	if (!out_options.replayPath.empty() && (out_options.seeded || !out_options.recordPath.empty())) {
+		std::cerr << "Error: A replay uses the seed it was recorded with, and can't be recorded again.\n";
+		return false;
+	}
+	if (!out_options.tracePath.empty() && out_options.replayPath.empty()) {
+		std::cerr << "Error: --trace is only for replays. Use F4 to trace a live run.\n";
+		return false;
+	}
+	if (out_options.draw && out_options.replayPath.empty()) {
+		std::cerr << "Error: --draw is only for replays.\n";
+		return false;
+	}
+	if (out_options.zoom != 1 && !out_options.draw) {
+		std::cerr << "Error: --zoom is only for drawing replays, with --draw.\n";
+		return false;
+	}
+	return true;
+}
+
+void printTimes(std::string_view label, std::vector<double>& micros) {
+	double sum(0);
+	for (double m : micros)
+		sum += m;
+	std::sort(micros.begin(), micros.end());
+	std::cout << label << ": mean " << sum / micros.size() << "us, p50 " << micros[micros.size() / 2]
+		<< "us, p99 " << micros[std::min(micros.size() - 1, micros.size() * 99 / 100)] << "us, max " << micros.back() << "us\n";
+}
+
+// Step a recording's examples with its input as fast as possible, with no window, and report how long the steps took.
+// When drawing, each step is also drawn into an offscreen framebuffer, and optionally written out as an image.
+int runReplay(const Options& options) {
+	ReplayReader reader;
+	if (!reader.open(options.replayPath))
+		return -1;
+	gen::init(reader.getSeed());
+	if (options.draw) {
+		auto backend(std::make_unique<SoftwareBackend>(SCREEN_WIDTH, SCREEN_HEIGHT));
+		backend->dumpFrames(options.frameFormat, options.framePrefix);
+		graphics.init(std::move(backend));
+	}
+	if (!options.tracePath.empty()) {
+		getProfiler().setEnabled(true);
+		getProfiler().setThreadName("replay");
+		getProfiler().startTrace();
+	}
+
+	std::unique_ptr<Example> example;
+	Input stepInput;
+	ExampleSnapshot snapshot;
+	std::vector<double> stepMicros, drawMicros;
+	std::size_t primitives(0);
+	MS simulated(0);
+	ReplayRecord record;
+	const auto replayStart(std::chrono::steady_clock::now());
+	while (reader.next(record)) {
+		if (record.type == ReplayRecord::Type::EXAMPLE) {
+			if (record.exampleNum >= EXAMPLE_NAMES.size() || record.broadphase >= BROADPHASE_NAMES.size()) {
+				std::cerr << "Error: The recording has an unknown example or broadphase.\n";
+				return -1;
+			}
+			exampleNum = record.exampleNum;
+			broadphase = static_cast<Broadphase>(record.broadphase);
+			example = makeExample(exampleNum, broadphase);
+			continue;
+		}
+		if (!example) {
+			std::cerr << "Error: The recording doesn't start with an example.\n";
+			return -1;
+		}
+		switch (record.type) {
+		case ReplayRecord::Type::RESET:
+			example->reset();
+			break;
+		case ReplayRecord::Type::LOAD_SCENE:
+			example->loadScene(SCENE_FILE); // Whatever the file holds now, which may not be what was loaded when recording.
+			break;
+		case ReplayRecord::Type::STEP: {
+			stepInput.clearFrame();
+			for (const Input::KeyEvent& event : record.events) {
+				if (event.down)
+					stepInput.keyDownEvent(event.key);
+				else
+					stepInput.keyUpEvent(event.key);
+			}
+			const auto start(std::chrono::steady_clock::now());
+			{
+				ScopedTimer timer(Profiler::Phase::UPDATE);
+				example->update(stepInput, record.elapsed);
+				example->capture(snapshot);
+			}
+			stepMicros.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+			simulated += record.elapsed;
+			if (options.draw) {
+				const auto drawStart(std::chrono::steady_clock::now());
+				{
+					ScopedTimer timer(Profiler::Phase::DRAW);
+					graphics.clear(BACKGROUND_COLOUR);
+					example->draw(graphics, ViewControl{ctp::Coord2(0, 0), options.zoom}, snapshot, snapshot, 1.0f);
+					graphics.flush(); // Batches are rasterized into the framebuffer here.
+				}
+				drawMicros.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - drawStart).count());
+				graphics.present(); // Not timed, as it copies the frame and may write it out.
+				primitives += graphics.getFrameStats().primitives;
+			}
+			break;
+		}
+		default:
+			break;
+		}
+	}
+	const double totalMillis(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - replayStart).count());
+	if (!options.tracePath.empty())
+		getProfiler().stopTrace(options.tracePath);
+	if (stepMicros.empty()) {
+		std::cout << "The recording has no steps.\n";
+		return reader.hasFailed() ? -1 : 0;
+	}
+
+	std::cout << "Replayed " << stepMicros.size() << " steps (" << simulated << "ms simulated) in " << totalMillis << "ms, seed " << reader.getSeed() << ".\n";
+	printTimes("Per step", stepMicros);
+	if (options.draw) {
+		std::cout << "Drew " << drawMicros.size() << " frames of " << SCREEN_WIDTH << "x" << SCREEN_HEIGHT
+			<< ", " << primitives / drawMicros.size() << " primitives per frame.\n";
+		printTimes("Per draw", drawMicros);
+	}
+	return reader.hasFailed() ? -1 : 0;
+}
 } // namespace
 
-int run(int, char* []) {
-	gen::init();
+int run(int argc, char* args[]) {
+	Options options;
+	if (!parseOptions(argc, args, options)) {
+		std::cerr << "Usage: " << (argc > 0 ? args[0] : "examples") << " [--seed N] [--record file]\n"
+			<< "       " << (argc > 0 ? args[0] : "examples") << " --replay file [--trace file] [--draw none|ppm|png [--frames prefix] [--zoom Z]]\n";
+		return -1;
+	}
+	if (!options.replayPath.empty())
+		return runReplay(options);
+
+	const std::uint32_t seed(options.seeded ? options.seed : gen::init());
+	if (options.seeded)
+		gen::init(seed);
+	if (!options.recordPath.empty()) {
+		if (!recorder.open(options.recordPath, seed))
+			return -1;
+		simulation.setRecorder(&recorder);
+		std::cout << "Recording to " << options.recordPath << " with seed " << seed << ".\n";
+	}
 
 	if (!graphics.init(SCREEN_WIDTH, SCREEN_HEIGHT)) {
 		std::cerr << "Error: Failed to initialize graphics.\n";
@@ -140,9 +465,13 @@ int run(int, char* []) {
 		return -1;
 	}
 
-	example = std::make_unique<ExampleShapes>(ExampleShapes::ExampleType::MIXED, LEVEL_REGION);
-	exampleNum = 4;
-	previousTime = SDL_GetTicks();
+	getProfiler().setEnabled(true);
+	getProfiler().setThreadName("render");
+	exampleNum = 3;
+	simulation.setExample(exampleFactory(), makeCommand(ReplayRecord::Type::EXAMPLE));
+	updateWindowTitle();
+	simulation.start();
+	frameStart = Profiler::Clock::now();
 	// Start the game loop.
 #ifdef __EMSCRIPTEN__
 	emscripten_set_main_loop(update, -1, 1);
@@ -1,11 +1,49 @@
 #include "generator.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 
+#include "ThreadPool.hpp"
+
 namespace gen {
-void init() {
-	rng.seed(std::random_device{}());
+namespace {
+const std::size_t SHAPES_PER_TASK = 4096;
+
+// Turn the running totals of numVerts + 1 random gaps, held in the vertices' x, into vertices at sorted random angles around a circle.
+// The totals divided by the last one are sorted uniform numbers, so this needs no sort.
+// Going down from tau gives counterclockwise winding.
+void placeOnCircle(ctp::Coord2* vertices, std::size_t numVerts, ctp::gFloat total, ctp::gFloat radius) {
+	for (std::size_t i = 0; i < numVerts; ++i) {
+		const ctp::gFloat angle(ctp::constants::TAU * (1 - vertices[i].x / total));
+		vertices[i] = ctp::Coord2(radius * std::cos(angle), radius * std::sin(angle));
+	}
+}
+
+// The draws every shape in a batch starts with: which kind it is, and how many vertices if it's a polygon.
+struct ShapeHead {
+	ctp::ShapeType type;
+	std::uint32_t numVerts;
+};
+ShapeHead drawHead(Stream& stream, const ShapeSpec& spec, std::size_t minVerts) {
+	const ctp::gFloat pick(stream.unit());
+	if (pick < spec.rectShare)
+		return ShapeHead{ctp::ShapeType::RECTANGLE, 0};
+	if (pick < spec.rectShare + spec.polyShare)
+		return ShapeHead{ctp::ShapeType::POLYGON, static_cast<std::uint32_t>(stream.count(minVerts, std::max(spec.maxVerts, minVerts)))};
+	return ShapeHead{ctp::ShapeType::CIRCLE, 0};
+}
+}
+
+std::mt19937 rng;
+
+std::uint32_t init() {
+	const std::uint32_t seed(std::random_device{}());
+	init(seed);
+	return seed;
+}
+void init(std::uint32_t seed) {
+	rng.seed(seed);
 }
 
 ctp::Polygon poly(const ctp::gFloat minRad, const ctp::gFloat maxRad, const std::size_t minVerts, const std::size_t maxVerts) {
@@ -14,26 +52,22 @@ ctp::Polygon poly(const ctp::gFloat minRad, const ctp::gFloat maxRad, const std:
 	std::uniform_int_distribution<std::size_t> distVerts(min, maxVerts < min ? min : maxVerts);
 	const std::size_t numVerts(distVerts(rng));
 
-	// Generate random numbers between 0 and tau (2pi) to make points around a circle.
-	std::uniform_real_distribution<ctp::gFloat> distPI(0.0f, ctp::constants::TAU);
-	std::vector<ctp::gFloat> piVec;
-	piVec.reserve(numVerts);
-	for (std::size_t i = 0; i < numVerts; ++i)
-		piVec.push_back(distPI(rng));
-	// Sort descending (so we have counterclockwise winding).
-	std::sort(piVec.begin(), piVec.end(), [](const ctp::gFloat& lhs, const ctp::gFloat& rhs) {
-		return lhs > rhs;
-		});
-
 	// Get radius for polygon.
 	std::uniform_real_distribution<ctp::gFloat> distRad(minRad, maxRad);
-	ctp::gFloat radius(distRad(rng));
+	const ctp::gFloat radius(distRad(rng));
 
+	// Make points around a circle, from random gaps between them.
+	std::exponential_distribution<ctp::gFloat> distGap(1);
 	std::vector<ctp::Coord2> vertices;
 	vertices.reserve(numVerts);
-	for (std::size_t i = 0; i < numVerts; ++i)
-		vertices.push_back(ctp::Coord2(radius * std::cos(piVec[i]), radius * std::sin(piVec[i])));
-	return ctp::Polygon(vertices);
+	ctp::gFloat total(0);
+	for (std::size_t i = 0; i < numVerts; ++i) {
+		total += distGap(rng);
+		vertices.push_back(ctp::Coord2(total, 0));
+	}
+	total += distGap(rng);
+	placeOnCircle(vertices.data(), numVerts, total, radius);
+	return ctp::Polygon(std::move(vertices));
 }
 ctp::Coord2 coord2(const ctp::Rect& region) {
 	std::uniform_real_distribution<ctp::gFloat> X(region.left(), region.right());
@@ -44,4 +78,122 @@ ctp::gFloat gFloat(const ctp::gFloat min, const ctp::gFloat max) {
 	std::uniform_real_distribution<ctp::gFloat> f(min, max);
 	return f(rng);
 }
+
+ctp::Rect ShapeSoA::getBounds(std::size_t index) const {
+	const std::array<ctp::gFloat, 4>& p(params[index]);
+	const ctp::Coord2& pos(positions[index]);
+	switch (types[index]) {
+	case ctp::ShapeType::POLYGON: {
+		const auto first(vertices.begin() + firstVertex[index]), last(first + vertexCount[index]);
+		ctp::gFloat minX(first->x), minY(first->y), maxX(first->x), maxY(first->y);
+		for (auto v = first; v != last; ++v) {
+			minX = std::min(minX, v->x);
+			minY = std::min(minY, v->y);
+			maxX = std::max(maxX, v->x);
+			maxY = std::max(maxY, v->y);
+		}
+		return ctp::Rect(pos.x + minX, pos.y + minY, maxX - minX, maxY - minY);
+	}
+	case ctp::ShapeType::CIRCLE:
+		return ctp::Rect(pos.x + p[0] - p[2], pos.y + p[1] - p[2], 2 * p[2], 2 * p[2]);
+	case ctp::ShapeType::RECTANGLE:
+	default:
+		return ctp::Rect(pos.x + p[0], pos.y + p[1], p[2], p[3]);
+	}
+}
+ctp::Circle ShapeSoA::getBoundingCircle(std::size_t index) const {
+	const std::array<ctp::gFloat, 4>& p(params[index]);
+	switch (types[index]) {
+	case ctp::ShapeType::POLYGON: {
+		// Centred on the bounds, reaching the furthest vertex.
+		const auto first(vertices.begin() + firstVertex[index]), last(first + vertexCount[index]);
+		const ctp::Coord2 center(getBounds(index).center() - positions[index]);
+		ctp::gFloat radius2(0);
+		for (auto v = first; v != last; ++v) {
+			const ctp::Coord2 d(*v - center);
+			radius2 = std::max(radius2, d.x * d.x + d.y * d.y);
+		}
+		return ctp::Circle(center, std::sqrt(radius2));
+	}
+	case ctp::ShapeType::CIRCLE:
+		return ctp::Circle(ctp::Coord2(p[0], p[1]), p[2]);
+	case ctp::ShapeType::RECTANGLE:
+	default:
+		return ctp::Circle(ctp::Coord2(p[0] + p[2] / 2, p[1] + p[3] / 2), std::sqrt(p[2] * p[2] + p[3] * p[3]) / 2);
+	}
+}
+ctp::ShapeContainer ShapeSoA::makeShape(std::size_t index) const {
+	const std::array<ctp::gFloat, 4>& p(params[index]);
+	switch (types[index]) {
+	case ctp::ShapeType::POLYGON: {
+		const auto first(vertices.begin() + firstVertex[index]);
+		return ctp::ShapeContainer(ctp::Polygon(std::vector<ctp::Coord2>(first, first + vertexCount[index])));
+	}
+	case ctp::ShapeType::CIRCLE:
+		return ctp::ShapeContainer(ctp::Circle(ctp::Coord2(p[0], p[1]), p[2]));
+	case ctp::ShapeType::RECTANGLE:
+	default:
+		return ctp::ShapeContainer(ctp::Rect(p[0], p[1], p[2], p[3]));
+	}
+}
+
+// Two passes: the first counts each polygon's vertices so the pool can be laid out, and the second makes the shapes.
+// Each shape's stream is started again in the second pass, and carries on from the same draws.
+void shapes(game::ThreadPool& pool, std::uint64_t seed, std::size_t count, const ShapeSpec& spec, ShapeSoA& out) {
+	if (spec.minVerts < 3 || spec.maxVerts < 3) std::cerr << "Error: Cannot generate a polygon with fewer than 3 vertices. Defaulting to 3 minimum.\n";
+	const std::size_t minVerts(std::max<std::size_t>(spec.minVerts, 3));
+	out.types.resize(count);
+	out.positions.resize(count);
+	out.params.resize(count);
+	out.firstVertex.resize(count);
+	out.vertexCount.resize(count);
+
+	pool.parallelFor(count, SHAPES_PER_TASK, [&](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			Stream stream(seed, i);
+			const ShapeHead head(drawHead(stream, spec, minVerts));
+			out.types[i] = head.type;
+			out.vertexCount[i] = head.numVerts;
+		}
+	});
+	std::uint32_t numVertices(0);
+	for (std::size_t i = 0; i < count; ++i) {
+		out.firstVertex[i] = numVertices;
+		numVertices += out.vertexCount[i];
+	}
+	out.vertices.resize(numVertices);
+
+	pool.parallelFor(count, SHAPES_PER_TASK, [&](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			Stream stream(seed, i);
+			drawHead(stream, spec, minVerts);
+			const ctp::gFloat x(stream.unit()), y(stream.unit());
+			out.positions[i] = ctp::Coord2(spec.region.x + x * spec.region.w, spec.region.y + y * spec.region.h);
+			switch (out.types[i]) {
+			case ctp::ShapeType::RECTANGLE: {
+				const ctp::gFloat w(stream.range(spec.minSize, spec.maxSize)), h(stream.range(spec.minSize, spec.maxSize));
+				out.params[i] = {0, 0, w, h};
+				break;
+			}
+			case ctp::ShapeType::POLYGON: {
+				const ctp::gFloat radius(stream.range(spec.minSize, spec.maxSize));
+				ctp::Coord2* vertices(out.vertices.data() + out.firstVertex[i]);
+				ctp::gFloat total(0);
+				for (std::uint32_t v = 0; v < out.vertexCount[i]; ++v) {
+					total += -std::log(1 - stream.unit()); // An exponential gap.
+					vertices[v] = ctp::Coord2(total, 0);
+				}
+				total += -std::log(1 - stream.unit());
+				placeOnCircle(vertices, out.vertexCount[i], total, radius);
+				out.params[i] = {0, 0, 0, 0};
+				break;
+			}
+			case ctp::ShapeType::CIRCLE:
+			default:
+				out.params[i] = {0, 0, stream.range(spec.minSize, spec.maxSize), 0};
+				break;
+			}
+		}
+	});
+}
 }
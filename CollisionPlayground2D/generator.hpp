@@ -1,13 +1,23 @@
 #ifndef INCLUDE_GAME_GENERATOR_HPP
 #define INCLUDE_GAME_GENERATOR_HPP
 
+#include <array>
+#include <cstdint>
 #include <random>
+#include <vector>
 
 #include "Geometry2D/Geometry.hpp"
 
+namespace game {
+class ThreadPool;
+}
+
 namespace gen {
-static std::mt19937 rng;
-void init();
+// Shared by the functions below, which are for the main thread. Batches have their own streams of random numbers.
+extern std::mt19937 rng;
+// Seed randomly, returning the seed so the run can be repeated.
+std::uint32_t init();
+void init(std::uint32_t seed);
 // Generate a polygon.
 // region is a bounding box defining the region to place the polygon's center in (part of the polygon can be outside this region).
 // minRad and maxRad control how large the generated polygon will be.
@@ -17,6 +27,65 @@ ctp::Polygon poly(const ctp::gFloat minRad, const ctp::gFloat maxRad, const std:
 ctp::Coord2 coord2(const ctp::Rect& region);
 // Generate a gFloat within a given range [min, max).
 ctp::gFloat gFloat(const ctp::gFloat min, const ctp::gFloat max);
+
+// Random numbers for one item of a batch, made from the batch's seed and the item's index (SplitMix64).
+// Items' streams don't depend on each other, so a batch comes out the same whatever order and threads its items are made on.
+class Stream {
+public:
+	Stream(std::uint64_t seed, std::uint64_t index) : state_(_mix(seed ^ _mix(index + GAMMA))) {}
+	std::uint64_t next() {
+		state_ += GAMMA;
+		return _mix(state_);
+	}
+	// In [0, 1).
+	ctp::gFloat unit() { return static_cast<ctp::gFloat>(static_cast<double>(next() >> 40) / 16777216.0); }
+	// In [min, max).
+	ctp::gFloat range(ctp::gFloat min, ctp::gFloat max) { return min + (max - min) * unit(); }
+	// In [min, max].
+	std::size_t count(std::size_t min, std::size_t max) { return min + static_cast<std::size_t>(next() % (max - min + 1)); }
+
+private:
+	static constexpr std::uint64_t GAMMA = 0x9E3779B97F4A7C15ull;
+	std::uint64_t state_;
+
+	static std::uint64_t _mix(std::uint64_t z) {
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+};
+
+// What a batch of shapes looks like. Each shape is a rectangle, polygon or circle, picked by the given shares.
+struct ShapeSpec {
+	ctp::Rect region;          // Where the shapes' positions are.
+	ctp::gFloat minSize, maxSize;
+	std::size_t minVerts, maxVerts;
+	ctp::gFloat rectShare;     // Of the shapes that are rectangles, from 0 to 1.
+	ctp::gFloat polyShare;     // Polygons. The rest are circles.
+};
+
+// Shapes laid out as a structure of arrays, with every polygon's vertices in one pool.
+struct ShapeSoA {
+	std::vector<ctp::ShapeType> types;
+	std::vector<ctp::Coord2> positions;
+	std::vector<std::array<ctp::gFloat, 4>> params; // Rectangles: x, y, w, h. Circles: center x, center y, radius.
+	std::vector<std::uint32_t> firstVertex;         // Polygons only, as is vertexCount.
+	std::vector<std::uint32_t> vertexCount;
+	std::vector<ctp::Coord2> vertices;              // Relative to the shapes' positions.
+
+	std::size_t size() const { return types.size(); }
+	// A shape's bounding box at its position, read from the arrays.
+	ctp::Rect getBounds(std::size_t index) const;
+	// A circle containing a shape, relative to its position, as getBoundingCircle gives for the shape.
+	ctp::Circle getBoundingCircle(std::size_t index) const;
+	// Copy a shape into a container of its own, e.g. to add to a map. A polygon's vertices are copied into a vector of its own,
+	// so where only the bounds or position are needed, read those directly.
+	ctp::ShapeContainer makeShape(std::size_t index) const;
+};
+
+// Generate count shapes on the pool's threads, replacing out's. The shapes only depend on the seed, not on the number of threads.
+// Polygons are made as gen::poly makes them, with their vertices written straight into the batch's pool.
+void shapes(game::ThreadPool& pool, std::uint64_t seed, std::size_t count, const ShapeSpec& spec, ShapeSoA& out);
 }
 
 #endif // INCLUDE_GAME_GENERATOR_HPP
@@ -0,0 +1,297 @@
+#include "AABBTreeCollisionMap.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace game {
+const ctp::gFloat AABBTreeCollisionMap::DEFAULT_FAT_MARGIN = 8.0f;
+const ctp::gFloat AABBTreeCollisionMap::DISPLACEMENT_MULTIPLIER = 4.0f;
+const AABBTreeCollisionMap::Handle AABBTreeCollisionMap::NULL_HANDLE = std::numeric_limits<Handle>::max();
+
+AABBTreeCollisionMap::AABBTreeCollisionMap(ctp::gFloat fatMargin) : fat_margin_(fatMargin), root_(NULL_HANDLE), free_list_(NULL_HANDLE) {}
+AABBTreeCollisionMap::~AABBTreeCollisionMap() {
+	clear();
+}
+
+const std::vector<ctp::Collidable*> AABBTreeCollisionMap::getColliding(const ctp::Collidable& collidable, ctp::Coord2 delta) const {
+	++stats_.queries;
+	std::vector<ctp::Collidable*> colliding;
+	const ctp::Rect swept(sweepBounds(getQueryBounds(collidable), delta));
+	query(swept, [&](std::size_t index) {
+		if (_keep_candidate(bounds_[index], swept))
+			obstacles_[index]->collect(swept, colliding);
+	});
+	return colliding;
+}
+
+void AABBTreeCollisionMap::add(PreparedWall* collidable) {
+	insert(collidable);
+}
+PreparedWall* AABBTreeCollisionMap::operator[](std::size_t index) const {
+	return obstacles_[index];
+}
+std::size_t AABBTreeCollisionMap::size() const {
+	return obstacles_.size();
+}
+void AABBTreeCollisionMap::clear() {
+	for (std::size_t i = 0; i < obstacles_.size(); ++i)
+		delete obstacles_[i];
+	obstacles_.clear();
+	leaves_.clear();
+	bounds_.clear();
+	nodes_.clear();
+	root_ = NULL_HANDLE;
+	free_list_ = NULL_HANDLE;
+}
+void AABBTreeCollisionMap::refit(std::size_t index, const ctp::Coord2& displacement) {
+	move(leaves_[index], displacement);
+}
+
+bool AABBTreeCollisionMap::findCloserHit(const ctp::Ray& ray, RayHit& inout_hit) const {
+	ctp::gFloat enter, exit;
+	if (root_ == NULL_HANDLE || !clipRay(ray, nodes_[root_].bounds, enter, exit))
+		return false;
+	ctp::gFloat testNear, testFar;
+	ctp::Coord2 testNormNear, testNormFar;
+	bool found(false);
+	ray_stack_.clear();
+	ray_stack_.emplace_back(root_, enter);
+	while (!ray_stack_.empty()) {
+		const auto [index, nodeEnter] = ray_stack_.back();
+		ray_stack_.pop_back();
+		if (nodeEnter > inout_hit.near)
+			continue; // Everything in this node is further than the closest hit.
+		const Node& node(nodes_[index]);
+		if (node.isLeaf()) {
+			if (obstacles_[node.obstacle]->intersects(ray, testNear, testNormNear, testFar, testNormFar) && testNear < inout_hit.near) {
+				inout_hit = RayHit{node.obstacle, testNear, testFar, testNormNear, testNormFar};
+				found = true;
+				if (testNear == 0.0f)
+					return true;
+			}
+			continue;
+		}
+		// Push the further child first, so the nearer one is visited first.
+		ctp::gFloat leftEnter, rightEnter;
+		const bool hitLeft(clipRay(ray, nodes_[node.left].bounds, leftEnter, exit));
+		const bool hitRight(clipRay(ray, nodes_[node.right].bounds, rightEnter, exit));
+		if (hitLeft && hitRight) {
+			if (leftEnter < rightEnter) {
+				ray_stack_.emplace_back(node.right, rightEnter);
+				ray_stack_.emplace_back(node.left, leftEnter);
+			} else {
+				ray_stack_.emplace_back(node.left, leftEnter);
+				ray_stack_.emplace_back(node.right, rightEnter);
+			}
+		} else if (hitLeft) {
+			ray_stack_.emplace_back(node.left, leftEnter);
+		} else if (hitRight) {
+			ray_stack_.emplace_back(node.right, rightEnter);
+		}
+	}
+	return found;
+}
+
+AABBTreeCollisionMap::Handle AABBTreeCollisionMap::insert(PreparedWall* collidable) {
+	const std::size_t leaf(_allocate_node());
+	const ctp::Rect bounds(collidable->getBounds());
+	nodes_[leaf].bounds = _fatten(bounds, ctp::Coord2(0, 0));
+	nodes_[leaf].obstacle = obstacles_.size();
+	nodes_[leaf].height = 0;
+	obstacles_.push_back(collidable);
+	leaves_.push_back(leaf);
+	bounds_.push_back(bounds);
+	_insert_leaf(leaf);
+	return leaf;
+}
+void AABBTreeCollisionMap::remove(Handle handle) {
+	const std::size_t index(nodes_[handle].obstacle);
+	_remove_leaf(handle);
+	_free_node(handle);
+	delete obstacles_[index];
+	// Keep obstacles contiguous by moving the last one into the gap.
+	if (index != obstacles_.size() - 1) {
+		obstacles_[index] = obstacles_.back();
+		leaves_[index] = leaves_.back();
+		bounds_[index] = bounds_.back();
+		nodes_[leaves_[index]].obstacle = index;
+	}
+	obstacles_.pop_back();
+	leaves_.pop_back();
+	bounds_.pop_back();
+}
+bool AABBTreeCollisionMap::move(Handle handle, const ctp::Coord2& displacement) {
+	const std::size_t index(nodes_[handle].obstacle);
+	const ctp::Rect bounds(obstacles_[index]->getBounds());
+	bounds_[index] = bounds;
+	if (boundsContain(nodes_[handle].bounds, bounds))
+		return false; // Still inside its fat bounds: the tree doesn't need to change.
+	_remove_leaf(handle);
+	nodes_[handle].bounds = _fatten(bounds, displacement);
+	_insert_leaf(handle);
+	return true;
+}
+AABBTreeCollisionMap::Handle AABBTreeCollisionMap::getHandle(std::size_t index) const {
+	return leaves_[index];
+}
+int AABBTreeCollisionMap::height() const {
+	return root_ == NULL_HANDLE ? 0 : nodes_[root_].height;
+}
+
+ctp::Rect AABBTreeCollisionMap::_fatten(const ctp::Rect& bounds, const ctp::Coord2& displacement) const {
+	// Predict where the obstacle is going, so steady movement doesn't reinsert it every frame.
+	return sweepBounds(expandBounds(bounds, fat_margin_), displacement * DISPLACEMENT_MULTIPLIER);
+}
+std::size_t AABBTreeCollisionMap::_allocate_node() {
+	std::size_t node;
+	if (free_list_ != NULL_HANDLE) {
+		node = free_list_;
+		free_list_ = nodes_[node].parent;
+	} else {
+		node = nodes_.size();
+		nodes_.emplace_back();
+	}
+	nodes_[node].parent = NULL_HANDLE;
+	nodes_[node].left = NULL_HANDLE;
+	nodes_[node].right = NULL_HANDLE;
+	nodes_[node].height = 0;
+	return node;
+}
+void AABBTreeCollisionMap::_free_node(std::size_t node) {
+	nodes_[node].parent = free_list_;
+	nodes_[node].height = -1;
+	free_list_ = node;
+}
+void AABBTreeCollisionMap::_insert_leaf(std::size_t leaf) {
+	if (root_ == NULL_HANDLE) {
+		root_ = leaf;
+		nodes_[leaf].parent = NULL_HANDLE;
+		return;
+	}
+	// Find the best sibling for the new leaf, by the increase in total perimeter it would cause.
+	const ctp::Rect leafBounds(nodes_[leaf].bounds);
+	std::size_t index(root_);
+	while (!nodes_[index].isLeaf()) {
+		const Node& node(nodes_[index]);
+		const ctp::gFloat cost(boundsCost(node.bounds));
+		const ctp::gFloat combinedCost(boundsCost(combineBounds(node.bounds, leafBounds)));
+		const ctp::gFloat siblingCost(2 * combinedCost);                // Cost of pairing the leaf with this node.
+		const ctp::gFloat inheritanceCost(2 * (combinedCost - cost)); // Cost every descendant pays for the leaf going further down.
+		const auto descendCost = [&](std::size_t child) {
+			const ctp::gFloat childCombined(boundsCost(combineBounds(nodes_[child].bounds, leafBounds)));
+			return inheritanceCost + (nodes_[child].isLeaf() ? childCombined : childCombined - boundsCost(nodes_[child].bounds));
+		};
+		const ctp::gFloat leftCost(descendCost(node.left)), rightCost(descendCost(node.right));
+		if (siblingCost < leftCost && siblingCost < rightCost)
+			break;
+		index = leftCost < rightCost ? node.left : node.right;
+	}
+	const std::size_t sibling(index);
+	const std::size_t oldParent(nodes_[sibling].parent);
+	const std::size_t newParent(_allocate_node()); // Note this may reallocate nodes_.
+	nodes_[newParent].parent = oldParent;
+	nodes_[newParent].bounds = combineBounds(leafBounds, nodes_[sibling].bounds);
+	nodes_[newParent].height = nodes_[sibling].height + 1;
+	nodes_[newParent].left = sibling;
+	nodes_[newParent].right = leaf;
+	nodes_[sibling].parent = newParent;
+	nodes_[leaf].parent = newParent;
+	if (oldParent == NULL_HANDLE) {
+		root_ = newParent;
+	} else if (nodes_[oldParent].left == sibling) {
+		nodes_[oldParent].left = newParent;
+	} else {
+		nodes_[oldParent].right = newParent;
+	}
+	_refit_ancestors(nodes_[leaf].parent);
+}
+void AABBTreeCollisionMap::_remove_leaf(std::size_t leaf) {
+	if (leaf == root_) {
+		root_ = NULL_HANDLE;
+		return;
+	}
+	const std::size_t parent(nodes_[leaf].parent);
+	const std::size_t grandParent(nodes_[parent].parent);
+	const std::size_t sibling(nodes_[parent].left == leaf ? nodes_[parent].right : nodes_[parent].left);
+	// Replace the parent with the sibling.
+	nodes_[sibling].parent = grandParent;
+	_free_node(parent);
+	if (grandParent == NULL_HANDLE) {
+		root_ = sibling;
+		return;
+	}
+	if (nodes_[grandParent].left == parent)
+		nodes_[grandParent].left = sibling;
+	else
+		nodes_[grandParent].right = sibling;
+	_refit_ancestors(grandParent);
+}
+void AABBTreeCollisionMap::_refit_ancestors(std::size_t node) {
+	while (node != NULL_HANDLE) {
+		node = _balance(node);
+		Node& n(nodes_[node]);
+		n.height = 1 + std::max(nodes_[n.left].height, nodes_[n.right].height);
+		n.bounds = combineBounds(nodes_[n.left].bounds, nodes_[n.right].bounds);
+		node = n.parent;
+	}
+}
+std::size_t AABBTreeCollisionMap::_balance(std::size_t a) {
+	Node& A(nodes_[a]);
+	if (A.isLeaf() || A.height < 2)
+		return a;
+	const std::size_t b(A.left), c(A.right);
+	Node& B(nodes_[b]);
+	Node& C(nodes_[c]);
+	const int balance(C.height - B.height);
+	if (balance > 1) { // Rotate C up.
+		const std::size_t f(C.left), g(C.right);
+		Node& F(nodes_[f]);
+		Node& G(nodes_[g]);
+		C.left = a;
+		C.parent = A.parent;
+		A.parent = c;
+		if (C.parent == NULL_HANDLE)
+			root_ = c;
+		else if (nodes_[C.parent].left == a)
+			nodes_[C.parent].left = c;
+		else
+			nodes_[C.parent].right = c;
+		// Keep the taller of C's children, and give the other to A.
+		const bool keepF(F.height > G.height);
+		const std::size_t kept(keepF ? f : g), given(keepF ? g : f);
+		C.right = kept;
+		A.right = given;
+		nodes_[given].parent = a;
+		A.bounds = combineBounds(B.bounds, nodes_[given].bounds);
+		C.bounds = combineBounds(A.bounds, nodes_[kept].bounds);
+		A.height = 1 + std::max(B.height, nodes_[given].height);
+		C.height = 1 + std::max(A.height, nodes_[kept].height);
+		return c;
+	}
+	if (balance < -1) { // Rotate B up.
+		const std::size_t d(B.left), e(B.right);
+		Node& D(nodes_[d]);
+		Node& E(nodes_[e]);
+		B.left = a;
+		B.parent = A.parent;
+		A.parent = b;
+		if (B.parent == NULL_HANDLE)
+			root_ = b;
+		else if (nodes_[B.parent].left == a)
+			nodes_[B.parent].left = b;
+		else
+			nodes_[B.parent].right = b;
+		const bool keepD(D.height > E.height);
+		const std::size_t kept(keepD ? d : e), given(keepD ? e : d);
+		B.right = kept;
+		A.left = given;
+		nodes_[given].parent = a;
+		A.bounds = combineBounds(C.bounds, nodes_[given].bounds);
+		B.bounds = combineBounds(A.bounds, nodes_[kept].bounds);
+		A.height = 1 + std::max(C.height, nodes_[given].height);
+		B.height = 1 + std::max(A.height, nodes_[kept].height);
+		return b;
+	}
+	return a;
+}
+}
@@ -0,0 +1,107 @@
+#ifndef INCLUDE_GAME_AABB_TREE_COLLISION_MAP_HPP
+#define INCLUDE_GAME_AABB_TREE_COLLISION_MAP_HPP
+
+#include <utility>
+#include <vector>
+
+#include <Geometry2D/Geometry.hpp>
+
+#include "Bounds.hpp"
+#include "ObstacleMap.hpp"
+
+// Dynamic bounding volume tree CollisionMap implementation.
+// Each obstacle is a leaf with a fattened bounding box, so small movements don't change the tree at all.
+// Obstacles that leave their fat bounds are reinserted, and the tree is kept balanced with rotations.
+
+namespace game {
+class AABBTreeCollisionMap : public ObstacleMap {
+public:
+	using Handle = std::size_t; // Stays valid until the obstacle is removed.
+
+	static const ctp::gFloat DEFAULT_FAT_MARGIN;
+	static const ctp::gFloat DISPLACEMENT_MULTIPLIER; // How far ahead to extend fat bounds along an obstacle's displacement.
+	static const Handle NULL_HANDLE;
+
+	AABBTreeCollisionMap(ctp::gFloat fatMargin = DEFAULT_FAT_MARGIN);
+	~AABBTreeCollisionMap() override;
+
+	// Get the obstacles whose fat bounds overlap the collidable's bounds swept along delta.
+	// With swept culling, their exact bounds must overlap as well.
+	const std::vector<ctp::Collidable*> getColliding(const ctp::Collidable& collidable, ctp::Coord2 delta) const override;
+	void add(PreparedWall* collidable) override;
+	PreparedWall* operator[](std::size_t index) const override;
+	std::size_t size() const override;
+	void clear() override;
+	void refit(std::size_t index, const ctp::Coord2& displacement) override;
+	// Visits the tree front to back, skipping nodes further away than the closest hit so far.
+	bool findCloserHit(const ctp::Ray& ray, RayHit& inout_hit) const override;
+
+	// Add an obstacle, taking ownership of it.
+	Handle insert(PreparedWall* collidable);
+	// Remove and delete an obstacle. The last obstacle takes over the removed obstacle's index.
+	void remove(Handle handle);
+	// Update an obstacle after it has moved. Returns true if it left its fat bounds and had to be reinserted.
+	bool move(Handle handle, const ctp::Coord2& displacement);
+	Handle getHandle(std::size_t index) const;
+	// Height of the tree (0 for a single leaf). Useful to check balance.
+	int height() const;
+
+	// Call visit(index) for each obstacle whose fat bounds overlap the given bounds.
+	// visit must not query this map.
+	template<typename Visitor>
+	void query(const ctp::Rect& bounds, Visitor&& visit) const;
+
+private:
+	struct Node {
+		ctp::Rect bounds;     // Fattened for leaves.
+		std::size_t parent;   // Next free node while on the free list.
+		std::size_t left;
+		std::size_t right;
+		std::size_t obstacle; // Index of a leaf's obstacle.
+		int height;           // Leaves have height 0, free nodes -1.
+
+		bool isLeaf() const { return left == NULL_HANDLE; }
+	};
+
+	ctp::gFloat fat_margin_;
+	std::vector<Node> nodes_;
+	std::size_t root_;
+	std::size_t free_list_;
+	std::vector<PreparedWall*> obstacles_;
+	std::vector<Handle> leaves_;    // Leaf node of each obstacle.
+	std::vector<ctp::Rect> bounds_; // Exact bounding box of each obstacle.
+
+	mutable std::vector<std::size_t> query_stack_;
+	mutable std::vector<std::pair<std::size_t, ctp::gFloat>> ray_stack_; // Nodes with the distance the ray enters them.
+
+	ctp::Rect _fatten(const ctp::Rect& bounds, const ctp::Coord2& displacement) const;
+	std::size_t _allocate_node();
+	void _free_node(std::size_t node);
+	void _insert_leaf(std::size_t leaf);
+	void _remove_leaf(std::size_t leaf);
+	void _refit_ancestors(std::size_t node);
+	std::size_t _balance(std::size_t node); // Returns the node that replaced it.
+};
+
+template<typename Visitor>
+void AABBTreeCollisionMap::query(const ctp::Rect& bounds, Visitor&& visit) const {
+	if (root_ == NULL_HANDLE)
+		return;
+	query_stack_.clear();
+	query_stack_.push_back(root_);
+	while (!query_stack_.empty()) {
+		const Node& node(nodes_[query_stack_.back()]);
+		query_stack_.pop_back();
+		if (!boundsOverlap(node.bounds, bounds))
+			continue;
+		if (node.isLeaf()) {
+			visit(node.obstacle);
+		} else {
+			query_stack_.push_back(node.left);
+			query_stack_.push_back(node.right);
+		}
+	}
+}
+}
+
+#endif // INCLUDE_GAME_AABB_TREE_COLLISION_MAP_HPP
@@ -0,0 +1,75 @@
+#ifndef INCLUDE_GAME_ARENA_HPP
+#define INCLUDE_GAME_ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bump allocator: memory is handed out from large blocks, and all of it is given back at once by rewinding.
+// Blocks are kept when rewinding, so refilling an arena to the same size doesn't allocate.
+// Nothing is destroyed when rewinding: objects with destructors must be destroyed by their owner first.
+
+namespace game {
+class Arena {
+public:
+	static constexpr std::size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+	explicit Arena(std::size_t blockSize = DEFAULT_BLOCK_SIZE) : block_size_(blockSize) {}
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	// Get uninitialized memory for count objects of type T.
+	template<typename T>
+	T* allocate(std::size_t count = 1) {
+		return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+	}
+	void* allocate(std::size_t size, std::size_t align) {
+		for (;;) {
+			for (; block_ < blocks_.size(); ++block_, offset_ = 0) {
+				Block& block(blocks_[block_]);
+				const std::uintptr_t base(reinterpret_cast<std::uintptr_t>(block.data.get()));
+				const std::size_t start((base + offset_ + align - 1) / align * align - base);
+				if (start + size <= block.size) {
+					offset_ = start + size;
+					return block.data.get() + start;
+				}
+			}
+			// Out of blocks. Oversized requests get a block big enough for them.
+			const std::size_t blockSize(std::max(block_size_, size + align));
+			blocks_.push_back(Block{std::make_unique<char[]>(blockSize), blockSize});
+			block_ = blocks_.size() - 1;
+		}
+	}
+	// Give back everything allocated, keeping the blocks for reuse.
+	void rewind() {
+		block_ = 0;
+		offset_ = 0;
+	}
+	// Give back everything, and free the blocks.
+	void release() {
+		blocks_.clear();
+		rewind();
+	}
+	std::size_t capacity() const {
+		std::size_t total(0);
+		for (const Block& block : blocks_)
+			total += block.size;
+		return total;
+	}
+
+private:
+	struct Block {
+		std::unique_ptr<char[]> data;
+		std::size_t size;
+	};
+
+	std::size_t block_size_;
+	std::vector<Block> blocks_;
+	std::size_t block_{0};  // Block currently being allocated from.
+	std::size_t offset_{0}; // Bytes used in the current block.
+};
+}
+
+#endif // INCLUDE_GAME_ARENA_HPP
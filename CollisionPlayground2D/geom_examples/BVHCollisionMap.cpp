@@ -0,0 +1,328 @@
+#include "BVHCollisionMap.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+namespace game {
+const std::size_t BVHCollisionMap::MAX_LEAF_SIZE = 4;
+const std::size_t BVHCollisionMap::NUM_BINS = 16;
+const std::uint32_t BVHCollisionMap::NULL_NODE = std::numeric_limits<std::uint32_t>::max();
+
+namespace {
+// Builds a hierarchy top down into flat arrays.
+struct Builder {
+	const std::vector<ctp::Rect>& bounds;
+	std::vector<BVHCollisionMap::Node>& nodes;
+	std::vector<std::uint32_t>& order;
+	std::vector<std::uint32_t>& parents;
+
+	ctp::Rect leafBounds(std::uint32_t first, std::uint32_t count) const {
+		ctp::Rect result(bounds[order[first]]);
+		for (std::uint32_t i = first + 1; i < first + count; ++i)
+			result = combineBounds(result, bounds[order[i]]);
+		return result;
+	}
+	std::uint32_t buildNode(std::uint32_t parent, std::uint32_t first, std::uint32_t count);
+};
+std::uint32_t Builder::buildNode(std::uint32_t parent, std::uint32_t first, std::uint32_t count) {
+	const std::uint32_t index(static_cast<std::uint32_t>(nodes.size()));
+	nodes.push_back(BVHCollisionMap::Node{ctp::Rect(), first, count});
+	parents.push_back(parent);
+	nodes[index].bounds = leafBounds(first, count);
+	if (count <= BVHCollisionMap::MAX_LEAF_SIZE)
+		return index;
+	// Split along the axis where the obstacles' centers are most spread out.
+	const auto center = [&](std::uint32_t obs, bool xAxis) {
+		const ctp::Rect& b(bounds[obs]);
+		return xAxis ? b.x + b.w * 0.5f : b.y + b.h * 0.5f;
+	};
+	ctp::gFloat minX(center(order[first], true)), maxX(minX), minY(center(order[first], false)), maxY(minY);
+	for (std::uint32_t i = first + 1; i < first + count; ++i) {
+		minX = std::min(minX, center(order[i], true));
+		maxX = std::max(maxX, center(order[i], true));
+		minY = std::min(minY, center(order[i], false));
+		maxY = std::max(maxY, center(order[i], false));
+	}
+	const bool xAxis(maxX - minX >= maxY - minY);
+	const ctp::gFloat min(xAxis ? minX : minY), extent(xAxis ? maxX - minX : maxY - minY);
+	std::uint32_t leftCount(count / 2);
+	if (extent > 0) {
+		// Bin the obstacles by center, and find the split between bins with the lowest surface area cost.
+		const auto binOf = [&](std::uint32_t obs) {
+			return std::min(BVHCollisionMap::NUM_BINS - 1, static_cast<std::size_t>((center(obs, xAxis) - min) / extent * BVHCollisionMap::NUM_BINS));
+		};
+		std::array<std::uint32_t, BVHCollisionMap::NUM_BINS> binCounts{};
+		std::array<ctp::Rect, BVHCollisionMap::NUM_BINS> binBounds;
+		for (std::uint32_t i = first; i < first + count; ++i) {
+			const std::size_t bin(binOf(order[i]));
+			binBounds[bin] = binCounts[bin] == 0 ? bounds[order[i]] : combineBounds(binBounds[bin], bounds[order[i]]);
+			++binCounts[bin];
+		}
+		std::array<ctp::gFloat, BVHCollisionMap::NUM_BINS> leftCosts;
+		ctp::Rect sweep;
+		std::uint32_t sweepCount(0);
+		for (std::size_t i = 0; i + 1 < BVHCollisionMap::NUM_BINS; ++i) { // Cost of everything left of each split.
+			if (binCounts[i] > 0) {
+				sweep = sweepCount == 0 ? binBounds[i] : combineBounds(sweep, binBounds[i]);
+				sweepCount += binCounts[i];
+			}
+			leftCosts[i] = sweepCount == 0 ? 0 : sweepCount * boundsCost(sweep);
+		}
+		ctp::gFloat bestCost(std::numeric_limits<ctp::gFloat>::max());
+		std::size_t bestSplit(0);
+		sweepCount = 0;
+		for (std::size_t i = BVHCollisionMap::NUM_BINS - 1; i > 0; --i) { // Add the cost of everything right of each split.
+			if (binCounts[i] > 0) {
+				sweep = sweepCount == 0 ? binBounds[i] : combineBounds(sweep, binBounds[i]);
+				sweepCount += binCounts[i];
+			}
+			if (sweepCount == 0 || sweepCount == count)
+				continue;
+			const ctp::gFloat cost(leftCosts[i - 1] + sweepCount * boundsCost(sweep));
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestSplit = i;
+			}
+		}
+		const auto split(std::partition(order.begin() + first, order.begin() + first + count,
+			[&](std::uint32_t obs) { return binOf(obs) < bestSplit; }));
+		leftCount = static_cast<std::uint32_t>(split - (order.begin() + first));
+	}
+	if (leftCount == 0 || leftCount == count) {
+		// All centers fall together: fall back to splitting down the middle.
+		leftCount = count / 2;
+		std::nth_element(order.begin() + first, order.begin() + first + leftCount, order.begin() + first + count,
+			[&](std::uint32_t a, std::uint32_t b) { return center(a, xAxis) < center(b, xAxis); });
+	}
+	buildNode(index, first, leftCount); // The left child always directly follows its parent.
+	const std::uint32_t right(buildNode(index, first + leftCount, count - leftCount));
+	nodes[index].first = right;
+	nodes[index].count = 0;
+	return index;
+}
+}
+
+BVHCollisionMap::~BVHCollisionMap() {
+	clear();
+}
+
+const std::vector<ctp::Collidable*> BVHCollisionMap::getColliding(const ctp::Collidable& collidable, ctp::Coord2 delta) const {
+	++stats_.queries;
+	std::vector<ctp::Collidable*> colliding;
+	const ctp::Rect swept(sweepBounds(getQueryBounds(collidable), delta));
+	query(swept, [&](std::size_t index) {
+		if (_keep_candidate(bounds_[index], swept))
+			obstacles_[index]->collect(swept, colliding);
+	});
+	return colliding;
+}
+
+void BVHCollisionMap::add(PreparedWall* collidable) {
+	obstacles_.push_back(collidable);
+	bounds_.push_back(collidable->getBounds());
+	dirty_ = true;
+}
+PreparedWall* BVHCollisionMap::operator[](std::size_t index) const {
+	return obstacles_[index];
+}
+std::size_t BVHCollisionMap::size() const {
+	return obstacles_.size();
+}
+void BVHCollisionMap::clear() {
+	for (std::size_t i = 0; i < obstacles_.size(); ++i)
+		delete obstacles_[i];
+	obstacles_.clear();
+	bounds_.clear();
+	nodes_.clear();
+	order_.clear();
+	parents_.clear();
+	leaves_.clear();
+	dirty_ = false;
+}
+void BVHCollisionMap::refit(std::size_t index, const ctp::Coord2&) {
+	bounds_[index] = obstacles_[index]->getBounds();
+	if (dirty_)
+		return; // The whole hierarchy will be rebuilt anyway.
+	std::uint32_t node(leaves_[index]);
+	nodes_[node].bounds = _leaf_bounds(nodes_[node]);
+	while (parents_[node] != NULL_NODE) {
+		node = parents_[node];
+		nodes_[node].bounds = combineBounds(nodes_[node + 1].bounds, nodes_[nodes_[node].first].bounds);
+	}
+}
+
+bool BVHCollisionMap::findCloserHit(const ctp::Ray& ray, RayHit& inout_hit) const {
+	_update();
+	ctp::gFloat enter, exit;
+	if (nodes_.empty() || !clipRay(ray, nodes_[0].bounds, enter, exit))
+		return false;
+	ctp::gFloat testNear, testFar;
+	ctp::Coord2 testNormNear, testNormFar;
+	bool found(false);
+	ray_stack_.clear();
+	ray_stack_.emplace_back(0, enter);
+	while (!ray_stack_.empty()) {
+		const auto [index, nodeEnter] = ray_stack_.back();
+		ray_stack_.pop_back();
+		if (nodeEnter > inout_hit.near)
+			continue; // Everything in this node is further than the closest hit.
+		const Node& node(nodes_[index]);
+		if (node.count > 0) {
+			for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+				const std::uint32_t obs(order_[i]);
+				if (!clipRay(ray, bounds_[obs], enter, exit) || enter > inout_hit.near)
+					continue;
+				if (obstacles_[obs]->intersects(ray, testNear, testNormNear, testFar, testNormFar) && testNear < inout_hit.near) {
+					inout_hit = RayHit{obs, testNear, testFar, testNormNear, testNormFar};
+					found = true;
+					if (testNear == 0.0f)
+						return true;
+				}
+			}
+			continue;
+		}
+		// Push the further child first, so the nearer one is visited first.
+		const std::uint32_t left(index + 1), right(node.first);
+		ctp::gFloat leftEnter, rightEnter;
+		const bool hitLeft(clipRay(ray, nodes_[left].bounds, leftEnter, exit));
+		const bool hitRight(clipRay(ray, nodes_[right].bounds, rightEnter, exit));
+		if (hitLeft && hitRight) {
+			if (leftEnter < rightEnter) {
+				ray_stack_.emplace_back(right, rightEnter);
+				ray_stack_.emplace_back(left, leftEnter);
+			} else {
+				ray_stack_.emplace_back(left, leftEnter);
+				ray_stack_.emplace_back(right, rightEnter);
+			}
+		} else if (hitLeft) {
+			ray_stack_.emplace_back(left, leftEnter);
+		} else if (hitRight) {
+			ray_stack_.emplace_back(right, rightEnter);
+		}
+	}
+	return found;
+}
+
+void BVHCollisionMap::findClosestHits(const std::vector<ctp::Ray>& rays, std::size_t packetSize,
+	std::vector<ctp::gFloat>& out_dists, std::vector<std::size_t>& out_inds) const {
+	_update();
+	out_dists.assign(rays.size(), -1);
+	out_inds.assign(rays.size(), 0);
+	if (nodes_.empty())
+		return;
+	packetSize = std::clamp<std::size_t>(packetSize, 1, RayPacket::MAX_SIZE);
+	RayPacket packet;
+	for (std::size_t first = 0; first < rays.size(); first += packetSize) {
+		packet.load(&rays[first], std::min(packetSize, rays.size() - first));
+		_trace_packet(packet);
+		for (std::size_t i = 0; i < packet.size; ++i) {
+			if (packet.hit[i] != RayPacket::NO_HIT) {
+				out_dists[first + i] = packet.closest[i];
+				out_inds[first + i] = packet.hit[i];
+			}
+		}
+	}
+}
+
+void BVHCollisionMap::build() const {
+	buildHierarchy(bounds_, nodes_, order_, parents_);
+	leaves_.resize(obstacles_.size());
+	for (std::uint32_t i = 0; i < nodes_.size(); ++i) {
+		for (std::uint32_t j = nodes_[i].first; j < nodes_[i].first + nodes_[i].count; ++j) // Internal nodes have no count.
+			leaves_[order_[j]] = i;
+	}
+	dirty_ = false;
+}
+void BVHCollisionMap::buildHierarchy(const std::vector<ctp::Rect>& bounds,
+	std::vector<Node>& out_nodes, std::vector<std::uint32_t>& out_order, std::vector<std::uint32_t>& out_parents) {
+	out_nodes.clear();
+	out_parents.clear();
+	out_order.resize(bounds.size());
+	for (std::uint32_t i = 0; i < out_order.size(); ++i)
+		out_order[i] = i;
+	if (out_order.empty())
+		return;
+	out_nodes.reserve(2 * out_order.size() / MAX_LEAF_SIZE + 1);
+	out_parents.reserve(out_nodes.capacity());
+	Builder{bounds, out_nodes, out_order, out_parents}.buildNode(NULL_NODE, 0, static_cast<std::uint32_t>(out_order.size()));
+}
+void BVHCollisionMap::_update() const {
+	if (dirty_)
+		build();
+}
+void BVHCollisionMap::_trace_packet(RayPacket& packet) const {
+	// Children are ordered by the packet's average direction rather than per ray, so every ray takes the same path.
+	ctp::gFloat dirX(0), dirY(0);
+	for (std::size_t i = 0; i < packet.size; ++i) {
+		dirX += packet.dirX[i];
+		dirY += packet.dirY[i];
+	}
+	const auto distance = [&](const ctp::Rect& b) { return (b.x + b.w * 0.5f) * dirX + (b.y + b.h * 0.5f) * dirY; };
+	float enter[RayPacket::MAX_SIZE];
+	packet_stack_.clear();
+	packet_stack_.push_back(0);
+	while (!packet_stack_.empty()) {
+		const std::uint32_t index(packet_stack_.back());
+		packet_stack_.pop_back();
+		const Node& node(nodes_[index]);
+		// Tested when popped rather than pushed, so it uses the closest hits found since.
+		if (simd::intersectBox(packet, node.bounds, enter) == 0)
+			continue;
+		if (node.count > 0) {
+			for (std::uint32_t i = node.first; i < node.first + node.count; ++i)
+				_intersect_packet(packet, order_[i]);
+			continue;
+		}
+		const std::uint32_t left(index + 1), right(node.first);
+		if (distance(nodes_[left].bounds) < distance(nodes_[right].bounds)) {
+			packet_stack_.push_back(right);
+			packet_stack_.push_back(left);
+		} else {
+			packet_stack_.push_back(left);
+			packet_stack_.push_back(right);
+		}
+	}
+}
+void BVHCollisionMap::_intersect_packet(RayPacket& packet, std::uint32_t obs) const {
+	float near[RayPacket::MAX_SIZE];
+	std::uint32_t mask(simd::intersectBox(packet, bounds_[obs], near));
+	if (mask == 0)
+		return;
+	const PreparedWall& wall(*obstacles_[obs]);
+	const ctp::ConstShapeRef collider(wall.getCollider());
+	const ctp::Coord2 pos(wall.getPosition());
+	// A compound's collider is only its bounds, so it's tested like a polygon.
+	switch (wall.isCompound() ? ctp::ShapeType::POLYGON : collider.type()) {
+	case ctp::ShapeType::RECTANGLE:
+		break; // The bounds are the rectangle, so the box test was exact.
+	case ctp::ShapeType::CIRCLE:
+		mask = simd::intersectCircle(packet, collider.circle().center + pos, collider.circle().radius, near);
+		break;
+	default: { // No SIMD test: fall back to testing the rays that hit the bounds one at a time.
+		ctp::gFloat testNear, testFar;
+		ctp::Coord2 testNormNear, testNormFar;
+		for (std::size_t i = 0; i < packet.size; ++i) {
+			if ((mask & (1u << i)) == 0)
+				continue;
+			if (wall.intersects(packet.getRay(i), testNear, testNormNear, testFar, testNormFar) && testNear <= packet.closest[i])
+				near[i] = testNear;
+			else
+				mask &= ~(1u << i);
+		}
+	}
+	}
+	for (std::size_t i = 0; i < packet.size; ++i) {
+		if ((mask & (1u << i)) != 0 && near[i] < packet.closest[i]) {
+			packet.closest[i] = near[i];
+			packet.hit[i] = obs;
+		}
+	}
+}
+ctp::Rect BVHCollisionMap::_leaf_bounds(const Node& leaf) const {
+	ctp::Rect bounds(bounds_[order_[leaf.first]]);
+	for (std::uint32_t i = leaf.first + 1; i < leaf.first + leaf.count; ++i)
+		bounds = combineBounds(bounds, bounds_[order_[i]]);
+	return bounds;
+}
+}
@@ -0,0 +1,105 @@
+#ifndef INCLUDE_GAME_BVH_COLLISION_MAP_HPP
+#define INCLUDE_GAME_BVH_COLLISION_MAP_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <Geometry2D/Geometry.hpp>
+
+#include "Bounds.hpp"
+#include "ObstacleMap.hpp"
+#include "RayPacket.hpp"
+
+// Static bounding volume hierarchy CollisionMap implementation, aimed at ray queries.
+// The hierarchy is built top down with the surface area heuristic into a flat array, the first time it is queried after
+// obstacles are added. Moving obstacles only refits the bounds of the existing hierarchy, so it degrades if they move far.
+
+namespace game {
+class BVHCollisionMap : public ObstacleMap {
+public:
+	static const std::size_t MAX_LEAF_SIZE;
+	static const std::size_t NUM_BINS; // Number of buckets to test splits between when building.
+	static const std::uint32_t NULL_NODE;
+
+	struct Node {
+		ctp::Rect bounds;
+		std::uint32_t first; // First obstacle in order_ for leaves, or the right child for internal nodes (the left child is next).
+		std::uint32_t count; // Number of obstacles in a leaf. 0 for internal nodes.
+	};
+
+	BVHCollisionMap() = default;
+	~BVHCollisionMap() override;
+
+	// Get the obstacles in leaves whose bounds overlap the collidable's bounds swept along delta.
+	// With swept culling, their own bounds must overlap as well.
+	const std::vector<ctp::Collidable*> getColliding(const ctp::Collidable& collidable, ctp::Coord2 delta) const override;
+	void add(PreparedWall* collidable) override;
+	PreparedWall* operator[](std::size_t index) const override;
+	std::size_t size() const override;
+	void clear() override;
+	// Refit the bounds of the obstacle's leaf and its ancestors. The hierarchy itself is not rebuilt.
+	void refit(std::size_t index, const ctp::Coord2& displacement) override;
+	// Visits nodes front to back, skipping any that start further away than the closest hit so far.
+	bool findCloserHit(const ctp::Ray& ray, RayHit& inout_hit) const override;
+	// Traces packets of up to RayPacket::MAX_SIZE rays down the hierarchy together, testing boxes and circles with SIMD.
+	// Works best when the rays in a packet are coherent, like neighbouring rays in a fan.
+	void findClosestHits(const std::vector<ctp::Ray>& rays, std::size_t packetSize,
+		std::vector<ctp::gFloat>& out_dists, std::vector<std::size_t>& out_inds) const override;
+
+	// Build the hierarchy now, rather than on the next query.
+	void build() const;
+	// Build a hierarchy over a list of boxes. out_order gets the box indices grouped by leaf, and out_parents the parent of each node.
+	static void buildHierarchy(const std::vector<ctp::Rect>& bounds,
+		std::vector<Node>& out_nodes, std::vector<std::uint32_t>& out_order, std::vector<std::uint32_t>& out_parents);
+
+	// Call visit(index) for each obstacle in a leaf whose bounds overlap the given bounds.
+	// visit must not query this map.
+	template<typename Visitor>
+	void query(const ctp::Rect& bounds, Visitor&& visit) const;
+
+private:
+	std::vector<PreparedWall*> obstacles_;
+	std::vector<ctp::Rect> bounds_; // Bounding box of each obstacle.
+
+	// The hierarchy is rebuilt lazily, so it is mutable.
+	mutable bool dirty_{false};
+	mutable std::vector<Node> nodes_;
+	mutable std::vector<std::uint32_t> order_;   // Obstacle indices, grouped by leaf.
+	mutable std::vector<std::uint32_t> parents_; // Parent of each node.
+	mutable std::vector<std::uint32_t> leaves_;  // Leaf containing each obstacle.
+	mutable std::vector<std::uint32_t> query_stack_;
+	mutable std::vector<std::pair<std::uint32_t, ctp::gFloat>> ray_stack_; // Nodes with the distance the ray enters them.
+	mutable std::vector<std::uint32_t> packet_stack_;
+
+	void _update() const; // Rebuild if needed.
+	ctp::Rect _leaf_bounds(const Node& leaf) const;
+	void _trace_packet(RayPacket& packet) const;
+	void _intersect_packet(RayPacket& packet, std::uint32_t obs) const; // Test an obstacle against every active ray.
+};
+
+template<typename Visitor>
+void BVHCollisionMap::query(const ctp::Rect& bounds, Visitor&& visit) const {
+	_update();
+	if (nodes_.empty())
+		return;
+	query_stack_.clear();
+	query_stack_.push_back(0);
+	while (!query_stack_.empty()) {
+		const std::uint32_t index(query_stack_.back());
+		const Node& node(nodes_[index]);
+		query_stack_.pop_back();
+		if (!boundsOverlap(node.bounds, bounds))
+			continue;
+		if (node.count == 0) {
+			query_stack_.push_back(index + 1);
+			query_stack_.push_back(node.first);
+			continue;
+		}
+		for (std::uint32_t i = node.first; i < node.first + node.count; ++i)
+			visit(order_[i]);
+	}
+}
+}
+
+#endif // INCLUDE_GAME_BVH_COLLISION_MAP_HPP
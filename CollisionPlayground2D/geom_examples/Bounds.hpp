@@ -0,0 +1,88 @@
+#ifndef INCLUDE_GAME_BOUNDS_HPP
+#define INCLUDE_GAME_BOUNDS_HPP
+
+#include <algorithm>
+#include <limits>
+
+#include <Geometry2D/Geometry.hpp>
+
+// Axis-aligned bounding box helpers shared by the broadphase collision maps.
+
+namespace game {
+// Get the axis-aligned bounding box of a shape placed at a position.
+inline ctp::Rect getBounds(ctp::ConstShapeRef shape, const ctp::Coord2& pos) {
+	switch (shape.type()) {
+	case ctp::ShapeType::RECTANGLE: {
+		const ctp::Rect& r(shape.rect());
+		return ctp::Rect(r.x + pos.x, r.y + pos.y, r.w, r.h);
+	}
+	case ctp::ShapeType::POLYGON: {
+		const ctp::Polygon& p(shape.poly());
+		if (p.size() == 0)
+			return ctp::Rect(pos.x, pos.y, 0, 0);
+		ctp::gFloat left(p[0].x), right(p[0].x), top(p[0].y), bottom(p[0].y);
+		for (std::size_t i = 1; i < p.size(); ++i) {
+			left = std::min(left, p[i].x);
+			right = std::max(right, p[i].x);
+			top = std::min(top, p[i].y);
+			bottom = std::max(bottom, p[i].y);
+		}
+		return ctp::Rect(left + pos.x, top + pos.y, right - left, bottom - top);
+	}
+	case ctp::ShapeType::CIRCLE: {
+		const ctp::Circle& c(shape.circle());
+		return ctp::Rect(c.center.x + pos.x - c.radius, c.center.y + pos.y - c.radius, c.radius * 2, c.radius * 2);
+	}
+	default:
+		return ctp::Rect(pos.x, pos.y, 0, 0);
+	}
+}
+inline ctp::Rect getBounds(const ctp::Collidable& collidable) {
+	return getBounds(collidable.getCollider(), collidable.getPosition());
+}
+// Get the smallest box containing both boxes.
+inline ctp::Rect combineBounds(const ctp::Rect& a, const ctp::Rect& b) {
+	const ctp::gFloat left(std::min(a.x, b.x)), top(std::min(a.y, b.y));
+	return ctp::Rect(left, top, std::max(a.x + a.w, b.x + b.w) - left, std::max(a.y + a.h, b.y + b.h) - top);
+}
+// Expand a bounding box to cover everything it passes over while moving by delta.
+inline ctp::Rect sweepBounds(const ctp::Rect& bounds, const ctp::Coord2& delta) {
+	return combineBounds(bounds, ctp::Rect(bounds.x + delta.x, bounds.y + delta.y, bounds.w, bounds.h));
+}
+// Check whether two boxes overlap (touching edges count as overlapping).
+inline bool boundsOverlap(const ctp::Rect& a, const ctp::Rect& b) {
+	return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h;
+}
+// Check whether the inner box is entirely inside the outer box.
+inline bool boundsContain(const ctp::Rect& outer, const ctp::Rect& inner) {
+	return outer.x <= inner.x && outer.y <= inner.y && inner.x + inner.w <= outer.x + outer.w && inner.y + inner.h <= outer.y + outer.h;
+}
+// Grow a box by a margin on every side.
+inline ctp::Rect expandBounds(const ctp::Rect& bounds, ctp::gFloat margin) {
+	return ctp::Rect(bounds.x - margin, bounds.y - margin, bounds.w + margin * 2, bounds.h + margin * 2);
+}
+// Half the perimeter of a box, used as the cost of a box when building trees.
+inline ctp::gFloat boundsCost(const ctp::Rect& bounds) {
+	return bounds.w + bounds.h;
+}
+// Find the range of distances along a ray that are inside a box (slab test).
+// Returns false if the ray misses the box. out_enter is 0 if the ray starts inside the box.
+inline bool clipRay(const ctp::Ray& ray, const ctp::Rect& bounds, ctp::gFloat& out_enter, ctp::gFloat& out_exit) {
+	out_enter = 0;
+	out_exit = std::numeric_limits<ctp::gFloat>::max();
+	const auto clipAxis = [&out_enter, &out_exit](ctp::gFloat origin, ctp::gFloat dir, ctp::gFloat min, ctp::gFloat max) {
+		if (dir == 0)
+			return origin >= min && origin <= max;
+		ctp::gFloat near((min - origin) / dir), far((max - origin) / dir);
+		if (near > far)
+			std::swap(near, far);
+		out_enter = std::max(out_enter, near);
+		out_exit = std::min(out_exit, far);
+		return out_enter <= out_exit;
+	};
+	return clipAxis(ray.origin.x, ray.dir.x, bounds.x, bounds.x + bounds.w)
+		&& clipAxis(ray.origin.y, ray.dir.y, bounds.y, bounds.y + bounds.h);
+}
+}
+
+#endif // INCLUDE_GAME_BOUNDS_HPP
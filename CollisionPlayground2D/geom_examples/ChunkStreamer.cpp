@@ -0,0 +1,202 @@
+#include "ChunkStreamer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+
+#include "SceneFile.hpp"
+#include "ShapeUtil.hpp"
+#include "SimpleCollisionMap.hpp"
+#include "../Profiler.hpp"
+#include "../ThreadPool.hpp"
+
+namespace game {
+namespace {
+bool contains(const std::deque<ChunkCoord>& coords, const ChunkCoord& coord) {
+	return std::find(coords.begin(), coords.end(), coord) != coords.end();
+}
+}
+
+ChunkStreamer::ChunkStreamer(const WorldSpec& spec) : spec_(spec) {
+#ifndef __EMSCRIPTEN__
+	thread_ = std::thread(&ChunkStreamer::_run, this);
+#endif
+}
+ChunkStreamer::~ChunkStreamer() {
+#ifndef __EMSCRIPTEN__
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+	wake_.notify_all();
+	thread_.join();
+#endif
+}
+
+bool ChunkStreamer::exists(const ChunkCoord& coord) const {
+	return coord.x >= 0 && coord.y >= 0 && coord.x < spec_.chunksPerSide && coord.y < spec_.chunksPerSide;
+}
+
+void ChunkStreamer::request(const std::vector<ChunkCoord>& coords) {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		queue_.clear();
+		for (const ChunkCoord& coord : coords) {
+			if (!exists(coord) || (loading_ && loading_coord_ == coord) || contains(queue_, coord))
+				continue;
+			if (std::any_of(loaded_.begin(), loaded_.end(), [&](const LoadedChunk& chunk) { return chunk.coord == coord; }))
+				continue;
+			queue_.push_back(coord);
+		}
+	}
+#ifndef __EMSCRIPTEN__
+	wake_.notify_one();
+#endif
+}
+
+void ChunkStreamer::poll(std::vector<LoadedChunk>& out_loaded) {
+	std::unique_lock<std::mutex> lock(mutex_);
+#ifdef __EMSCRIPTEN__
+	released_.clear();
+	if (!queue_.empty()) {
+		const ChunkCoord coord(queue_.front());
+		queue_.pop_front();
+		lock.unlock();
+		out_loaded.push_back(_load(coord));
+		lock.lock();
+	}
+#endif
+	for (LoadedChunk& chunk : loaded_)
+		out_loaded.push_back(std::move(chunk));
+	loaded_.clear();
+}
+
+ChunkStreamer::LoadedChunk ChunkStreamer::loadNow(const ChunkCoord& coord) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	queue_.erase(std::remove(queue_.begin(), queue_.end(), coord), queue_.end());
+#ifndef __EMSCRIPTEN__
+	done_.wait(lock, [&]() { return !loading_ || loading_coord_ != coord; });
+#endif
+	const auto found(std::find_if(loaded_.begin(), loaded_.end(), [&](const LoadedChunk& chunk) { return chunk.coord == coord; }));
+	if (found != loaded_.end()) {
+		LoadedChunk chunk(std::move(*found));
+		loaded_.erase(found);
+		return chunk;
+	}
+	lock.unlock();
+	return _load(coord);
+}
+
+void ChunkStreamer::release(std::unique_ptr<ObstacleMap> map) {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		released_.push_back(std::move(map));
+	}
+#ifndef __EMSCRIPTEN__
+	wake_.notify_one();
+#endif
+}
+
+#ifndef __EMSCRIPTEN__
+void ChunkStreamer::_run() {
+	getProfiler().setThreadName("streaming");
+	std::unique_lock<std::mutex> lock(mutex_);
+	for (;;) {
+		wake_.wait(lock, [this]() { return stopping_ || !queue_.empty() || !released_.empty(); });
+		if (stopping_)
+			return;
+		if (!released_.empty()) {
+			std::vector<std::unique_ptr<ObstacleMap>> released(std::move(released_));
+			released_.clear();
+			lock.unlock();
+			released.clear();
+			lock.lock();
+			continue;
+		}
+		const ChunkCoord coord(queue_.front());
+		queue_.pop_front();
+		loading_ = true;
+		loading_coord_ = coord;
+		lock.unlock();
+		LoadedChunk chunk(_load(coord));
+		lock.lock();
+		loaded_.push_back(std::move(chunk));
+		loading_ = false;
+		done_.notify_all();
+	}
+}
+#endif
+
+ChunkStreamer::LoadedChunk ChunkStreamer::_load(const ChunkCoord& coord) const {
+	const auto start(std::chrono::steady_clock::now());
+	const std::string path(_path(coord));
+	LoadedChunk chunk{coord, std::make_unique<MappedCollisionMap>(), nullptr, 0, 0, false};
+	std::error_code error;
+	if (!std::filesystem::exists(path, error)) {
+		chunk.generated = true;
+		if (!_generate(coord, path))
+			std::cerr << "Error: Chunk " << coord.x << ", " << coord.y << " could not be generated, so it will be empty.\n";
+	}
+	auto obstacles(std::make_shared<ExampleSnapshot::ObstacleChunk>());
+	const ctp::gFloat chunkSize(spec_.chunkSize);
+	obstacles->bounds = ctp::Rect(coord.x * chunkSize, coord.y * chunkSize, chunkSize, chunkSize);
+	if (chunk.map->load(path)) {
+		// Make every obstacle's PreparedWall now, rather than on the first query that reaches it.
+		const MappedCollisionMap& map(*chunk.map);
+		std::size_t vertices(0);
+		obstacles->obstacles.reserve(map.size());
+		for (std::size_t i = 0; i < map.size(); ++i) {
+			const PreparedWall& wall(*map[i]);
+			obstacles->bounds = combineBounds(obstacles->bounds, wall.getBounds());
+			obstacles->obstacles.push_back(ExampleSnapshot::Obstacle{copyShape(wall.getCollider()), wall.getPosition(), {}});
+			vertices += map.getScene().shape(i).vertexCount;
+		}
+		// The file, each obstacle's wall and copy for drawing, and the walls' and copies' polygon vertices.
+		chunk.bytes = static_cast<std::size_t>(std::filesystem::file_size(path, error)) +
+			map.size() * (sizeof(PreparedWall) + sizeof(ExampleSnapshot::Obstacle)) + vertices * sizeof(ctp::Coord2) * 2;
+	}
+	chunk.obstacles = std::move(obstacles);
+	chunk.loadMillis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	return chunk;
+}
+
+// The file is written under another name and then renamed, so a chunk file is never seen half written.
+bool ChunkStreamer::_generate(const ChunkCoord& coord, const std::string& path) const {
+	std::error_code error;
+	std::filesystem::create_directories(spec_.directory, error);
+	if (error) {
+		std::cerr << "Error: Could not create the world directory \"" << spec_.directory << "\": " << error.message() << "\n";
+		return false;
+	}
+	gen::ShapeSpec shapes(spec_.shapes);
+	shapes.region = ctp::Rect(coord.x * spec_.chunkSize, coord.y * spec_.chunkSize, spec_.chunkSize, spec_.chunkSize);
+	const std::uint64_t seed(gen::Stream(spec_.seed, (static_cast<std::uint64_t>(static_cast<std::uint32_t>(coord.x)) << 32) |
+		static_cast<std::uint32_t>(coord.y)).next());
+	ThreadPool pool(1); // Runs inline: the chunk is small, and loadNow may generate on the simulation thread.
+	gen::ShapeSoA batch;
+	gen::shapes(pool, seed, spec_.shapesPerChunk, shapes, batch);
+	SimpleCollisionMap map;
+	for (std::size_t i = 0; i < batch.size(); ++i) {
+		if (!boundsOverlap(batch.getBounds(i), spec_.clearing))
+			map.addWall(batch.makeShape(i), batch.positions[i]);
+	}
+	const std::string temporary(path + ".tmp");
+	if (!saveScene(temporary, map, shapes.region))
+		return false;
+	std::filesystem::rename(temporary, path, error);
+	if (error) {
+		std::cerr << "Error: Could not rename \"" << temporary << "\" to \"" << path << "\": " << error.message() << "\n";
+		return false;
+	}
+	return true;
+}
+
+std::string ChunkStreamer::_path(const ChunkCoord& coord) const {
+	char name[48];
+	std::snprintf(name, sizeof(name), "chunk_%d_%d.cpscene", coord.x, coord.y);
+	return (std::filesystem::path(spec_.directory) / name).string();
+}
+}
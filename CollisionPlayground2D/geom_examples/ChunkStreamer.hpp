@@ -0,0 +1,93 @@
+#ifndef INCLUDE_GAME_CHUNK_STREAMER_HPP
+#define INCLUDE_GAME_CHUNK_STREAMER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#ifndef __EMSCRIPTEN__
+#include <condition_variable>
+#include <thread>
+#endif
+
+#include "ChunkedCollisionMap.hpp"
+#include "ExampleSnapshot.hpp"
+#include "MappedCollisionMap.hpp"
+#include "../generator.hpp"
+
+#include <Geometry2D/Geometry.hpp>
+
+// Loads the chunks of a world on a background thread, so stepping never waits on the disk.
+// Each chunk is a scene file of its own, with its hierarchy prebuilt. A chunk whose file is missing is generated and written first,
+// from the world's seed and the chunk's coordinates, so the world comes out the same every time.
+// A loaded chunk comes back with every obstacle already prepared, and already copied for drawing,
+// so making it resident only moves pointers. Evicted chunks can be handed back, to be freed on the loading thread too.
+// Emscripten has no threads here: there, poll() loads one requested chunk per call instead.
+
+namespace game {
+struct WorldSpec {
+	std::string directory;        // Where the chunk files are kept.
+	std::uint64_t seed;
+	ctp::gFloat chunkSize;
+	std::int32_t chunksPerSide;   // Chunks (0, 0) to (chunksPerSide - 1, chunksPerSide - 1) exist.
+	std::size_t shapesPerChunk;
+	gen::ShapeSpec shapes;        // Of every chunk. The region is replaced by the chunk's.
+	ctp::Rect clearing;           // Kept free of obstacles, for the mover to start in.
+};
+
+class ChunkStreamer {
+public:
+	struct LoadedChunk {
+		ChunkCoord coord;
+		std::unique_ptr<MappedCollisionMap> map;
+		std::shared_ptr<const ExampleSnapshot::ObstacleChunk> obstacles; // For drawing.
+		std::size_t bytes;  // Roughly what the chunk takes in memory.
+		double loadMillis;  // To generate (if the file was missing) and load it.
+		bool generated;
+	};
+
+	explicit ChunkStreamer(const WorldSpec& spec);
+	~ChunkStreamer();
+	ChunkStreamer(const ChunkStreamer&) = delete;
+	ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+	const WorldSpec& getSpec() const { return spec_; }
+	bool exists(const ChunkCoord& coord) const;
+	// Load these chunks, in order, replacing whatever was asked for before and hasn't started loading.
+	// Chunks being loaded, or loaded and not yet taken, aren't loaded again.
+	void request(const std::vector<ChunkCoord>& coords);
+	// Add the chunks loaded since the last call to out_loaded.
+	void poll(std::vector<LoadedChunk>& out_loaded);
+	// Load a chunk on the calling thread, for when stepping can't go on without it.
+	// If the loading thread already has it, waits for that instead.
+	LoadedChunk loadNow(const ChunkCoord& coord);
+	// Free a chunk's map on the loading thread.
+	void release(std::unique_ptr<ObstacleMap> map);
+
+private:
+	const WorldSpec spec_;
+
+	std::mutex mutex_; // Guards everything below.
+	std::deque<ChunkCoord> queue_;
+	std::vector<LoadedChunk> loaded_;
+	std::vector<std::unique_ptr<ObstacleMap>> released_;
+	bool loading_{false}; // Whether the loading thread is loading loading_coord_.
+	ChunkCoord loading_coord_{0, 0};
+#ifndef __EMSCRIPTEN__
+	std::condition_variable wake_; // Work for the loading thread.
+	std::condition_variable done_; // A chunk has loaded.
+	bool stopping_{false};
+	std::thread thread_;
+	void _run();
+#endif
+
+	LoadedChunk _load(const ChunkCoord& coord) const;
+	bool _generate(const ChunkCoord& coord, const std::string& path) const;
+	std::string _path(const ChunkCoord& coord) const;
+};
+}
+
+#endif // INCLUDE_GAME_CHUNK_STREAMER_HPP
@@ -0,0 +1,166 @@
+#include "ChunkedCollisionMap.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace game {
+ChunkedCollisionMap::ChunkedCollisionMap(ctp::gFloat chunkSize, ctp::gFloat overhang) : chunk_size_(chunkSize), overhang_(overhang) {}
+ChunkedCollisionMap::~ChunkedCollisionMap() {
+	clear();
+}
+
+ChunkCoord ChunkedCollisionMap::getChunk(const ctp::Coord2& position) const {
+	return ChunkCoord{static_cast<std::int32_t>(std::floor(position.x / chunk_size_)), static_cast<std::int32_t>(std::floor(position.y / chunk_size_))};
+}
+ctp::Rect ChunkedCollisionMap::getChunkRegion(const ChunkCoord& coord) const {
+	return ctp::Rect(coord.x * chunk_size_, coord.y * chunk_size_, chunk_size_, chunk_size_);
+}
+
+void ChunkedCollisionMap::addChunk(const ChunkCoord& coord, std::unique_ptr<ObstacleMap> map) {
+	const ObstacleMap& chunkMap(*map);
+	ctp::Rect bounds(getChunkRegion(coord));
+	for (std::size_t i = 0; i < chunkMap.size(); ++i)
+		bounds = combineBounds(bounds, chunkMap[i]->getBounds());
+	const auto found(lookup_.find(_key(coord)));
+	if (found != lookup_.end()) {
+		chunks_[found->second].map = std::move(map);
+		chunks_[found->second].bounds = bounds;
+	} else {
+		lookup_.emplace(_key(coord), chunks_.size());
+		chunks_.push_back(Chunk{coord, std::move(map), bounds});
+	}
+	starts_valid_ = false;
+}
+// The last chunk takes the removed one's place, so removing doesn't move the others.
+std::unique_ptr<ObstacleMap> ChunkedCollisionMap::removeChunk(const ChunkCoord& coord) {
+	const auto found(lookup_.find(_key(coord)));
+	if (found == lookup_.end())
+		return nullptr;
+	const std::size_t index(found->second);
+	lookup_.erase(found);
+	std::unique_ptr<ObstacleMap> map(std::move(chunks_[index].map));
+	if (index + 1 != chunks_.size()) {
+		chunks_[index] = std::move(chunks_.back());
+		lookup_[_key(chunks_[index].coord)] = index;
+	}
+	chunks_.pop_back();
+	starts_valid_ = false;
+	return map;
+}
+
+void ChunkedCollisionMap::findChunks(const ctp::Rect& bounds, std::vector<ChunkCoord>& out_coords) const {
+	ChunkCoord first, last;
+	_chunk_range(bounds, first, last);
+	for (std::int32_t y = first.y; y <= last.y; ++y) {
+		for (std::int32_t x = first.x; x <= last.x; ++x)
+			out_coords.push_back(ChunkCoord{x, y});
+	}
+}
+// Obstacles reach past their chunk by up to the overhang, so chunks that far outside the bounds are included.
+void ChunkedCollisionMap::_chunk_range(const ctp::Rect& bounds, ChunkCoord& out_first, ChunkCoord& out_last) const {
+	out_first = getChunk(ctp::Coord2(bounds.x - overhang_, bounds.y - overhang_));
+	out_last = getChunk(ctp::Coord2(bounds.x + bounds.w + overhang_, bounds.y + bounds.h + overhang_));
+}
+template<typename Func>
+void ChunkedCollisionMap::_for_chunks(const ctp::Rect& bounds, Func&& f) const {
+	ChunkCoord first, last;
+	_chunk_range(bounds, first, last);
+	for (std::int32_t y = first.y; y <= last.y; ++y) {
+		for (std::int32_t x = first.x; x <= last.x; ++x) {
+			const auto found(lookup_.find(_key(ChunkCoord{x, y})));
+			if (found != lookup_.end() && boundsOverlap(chunks_[found->second].bounds, bounds))
+				f(chunks_[found->second]);
+		}
+	}
+}
+
+const std::vector<ctp::Collidable*> ChunkedCollisionMap::getColliding(const ctp::Collidable& collidable, ctp::Coord2 delta) const {
+	++stats_.queries;
+	const ctp::Rect swept(sweepBounds(getQueryBounds(collidable), delta));
+	std::vector<ctp::Collidable*> colliding;
+	_for_chunks(swept, [&](const Chunk& chunk) {
+		const std::vector<ctp::Collidable*> found(chunk.map->getColliding(collidable, delta));
+		colliding.insert(colliding.end(), found.begin(), found.end());
+	});
+	for (std::size_t i = 0; i < added_.size(); ++i) {
+		if (_keep_candidate(added_bounds_[i], swept))
+			added_[i]->collect(swept, colliding);
+	}
+	return colliding;
+}
+
+void ChunkedCollisionMap::add(PreparedWall* collidable) {
+	added_.push_back(collidable);
+	added_bounds_.push_back(collidable->getBounds());
+	starts_valid_ = false;
+}
+PreparedWall* ChunkedCollisionMap::operator[](std::size_t index) const {
+	_update_starts();
+	if (index >= starts_.back())
+		return added_[index - starts_.back()];
+	const std::size_t chunk(static_cast<std::size_t>(std::upper_bound(starts_.begin(), starts_.end(), index) - starts_.begin()) - 1);
+	return (*chunks_[chunk].map)[index - starts_[chunk]];
+}
+std::size_t ChunkedCollisionMap::size() const {
+	_update_starts();
+	return starts_.back() + added_.size();
+}
+void ChunkedCollisionMap::clear() {
+	chunks_.clear();
+	lookup_.clear();
+	for (std::size_t i = 0; i < added_.size(); ++i)
+		delete added_[i];
+	added_.clear();
+	added_bounds_.clear();
+	starts_valid_ = false;
+}
+void ChunkedCollisionMap::refit(std::size_t index, const ctp::Coord2&) {
+	_update_starts();
+	if (index < starts_.back()) {
+		std::cerr << "Error: Obstacles in a world chunk can't move.\n";
+		return;
+	}
+	added_bounds_[index - starts_.back()] = added_[index - starts_.back()]->getBounds();
+}
+// Each chunk only has to beat the closest hit so far, so chunks the ray reaches after it are skipped.
+bool ChunkedCollisionMap::findCloserHit(const ctp::Ray& ray, RayHit& inout_hit) const {
+	_update_starts();
+	bool found(false);
+	ctp::gFloat enter, exit;
+	for (std::size_t c = 0; c < chunks_.size(); ++c) {
+		if (!clipRay(ray, chunks_[c].bounds, enter, exit) || enter > inout_hit.near)
+			continue;
+		RayHit hit(inout_hit);
+		if (chunks_[c].map->findCloserHit(ray, hit)) {
+			inout_hit = hit;
+			inout_hit.index += starts_[c];
+			found = true;
+		}
+	}
+	ctp::gFloat testNear, testFar;
+	ctp::Coord2 testNormNear, testNormFar;
+	for (std::size_t i = 0; i < added_.size(); ++i) {
+		if (!clipRay(ray, added_bounds_[i], enter, exit) || enter > inout_hit.near)
+			continue;
+		if (added_[i]->intersects(ray, testNear, testNormNear, testFar, testNormFar) && testNear < inout_hit.near) {
+			inout_hit = RayHit{starts_.back() + i, testNear, testFar, testNormNear, testNormFar};
+			found = true;
+		}
+	}
+	return found;
+}
+
+void ChunkedCollisionMap::_update_starts() const {
+	if (starts_valid_)
+		return;
+	starts_.resize(chunks_.size() + 1);
+	std::size_t total(0);
+	for (std::size_t c = 0; c < chunks_.size(); ++c) {
+		starts_[c] = total;
+		total += chunks_[c].map->size();
+	}
+	starts_.back() = total;
+	starts_valid_ = true;
+}
+}
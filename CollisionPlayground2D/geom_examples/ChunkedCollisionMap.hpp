@@ -0,0 +1,86 @@
+#ifndef INCLUDE_GAME_CHUNKED_COLLISION_MAP_HPP
+#define INCLUDE_GAME_CHUNKED_COLLISION_MAP_HPP
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <Geometry2D/Geometry.hpp>
+
+#include "ObstacleMap.hpp"
+
+// CollisionMap over the resident chunks of a world split into square chunks, each chunk's obstacles in a map of their own.
+// Chunks are made resident and evicted whole, without touching the other chunks' maps, so neither costs more for a bigger world.
+// An obstacle belongs to the chunk its position is in, but can reach up to the overhang past the chunk's edge.
+// Queries only look at the chunks near them, so obstacles in chunks that aren't resident are simply not there.
+// Obstacles added directly, rather than with a chunk, are kept in memory and tested one by one.
+
+namespace game {
+struct ChunkCoord {
+	std::int32_t x, y;
+
+	bool operator==(const ChunkCoord& other) const { return x == other.x && y == other.y; }
+	bool operator!=(const ChunkCoord& other) const { return !(*this == other); }
+};
+
+class ChunkedCollisionMap : public ObstacleMap {
+public:
+	ChunkedCollisionMap(ctp::gFloat chunkSize, ctp::gFloat overhang);
+	~ChunkedCollisionMap() override;
+
+	ctp::gFloat getChunkSize() const { return chunk_size_; }
+	ChunkCoord getChunk(const ctp::Coord2& position) const;
+	ctp::Rect getChunkRegion(const ChunkCoord& coord) const;
+	// Add every chunk, resident or not, whose obstacles could reach into the bounds.
+	void findChunks(const ctp::Rect& bounds, std::vector<ChunkCoord>& out_coords) const;
+
+	// Make a chunk resident, with its obstacles in their own map. Replaces the chunk if it is already resident.
+	void addChunk(const ChunkCoord& coord, std::unique_ptr<ObstacleMap> map);
+	// Take a chunk's map back out. Returns nullptr if it wasn't resident.
+	std::unique_ptr<ObstacleMap> removeChunk(const ChunkCoord& coord);
+	bool isResident(const ChunkCoord& coord) const { return lookup_.count(_key(coord)) != 0; }
+	std::size_t getChunkCount() const { return chunks_.size(); }
+	const ChunkCoord& getChunkCoord(std::size_t index) const { return chunks_[index].coord; }
+
+	const std::vector<ctp::Collidable*> getColliding(const ctp::Collidable& collidable, ctp::Coord2 delta) const override;
+	// Chunks' obstacles come in the order the chunks were made resident, followed by added obstacles.
+	// Indices change whenever a chunk is added or removed.
+	void add(PreparedWall* collidable) override;
+	PreparedWall* operator[](std::size_t index) const override;
+	std::size_t size() const override;
+	// Remove every chunk and added obstacle.
+	void clear() override;
+	// Only added obstacles can move.
+	void refit(std::size_t index, const ctp::Coord2& displacement) override;
+	bool findCloserHit(const ctp::Ray& ray, RayHit& inout_hit) const override;
+
+private:
+	struct Chunk {
+		ChunkCoord coord;
+		std::unique_ptr<ObstacleMap> map;
+		ctp::Rect bounds; // Of the chunk's obstacles.
+	};
+
+	ctp::gFloat chunk_size_;
+	ctp::gFloat overhang_;
+	std::vector<Chunk> chunks_;
+	std::unordered_map<std::uint64_t, std::size_t> lookup_; // Chunk key to its index in chunks_.
+	std::vector<PreparedWall*> added_;
+	std::vector<ctp::Rect> added_bounds_;
+
+	mutable std::vector<std::size_t> starts_; // Index of each chunk's first obstacle, and the total at the end.
+	mutable bool starts_valid_{false};
+
+	static std::uint64_t _key(const ChunkCoord& coord) {
+		return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(coord.x)) << 32) | static_cast<std::uint32_t>(coord.y);
+	}
+	void _update_starts() const;
+	void _chunk_range(const ctp::Rect& bounds, ChunkCoord& out_first, ChunkCoord& out_last) const;
+	// Call f(chunk) for each resident chunk whose obstacles might overlap the bounds.
+	template<typename Func>
+	void _for_chunks(const ctp::Rect& bounds, Func&& f) const;
+};
+}
+
+#endif // INCLUDE_GAME_CHUNKED_COLLISION_MAP_HPP
@@ -0,0 +1,99 @@
+#include "CompoundWall.hpp"
+
+#include "Bounds.hpp"
+
+namespace game {
+CompoundWall::Part::Part(const CompoundWall& wall, const ctp::ShapeContainer& collider, const ctp::Coord2& offset)
+	: wall_(&wall), collider_(collider), offset_(offset) {
+	computeNormals(collider_);
+	prepared_ = prepareShape(collider_);
+}
+
+CompoundWall::CompoundWall(const std::vector<std::pair<ctp::ShapeContainer, ctp::Coord2>>& parts, const ctp::Coord2& position)
+	: PreparedWall(ctp::ShapeContainer(_get_bounds(parts)), position) {
+	std::vector<ctp::Rect> bounds;
+	bounds.reserve(parts.size());
+	for (const auto& part : parts)
+		bounds.push_back(game::getBounds(part.first, part.second));
+	std::vector<std::uint32_t> order, parents;
+	BVHCollisionMap::buildHierarchy(bounds, nodes_, order, parents);
+	parts_.reserve(order.size());
+	for (std::uint32_t i : order)
+		parts_.emplace_back(*this, parts[i].first, parts[i].second);
+}
+
+void CompoundWall::collect(const ctp::Rect& bounds, std::vector<ctp::Collidable*>& out) {
+	query(bounds, [&](std::size_t i) {
+		if (boundsOverlap(parts_[i].getPrepared().getBounds(parts_[i].getPosition()), bounds))
+			out.push_back(&parts_[i]);
+	});
+}
+
+bool CompoundWall::intersects(const ctp::Ray& ray,
+	ctp::gFloat& out_near, ctp::Coord2& out_norm_near, ctp::gFloat& out_far, ctp::Coord2& out_norm_far) const {
+	if (nodes_.empty())
+		return false;
+	ctp::gFloat closest(-1);
+	_intersect(0, ray, ctp::Ray{ray.origin - position_, ray.dir}, closest, out_near, out_norm_near, out_far, out_norm_far);
+	return closest != -1;
+}
+
+bool CompoundWall::overlaps(ctp::ConstShapeRef shape, const ctp::Coord2& pos, const PreparedShape& prepared) const {
+	bool overlapping(false);
+	query(prepared.getBounds(pos), [&](std::size_t i) {
+		const Part& part(parts_[i]);
+		overlapping = overlapping || (mayOverlap(prepared, pos, part.getPrepared(), part.getPosition())
+			&& ctp::overlaps(shape, pos, part.getCollider(), part.getPosition()));
+	});
+	return overlapping;
+}
+bool CompoundWall::overlaps(const PreparedWall& other) const {
+	bool overlapping(false);
+	query(other.getBounds(), [&](std::size_t i) {
+		const Part& part(parts_[i]);
+		overlapping = overlapping || other.overlaps(part.getCollider(), part.getPosition(), part.getPrepared());
+	});
+	return overlapping;
+}
+
+ctp::Rect CompoundWall::_get_bounds(const std::vector<std::pair<ctp::ShapeContainer, ctp::Coord2>>& parts) {
+	if (parts.empty())
+		return ctp::Rect(0, 0, 0, 0);
+	ctp::Rect bounds(game::getBounds(parts[0].first, parts[0].second));
+	for (std::size_t i = 1; i < parts.size(); ++i)
+		bounds = combineBounds(bounds, game::getBounds(parts[i].first, parts[i].second));
+	return bounds;
+}
+// Visits the nearer child first, and skips nodes that start further away than the closest hit so far.
+void CompoundWall::_intersect(std::uint32_t index, const ctp::Ray& ray, const ctp::Ray& localRay, ctp::gFloat& closest,
+	ctp::gFloat& out_near, ctp::Coord2& out_norm_near, ctp::gFloat& out_far, ctp::Coord2& out_norm_far) const {
+	const BVHCollisionMap::Node& node(nodes_[index]);
+	if (node.count > 0) {
+		ctp::gFloat testNear, testFar;
+		ctp::Coord2 testNormNear, testNormFar;
+		for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+			const Part& part(parts_[i]);
+			if (ctp::intersects(ray, part.getCollider(), part.getPosition(), testNear, testNormNear, testFar, testNormFar)
+				&& (closest == -1 || testNear < closest)) {
+				closest = testNear;
+				out_near = testNear;
+				out_norm_near = testNormNear;
+				out_far = testFar;
+				out_norm_far = testNormFar;
+			}
+		}
+		return;
+	}
+	ctp::gFloat leftEnter, rightEnter, exit;
+	const bool hitLeft(clipRay(localRay, nodes_[index + 1].bounds, leftEnter, exit));
+	const bool hitRight(clipRay(localRay, nodes_[node.first].bounds, rightEnter, exit));
+	const bool leftFirst(!hitRight || (hitLeft && leftEnter <= rightEnter));
+	const std::uint32_t children[2] = {leftFirst ? index + 1 : node.first, leftFirst ? node.first : index + 1};
+	const bool hits[2] = {leftFirst ? hitLeft : hitRight, leftFirst ? hitRight : hitLeft};
+	const ctp::gFloat enters[2] = {leftFirst ? leftEnter : rightEnter, leftFirst ? rightEnter : leftEnter};
+	for (int c = 0; c < 2; ++c) {
+		if (hits[c] && (closest == -1 || enters[c] <= closest))
+			_intersect(children[c], ray, localRay, closest, out_near, out_norm_near, out_far, out_norm_far);
+	}
+}
+}
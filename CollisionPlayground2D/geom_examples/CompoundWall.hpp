@@ -0,0 +1,88 @@
+#ifndef INCLUDE_GAME_COMPOUND_WALL_HPP
+#define INCLUDE_GAME_COMPOUND_WALL_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <Geometry2D/Geometry.hpp>
+
+#include "BVHCollisionMap.hpp"
+#include "PreparedShape.hpp"
+
+// An obstacle made of many shapes, each at an offset from the wall's position, e.g. a concave obstacle built from convex pieces.
+// It's one obstacle in a map, with one index, but ctp only ever sees its parts: a small bounding volume hierarchy over the parts
+// (built as BVHCollisionMap builds its own) finds the ones a query reaches, and only those are tested or returned to Movable::move.
+// The wall's own collider is the box around all of its parts, which is what maps use as its bounds.
+// The parts can't change, but the wall can move, and its parts move with it.
+
+namespace game {
+class CompoundWall : public PreparedWall {
+public:
+	// One of a compound's shapes, which is what ctp tests against.
+	class Part : public ctp::Collidable {
+	public:
+		Part(const CompoundWall& wall, const ctp::ShapeContainer& collider, const ctp::Coord2& offset);
+
+		ctp::ConstShapeRef getCollider() const override { return collider_; }
+		ctp::Coord2 getPosition() const override { return wall_->getPosition() + offset_; }
+		const CompoundWall& getWall() const { return *wall_; }
+		const ctp::Coord2& getOffset() const { return offset_; }
+		const PreparedShape& getPrepared() const { return prepared_; }
+
+	private:
+		const CompoundWall* wall_;
+		ctp::ShapeContainer collider_;
+		ctp::Coord2 offset_;
+		PreparedShape prepared_;
+	};
+
+	// Make a wall from shapes and their offsets from its position.
+	CompoundWall(const std::vector<std::pair<ctp::ShapeContainer, ctp::Coord2>>& parts, const ctp::Coord2& position);
+	// Parts point back at their wall, so it can't be copied.
+	CompoundWall(const CompoundWall&) = delete;
+	CompoundWall& operator=(const CompoundWall&) = delete;
+
+	std::size_t getPartCount() const { return parts_.size(); }
+	const Part& getPart(std::size_t index) const { return parts_[index]; }
+
+	bool isCompound() const override { return true; }
+	void collect(const ctp::Rect& bounds, std::vector<ctp::Collidable*>& out) override;
+	// The closest part hit, with where the ray enters and exits that part.
+	bool intersects(const ctp::Ray& ray,
+		ctp::gFloat& out_near, ctp::Coord2& out_norm_near, ctp::gFloat& out_far, ctp::Coord2& out_norm_far) const override;
+	bool overlaps(ctp::ConstShapeRef shape, const ctp::Coord2& pos, const PreparedShape& prepared) const override;
+	bool overlaps(const PreparedWall& other) const override;
+
+	// Call visit(index) for each part in a leaf whose bounds overlap the given bounds. The bounds are in world space.
+	template<typename Visitor>
+	void query(const ctp::Rect& bounds, Visitor&& visit) const {
+		if (!nodes_.empty())
+			_query(0, ctp::Rect(bounds.x - position_.x, bounds.y - position_.y, bounds.w, bounds.h), visit);
+	}
+
+private:
+	std::vector<Part> parts_; // Grouped by leaf.
+	std::vector<BVHCollisionMap::Node> nodes_; // Bounds relative to the wall's position.
+
+	static ctp::Rect _get_bounds(const std::vector<std::pair<ctp::ShapeContainer, ctp::Coord2>>& parts);
+	// Recurses rather than keeping a stack, so several threads can query the same wall.
+	template<typename Visitor>
+	void _query(std::uint32_t index, const ctp::Rect& localBounds, Visitor& visit) const {
+		const BVHCollisionMap::Node& node(nodes_[index]);
+		if (!boundsOverlap(node.bounds, localBounds))
+			return;
+		if (node.count > 0) {
+			for (std::uint32_t i = node.first; i < node.first + node.count; ++i)
+				visit(static_cast<std::size_t>(i));
+			return;
+		}
+		_query(index + 1, localBounds, visit);
+		_query(node.first, localBounds, visit);
+	}
+	void _intersect(std::uint32_t index, const ctp::Ray& ray, const ctp::Ray& localRay, ctp::gFloat& closest,
+		ctp::gFloat& out_near, ctp::Coord2& out_norm_near, ctp::gFloat& out_far, ctp::Coord2& out_norm_far) const;
+};
+}
+
+#endif // INCLUDE_GAME_COMPOUND_WALL_HPP
@@ -0,0 +1,45 @@
+#include "CrowdGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace game {
+void CrowdGrid::build(const ctp::Rect& region, ctp::gFloat cellSize, const std::vector<ctp::Rect>& bounds) {
+	region_ = region;
+	cell_size_ = cellSize;
+	cols_ = std::max(1, static_cast<std::int32_t>(std::ceil(region.w / cellSize)));
+	rows_ = std::max(1, static_cast<std::int32_t>(std::ceil(region.h / cellSize)));
+	bounds_ = bounds;
+
+	// Counting sort: count the entries in each cell, turn the counts into offsets, then place the entries.
+	const std::size_t numCells(static_cast<std::size_t>(cols_) * rows_);
+	cell_start_.assign(numCells + 1, 0);
+	for (const ctp::Rect& b : bounds_) {
+		const std::int32_t firstCol(_col(b.x)), lastCol(_col(b.x + b.w)), firstRow(_row(b.y)), lastRow(_row(b.y + b.h));
+		for (std::int32_t row = firstRow; row <= lastRow; ++row)
+			for (std::int32_t col = firstCol; col <= lastCol; ++col)
+				++cell_start_[static_cast<std::size_t>(row) * cols_ + col + 1];
+	}
+	for (std::size_t cell = 0; cell < numCells; ++cell)
+		cell_start_[cell + 1] += cell_start_[cell];
+	entries_.resize(cell_start_[numCells]);
+	for (std::uint32_t i = 0; i < bounds_.size(); ++i) {
+		const ctp::Rect& b(bounds_[i]);
+		const std::int32_t firstCol(_col(b.x)), lastCol(_col(b.x + b.w)), firstRow(_row(b.y)), lastRow(_row(b.y + b.h));
+		for (std::int32_t row = firstRow; row <= lastRow; ++row)
+			for (std::int32_t col = firstCol; col <= lastCol; ++col)
+				entries_[cell_start_[static_cast<std::size_t>(row) * cols_ + col]++] = i;
+	}
+	// Placing the entries moved each cell's start to the next cell's. Shift them back.
+	for (std::size_t cell = numCells; cell > 0; --cell)
+		cell_start_[cell] = cell_start_[cell - 1];
+	cell_start_[0] = 0;
+}
+
+std::int32_t CrowdGrid::_col(ctp::gFloat x) const {
+	return static_cast<std::int32_t>(std::clamp(std::floor((x - region_.x) / cell_size_), ctp::gFloat(0), static_cast<ctp::gFloat>(cols_ - 1)));
+}
+std::int32_t CrowdGrid::_row(ctp::gFloat y) const {
+	return static_cast<std::int32_t>(std::clamp(std::floor((y - region_.y) / cell_size_), ctp::gFloat(0), static_cast<ctp::gFloat>(rows_ - 1)));
+}
+}
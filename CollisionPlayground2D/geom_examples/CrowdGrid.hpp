@@ -0,0 +1,88 @@
+#ifndef INCLUDE_GAME_CROWD_GRID_HPP
+#define INCLUDE_GAME_CROWD_GRID_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <Geometry2D/Geometry.hpp>
+
+#include "Bounds.hpp"
+
+// A uniform grid over a fixed region, built in one go from a list of bounding boxes.
+// Building reuses the grid's memory, and queries don't write anything, so any number of threads can query it at once.
+// Boxes reaching outside the region are kept in its border cells.
+
+namespace game {
+class CrowdGrid {
+public:
+	void build(const ctp::Rect& region, ctp::gFloat cellSize, const std::vector<ctp::Rect>& bounds);
+
+	// Call visit(index) once for each box overlapping the query box (touching edges count as overlapping).
+	template<typename Visitor>
+	void query(const ctp::Rect& box, Visitor&& visit) const;
+
+	// Call visit(blockBox) once for each block of blockCells x blockCells cells overlapping the query box that any box reaches into.
+	// Blocks are aligned to the grid, and clipped to the region. For drawing what's in the grid when its cells are too small to show.
+	template<typename Visitor>
+	void queryBlocks(const ctp::Rect& box, std::int32_t blockCells, Visitor&& visit) const;
+
+	std::size_t size() const { return bounds_.size(); }
+	ctp::gFloat getCellSize() const { return cell_size_; }
+	const ctp::Rect& getBounds(std::size_t index) const { return bounds_[index]; }
+
+private:
+	ctp::Rect region_;
+	ctp::gFloat cell_size_{1};
+	std::int32_t cols_{0}, rows_{0};
+	std::vector<ctp::Rect> bounds_;
+	std::vector<std::uint32_t> cell_start_; // Where each cell's entries start. The last element is the number of entries.
+	std::vector<std::uint32_t> entries_;    // Box indices, grouped by cell.
+
+	std::int32_t _col(ctp::gFloat x) const;
+	std::int32_t _row(ctp::gFloat y) const;
+};
+
+template<typename Visitor>
+void CrowdGrid::query(const ctp::Rect& box, Visitor&& visit) const {
+	const std::int32_t firstCol(_col(box.x)), lastCol(_col(box.x + box.w));
+	const std::int32_t firstRow(_row(box.y)), lastRow(_row(box.y + box.h));
+	for (std::int32_t row = firstRow; row <= lastRow; ++row) {
+		for (std::int32_t col = firstCol; col <= lastCol; ++col) {
+			const std::size_t cell(static_cast<std::size_t>(row) * cols_ + col);
+			for (std::uint32_t e = cell_start_[cell]; e < cell_start_[cell + 1]; ++e) {
+				const std::uint32_t index(entries_[e]);
+				const ctp::Rect& b(bounds_[index]);
+				if (!boundsOverlap(b, box))
+					continue;
+				// A box spanning several cells is only visited from the cell holding the top left of its overlap with the query.
+				if (_col(std::max(b.x, box.x)) == col && _row(std::max(b.y, box.y)) == row)
+					visit(index);
+			}
+		}
+	}
+}
+// A row of a block is a run of consecutive cells, so whether it holds anything is one comparison of cell starts.
+template<typename Visitor>
+void CrowdGrid::queryBlocks(const ctp::Rect& box, std::int32_t blockCells, Visitor&& visit) const {
+	if (cell_start_.empty() || !boundsOverlap(box, region_))
+		return;
+	const std::int32_t firstCol(_col(box.x) / blockCells * blockCells), lastCol(_col(box.x + box.w));
+	const std::int32_t firstRow(_row(box.y) / blockCells * blockCells), lastRow(_row(box.y + box.h));
+	for (std::int32_t row = firstRow; row <= lastRow; row += blockCells) {
+		const std::int32_t endRow(std::min(row + blockCells, rows_));
+		for (std::int32_t col = firstCol; col <= lastCol; col += blockCells) {
+			const std::int32_t endCol(std::min(col + blockCells, cols_));
+			bool occupied(false);
+			for (std::int32_t r = row; r < endRow && !occupied; ++r) {
+				const std::size_t start(static_cast<std::size_t>(r) * cols_ + col);
+				occupied = cell_start_[start] != cell_start_[start + (endCol - col)];
+			}
+			if (occupied)
+				visit(ctp::Rect(region_.x + col * cell_size_, region_.y + row * cell_size_, (endCol - col) * cell_size_, (endRow - row) * cell_size_));
+		}
+	}
+}
+}
+
+#endif // INCLUDE_GAME_CROWD_GRID_HPP
@@ -0,0 +1,19 @@
+#include "DriftingWall.hpp"
+
+namespace game {
+const game::Velocity DriftingWall::MAX_DRIFT_SPEED = 0.05f;
+
+DriftingWall::DriftingWall(const ctp::ShapeContainer& collider, const ctp::Coord2& position, const game::Velocity2D& velocity)
+	: PreparedWall(collider, position), velocity_(velocity) {}
+
+ctp::Coord2 DriftingWall::update(const game::MS elapsedTime, const ctp::Rect& region) {
+	// Bounce off the region's edges.
+	if ((position_.x < region.left() && velocity_.x < 0) || (position_.x > region.right() && velocity_.x > 0))
+		velocity_.x = -velocity_.x;
+	if ((position_.y < region.top() && velocity_.y < 0) || (position_.y > region.bottom() && velocity_.y > 0))
+		velocity_.y = -velocity_.y;
+	const ctp::Coord2 delta(velocity_ * (ctp::gFloat)(elapsedTime));
+	position_ += delta;
+	return delta;
+}
+}
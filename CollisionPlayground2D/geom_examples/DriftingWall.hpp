@@ -0,0 +1,25 @@
+#ifndef INCLUDE_GAME_DRIFTING_WALL_HPP
+#define INCLUDE_GAME_DRIFTING_WALL_HPP
+
+#include "../units.hpp"
+
+#include <Geometry2D/Geometry.hpp>
+
+#include "PreparedShape.hpp"
+
+namespace game {
+// An obstacle that drifts at a constant velocity, bouncing off the edges of a region.
+class DriftingWall : public PreparedWall {
+public:
+	static const game::Velocity MAX_DRIFT_SPEED;
+
+	DriftingWall(const ctp::ShapeContainer& collider, const ctp::Coord2& position, const game::Velocity2D& velocity);
+
+	// Drift, keeping the wall's position inside the region. Returns how far it moved.
+	ctp::Coord2 update(const game::MS elapsedTime, const ctp::Rect& region);
+private:
+	game::Velocity2D velocity_;
+};
+}
+
+#endif // INCLUDE_GAME_DRIFTING_WALL_HPP
@@ -1,6 +1,14 @@
 #include "Example.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "CompoundWall.hpp"
+#include "ObstacleMap.hpp"
+#include "ShapeUtil.hpp"
 #include "../generator.hpp"
+#include "../Graphics.hpp"
 
 #include <Geometry2D/Geometry.hpp>
 
@@ -10,11 +18,172 @@ const ctp::gFloat Example::SHAPE_MIN_SIZE = 0.1f;
 const ctp::gFloat Example::SHAPE_MAX_SIZE = 100.0f;
 const std::size_t Example::POLY_MIN_VERTS = 3;
 const std::size_t Example::POLY_MAX_VERTS = 20;
+const ctp::gFloat Example::COMPOUND_MAX_SIZE = 120.0f;
 
 const Colour Example::SHAPE_COLOUR = Colour::LIGHT_BLUE;
 const Colour Example::HIT_SHAPE_COLOUR = Colour::RED;
+const Colour Example::AGENT_COLOUR = Colour::LIGHT_GREEN;
+const Uint8 Example::RAY_ORIGIN_RADIUS = 5;
+const Colour Example::RAY_ORIGIN_COLOUR = Colour::ORANGE;
+const Colour Example::HIT_POINT_COLOUR = Colour::CYAN;
+const Colour Example::VISIBLE_COLOUR = Colour{255, 255, 0, 48};
+const Colour Example::VISIBLE_EDGE_COLOUR = Colour::YELLOW;
+const float Example::GRID_BLOCK_SIZE = 3.0f;
+
+bool Example::saveScene(const std::string&) const {
+	std::cerr << "This example can't save scenes.\n";
+	return false;
+}
+bool Example::loadScene(const std::string&) {
+	std::cerr << "This example can't load scenes.\n";
+	return false;
+}
+
+void Example::captureObstacles(const ObstacleMap& map, ExampleSnapshot& out) {
+	if (!obstacles_) {
+		auto obstacles(std::make_shared<std::vector<ExampleSnapshot::Obstacle>>());
+		obstacles->reserve(map.size());
+		for (std::size_t i = 0; i < map.size(); ++i) {
+			obstacles->push_back(ExampleSnapshot::Obstacle{copyShape(map[i]->getCollider()), map[i]->getPosition(), {}});
+			if (!map[i]->isCompound())
+				continue;
+			const CompoundWall& compound(static_cast<const CompoundWall&>(*map[i]));
+			for (std::size_t p = 0; p < compound.getPartCount(); ++p)
+				obstacles->back().parts.emplace_back(copyShape(compound.getPart(p).getCollider()), compound.getPart(p).getOffset());
+		}
+		obstacles_ = std::move(obstacles);
+	}
+	out.obstacles = obstacles_;
+}
+
+namespace {
+void renderObstacle(const Graphics& graphics, const ExampleSnapshot::Obstacle& obs, const ctp::Coord2& position) {
+	if (obs.parts.empty())
+		graphics.renderShape(obs.shape, position);
+	for (const auto& part : obs.parts)
+		graphics.renderShape(part.first, position + part.second);
+}
+}
+
+void Example::draw(const Graphics& graphics, const ViewControl& view, const ExampleSnapshot& prev, const ExampleSnapshot& curr, float alpha) {
+	const auto lerp = [alpha](const ctp::Coord2& a, const ctp::Coord2& b) { return a + (b - a) * alpha; };
+	Pixel width, height;
+	graphics.getOutputSize(width, height);
+	// Examples that fit on the screen are seen from the origin until the view is moved.
+	const ctp::Coord2 focus(!curr.followMover || !curr.moverShape ? ctp::Coord2(width * 0.5f, height * 0.5f)
+		: prev.moverShape == curr.moverShape ? lerp(prev.moverPosition, curr.moverPosition) : curr.moverPosition);
+	const Camera camera(view.apply(focus, width, height));
+	const ctp::Rect seen(camera.getView(width, height));
+	graphics.setCamera(camera);
+	if (!curr.obstacleChunks.empty()) {
+		graphics.setRenderColour(SHAPE_COLOUR);
+		for (const auto& chunk : curr.obstacleChunks) {
+			if (!boundsOverlap(chunk->bounds, seen))
+				continue;
+			for (const ExampleSnapshot::Obstacle& obs : chunk->obstacles)
+				renderObstacle(graphics, obs, obs.position);
+		}
+	}
+	if (curr.obstacles) {
+		const std::vector<ExampleSnapshot::Obstacle>& obstacles(*curr.obstacles);
+		if (curr.obstaclePositions.empty()) {
+			if (layer_obstacles_ != curr.obstacles || layer_camera_ != camera) {
+				layer_obstacles_ = curr.obstacles;
+				static_layer_.invalidate();
+			}
+			if (layer_camera_ != camera) {
+				layer_camera_ = camera;
+				_render_visible(graphics, camera, seen, curr.obstacles);
+			} else {
+				static_layer_.render(graphics, [&]() { _render_visible(graphics, camera, seen, curr.obstacles); });
+			}
+		} else { // The obstacles move, so there's nothing to cache.
+			const bool interpolate(prev.obstacles == curr.obstacles && prev.obstaclePositions.size() == curr.obstaclePositions.size());
+			graphics.setRenderColour(SHAPE_COLOUR);
+			for (std::size_t i = 0; i < obstacles.size() && i < curr.obstaclePositions.size(); ++i)
+				renderObstacle(graphics, obstacles[i], interpolate ? lerp(prev.obstaclePositions[i], curr.obstaclePositions[i]) : curr.obstaclePositions[i]);
+		}
+		graphics.setRenderColour(HIT_SHAPE_COLOUR);
+		for (std::size_t i : curr.hitObstacles) {
+			const ctp::Coord2 position(i < curr.obstaclePositions.size() ? curr.obstaclePositions[i] : obstacles[i].position);
+			renderObstacle(graphics, obstacles[i], position);
+		}
+	}
+	if (!curr.visibility.empty()) {
+		// Not interpolated: the polygon's vertices change from step to step.
+		std::vector<SDL_Point> points;
+		points.reserve(curr.visibility.size());
+		for (const ctp::Coord2& v : curr.visibility)
+			points.push_back(camera.toScreen(v));
+		graphics.setRenderColour(VISIBLE_COLOUR);
+		graphics.renderFilledPoly(points);
+		graphics.setRenderColour(VISIBLE_EDGE_COLOUR);
+		graphics.renderPoly(points);
+	}
+	if (curr.hasRayOrigin) {
+		graphics.setRenderColour(RAY_ORIGIN_COLOUR);
+		graphics.renderCircle(camera.toScreen(prev.hasRayOrigin ? lerp(prev.rayOrigin, curr.rayOrigin) : curr.rayOrigin), RAY_ORIGIN_RADIUS, 1);
+	}
+	const bool interpolateRays(prev.rays.size() == curr.rays.size());
+	for (std::size_t i = 0; i < curr.rays.size(); ++i) {
+		const ExampleSnapshot::RaySegment& r(curr.rays[i]);
+		ctp::Coord2 origin(r.origin), dir(r.dir);
+		ctp::gFloat length(r.length);
+		if (interpolateRays) {
+			const ExampleSnapshot::RaySegment& p(prev.rays[i]);
+			origin = lerp(p.origin, r.origin);
+			dir = lerp(p.dir, r.dir);
+			const ctp::gFloat dirLength(std::sqrt(dir.x * dir.x + dir.y * dir.y));
+			dir = dirLength > 0 ? dir * (1.0f / dirLength) : r.dir;
+			length = p.length + (r.length - static_cast<ctp::gFloat>(p.length)) * alpha;
+		}
+		graphics.setRenderColour(r.colour);
+		graphics.renderRay(camera.toScreen(origin), dir.x, dir.y, static_cast<Uint16>(std::min(length * camera.getScale(), 65535.0f)));
+	}
+	if (curr.agentShapes) {
+		const std::vector<ctp::ShapeContainer>& shapes(*curr.agentShapes);
+		const bool interpolate(prev.agentShapes == curr.agentShapes && prev.agentPositions.size() == curr.agentPositions.size());
+		graphics.setRenderColour(AGENT_COLOUR);
+		for (std::size_t i = 0; i < shapes.size() && i < curr.agentPositions.size(); ++i)
+			graphics.renderShape(shapes[i], interpolate ? lerp(prev.agentPositions[i], curr.agentPositions[i]) : curr.agentPositions[i]);
+	}
+	if (curr.moverShape) {
+		graphics.setRenderColour(HIT_SHAPE_COLOUR);
+		graphics.renderShape(*curr.moverShape, prev.moverShape == curr.moverShape ? lerp(prev.moverPosition, curr.moverPosition) : curr.moverPosition);
+	}
+	graphics.setRenderColour(HIT_POINT_COLOUR);
+	for (const ctp::Coord2& point : curr.hitPoints)
+		graphics.renderPoint(camera.toScreen(point), curr.hitPointSize);
+}
+
+// The grid's cells are a couple of obstacles across, so a query returns about as many obstacles as are in view.
+void Example::_render_visible(const Graphics& graphics, const Camera& camera, const ctp::Rect& view,
+	const std::shared_ptr<const std::vector<ExampleSnapshot::Obstacle>>& obstacles) {
+	if (grid_obstacles_ != obstacles) {
+		grid_obstacles_ = obstacles;
+		grid_bounds_.clear();
+		ctp::Rect region(0, 0, 0, 0);
+		for (const ExampleSnapshot::Obstacle& obs : *obstacles) {
+			grid_bounds_.push_back(game::getBounds(obs.shape, obs.position));
+			region = grid_bounds_.size() == 1 ? grid_bounds_.back() : combineBounds(region, grid_bounds_.back());
+		}
+		const ctp::gFloat spacing(grid_bounds_.empty() ? 1 : std::sqrt(region.w * region.h / grid_bounds_.size()));
+		draw_grid_.build(region, std::max(spacing * 2, ctp::gFloat(1)), grid_bounds_);
+	}
+	graphics.setRenderColour(SHAPE_COLOUR);
+	const float cellPixels(draw_grid_.getCellSize() * camera.getScale());
+	if (cellPixels < GRID_BLOCK_SIZE) {
+		draw_grid_.queryBlocks(view, static_cast<std::int32_t>(std::ceil(GRID_BLOCK_SIZE / cellPixels)), [&](const ctp::Rect& block) {
+			const SDL_Point low(camera.toScreen(ctp::Coord2(block.x, block.y))), high(camera.toScreen(ctp::Coord2(block.x + block.w, block.y + block.h)));
+			graphics.renderFilledRect(SDL_Rect{low.x, low.y, std::max(high.x - low.x, 1), std::max(high.y - low.y, 1)});
+		});
+		return;
+	}
+	const std::vector<ExampleSnapshot::Obstacle>& all(*obstacles);
+	draw_grid_.query(view, [&](std::size_t i) { renderObstacle(graphics, all[i], all[i].position); });
+}
 
-ctp::ShapeContainer Example::genShape() const {
+ctp::ShapeContainer Example::genShape() {
 	const ctp::gFloat rand(gen::gFloat(0.0f, 1.0f));
 	if (rand < 0.2f)
 		return ctp::ShapeContainer(genRect());
@@ -22,15 +191,61 @@ ctp::ShapeContainer Example::genShape() const {
 		return ctp::ShapeContainer(genPoly());
 	return ctp::ShapeContainer(genCircle());
 }
-ctp::Rect Example::genRect() const {
+gen::ShapeSpec Example::getShapeSpec(const ctp::Rect& region) {
+	return gen::ShapeSpec{region, SHAPE_MIN_SIZE, SHAPE_MAX_SIZE, POLY_MIN_VERTS, POLY_MAX_VERTS, 0.2f, 0.5f};
+}
+ctp::Rect Example::genRect() {
 	return ctp::Rect(0, 0,
 		gen::gFloat(SHAPE_MIN_SIZE, SHAPE_MAX_SIZE),  // w
 		gen::gFloat(SHAPE_MIN_SIZE, SHAPE_MAX_SIZE)); // h
 }
-ctp::Polygon Example::genPoly() const {
+ctp::Polygon Example::genPoly() {
 	return gen::poly(SHAPE_MIN_SIZE, SHAPE_MAX_SIZE, POLY_MIN_VERTS, POLY_MAX_VERTS);
 }
-ctp::Circle Example::genCircle() const {
+ctp::Circle Example::genCircle() {
 	return ctp::Circle(gen::gFloat(SHAPE_MIN_SIZE, SHAPE_MAX_SIZE));
 }
+std::vector<std::pair<ctp::ShapeContainer, ctp::Coord2>> Example::genCompound() {
+	std::vector<std::pair<ctp::ShapeContainer, ctp::Coord2>> parts;
+	const auto onCircle = [](ctp::gFloat angle, ctp::gFloat radius) { return ctp::Coord2(std::cos(angle) * radius, std::sin(angle) * radius); };
+	const ctp::gFloat rand(gen::gFloat(0.0f, 1.0f));
+	if (rand < 0.4f) { // An arc, in quads a few degrees wide.
+		const ctp::gFloat outer(gen::gFloat(COMPOUND_MAX_SIZE * 0.3f, COMPOUND_MAX_SIZE));
+		const ctp::gFloat inner(outer - gen::gFloat(6.0f, outer * 0.4f));
+		const ctp::gFloat span(gen::gFloat(ctp::constants::PI, ctp::constants::TAU * 0.85f));
+		const ctp::gFloat start(gen::gFloat(0.0f, ctp::constants::TAU));
+		const std::size_t numParts(static_cast<std::size_t>(std::ceil(span / (ctp::constants::TAU / 32))));
+		for (std::size_t i = 0; i < numParts; ++i) {
+			const ctp::gFloat a0(start + span * i / numParts), a1(start + span * (i + 1) / numParts);
+			const ctp::Coord2 offset(onCircle((a0 + a1) / 2, (inner + outer) / 2));
+			parts.emplace_back(ctp::Polygon(std::vector<ctp::Coord2>{onCircle(a0, inner) - offset, onCircle(a0, outer) - offset,
+				onCircle(a1, outer) - offset, onCircle(a1, inner) - offset}), offset);
+		}
+	} else if (rand < 0.75f) { // A wall that turns a corner after each piece.
+		const ctp::gFloat thickness(gen::gFloat(6.0f, 20.0f));
+		const std::size_t numParts(6 + static_cast<std::size_t>(gen::gFloat(0.0f, 11.0f)));
+		ctp::Coord2 at(0, 0), dir(gen::gFloat(0.0f, 1.0f) < 0.5f ? ctp::Coord2(1, 0) : ctp::Coord2(0, 1));
+		for (std::size_t i = 0; i < numParts; ++i) {
+			// Each piece runs on past the corner by its thickness, so the pieces overlap there.
+			const ctp::gFloat length(gen::gFloat(COMPOUND_MAX_SIZE * 0.15f, COMPOUND_MAX_SIZE * 0.5f));
+			const ctp::Coord2 end(at + dir * length);
+			const ctp::Coord2 corner(std::min(at.x, end.x), std::min(at.y, end.y));
+			const ctp::Rect rect(0, 0, std::abs(end.x - at.x) + thickness, std::abs(end.y - at.y) + thickness);
+			parts.emplace_back(ctp::ShapeContainer(rect), corner);
+			at = end;
+			dir = gen::gFloat(0.0f, 1.0f) < 0.5f ? ctp::Coord2(-dir.y, dir.x) : ctp::Coord2(dir.y, -dir.x);
+		}
+	} else { // A star: a circle with triangular spokes.
+		const ctp::gFloat hub(gen::gFloat(10.0f, 30.0f));
+		const std::size_t numSpokes(5 + static_cast<std::size_t>(gen::gFloat(0.0f, 8.0f)));
+		parts.emplace_back(ctp::ShapeContainer(ctp::Circle(hub)), ctp::Coord2(0, 0));
+		for (std::size_t i = 0; i < numSpokes; ++i) {
+			const ctp::gFloat angle(ctp::constants::TAU * i / numSpokes), halfWidth(ctp::constants::PI / numSpokes * 0.6f);
+			const ctp::gFloat length(gen::gFloat(hub + 20.0f, COMPOUND_MAX_SIZE * 0.8f));
+			parts.emplace_back(ctp::Polygon(std::vector<ctp::Coord2>{onCircle(angle - halfWidth, hub * 0.8f), onCircle(angle, length),
+				onCircle(angle + halfWidth, hub * 0.8f)}), ctp::Coord2(0, 0));
+		}
+	}
+	return parts;
+}
 }
@@ -1,8 +1,17 @@
 #ifndef INCLUDE_GAME_EXAMPLE_HPP
 #define INCLUDE_GAME_EXAMPLE_HPP
 
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CrowdGrid.hpp"
+#include "ExampleSnapshot.hpp"
 #include "../units.hpp"
+#include "../Camera.hpp"
 #include "../Colour.hpp"
+#include "../StaticLayer.hpp"
 
 namespace ctp {
 class ShapeContainer;
@@ -10,10 +19,14 @@ class Rect;
 class Polygon;
 class Circle;
 }
+namespace gen {
+struct ShapeSpec;
+}
 
 class Input;
 class Graphics;
 namespace game {
+class ObstacleMap;
 class Example {
 public:
 	static const std::size_t  NUM_SHAPES;
@@ -21,19 +34,67 @@ public:
 	static const ctp::gFloat SHAPE_MAX_SIZE;
 	static const std::size_t  POLY_MIN_VERTS;
 	static const std::size_t  POLY_MAX_VERTS;
+	static const ctp::gFloat COMPOUND_MAX_SIZE;
 
 	static const Colour	SHAPE_COLOUR;
 	static const Colour	HIT_SHAPE_COLOUR;
 
+	static const Colour AGENT_COLOUR;
+
+	static const Uint8 RAY_ORIGIN_RADIUS;
+	static const Colour RAY_ORIGIN_COLOUR;
+	static const Colour HIT_POINT_COLOUR;
+	static const Colour VISIBLE_COLOUR;
+	static const Colour VISIBLE_EDGE_COLOUR;
+	// Zoomed out so far that the culling grid's cells are smaller than this on screen, in pixels,
+	// obstacles are drawn as filled blocks of cells instead of one by one.
+	static const float GRID_BLOCK_SIZE;
+
 	virtual ~Example() {}
+	// Called on the simulation thread.
 	virtual void update(const Input& input, const MS elapsedTime) = 0;
-	virtual void draw(const Graphics& graphics) = 0;
+	// Copy what is needed to draw the example into a snapshot. Called on the simulation thread after each update.
+	virtual void capture(ExampleSnapshot& out) = 0;
 	virtual void reset() = 0;
+	// Draw snapshots of two consecutive steps, interpolating from prev to curr by alpha (0 to 1), as the view is panned and zoomed.
+	// Called on the render thread. Only the snapshots are read, so the simulation can keep running.
+	void draw(const Graphics& graphics, const ViewControl& view, const ExampleSnapshot& prev, const ExampleSnapshot& curr, float alpha);
+	// Save the example's obstacles to a scene file, or replace them with a scene file's.
+	// Returns false (printing why) if it fails, or the example doesn't support scene files.
+	virtual bool saveScene(const std::string& path) const;
+	virtual bool loadScene(const std::string& path);
+
+	// Generate the random shapes the examples are made of.
+	static ctp::ShapeContainer genShape();
+	static ctp::Rect genRect();
+	static ctp::Polygon genPoly();
+	static ctp::Circle genCircle();
+	// Generate a concave shape made of convex parts (an arc, a bent wall or a star), as each part's shape and offset.
+	static std::vector<std::pair<ctp::ShapeContainer, ctp::Coord2>> genCompound();
+	// The same mix of shapes, for generating in batches.
+	static gen::ShapeSpec getShapeSpec(const ctp::Rect& region);
+
 protected:
-	ctp::ShapeContainer genShape() const;
-	ctp::Rect genRect() const;
-	ctp::Polygon genPoly() const;
-	ctp::Circle genCircle() const;
+	// Mark the obstacles as changed, so the next capture copies them again.
+	void obstaclesChanged() { obstacles_.reset(); }
+	// Share the map's obstacles with a snapshot, copying them only if they changed since the last capture.
+	void captureObstacles(const ObstacleMap& map, ExampleSnapshot& out);
+
+private:
+	std::shared_ptr<const std::vector<ExampleSnapshot::Obstacle>> obstacles_; // Simulation thread.
+
+	// Render thread. Static obstacles are drawn once into the layer, and redrawn when a snapshot has different obstacles.
+	// While the camera moves they are drawn straight to the screen instead, and put back in the layer once it stops.
+	StaticLayer static_layer_;
+	std::shared_ptr<const std::vector<ExampleSnapshot::Obstacle>> layer_obstacles_;
+	Camera layer_camera_;
+	// Static obstacles' bounds in a grid, so only those in view are drawn. Rebuilt when a snapshot has different obstacles.
+	CrowdGrid draw_grid_;
+	std::shared_ptr<const std::vector<ExampleSnapshot::Obstacle>> grid_obstacles_;
+	std::vector<ctp::Rect> grid_bounds_;
+
+	void _render_visible(const Graphics& graphics, const Camera& camera, const ctp::Rect& view,
+		const std::shared_ptr<const std::vector<ExampleSnapshot::Obstacle>>& obstacles);
 };
 }
 
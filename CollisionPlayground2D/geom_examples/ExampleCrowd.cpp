@@ -0,0 +1,252 @@
+#include "ExampleCrowd.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+
+#include "ShapeUtil.hpp"
+#include "../generator.hpp"
+#include "../Input.hpp"
+#include "../Profiler.hpp"
+
+namespace game {
+const std::size_t ExampleCrowd::NUM_AGENT_COUNTS = 4;
+const std::size_t ExampleCrowd::AGENT_COUNTS[NUM_AGENT_COUNTS] = {500, 2000, 4000, 8000};
+const ctp::gFloat ExampleCrowd::AGENT_MIN_SIZE = 3.0f;
+const ctp::gFloat ExampleCrowd::AGENT_MAX_SIZE = 7.0f;
+const ctp::gFloat ExampleCrowd::GOAL_RADIUS = 10.0f;
+const MS ExampleCrowd::GOAL_TIMEOUT = 5000;
+const ctp::gFloat ExampleCrowd::CELL_SIZE = 32.0f;
+const std::size_t ExampleCrowd::AGENTS_PER_TASK = 64;
+const MS ExampleCrowd::TIMING_REPORT_INTERVAL = 1000;
+
+namespace {
+// What an agent collides with while it moves: the obstacles, and every other agent where it was at the start of the step.
+// Only reads, so each thread can use its own.
+class CrowdQuery : public ctp::CollisionMap {
+public:
+	CrowdQuery(const std::vector<PreparedWall*>& obstacles, const CrowdGrid& obstacleGrid, std::vector<PooledWall>& bodies, const CrowdGrid& bodyGrid)
+		: obstacles_(obstacles), obstacle_grid_(obstacleGrid), bodies_(bodies), body_grid_(bodyGrid) {}
+
+	void setAgent(std::size_t agent) { agent_ = agent; }
+
+	const std::vector<ctp::Collidable*> getColliding(const ctp::Collidable& collidable, ctp::Coord2 delta) const override {
+		const ctp::Rect swept(sweepBounds(getQueryBounds(collidable), delta));
+		std::vector<ctp::Collidable*> colliding;
+		obstacle_grid_.query(swept, [&](std::size_t i) { colliding.push_back(obstacles_[i]); });
+		body_grid_.query(swept, [&](std::size_t i) {
+			if (i != agent_)
+				colliding.push_back(&bodies_[i]);
+		});
+		return colliding;
+	}
+
+private:
+	const std::vector<PreparedWall*>& obstacles_;
+	const CrowdGrid& obstacle_grid_;
+	std::vector<PooledWall>& bodies_;
+	const CrowdGrid& body_grid_;
+	std::size_t agent_{0};
+};
+}
+
+ExampleCrowd::ExampleCrowd(const ctp::Rect& levelRegion, Broadphase broadphase, std::size_t numAgents, std::size_t numThreads)
+	: map_(makeObstacleMap(broadphase)), level_region_(levelRegion), num_agents_(numAgents), pool_(numThreads) {
+	_init();
+}
+void ExampleCrowd::_init() {
+	for (std::size_t i = 0; i < NUM_SHAPES; ++i)
+		map_->addWall(Example::genShape(), gen::coord2(level_region_));
+	std::vector<ctp::Rect> bounds;
+	for (std::size_t i = 0; i < map_->size(); ++i) {
+		obstacles_.push_back((*map_)[i]);
+		bounds.push_back(obstacles_.back()->getBounds());
+	}
+	obstacle_grid_.build(level_region_, CELL_SIZE, bounds);
+
+	_place_agents(num_agents_);
+	body_grid_.build(level_region_, CELL_SIZE, body_bounds_);
+	start_positions_.resize(agents_.size());
+	proposal_bounds_.resize(agents_.size());
+	reverted_.assign(agents_.size(), 0);
+}
+// Agents are spread over a lattice with room for the largest agent in each spot, so they start apart from each other.
+void ExampleCrowd::_place_agents(std::size_t numAgents) {
+	const ctp::gFloat spacing(AGENT_MAX_SIZE + 2.0f);
+	const std::size_t cols(static_cast<std::size_t>(level_region_.w / spacing)), rows(static_cast<std::size_t>(level_region_.h / spacing));
+	std::vector<std::size_t> spots(cols * rows);
+	std::iota(spots.begin(), spots.end(), 0);
+	std::shuffle(spots.begin(), spots.end(), gen::rng);
+
+	auto shapes(std::make_shared<std::vector<ctp::ShapeContainer>>());
+	for (std::size_t s = 0; s < spots.size() && agents_.size() < numAgents; ++s) {
+		const ctp::ShapeContainer shape(_gen_agent_shape());
+		const PreparedShape prepared(prepareShape(shape));
+		const ctp::Rect& extent(prepared.bounds);
+		const ctp::Coord2 corner(level_region_.x + (spots[s] % cols) * spacing + gen::gFloat(0, spacing - 1.0f - extent.w),
+		                         level_region_.y + (spots[s] / cols) * spacing + gen::gFloat(0, spacing - 1.0f - extent.h));
+		const ctp::Coord2 position(corner.x - extent.x, corner.y - extent.y);
+		const ctp::Rect bounds(prepared.getBounds(position));
+		bool blocked(false);
+		obstacle_grid_.query(bounds, [&](std::size_t i) {
+			blocked = blocked || obstacles_[i]->overlaps(shape, position, prepared);
+		});
+		if (blocked)
+			continue;
+		// Seed each agent's random numbers from its index. Multiplying by an odd number keeps the seed non-zero, as xorshift needs.
+		const std::uint32_t seed(static_cast<std::uint32_t>(agents_.size() + 1) * 0x9E3779B9u);
+		agents_.push_back(Agent{Mover(shape, position), position, 0, seed});
+		bodies_.emplace_back(copyShape(agents_.back().mover.getCollider()), position);
+		bodies_.back().prepare(); // Now, as the pool's threads read it.
+		body_bounds_.push_back(bounds);
+		shapes->push_back(copyShape(agents_.back().mover.getCollider()));
+	}
+	if (agents_.size() < numAgents)
+		std::cout << "Only found room for " << agents_.size() << " of " << numAgents << " agents.\n";
+	agent_shapes_ = std::move(shapes);
+}
+ctp::ShapeContainer ExampleCrowd::_gen_agent_shape() const {
+	const ctp::gFloat rand(gen::gFloat(0.0f, 1.0f));
+	if (rand < 0.3f)
+		return ctp::ShapeContainer(ctp::Rect(0, 0, gen::gFloat(AGENT_MIN_SIZE, AGENT_MAX_SIZE), gen::gFloat(AGENT_MIN_SIZE, AGENT_MAX_SIZE)));
+	if (rand < 0.6f)
+		return ctp::ShapeContainer(gen::poly(AGENT_MIN_SIZE * 0.5f, AGENT_MAX_SIZE * 0.5f, 3, 8));
+	return ctp::ShapeContainer(ctp::Circle(gen::gFloat(AGENT_MIN_SIZE * 0.5f, AGENT_MAX_SIZE * 0.5f)));
+}
+
+void ExampleCrowd::update(const Input& input, const MS elapsedTime) {
+	if (input.wasKeyPressed(SDLK_n)) { // Next crowd size.
+		const std::size_t* next(std::upper_bound(AGENT_COUNTS, AGENT_COUNTS + NUM_AGENT_COUNTS, num_agents_));
+		num_agents_ = next == AGENT_COUNTS + NUM_AGENT_COUNTS ? AGENT_COUNTS[0] : *next;
+		std::cout << "Crowd size: " << num_agents_ << "\n";
+		reset();
+	}
+	if (input.wasKeyPressed(SDLK_t)) { // Double the threads, up to one per hardware thread, then go back to one.
+		const std::size_t maxThreads(ThreadPool::getDefaultThreadCount());
+		const std::size_t threads(getThreadCount());
+		setThreadCount(threads >= maxThreads ? 1 : std::min(threads * 2, maxThreads));
+		std::cout << "Crowd threads: " << getThreadCount() << "\n";
+	}
+	const std::size_t numAgents(agents_.size());
+	ScopedTimer timer(Profiler::Phase::COLLISION);
+	auto start(std::chrono::steady_clock::now());
+	pool_.parallelFor(numAgents, AGENTS_PER_TASK, [&](std::size_t begin, std::size_t end) { _propose(begin, end, elapsedTime); });
+	proposal_grid_.build(level_region_, CELL_SIZE, proposal_bounds_);
+	propose_micros_ += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	pool_.parallelFor(numAgents, AGENTS_PER_TASK, [&](std::size_t begin, std::size_t end) { _find_conflicts(begin, end); });
+	pool_.parallelFor(numAgents, AGENTS_PER_TASK, [&](std::size_t begin, std::size_t end) { _commit(begin, end); });
+	body_grid_.build(level_region_, CELL_SIZE, body_bounds_);
+	commit_micros_ += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	timer.stop();
+
+	timing_reverted_ += getRevertedCount();
+	_report_timing(elapsedTime);
+}
+// Head for the goal, picking a new one when it is reached or taking too long.
+void ExampleCrowd::_steer(Agent& agent, const MS elapsedTime) const {
+	const ctp::Coord2 position(agent.mover.getPosition());
+	agent.goalTime += elapsedTime;
+	ctp::Coord2 toGoal(agent.goal - position);
+	if (toGoal.x * toGoal.x + toGoal.y * toGoal.y < GOAL_RADIUS * GOAL_RADIUS || agent.goalTime > GOAL_TIMEOUT) {
+		agent.goal = ctp::Coord2(level_region_.x + _random(agent.rng) * level_region_.w, level_region_.y + _random(agent.rng) * level_region_.h);
+		agent.goalTime = 0;
+		toGoal = agent.goal - position;
+	}
+	const ctp::gFloat slack(GOAL_RADIUS * 0.5f); // Stop steering on an axis once close on it, rather than zig-zagging.
+	if (toGoal.x > slack)
+		agent.mover.moveRight();
+	else if (toGoal.x < -slack)
+		agent.mover.moveLeft();
+	else
+		agent.mover.stopMovingHorizontal();
+	if (toGoal.y > slack)
+		agent.mover.moveDown();
+	else if (toGoal.y < -slack)
+		agent.mover.moveUp();
+	else
+		agent.mover.stopMovingVertical();
+}
+void ExampleCrowd::_propose(std::size_t begin, std::size_t end, const MS elapsedTime) {
+	CrowdQuery query(obstacles_, obstacle_grid_, bodies_, body_grid_);
+	for (std::size_t i = begin; i < end; ++i) {
+		Agent& agent(agents_[i]);
+		start_positions_[i] = agent.mover.getPosition();
+		_steer(agent, elapsedTime);
+		query.setAgent(i);
+		agent.mover.update(elapsedTime, query);
+		proposal_bounds_[i] = agent.mover.getBounds();
+	}
+}
+void ExampleCrowd::_find_conflicts(std::size_t begin, std::size_t end) {
+	for (std::size_t i = begin; i < end; ++i) {
+		const Mover& mover(agents_[i].mover);
+		bool conflict(false);
+		proposal_grid_.query(proposal_bounds_[i], [&](std::size_t j) {
+			const Mover& other(agents_[j].mover);
+			conflict = conflict || (j < i && mayOverlap(mover.getPrepared(), mover.getPosition(), other.getPrepared(), other.getPosition())
+				&& ctp::overlaps(mover.getCollider(), mover.getPosition(), other.getCollider(), other.getPosition()));
+		});
+		reverted_[i] = conflict ? 1 : 0;
+	}
+}
+void ExampleCrowd::_commit(std::size_t begin, std::size_t end) {
+	for (std::size_t i = begin; i < end; ++i) {
+		Mover& mover(agents_[i].mover);
+		if (reverted_[i]) {
+			mover.setPosition(start_positions_[i]);
+			mover.halt();
+		}
+		bodies_[i].setPosition(mover.getPosition());
+		body_bounds_[i] = reverted_[i] ? bodies_[i].getBounds() : proposal_bounds_[i];
+	}
+}
+std::size_t ExampleCrowd::getRevertedCount() const {
+	return static_cast<std::size_t>(std::count(reverted_.begin(), reverted_.end(), std::uint8_t(1)));
+}
+void ExampleCrowd::_report_timing(const MS elapsedTime) {
+	++timing_steps_;
+	timing_elapsed_ += elapsedTime;
+	if (timing_elapsed_ < TIMING_REPORT_INTERVAL)
+		return;
+	const double agentSteps(static_cast<double>(agents_.size()) * timing_steps_);
+	std::cout << "Crowd of " << agents_.size() << " on " << getThreadCount() << " threads: "
+		<< agentSteps / ((propose_micros_ + commit_micros_) * 1e-6) << " agents/s (per step - propose: "
+		<< propose_micros_ / timing_steps_ << "us, commit: " << commit_micros_ / timing_steps_ << "us), "
+		<< 100.0 * timing_reverted_ / agentSteps << "% of moves reverted\n";
+	timing_elapsed_ = 0;
+	timing_steps_ = 0;
+	timing_reverted_ = 0;
+	propose_micros_ = 0;
+	commit_micros_ = 0;
+}
+
+void ExampleCrowd::capture(ExampleSnapshot& out) {
+	out.clearStep();
+	captureObstacles(*map_, out);
+	out.agentShapes = agent_shapes_;
+	out.agentPositions.reserve(agents_.size());
+	for (const Agent& agent : agents_)
+		out.agentPositions.push_back(agent.mover.getPosition());
+}
+void ExampleCrowd::reset() {
+	map_->clear();
+	obstaclesChanged();
+	obstacles_.clear();
+	agents_.clear();
+	bodies_.clear();
+	body_bounds_.clear();
+	_init();
+}
+
+ctp::gFloat ExampleCrowd::_random(std::uint32_t& state) {
+	// xorshift32.
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return static_cast<ctp::gFloat>(state >> 8) * (1.0f / 16777216.0f);
+}
+}
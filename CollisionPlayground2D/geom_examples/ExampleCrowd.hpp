@@ -0,0 +1,98 @@
+#ifndef INCLUDE_GAME_EXAMPLE_CROWD_HPP
+#define INCLUDE_GAME_EXAMPLE_CROWD_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "CrowdGrid.hpp"
+#include "Example.hpp"
+#include "Mover.hpp"
+#include "ObstacleMap.hpp"
+#include "ObstaclePool.hpp"
+#include "../ThreadPool.hpp"
+
+#include <Geometry2D/Geometry.hpp>
+
+// A crowd of small movers wandering between random goals, colliding with the obstacles and each other.
+// Each step runs in two phases, both spread over a thread pool:
+//   propose: every agent moves as a lone Mover would, against the obstacles and every other agent where it was at the start of the step.
+//   commit:  an agent whose new position overlaps a lower-numbered agent's new position is put back where it started.
+// No agent overlaps another afterwards: kept agents don't overlap each other, and every agent moved around the others' start positions.
+// Agents only read the start of step state and write their own slots, so the result is the same on any number of threads.
+// The obstacle maps keep scratch buffers and stats, so they can't be queried from several threads at once.
+// Agents query read-only grids of the obstacles and agents instead, and the map is only used to hold and draw the obstacles.
+
+namespace game {
+class ExampleCrowd : public Example {
+public:
+	static const std::size_t NUM_AGENT_COUNTS;
+	static const std::size_t AGENT_COUNTS[];
+	static const ctp::gFloat AGENT_MIN_SIZE;
+	static const ctp::gFloat AGENT_MAX_SIZE;
+	static const ctp::gFloat GOAL_RADIUS;     // How close an agent gets to its goal before picking another.
+	static const MS GOAL_TIMEOUT;             // How long an agent tries for a goal before giving up on it.
+	static const ctp::gFloat CELL_SIZE;       // Of the agent and obstacle grids.
+	static const std::size_t AGENTS_PER_TASK; // Agents in each chunk of work given to the thread pool.
+	static const MS TIMING_REPORT_INTERVAL;
+
+	ExampleCrowd(const ctp::Rect& levelRegion, Broadphase broadphase, std::size_t numAgents = AGENT_COUNTS[1],
+		std::size_t numThreads = ThreadPool::getDefaultThreadCount());
+	~ExampleCrowd() = default;
+	virtual void update(const Input& input, const MS elapsedTime);
+	virtual void capture(ExampleSnapshot& out);
+	virtual void reset();
+
+	void setThreadCount(std::size_t numThreads) { pool_.resize(numThreads); }
+	std::size_t getThreadCount() const { return pool_.size(); }
+	std::size_t getAgentCount() const { return agents_.size(); }
+	ctp::Coord2 getAgentPosition(std::size_t index) const { return agents_[index].mover.getPosition(); }
+	// Agents put back where they started in the last step.
+	std::size_t getRevertedCount() const;
+
+private:
+	struct Agent {
+		Mover mover;
+		ctp::Coord2 goal;
+		MS goalTime;         // Time spent heading for the goal.
+		std::uint32_t rng;   // Each agent has its own random numbers, so they don't depend on which thread runs it.
+	};
+
+	std::unique_ptr<ObstacleMap> map_;
+	ctp::Rect level_region_;
+	std::size_t num_agents_;
+	ThreadPool pool_;
+
+	std::vector<PreparedWall*> obstacles_; // The map's obstacles, for reading from the pool's threads.
+	CrowdGrid obstacle_grid_;
+
+	std::vector<Agent> agents_;
+	std::vector<PooledWall> bodies_;       // Agents where they were at the start of the step, for the others to collide with.
+	std::vector<ctp::Rect> body_bounds_;
+	CrowdGrid body_grid_;
+	std::vector<ctp::Coord2> start_positions_;
+	std::vector<ctp::Rect> proposal_bounds_;
+	CrowdGrid proposal_grid_;
+	std::vector<std::uint8_t> reverted_;
+	std::shared_ptr<const std::vector<ctp::ShapeContainer>> agent_shapes_; // Shared with snapshots.
+
+	// Timing, to compare thread counts.
+	MS timing_elapsed_{0};
+	std::size_t timing_steps_{0};
+	std::size_t timing_reverted_{0};
+	double propose_micros_{0};
+	double commit_micros_{0};
+
+	void _init();
+	void _place_agents(std::size_t numAgents);
+	ctp::ShapeContainer _gen_agent_shape() const;
+	void _steer(Agent& agent, const MS elapsedTime) const;
+	void _propose(std::size_t begin, std::size_t end, const MS elapsedTime);
+	void _find_conflicts(std::size_t begin, std::size_t end);
+	void _commit(std::size_t begin, std::size_t end);
+	void _report_timing(const MS elapsedTime);
+	static ctp::gFloat _random(std::uint32_t& state); // In [0, 1).
+};
+}
+
+#endif // INCLUDE_GAME_EXAMPLE_CROWD_HPP
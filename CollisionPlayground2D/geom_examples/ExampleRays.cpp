@@ -2,11 +2,15 @@
 
 #include <iostream>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 
 #include "../generator.hpp"
 #include "../Input.hpp"
-#include "../Graphics.hpp"
-#include "../util.hpp"
+#include "../Profiler.hpp"
+#include "MappedCollisionMap.hpp"
+#include "RayPacket.hpp"
+#include "SceneFile.hpp"
 
 namespace game {
 
@@ -15,89 +19,141 @@ const Uint16      ExampleRays::MAX_RAY_LENGTH = 1000;
 const Uint8       ExampleRays::HIT_POINT_SIZE = 4;
 
 const Colour ExampleRays::RAY_COLOUR = Colour::YELLOW;
-const Colour ExampleRays::RAY_ORIGIN_COLOUR = Colour::ORANGE;
-const Colour ExampleRays::HIT_POINT_COLOUR = Colour::CYAN;
 const Colour ExampleRays::RAY_REFLECT_COLOURS[] = {RAY_COLOUR, Colour::LIGHT_GREEN, Colour::FUCHSIA, Colour::ORANGE};
 const std::size_t ExampleRays::NUM_REFLECT_COLOURS = 4;
 
-ExampleRays::ExampleRays(ExampleType type, const ctp::Rect& levelRegion)
-	: type_(type), level_region_(levelRegion), rotating_ray_{ctp::Ray{level_region_.center(), ctp::Coord2(1, 0)}} {
+const std::size_t ExampleRays::FAN_RAYS = 512;
+const std::size_t ExampleRays::FAN_PACKET_SIZES[] = {4, 8, 16};
+const std::size_t ExampleRays::NUM_FAN_PACKET_SIZES = 3;
+const MS ExampleRays::TIMING_REPORT_INTERVAL = 1000;
+
+ExampleRays::ExampleRays(ExampleType type, const ctp::Rect& levelRegion, Broadphase broadphase)
+	: type_(type), map_(makeObstacleMap(broadphase)), level_region_(levelRegion), rotating_ray_{ctp::Ray{level_region_.center(), ctp::Coord2(1, 0)}} {
 	_init();
 }
 void ExampleRays::_init() {
 	for (std::size_t i = 0; i < NUM_SHAPES; ++i)
-		map_.add(new ctp::Wall(Example::genShape(), gen::coord2(level_region_)));
+		map_->addWall(Example::genShape(), gen::coord2(level_region_));
 }
 void ExampleRays::update(const Input& input, const MS elapsedTime) {
 	rotating_ray_.receiveInput(input);
 	rotating_ray_.update(elapsedTime);
+	if (type_ == ExampleType::FAN)
+		_update_fan(input, elapsedTime);
+	else if (type_ == ExampleType::CLOSEST || type_ == ExampleType::REFLECTING)
+		_report_timing(elapsedTime);
 }
-
-void ExampleRays::_draw_peircing(const Graphics& graphics) const {
-	std::vector<SDL_Point> intersections;
-	ctp::gFloat near, far;
-	const ctp::Ray& r(rotating_ray_.getRay());
-	for (std::size_t i = 0; i < map_.size(); ++i) {
-		if (ctp::intersects(r, map_[i]->getCollider(), map_[i]->getPosition(), near, far)) {
-			intersections.push_back(util::coord2DToSDLPoint(r.origin + r.dir * near));
-			intersections.push_back(util::coord2DToSDLPoint(r.origin + r.dir * far));
-			graphics.setRenderColour(Example::HIT_SHAPE_COLOUR);
-		} else {
-			graphics.setRenderColour(Example::SHAPE_COLOUR);
-		}
-		graphics.renderShape(map_[i]->getCollider(), map_[i]->getPosition());
+void ExampleRays::_update_fan(const Input& input, const MS elapsedTime) {
+	if (input.wasKeyPressed(SDLK_p)) {
+		packet_size_index_ = (packet_size_index_ + 1) % NUM_FAN_PACKET_SIZES;
+		std::cout << "Ray packet size: " << FAN_PACKET_SIZES[packet_size_index_] << "\n";
 	}
-	graphics.setRenderColour(RAY_COLOUR);
-	graphics.renderRay(util::coord2DToSDLPoint(r.origin), r.dir.x, r.dir.y, MAX_RAY_LENGTH);
-	graphics.setRenderColour(HIT_POINT_COLOUR);
-	graphics.renderPoints(intersections, HIT_POINT_SIZE);
-}
-bool ExampleRays::_find_closest_isect(ctp::Ray testRay,
-	std::size_t& out_closest_ind, ctp::gFloat& out_near, ctp::Coord2& out_norm_near, ctp::gFloat& out_far, ctp::Coord2& out_norm_far) const {
-	ctp::gFloat closest(-1), testNear, testFar;
-	ctp::Coord2 testNormNear, testNormFar;
-	for (std::size_t i = 0; i < map_.size(); ++i) {
-		if (ctp::intersects(testRay, map_[i]->getCollider(), map_[i]->getPosition(), testNear, testNormNear, testFar, testNormFar)) {
-			if (closest == -1 || testNear < closest) {
-				closest = testNear;
-				out_closest_ind = i;
-				out_near = testNear;
-				out_norm_near = testNormNear;
-				out_far = testFar;
-				out_norm_far = testNormFar;
-			}
-			if (closest == 0.0f)
-				return true;
-		}
+	if (input.wasKeyPressed(SDLK_i)) {
+		const int maxLevel(static_cast<int>(simd::getMaxLevel()));
+		simd::setLevel(static_cast<SimdLevel>((static_cast<int>(simd::getLevel()) + 1) % (maxLevel + 1)));
+		std::cout << "SIMD instruction set: " << simd::getLevelName(simd::getLevel()) << "\n";
 	}
-	return closest != -1;
-}
-void ExampleRays::_draw_closest(const Graphics& graphics) const {
+	// Spread the rays evenly around the rotating ray. Neighbouring rays end up in the same packet.
 	const ctp::Ray& r(rotating_ray_.getRay());
+	fan_rays_.resize(FAN_RAYS);
+	for (std::size_t i = 0; i < FAN_RAYS; ++i) {
+		const ctp::gFloat angle(ctp::constants::TAU * i / FAN_RAYS);
+		const ctp::gFloat sine(std::sin(angle)), cosine(std::cos(angle));
+		fan_rays_[i] = ctp::Ray{r.origin, ctp::Coord2(r.dir.x * cosine - r.dir.y * sine, r.dir.x * sine + r.dir.y * cosine)};
+	}
+	ScopedTimer timer(Profiler::Phase::COLLISION);
+	auto start(std::chrono::steady_clock::now());
+	map_->findClosestHits(fan_rays_, FAN_PACKET_SIZES[packet_size_index_], fan_dists_, fan_inds_);
+	packet_micros_ += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
 	std::size_t ind;
 	ctp::gFloat near, far;
-	ctp::Coord2 unused1, unused2;
-	bool isCollision = _find_closest_isect(r, ind, near, unused1, far, unused2);
-	// Draw results.
-	for (std::size_t i = 0; i < map_.size(); ++i) {
-		if (ind == i)
-			graphics.setRenderColour(Example::HIT_SHAPE_COLOUR);
-		else
-			graphics.setRenderColour(Example::SHAPE_COLOUR);
-		graphics.renderShape(map_[i]->getCollider(), map_[i]->getPosition());
+	ctp::Coord2 normNear, normFar;
+	for (std::size_t i = 0; i < FAN_RAYS; ++i)
+		map_->findClosestHit(fan_rays_[i], ind, near, normNear, far, normFar);
+	single_micros_ += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	timer.stop();
+	_report_timing(elapsedTime);
+}
+void ExampleRays::_report_timing(const MS elapsedTime) {
+	++timing_frames_;
+	timing_elapsed_ += elapsedTime;
+	if (timing_elapsed_ < TIMING_REPORT_INTERVAL)
+		return;
+	if (type_ == ExampleType::FAN) {
+		const double rays(static_cast<double>(FAN_RAYS) * timing_frames_);
+		std::cout << "Rays per second - packets of " << FAN_PACKET_SIZES[packet_size_index_] << " (" << simd::getLevelName(simd::getLevel()) << "): "
+			<< rays / packet_micros_ * 1e6 << ", single rays: " << rays / single_micros_ * 1e6 << "\n";
+	} else if (ray_cache_.getStats().queries > 0 && uncached_frames_ > 0) {
+		const RayCache::Stats& stats(ray_cache_.getStats());
+		std::cout << "Ray cache - hit rate: " << 100.0 * stats.hits / stats.queries << "%, per frame: " << cached_micros_ / timing_frames_
+			<< "us, or " << uncached_micros_ / uncached_frames_ << "us without the cache\n";
+		ray_cache_.resetStats();
+	}
+	packet_micros_ = 0;
+	single_micros_ = 0;
+	cached_micros_ = 0;
+	uncached_micros_ = 0;
+	uncached_frames_ = 0;
+	timing_elapsed_ = 0;
+	timing_frames_ = 0;
+}
+
+void ExampleRays::_capture_peircing(ExampleSnapshot& out) const {
+	ScopedTimer timer(Profiler::Phase::COLLISION);
+	const ctp::Ray& r(rotating_ray_.getRay());
+	std::vector<RayHit> hits;
+	map_->findHits(r, hits);
+	for (const RayHit& hit : hits) {
+		out.hitPoints.push_back(r.origin + r.dir * hit.near);
+		out.hitPoints.push_back(r.origin + r.dir * hit.far);
+		out.hitObstacles.push_back(hit.index);
 	}
-	graphics.setRenderColour(RAY_COLOUR);
-	graphics.renderRay(util::coord2DToSDLPoint(r.origin), r.dir.x, r.dir.y, isCollision ? static_cast<Uint16>(near) : MAX_RAY_LENGTH);
+	std::sort(out.hitObstacles.begin(), out.hitObstacles.end());
+	out.rays.push_back(ExampleSnapshot::RaySegment{r.origin, r.dir, MAX_RAY_LENGTH, RAY_COLOUR});
+}
+void ExampleRays::_capture_closest(ExampleSnapshot& out) {
+	ScopedTimer timer(Profiler::Phase::COLLISION);
+	const auto start(std::chrono::steady_clock::now());
+	const ctp::Ray& r(rotating_ray_.getRay());
+	RayHit hit;
+	bool isCollision = ray_cache_.findClosestHit(*map_, 0, r, hit);
+	cached_micros_ += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	timer.stop();
+	out.rays.push_back(ExampleSnapshot::RaySegment{r.origin, r.dir, isCollision ? static_cast<Uint16>(hit.near) : MAX_RAY_LENGTH, RAY_COLOUR});
 	if (isCollision) {
-		graphics.setRenderColour(HIT_POINT_COLOUR);
-		graphics.renderPoint(util::coord2DToSDLPoint(r.origin + r.dir * near), HIT_POINT_SIZE);
+		out.hitObstacles.push_back(hit.index);
+		out.hitPoints.push_back(r.origin + r.dir * hit.near);
 	}
+	_time_uncached(std::vector<ctp::Ray>{r});
 }
-bool ExampleRays::_find_reflection(ctp::Ray testRay, std::size_t& out_ind, ctp::gFloat& out_reflect_dist, ctp::Ray& out_reflected) const {
+// Trace the same rays again without the cache, to compare. Only done for the first frame of each report,
+// as tracing every frame twice would slow the example down as much as the cache speeds it up.
+void ExampleRays::_time_uncached(const std::vector<ctp::Ray>& rays) {
+	if (uncached_frames_ > 0)
+		return;
+	++uncached_frames_;
+	const auto start(std::chrono::steady_clock::now());
+	std::size_t ind;
 	ctp::gFloat near, far;
-	ctp::Coord2 norm_near, norm_far;
-	if (!_find_closest_isect(testRay, out_ind, near, norm_near, far, norm_far))
+	ctp::Coord2 normNear, normFar;
+	for (const ctp::Ray& ray : rays)
+		map_->findClosestHit(ray, ind, near, normNear, far, normFar);
+	uncached_micros_ += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+bool ExampleRays::_find_reflection(ctp::Ray testRay, std::size_t depth, std::size_t& out_ind, ctp::gFloat& out_reflect_dist, ctp::Ray& out_reflected) {
+	const auto start(std::chrono::steady_clock::now());
+	RayHit hit;
+	const bool isCollision(ray_cache_.findClosestHit(*map_, depth, testRay, hit));
+	cached_micros_ += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	if (!isCollision)
 		return false;
+	out_ind = hit.index;
+	ctp::gFloat near(hit.near);
+	ctp::Coord2 norm_near(hit.normNear);
+	const ctp::gFloat far(hit.far);
+	const ctp::Coord2 norm_far(hit.normFar);
 	if (near == 0.0f) { // Check if inside a shape.
 		near = far; // Use the exit point.
 		norm_near = -norm_far; // Reflect inside the shape.
@@ -125,55 +181,87 @@ Colour ExampleRays::_reflect_interp_colour(std::size_t reflectDepth) const {
 		static_cast<Uint8>(first.a + interp_A * interpolation)
 	};
 }
-void ExampleRays::_draw_reflecting(const Graphics& graphics) const {
-	std::vector<std::size_t> indices; // Keep track of shapes that were hit.
-	std::vector<SDL_Point> reflectPoints;
+void ExampleRays::_capture_reflecting(ExampleSnapshot& out) {
+	ScopedTimer timer(Profiler::Phase::COLLISION);
 	std::size_t numReflects(0), ind;
 	ctp::Ray currentRay(rotating_ray_.getRay()), reflectedRay;
 	ctp::gFloat reflectDist;
-	while (numReflects < MAX_REFLECTIONS && _find_reflection(currentRay, ind, reflectDist, reflectedRay)) {
-		graphics.setRenderColour(_reflect_interp_colour(numReflects));
-		graphics.renderRay(util::coord2DToSDLPoint(currentRay.origin), currentRay.dir.x, currentRay.dir.y, static_cast<Uint16>(reflectDist));
-
-		indices.push_back(ind);
-		reflectPoints.push_back(util::coord2DToSDLPoint(currentRay.origin + currentRay.dir * reflectDist));
+	std::vector<ctp::Ray> traced;
+	while (numReflects < MAX_REFLECTIONS) {
+		traced.push_back(currentRay);
+		if (!_find_reflection(currentRay, numReflects, ind, reflectDist, reflectedRay))
+			break;
+		out.rays.push_back(ExampleSnapshot::RaySegment{currentRay.origin, currentRay.dir, static_cast<Uint16>(reflectDist), _reflect_interp_colour(numReflects)});
+		out.hitObstacles.push_back(ind);
+		out.hitPoints.push_back(currentRay.origin + currentRay.dir * reflectDist);
 		currentRay = reflectedRay;
 		++numReflects;
 	}
-	if (numReflects < MAX_REFLECTIONS) { // Draw final ray, if necessary.
-		graphics.setRenderColour(_reflect_interp_colour(numReflects));
-		graphics.renderRay(util::coord2DToSDLPoint(currentRay.origin), currentRay.dir.x, currentRay.dir.y, MAX_RAY_LENGTH);
-	}
-	for (std::size_t i = 0; i < map_.size(); ++i) {
-		if (std::find(indices.begin(), indices.end(), i) != indices.end())
-			graphics.setRenderColour(Example::HIT_SHAPE_COLOUR);
-		else
-			graphics.setRenderColour(Example::SHAPE_COLOUR);
-		graphics.renderShape(map_[i]->getCollider(), map_[i]->getPosition());
+	timer.stop();
+	if (numReflects < MAX_REFLECTIONS) // Add the final ray, if necessary.
+		out.rays.push_back(ExampleSnapshot::RaySegment{currentRay.origin, currentRay.dir, MAX_RAY_LENGTH, _reflect_interp_colour(numReflects)});
+	std::sort(out.hitObstacles.begin(), out.hitObstacles.end());
+	out.hitObstacles.erase(std::unique(out.hitObstacles.begin(), out.hitObstacles.end()), out.hitObstacles.end());
+	_time_uncached(traced);
+}
+void ExampleRays::_capture_fan(ExampleSnapshot& out) const {
+	for (std::size_t i = 0; i < fan_rays_.size() && i < fan_dists_.size(); ++i) {
+		const ctp::Ray& r(fan_rays_[i]);
+		if (fan_dists_[i] == -1) {
+			out.rays.push_back(ExampleSnapshot::RaySegment{r.origin, r.dir, MAX_RAY_LENGTH, RAY_COLOUR});
+			continue;
+		}
+		out.rays.push_back(ExampleSnapshot::RaySegment{r.origin, r.dir, static_cast<Uint16>(fan_dists_[i]), RAY_COLOUR});
+		out.hitPoints.push_back(r.origin + r.dir * fan_dists_[i]);
+		out.hitObstacles.push_back(fan_inds_[i]);
 	}
-	graphics.setRenderColour(HIT_POINT_COLOUR);
-	graphics.renderPoints(reflectPoints, HIT_POINT_SIZE);
+	std::sort(out.hitObstacles.begin(), out.hitObstacles.end());
+	out.hitObstacles.erase(std::unique(out.hitObstacles.begin(), out.hitObstacles.end()), out.hitObstacles.end());
 }
-void ExampleRays::draw(const Graphics& graphics) {
-	// Draw ray's origin.
-	graphics.setRenderColour(RAY_ORIGIN_COLOUR);
-	graphics.renderCircle(util::coord2DToSDLPoint(rotating_ray_.getRay().origin), 5, 1);
+void ExampleRays::capture(ExampleSnapshot& out) {
+	out.clearStep();
+	captureObstacles(*map_, out);
+	out.hasRayOrigin = true;
+	out.rayOrigin = rotating_ray_.getRay().origin;
 	switch (type_) {
 	case ExampleType::PEIRCING:
-		_draw_peircing(graphics);
+		out.hitPointSize = HIT_POINT_SIZE;
+		_capture_peircing(out);
 		return;
 	case ExampleType::CLOSEST:
-		_draw_closest(graphics);
+		out.hitPointSize = HIT_POINT_SIZE;
+		_capture_closest(out);
 		return;
 	case ExampleType::REFLECTING:
-		_draw_reflecting(graphics);
+		out.hitPointSize = HIT_POINT_SIZE;
+		_capture_reflecting(out);
+		return;
+	case ExampleType::FAN:
+		out.hitPointSize = 1;
+		_capture_fan(out);
 		return;
 	default:
 		std::cerr << "Unhandled example type.\n";
 	}
 }
 void ExampleRays::reset() {
-	map_.clear();
+	map_->clear();
+	ray_cache_.invalidate();
+	obstaclesChanged();
 	_init();
 }
+bool ExampleRays::saveScene(const std::string& path) const {
+	return game::saveScene(path, *map_, level_region_);
+}
+bool ExampleRays::loadScene(const std::string& path) {
+	auto map(std::make_unique<MappedCollisionMap>());
+	if (!map->load(path))
+		return false;
+	level_region_ = map->getScene().getRegion();
+	map_ = std::move(map);
+	ray_cache_.invalidate();
+	obstaclesChanged();
+	rotating_ray_ = RotatingRay(ctp::Ray{level_region_.center(), rotating_ray_.getRay().dir});
+	return true;
+}
 }
@@ -1,9 +1,13 @@
 #ifndef INCLUDE_GAME_EXAMPLE_RAYS_HPP
 #define INCLUDE_GAME_EXAMPLE_RAYS_HPP
 
+#include <memory>
+#include <vector>
+
 #include "Example.hpp"
 #include "Mover.hpp"
-#include "SimpleCollisionMap.hpp"
+#include "ObstacleMap.hpp"
+#include "QueryCache.hpp"
 #include "RotatingRay.hpp"
 
 #include <Geometry2D/Geometry.hpp>
@@ -17,35 +21,59 @@ public:
 	static const Uint8       HIT_POINT_SIZE;
 	// Colours.
 	static const Colour RAY_COLOUR;
-	static const Colour RAY_ORIGIN_COLOUR;
-	static const Colour HIT_POINT_COLOUR;
 	static const Colour RAY_REFLECT_COLOURS[];
 	static const std::size_t NUM_REFLECT_COLOURS;
+	// Ray fan.
+	static const std::size_t FAN_RAYS;
+	static const std::size_t FAN_PACKET_SIZES[];
+	static const std::size_t NUM_FAN_PACKET_SIZES;
+	static const MS TIMING_REPORT_INTERVAL;
 
 	enum class ExampleType {
 		PEIRCING,
 		CLOSEST,
 		REFLECTING,
+		FAN, // Rays in every direction, traced in packets.
 	};
 
-	ExampleRays(ExampleType type, const ctp::Rect& levelRegion);
+	ExampleRays(ExampleType type, const ctp::Rect& levelRegion, Broadphase broadphase);
 	~ExampleRays() = default;
 	virtual void update(const Input& input, const MS elapsedTime);
-	virtual void draw(const Graphics& graphics);
+	virtual void capture(ExampleSnapshot& out);
 	virtual void reset();
+	virtual bool saveScene(const std::string& path) const;
+	virtual bool loadScene(const std::string& path);
 private:
 	ExampleType type_;
-	SimpleCollisionMap map_;
+	std::unique_ptr<ObstacleMap> map_;
 	ctp::Rect level_region_;
 	RotatingRay rotating_ray_;
+	RayCache ray_cache_; // What the ray and each reflection hit last step.
+
+	std::vector<ctp::Ray> fan_rays_;
+	std::vector<ctp::gFloat> fan_dists_;
+	std::vector<std::size_t> fan_inds_;
+	std::size_t packet_size_index_{1};
+	// Time spent tracing the fan in packets, and tracing the same rays one at a time to compare.
+	double packet_micros_{0};
+	double single_micros_{0};
+	// Time spent tracing with the ray cache in the closest and reflecting examples.
+	// To compare, one frame's rays per report are traced again without it, in uncached_micros_.
+	double cached_micros_{0};
+	double uncached_micros_{0};
+	std::size_t uncached_frames_{0};
+	MS timing_elapsed_{0};
+	std::size_t timing_frames_{0};
 
 	void _init();
-	bool _find_closest_isect(ctp::Ray testRay,
-		std::size_t& out_closest_ind, ctp::gFloat& out_near, ctp::Coord2& out_norm_near, ctp::gFloat& out_far, ctp::Coord2& out_norm_far) const;
-	bool _find_reflection(ctp::Ray testRay, std::size_t& out_ind, ctp::gFloat& out_reflect_dist, ctp::Ray& out_reflected) const;
-	void _draw_peircing(const Graphics& graphics) const;
-	void _draw_closest(const Graphics& graphics) const;
-	void _draw_reflecting(const Graphics& graphics) const;
+	void _update_fan(const Input& input, const MS elapsedTime);
+	void _report_timing(const MS elapsedTime);
+	bool _find_reflection(ctp::Ray testRay, std::size_t depth, std::size_t& out_ind, ctp::gFloat& out_reflect_dist, ctp::Ray& out_reflected);
+	void _time_uncached(const std::vector<ctp::Ray>& rays);
+	void _capture_peircing(ExampleSnapshot& out) const;
+	void _capture_closest(ExampleSnapshot& out);
+	void _capture_reflecting(ExampleSnapshot& out);
+	void _capture_fan(ExampleSnapshot& out) const;
 	Colour _reflect_interp_colour(std::size_t reflectDepth) const; // Change the ray's colour while reflecting.
 };
 }
@@ -1,34 +1,89 @@
 #include "ExampleShapes.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
 
+#include "CompoundWall.hpp"
+#include "DriftingWall.hpp"
+#include "MappedCollisionMap.hpp"
+#include "SceneFile.hpp"
+#include "../constants.hpp"
 #include "../generator.hpp"
 #include "../Input.hpp"
-#include "../Graphics.hpp"
+#include "../Profiler.hpp"
 
 namespace game {
-ExampleShapes::ExampleShapes(ExampleType type, const ctp::Rect& levelRegion) : type_(type), level_region_(levelRegion) {
+const MS ExampleShapes::TIMING_REPORT_INTERVAL = 1000;
+const std::size_t ExampleShapes::NUM_COMPOUNDS = 12;
+const std::size_t ExampleShapes::NUM_SHAPE_COUNTS = 4;
+const std::size_t ExampleShapes::SHAPE_COUNTS[NUM_SHAPE_COUNTS] = {20, 10000, 100000, 1000000};
+
+ExampleShapes::ExampleShapes(ExampleType type, const ctp::Rect& levelRegion, Broadphase broadphase)
+	: type_(type), map_(makeObstacleMap(broadphase)), contact_cache_(*map_), base_region_(levelRegion), level_region_(levelRegion),
+	num_shapes_(SHAPE_COUNTS[0]), placer_(levelRegion, SHAPE_MAX_SIZE) {
 	_init();
 }
+// The mover is put down first, so there's always room for it. The shapes are then placed around it until the level is full.
+// They're generated together on the pool's threads, so only placing them is done one at a time.
 void ExampleShapes::_init() {
-	for (std::size_t i = 0; i < NUM_SHAPES; ++i)
-		map_.add(new ctp::Wall(_gen_example_shape(), gen::coord2(level_region_)));
+	placer_.clear();
 	_gen_mover();
+	if (type_ == ExampleType::COMPOUND) {
+		_add_compounds();
+		return;
+	}
+	gen::ShapeSoA batch;
+	gen::shapes(pool_, gen::rng(), num_shapes_, _get_shape_spec(), batch);
+	for (std::size_t i = 0; i < batch.size(); ++i) {
+		ctp::Coord2 position;
+		if (!placer_.place(batch.getBoundingCircle(i), position)) {
+			std::cout << "The level is full: placed " << i << " of " << num_shapes_ << " shapes.\n";
+			break;
+		}
+		if (type_ == ExampleType::DRIFTING) {
+			const Velocity2D velocity(gen::gFloat(-DriftingWall::MAX_DRIFT_SPEED, DriftingWall::MAX_DRIFT_SPEED),
+			                          gen::gFloat(-DriftingWall::MAX_DRIFT_SPEED, DriftingWall::MAX_DRIFT_SPEED));
+			DriftingWall* drifter = new DriftingWall(batch.makeShape(i), position, velocity);
+			drifters_.push_back(drifter);
+			map_->add(drifter);
+		} else {
+			map_->addWall(batch.makeShape(i), position);
+		}
+	}
 }
-void ExampleShapes::_gen_mover() {
-	ctp::ShapeContainer collider = _gen_example_shape();
-	ctp::Coord2 position = gen::coord2(level_region_);
-	// Ensure that the mover doesn't start inside another shape (do collision tests until it is put down cleanly).
-	// Just assume that it will always be possible to place the mover...
-	for (;;) {
-		if (std::none_of(map_.obstacles.cbegin(), map_.obstacles.cend(), [&](const auto& obs) { return ctp::overlaps(collider, position, obs->getCollider(), obs->getPosition()); }))
+void ExampleShapes::_next_shape_count() {
+	const std::size_t* next(std::upper_bound(SHAPE_COUNTS, SHAPE_COUNTS + NUM_SHAPE_COUNTS, num_shapes_));
+	num_shapes_ = next == SHAPE_COUNTS + NUM_SHAPE_COUNTS ? SHAPE_COUNTS[0] : *next;
+	const ctp::gFloat scale(std::sqrt(static_cast<ctp::gFloat>(num_shapes_) / SHAPE_COUNTS[0]));
+	level_region_ = ctp::Rect(base_region_.x, base_region_.y, base_region_.w * scale, base_region_.h * scale);
+	placer_ = ShapePlacer(level_region_, SHAPE_MAX_SIZE);
+	std::cout << "Shapes: " << num_shapes_ << "\n";
+	reset();
+}
+void ExampleShapes::_add_compounds() {
+	for (std::size_t i = 0; i < NUM_COMPOUNDS; ++i) {
+		auto compound(std::make_unique<CompoundWall>(Example::genCompound(), ctp::Coord2(0, 0)));
+		ctp::Coord2 position;
+		if (!placer_.place(compound->getCollider(), position)) { // Placed by the box around its parts.
+			std::cout << "The level is full: placed " << i << " of " << NUM_COMPOUNDS << " compound shapes.\n";
 			break;
-		collider = _gen_example_shape();
+		}
+		compound->setPosition(position);
+		map_->add(compound.release());
+	}
+}
+void ExampleShapes::_gen_mover() {
+	const ctp::ShapeContainer collider(_gen_example_shape());
+	ctp::Coord2 position;
+	if (!placer_.place(collider, position)) {
 		position = gen::coord2(level_region_);
-		std::cout << "Spot occupied. Trying somewhere else...\n";
+		std::cerr << "Error: The level is full, so the mover may start inside a shape.\n";
 	}
 	std::cout << "Mover has entered the level.\n";
 	mover_ = Mover(collider, position);
+	mover_shape_ = std::make_shared<const ctp::ShapeContainer>(collider);
 }
 ctp::ShapeContainer ExampleShapes::_gen_example_shape() const {
 	switch (type_) {
@@ -39,33 +94,131 @@ ctp::ShapeContainer ExampleShapes::_gen_example_shape() const {
 	case ExampleType::CIRCLE:
 		return ctp::ShapeContainer(Example::genCircle());
 	case ExampleType::MIXED:
+	case ExampleType::DRIFTING:
+	case ExampleType::COMPOUND:
 		return Example::genShape();
 	default:
 		std::cerr << "Unhandled example type.\n";
 		return ctp::ShapeContainer(Example::genRect());
 	}
 }
+gen::ShapeSpec ExampleShapes::_get_shape_spec() const {
+	gen::ShapeSpec spec(Example::getShapeSpec(level_region_));
+	switch (type_) {
+	case ExampleType::RECT:
+		spec.rectShare = 1;
+		spec.polyShare = 0;
+		break;
+	case ExampleType::POLY:
+		spec.rectShare = 0;
+		spec.polyShare = 1;
+		break;
+	case ExampleType::CIRCLE:
+		spec.rectShare = 0;
+		spec.polyShare = 0;
+		break;
+	default: // Mixed shapes.
+		break;
+	}
+	return spec;
+}
 void ExampleShapes::update(const Input& input, MS elapsedTime) {
+	if (input.wasKeyPressed(SDLK_n) && type_ != ExampleType::DRIFTING && type_ != ExampleType::COMPOUND)
+		_next_shape_count();
+	if (type_ == ExampleType::DRIFTING)
+		_update_drifters(elapsedTime);
+	const auto start(std::chrono::steady_clock::now());
 	mover_.receiveInput(input);
-	mover_.update(elapsedTime, map_);
+	{
+		ScopedTimer timer(Profiler::Phase::COLLISION);
+		if (type_ == ExampleType::DRIFTING) // The obstacles move every step, so there's nothing to keep.
+			mover_.update(elapsedTime, *map_);
+		else
+			mover_.update(elapsedTime, contact_cache_);
+	}
+	query_micros_ += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	_report_timing(elapsedTime);
+}
+void ExampleShapes::_update_drifters(const MS elapsedTime) {
+	const auto start(std::chrono::steady_clock::now());
+	for (std::size_t i = 0; i < drifters_.size(); ++i)
+		map_->refit(i, drifters_[i]->update(elapsedTime, level_region_));
+	refit_micros_ += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
 }
-void ExampleShapes::draw(const Graphics& graphics) {
-	for (std::size_t i = 0; i < map_.size(); ++i) {
+void ExampleShapes::_report_timing(const MS elapsedTime) {
+	++timing_frames_;
+	timing_elapsed_ += elapsedTime;
+	if (timing_elapsed_ < TIMING_REPORT_INTERVAL)
+		return;
+	if (type_ == ExampleType::DRIFTING) {
+		const ObstacleMap::QueryStats& stats(map_->getQueryStats());
+		std::cout << "Average per frame - refit: " << refit_micros_ / timing_frames_ << "us, query: " << query_micros_ / timing_frames_ << "us"
+			<< ", narrowphase tests: " << static_cast<double>(stats.returned) / timing_frames_
+			<< " (of " << static_cast<double>(stats.candidates) / timing_frames_ << " broadphase candidates)\n";
+		map_->resetQueryStats();
+	} else if (contact_cache_.getStats().queries > 0) {
+		// Saved time is estimated: what the hits would have cost at the average cost of a miss.
+		const ContactCache::Stats& stats(contact_cache_.getStats());
+		const std::size_t misses(stats.queries - stats.hits);
+		const double hitCost(stats.hits > 0 ? stats.hitMicros / stats.hits : 0), missCost(misses > 0 ? stats.missMicros / misses : 0);
+		std::cout << "Contact cache - hit rate: " << 100.0 * stats.hits / stats.queries << "%, per query: " << hitCost << "us hit, "
+			<< missCost << "us miss, about " << (misses > 0 ? stats.hits * (missCost - hitCost) / timing_frames_ : 0) << "us saved per frame\n";
+		contact_cache_.resetStats();
+	}
+	timing_elapsed_ = 0;
+	timing_frames_ = 0;
+	refit_micros_ = 0;
+	query_micros_ = 0;
+}
+void ExampleShapes::capture(ExampleSnapshot& out) {
+	out.clearStep();
+	const ObstacleMap& map(*map_);
+	captureObstacles(map, out);
+	if (type_ == ExampleType::DRIFTING) {
+		for (std::size_t i = 0; i < map.size(); ++i)
+			out.obstaclePositions.push_back(map[i]->getPosition());
+	}
 #ifdef DEBUG
-		if (ctp::overlaps(mover_.getCollider(), mover_.getPosition(), map_[i]->getCollider(), map_[i]->getPosition()))
-			graphics.setRenderColour(Example::HIT_SHAPE_COLOUR);
-		else
-			graphics.setRenderColour(Example::SHAPE_COLOUR);
-#else
-		graphics.setRenderColour(Example::SHAPE_COLOUR);
-#endif
-		graphics.renderShape(map_[i]->getCollider(), map_[i]->getPosition());
+	// Highlight the obstacles the mover overlaps.
+	for (std::size_t i = 0; i < map.size(); ++i) {
+		if (map[i]->overlaps(mover_.getCollider(), mover_.getPosition(), mover_.getPrepared()))
+			out.hitObstacles.push_back(i);
 	}
-	graphics.setRenderColour(Example::HIT_SHAPE_COLOUR);
-	graphics.renderShape(mover_.getCollider(), mover_.getPosition());
+#endif
+	out.moverShape = mover_shape_;
+	out.moverPosition = mover_.getPosition();
+	// Levels bigger than the screen are seen from the mover.
+	out.followMover = level_region_.x < 0 || level_region_.y < 0 ||
+		level_region_.x + level_region_.w > SCREEN_WIDTH || level_region_.y + level_region_.h > SCREEN_HEIGHT;
 }
 void ExampleShapes::reset() {
-	map_.clear();
+	map_->clear();
+	drifters_.clear();
+	contact_cache_.invalidate();
+	obstaclesChanged();
 	_init();
 }
+bool ExampleShapes::saveScene(const std::string& path) const {
+	return game::saveScene(path, *map_, level_region_);
+}
+bool ExampleShapes::loadScene(const std::string& path) {
+	if (type_ == ExampleType::DRIFTING) {
+		std::cerr << "Scenes can't be loaded into the drifting example, as mapped obstacles can't move.\n";
+		return false;
+	}
+	auto map(std::make_unique<MappedCollisionMap>());
+	if (!map->load(path))
+		return false;
+	const SceneFile& scene(map->getScene());
+	level_region_ = scene.getRegion();
+	// Reserve the obstacles from the file's bounds, so their walls are still only made when a query needs them.
+	placer_ = ShapePlacer(level_region_, SHAPE_MAX_SIZE);
+	for (std::size_t i = 0; i < scene.shapeCount(); ++i)
+		placer_.addBounds(scene.getBounds(i));
+	map_ = std::move(map);
+	contact_cache_.setMap(*map_);
+	obstaclesChanged();
+	_gen_mover();
+	return true;
+}
 }
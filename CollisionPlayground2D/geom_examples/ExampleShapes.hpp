@@ -1,37 +1,72 @@
 #ifndef INCLUDE_GAME_EXAMPLE_SHAPES_HPP
 #define INCLUDE_GAME_EXAMPLE_SHAPES_HPP
 
+#include <memory>
+#include <vector>
+
 #include "Example.hpp"
 #include "Mover.hpp"
-#include "SimpleCollisionMap.hpp"
+#include "ObstacleMap.hpp"
+#include "QueryCache.hpp"
+#include "ShapePlacer.hpp"
+#include "../ThreadPool.hpp"
 
 #include <Geometry2D/Geometry.hpp>
 
 namespace game {
+class DriftingWall;
 class ExampleShapes : public Example {
 public:
+	static const MS TIMING_REPORT_INTERVAL;
+	static const std::size_t NUM_COMPOUNDS;
+	// Shape counts to cycle through, in the examples of one kind of shape or mixed shapes.
+	// The level grows with the count, so the shapes are as far apart as with the first.
+	static const std::size_t NUM_SHAPE_COUNTS;
+	static const std::size_t SHAPE_COUNTS[];
 
 	enum class ExampleType {
 		RECT,
 		POLY,
 		CIRCLE,
 		MIXED,
+		DRIFTING, // Mixed shapes that drift around, so the map has to be refit every frame.
+		COMPOUND, // Concave shapes, each one obstacle made of many convex parts.
 	};
 
-	ExampleShapes(ExampleType type, const ctp::Rect& levelRegion);
+	ExampleShapes(ExampleType type, const ctp::Rect& levelRegion, Broadphase broadphase);
 	~ExampleShapes() = default;
 	virtual void update(const Input& input, const MS elapsedTime);
-	virtual void draw(const Graphics& graphics);
+	virtual void capture(ExampleSnapshot& out);
 	virtual void reset();
+	virtual bool saveScene(const std::string& path) const;
+	virtual bool loadScene(const std::string& path);
 private:
 	ExampleType type_;
 	Mover mover_;
-	SimpleCollisionMap map_;
+	std::shared_ptr<const ctp::ShapeContainer> mover_shape_; // Shared with snapshots.
+	std::unique_ptr<ObstacleMap> map_;
+	ContactCache contact_cache_; // The mover's queries go through it, except when the obstacles drift.
+	std::vector<DriftingWall*> drifters_; // Owned by the map, in the same order.
+	ctp::Rect base_region_; // The level for the first shape count.
 	ctp::Rect level_region_;
+	std::size_t num_shapes_;
+	ShapePlacer placer_; // Where the shapes and mover are, so new ones can be put down without overlapping.
+	ThreadPool pool_; // For generating the shapes.
+
+	// Timing for the drifting example, to compare refitting the map with querying it. The others report the contact cache.
+	MS timing_elapsed_{0};
+	std::size_t timing_frames_{0};
+	double refit_micros_{0};
+	double query_micros_{0};
 
 	void _init();
+	void _next_shape_count();
 	void _gen_mover();
+	void _add_compounds();
 	ctp::ShapeContainer _gen_example_shape() const;
+	gen::ShapeSpec _get_shape_spec() const; // The example's kind of shape, for generating in batches.
+	void _update_drifters(const MS elapsedTime);
+	void _report_timing(const MS elapsedTime);
 };
 }
 
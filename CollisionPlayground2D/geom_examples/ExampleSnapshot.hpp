@@ -0,0 +1,71 @@
+#ifndef INCLUDE_GAME_EXAMPLE_SNAPSHOT_HPP
+#define INCLUDE_GAME_EXAMPLE_SNAPSHOT_HPP
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "../Colour.hpp"
+
+#include <Geometry2D/Geometry.hpp>
+
+// Everything needed to draw an example at one simulation step. Examples fill one in on the simulation thread after each step,
+// and the render thread draws from copies, so drawing never touches an example's live state.
+// Shapes that rarely change are shared rather than copied: they are replaced, never modified, when they change.
+
+namespace game {
+struct ExampleSnapshot {
+	struct Obstacle {
+		ctp::ShapeContainer shape;
+		ctp::Coord2 position;
+		std::vector<std::pair<ctp::ShapeContainer, ctp::Coord2>> parts; // Compounds only: each part's shape and offset. shape is their bounds.
+	};
+	// The obstacles of one chunk of a world too big to hold at once, with the box around them for culling.
+	struct ObstacleChunk {
+		ctp::Rect bounds;
+		std::vector<Obstacle> obstacles;
+	};
+	struct RaySegment {
+		ctp::Coord2 origin;
+		ctp::Coord2 dir;
+		Uint16 length;
+		Colour colour;
+	};
+
+	std::uint64_t step{0};
+
+	std::shared_ptr<const std::vector<Obstacle>> obstacles;
+	std::vector<ctp::Coord2> obstaclePositions; // Current positions of obstacles that move. Empty if they don't.
+	std::vector<std::size_t> hitObstacles;      // Obstacles drawn in the hit colour.
+	std::vector<std::shared_ptr<const ObstacleChunk>> obstacleChunks; // Drawn as well as obstacles. Never hit.
+
+	std::shared_ptr<const ctp::ShapeContainer> moverShape; // Null if there is no mover.
+	ctp::Coord2 moverPosition;
+	bool followMover{false}; // Keep the mover in the middle of the screen, rather than showing the world as it is.
+
+	std::shared_ptr<const std::vector<ctp::ShapeContainer>> agentShapes; // Null if there are no agents.
+	std::vector<ctp::Coord2> agentPositions;
+
+	bool hasRayOrigin{false};
+	ctp::Coord2 rayOrigin;
+	std::vector<RaySegment> rays;
+	std::vector<ctp::Coord2> hitPoints;
+	Uint8 hitPointSize{1};
+	std::vector<ctp::Coord2> visibility; // The region seen from the ray origin, as a polygon. Empty if there isn't one.
+
+	// Clear what is captured every step, keeping the shared shapes and the buffers' capacity.
+	void clearStep() {
+		obstaclePositions.clear();
+		hitObstacles.clear();
+		agentPositions.clear();
+		hasRayOrigin = false;
+		rays.clear();
+		hitPoints.clear();
+		visibility.clear();
+		obstacleChunks.clear();
+	}
+};
+}
+
+#endif // INCLUDE_GAME_EXAMPLE_SNAPSHOT_HPP
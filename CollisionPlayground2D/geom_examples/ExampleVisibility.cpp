@@ -0,0 +1,136 @@
+#include "ExampleVisibility.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "CompoundWall.hpp"
+#include "MappedCollisionMap.hpp"
+#include "SceneFile.hpp"
+#include "ShapeUtil.hpp"
+#include "../generator.hpp"
+#include "../Input.hpp"
+#include "../Profiler.hpp"
+
+namespace game {
+const std::size_t ExampleVisibility::NUM_OBSTACLE_COUNTS = 3;
+const std::size_t ExampleVisibility::OBSTACLE_COUNTS[NUM_OBSTACLE_COUNTS] = {20, 500, 5000};
+const ctp::gFloat ExampleVisibility::LIGHT_RADIUS = 6.0f;
+const std::size_t ExampleVisibility::FAN_RAYS = 1024;
+const std::size_t ExampleVisibility::FAN_PACKET_SIZE = 8;
+const MS ExampleVisibility::TIMING_REPORT_INTERVAL = 1000;
+
+ExampleVisibility::ExampleVisibility(const ctp::Rect& levelRegion, Broadphase broadphase, std::size_t numObstacles)
+	: map_(makeObstacleMap(broadphase)), level_region_(levelRegion), num_obstacles_(numObstacles) {
+	_init();
+}
+// The light starts in the middle of the level, and obstacles that would cover it are left out.
+void ExampleVisibility::_init() {
+	_place_light();
+	gen::ShapeSpec spec(getShapeSpec(level_region_));
+	spec.maxSize *= std::min(1.0f, std::sqrt(static_cast<ctp::gFloat>(NUM_SHAPES) / num_obstacles_));
+	gen::ShapeSoA batch;
+	gen::shapes(pool_, gen::rng(), num_obstacles_, spec, batch);
+	const ctp::Rect lightBounds(light_.getBounds());
+	for (std::size_t i = 0; i < batch.size(); ++i) {
+		if (!boundsOverlap(batch.getBounds(i), lightBounds))
+			map_->addWall(batch.makeShape(i), batch.positions[i]);
+	}
+	_build_sweep();
+}
+void ExampleVisibility::_place_light() {
+	const ctp::ShapeContainer shape{ctp::Circle(LIGHT_RADIUS)};
+	light_ = Mover(shape, level_region_.center());
+	light_shape_ = std::make_shared<const ctp::ShapeContainer>(shape);
+}
+// Compounds are added part by part, as the sweep only takes convex outlines.
+void ExampleVisibility::_build_sweep() {
+	const auto start(std::chrono::steady_clock::now());
+	sweep_.clear();
+	sweep_.setBounds(level_region_);
+	for (std::size_t i = 0; i < map_->size(); ++i) {
+		const PreparedWall& wall(*(*map_)[i]);
+		if (!wall.isCompound()) {
+			sweep_.addShape(wall.getCollider(), wall.getPosition());
+			continue;
+		}
+		const CompoundWall& compound(static_cast<const CompoundWall&>(wall));
+		for (std::size_t p = 0; p < compound.getPartCount(); ++p)
+			sweep_.addShape(compound.getPart(p).getCollider(), wall.getPosition() + compound.getPart(p).getOffset());
+	}
+	sweep_.build();
+	build_micros_ = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ExampleVisibility::update(const Input& input, const MS elapsedTime) {
+	if (input.wasKeyPressed(SDLK_n)) { // Next obstacle count.
+		const std::size_t* next(std::upper_bound(OBSTACLE_COUNTS, OBSTACLE_COUNTS + NUM_OBSTACLE_COUNTS, num_obstacles_));
+		num_obstacles_ = next == OBSTACLE_COUNTS + NUM_OBSTACLE_COUNTS ? OBSTACLE_COUNTS[0] : *next;
+		std::cout << "Obstacles: " << num_obstacles_ << "\n";
+		reset();
+	}
+	light_.receiveInput(input);
+	ScopedTimer timer(Profiler::Phase::COLLISION);
+	light_.update(elapsedTime, *map_);
+	const auto start(std::chrono::steady_clock::now());
+	sweep_.compute(light_.getPosition(), visible_);
+	sweep_micros_ += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	_time_fan();
+	timer.stop();
+	_report_timing(elapsedTime);
+}
+// Cast a fan of rays from the light, as line of sight was found before, to compare.
+void ExampleVisibility::_time_fan() {
+	const ctp::Coord2 origin(light_.getPosition());
+	fan_rays_.resize(FAN_RAYS);
+	for (std::size_t i = 0; i < FAN_RAYS; ++i) {
+		const ctp::gFloat angle(ctp::constants::TAU * i / FAN_RAYS);
+		fan_rays_[i] = ctp::Ray{origin, ctp::Coord2(std::cos(angle), std::sin(angle))};
+	}
+	const auto start(std::chrono::steady_clock::now());
+	map_->findClosestHits(fan_rays_, FAN_PACKET_SIZE, fan_dists_, fan_inds_);
+	fan_micros_ += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+void ExampleVisibility::_report_timing(const MS elapsedTime) {
+	++timing_frames_;
+	timing_elapsed_ += elapsedTime;
+	if (timing_elapsed_ < TIMING_REPORT_INTERVAL)
+		return;
+	const VisibilitySweep::Stats& stats(sweep_.getStats());
+	std::cout << "Visibility - " << map_->size() << " obstacles in " << stats.segments << " edges and " << stats.arcs << " arcs ("
+		<< build_micros_ << "us to split), " << stats.facing << " facing the light, " << visible_.size() << " vertices. Per frame: "
+		<< sweep_micros_ / timing_frames_ << "us, or " << fan_micros_ / timing_frames_ << "us for a fan of " << FAN_RAYS << " rays\n";
+	timing_elapsed_ = 0;
+	timing_frames_ = 0;
+	sweep_micros_ = 0;
+	fan_micros_ = 0;
+}
+
+void ExampleVisibility::capture(ExampleSnapshot& out) {
+	out.clearStep();
+	captureObstacles(*map_, out);
+	out.moverShape = light_shape_;
+	out.moverPosition = light_.getPosition();
+	out.visibility = visible_;
+}
+void ExampleVisibility::reset() {
+	map_->clear();
+	obstaclesChanged();
+	_init();
+}
+bool ExampleVisibility::saveScene(const std::string& path) const {
+	return game::saveScene(path, *map_, level_region_);
+}
+bool ExampleVisibility::loadScene(const std::string& path) {
+	auto map(std::make_unique<MappedCollisionMap>());
+	if (!map->load(path))
+		return false;
+	level_region_ = map->getScene().getRegion();
+	map_ = std::move(map);
+	obstaclesChanged();
+	_place_light();
+	_build_sweep();
+	return true;
+}
+}
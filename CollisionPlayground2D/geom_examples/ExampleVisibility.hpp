@@ -0,0 +1,68 @@
+#ifndef INCLUDE_GAME_EXAMPLE_VISIBILITY_HPP
+#define INCLUDE_GAME_EXAMPLE_VISIBILITY_HPP
+
+#include <memory>
+#include <vector>
+
+#include "Example.hpp"
+#include "Mover.hpp"
+#include "ObstacleMap.hpp"
+#include "VisibilitySweep.hpp"
+#include "../ThreadPool.hpp"
+
+#include <Geometry2D/Geometry.hpp>
+
+// A light moved around the level, lighting up everything it can see. The lit region is found exactly, every step,
+// by a VisibilitySweep over the obstacles' outlines rather than by casting rays. The outlines are only split again when the obstacles change.
+// n cycles through obstacle counts, scaling the shapes down so the level stays as full, to see how the sweep scales.
+// For comparison, the timing report includes a fan of rays from the light, which only approximates the same region.
+
+namespace game {
+class ExampleVisibility : public Example {
+public:
+	static const std::size_t NUM_OBSTACLE_COUNTS;
+	static const std::size_t OBSTACLE_COUNTS[];
+	static const ctp::gFloat LIGHT_RADIUS;
+	static const std::size_t FAN_RAYS;
+	static const std::size_t FAN_PACKET_SIZE;
+	static const MS TIMING_REPORT_INTERVAL;
+
+	ExampleVisibility(const ctp::Rect& levelRegion, Broadphase broadphase, std::size_t numObstacles = OBSTACLE_COUNTS[0]);
+	~ExampleVisibility() = default;
+	virtual void update(const Input& input, const MS elapsedTime);
+	virtual void capture(ExampleSnapshot& out);
+	virtual void reset();
+	virtual bool saveScene(const std::string& path) const;
+	virtual bool loadScene(const std::string& path);
+
+private:
+	std::unique_ptr<ObstacleMap> map_;
+	ctp::Rect level_region_;
+	std::size_t num_obstacles_;
+	ThreadPool pool_; // For generating the obstacles.
+	Mover light_;
+	std::shared_ptr<const ctp::ShapeContainer> light_shape_; // Shared with snapshots.
+
+	VisibilitySweep sweep_;
+	std::vector<ctp::Coord2> visible_;
+
+	std::vector<ctp::Ray> fan_rays_;
+	std::vector<ctp::gFloat> fan_dists_;
+	std::vector<std::size_t> fan_inds_;
+
+	// Timing.
+	MS timing_elapsed_{0};
+	std::size_t timing_frames_{0};
+	double build_micros_{0}; // Of the last build, not summed.
+	double sweep_micros_{0};
+	double fan_micros_{0};
+
+	void _init();
+	void _place_light();
+	void _build_sweep();
+	void _time_fan();
+	void _report_timing(const MS elapsedTime);
+};
+}
+
+#endif // INCLUDE_GAME_EXAMPLE_VISIBILITY_HPP
@@ -0,0 +1,175 @@
+#include "ExampleWorld.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "ShapeUtil.hpp"
+#include "../constants.hpp"
+#include "../Input.hpp"
+#include "../Profiler.hpp"
+
+namespace game {
+namespace {
+const ctp::gFloat WORLD_CHUNK_SIZE = 512.0f;
+const std::int32_t WORLD_CHUNKS_PER_SIDE = 64;
+const ctp::gFloat WORLD_CENTER = WORLD_CHUNK_SIZE * WORLD_CHUNKS_PER_SIDE / 2;
+
+ctp::gFloat distanceSquared(const ctp::Coord2& a, const ctp::Coord2& b) {
+	const ctp::Coord2 d(a - b);
+	return d.x * d.x + d.y * d.y;
+}
+}
+
+// 64 x 64 chunks of 48 shapes each: about 200k obstacles, of which a few hundred are ever resident.
+const WorldSpec ExampleWorld::WORLD{"world", 0x5eed, WORLD_CHUNK_SIZE, WORLD_CHUNKS_PER_SIDE, 48,
+	gen::ShapeSpec{ctp::Rect(0, 0, 0, 0), 2.0f, 48.0f, 3, 20, 0.2f, 0.5f},
+	ctp::Rect(WORLD_CENTER - 40, WORLD_CENTER - 40, 80, 80)};
+const ctp::gFloat ExampleWorld::MOVER_RADIUS = 6.0f;
+const ctp::gFloat ExampleWorld::LOAD_MARGIN = WORLD_CHUNK_SIZE;
+const MS ExampleWorld::LOOKAHEAD = 1000;
+const std::size_t ExampleWorld::MEMORY_BUDGET = 4 * 1024 * 1024;
+const MS ExampleWorld::TIMING_REPORT_INTERVAL = 1000;
+
+ExampleWorld::ExampleWorld() : streamer_(WORLD), map_(WORLD.chunkSize, WORLD.shapes.maxSize) {
+	_init();
+}
+// The mover starts in the clearing in the middle of the world.
+void ExampleWorld::_init() {
+	const ctp::ShapeContainer shape{ctp::Circle(MOVER_RADIUS)};
+	mover_ = Mover(shape, WORLD.clearing.center());
+	mover_shape_ = std::make_shared<const ctp::ShapeContainer>(shape);
+	velocity_ = ctp::Coord2(0, 0);
+	_stream(0);
+}
+
+void ExampleWorld::update(const Input& input, const MS elapsedTime) {
+	mover_.receiveInput(input);
+	_stream(elapsedTime);
+	const ctp::Coord2 start(mover_.getPosition());
+	{
+		ScopedTimer timer(Profiler::Phase::COLLISION);
+		mover_.update(elapsedTime, map_);
+	}
+	if (elapsedTime > 0)
+		velocity_ = (mover_.getPosition() - start) * (1.0f / elapsedTime);
+	_report(elapsedTime);
+}
+
+void ExampleWorld::_stream(const MS elapsedTime) {
+	loaded_.clear();
+	streamer_.poll(loaded_);
+	for (ChunkStreamer::LoadedChunk& chunk : loaded_)
+		_make_resident(std::move(chunk));
+
+	// Whatever the mover could reach this step has to be there before it moves.
+	needed_.clear();
+	map_.findChunks(expandBounds(mover_.getBounds(), Mover::MAX_SPEED * elapsedTime), needed_);
+	for (const ChunkCoord& coord : needed_) {
+		if (!streamer_.exists(coord) || map_.isResident(coord))
+			continue;
+		const auto start(std::chrono::steady_clock::now());
+		_make_resident(streamer_.loadNow(coord));
+		++waits_;
+		wait_millis_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// The screen around the mover, and around where it is heading.
+	const ctp::Coord2 position(mover_.getPosition());
+	const ctp::Coord2 ahead(position + velocity_ * LOOKAHEAD);
+	const ctp::gFloat halfW(SCREEN_WIDTH / 2.0f), halfH(SCREEN_HEIGHT / 2.0f);
+	const ctp::Rect view(combineBounds(
+		ctp::Rect(position.x - halfW, position.y - halfH, 2 * halfW, 2 * halfH),
+		ctp::Rect(ahead.x - halfW, ahead.y - halfH, 2 * halfW, 2 * halfH)));
+	wanted_.clear();
+	map_.findChunks(expandBounds(view, LOAD_MARGIN), wanted_);
+	wanted_.erase(std::remove_if(wanted_.begin(), wanted_.end(), [this](const ChunkCoord& coord) { return !streamer_.exists(coord); }),
+		wanted_.end());
+	std::sort(wanted_.begin(), wanted_.end(), [&](const ChunkCoord& a, const ChunkCoord& b) {
+		return distanceSquared(map_.getChunkRegion(a).center(), position) < distanceSquared(map_.getChunkRegion(b).center(), position);
+	});
+	requests_.clear();
+	for (const ChunkCoord& coord : wanted_) {
+		if (!map_.isResident(coord))
+			requests_.push_back(coord);
+	}
+	streamer_.request(requests_);
+	_evict();
+}
+
+void ExampleWorld::_make_resident(ChunkStreamer::LoadedChunk&& chunk) {
+	++loads_;
+	generated_ += chunk.generated ? 1 : 0;
+	load_millis_ += chunk.loadMillis;
+	const Resident resident{chunk.coord, chunk.bytes, std::move(chunk.obstacles)};
+	const auto found(std::find_if(resident_.begin(), resident_.end(), [&](const Resident& r) { return r.coord == resident.coord; }));
+	if (found != resident_.end()) {
+		resident_bytes_ -= found->bytes;
+		*found = resident;
+		streamer_.release(map_.removeChunk(resident.coord));
+	} else {
+		resident_.push_back(resident);
+	}
+	resident_bytes_ += resident.bytes;
+	map_.addChunk(resident.coord, std::move(chunk.map));
+}
+
+// Chunks that are wanted are never evicted, even over budget: they would only be loaded straight back.
+void ExampleWorld::_evict() {
+	const ctp::Coord2 position(mover_.getPosition());
+	while (resident_bytes_ > MEMORY_BUDGET) {
+		std::size_t furthest(resident_.size());
+		ctp::gFloat furthestDistance(-1);
+		for (std::size_t i = 0; i < resident_.size(); ++i) {
+			if (std::find(wanted_.begin(), wanted_.end(), resident_[i].coord) != wanted_.end())
+				continue;
+			const ctp::gFloat distance(distanceSquared(map_.getChunkRegion(resident_[i].coord).center(), position));
+			if (distance > furthestDistance) {
+				furthest = i;
+				furthestDistance = distance;
+			}
+		}
+		if (furthest == resident_.size())
+			return;
+		resident_bytes_ -= resident_[furthest].bytes;
+		streamer_.release(map_.removeChunk(resident_[furthest].coord));
+		resident_[furthest] = std::move(resident_.back());
+		resident_.pop_back();
+		++evictions_;
+	}
+}
+
+void ExampleWorld::_report(const MS elapsedTime) {
+	timing_elapsed_ += elapsedTime;
+	if (timing_elapsed_ < TIMING_REPORT_INTERVAL)
+		return;
+	std::cout << "World - " << resident_.size() << " chunks resident, " << map_.size() << " obstacles, "
+		<< resident_bytes_ / 1024 << "KB of " << MEMORY_BUDGET / 1024 << "KB. Loaded " << loads_ << " (" << generated_ << " generated), "
+		<< (loads_ ? load_millis_ / loads_ : 0) << "ms each. Evicted " << evictions_ << ". Waited for " << waits_ << ", "
+		<< wait_millis_ << "ms\n";
+	timing_elapsed_ = 0;
+	loads_ = 0;
+	generated_ = 0;
+	evictions_ = 0;
+	waits_ = 0;
+	load_millis_ = 0;
+	wait_millis_ = 0;
+}
+
+void ExampleWorld::capture(ExampleSnapshot& out) {
+	out.clearStep();
+	for (const Resident& resident : resident_)
+		out.obstacleChunks.push_back(resident.obstacles);
+	out.moverShape = mover_shape_;
+	out.moverPosition = mover_.getPosition();
+	out.followMover = true;
+}
+void ExampleWorld::reset() {
+	for (const Resident& resident : resident_)
+		streamer_.release(map_.removeChunk(resident.coord));
+	resident_.clear();
+	resident_bytes_ = 0;
+	map_.clear();
+	_init();
+}
+}
@@ -0,0 +1,80 @@
+#ifndef INCLUDE_GAME_EXAMPLE_WORLD_HPP
+#define INCLUDE_GAME_EXAMPLE_WORLD_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ChunkedCollisionMap.hpp"
+#include "ChunkStreamer.hpp"
+#include "Example.hpp"
+#include "Mover.hpp"
+
+#include <Geometry2D/Geometry.hpp>
+
+// A world far bigger than the screen, split into chunks that are streamed in from disk as the mover gets near them,
+// with the camera following the mover. Chunks are only generated the first time they are needed, and kept on disk after that.
+// Each step, before the mover moves:
+//   - chunks the loading thread has finished are made resident.
+//   - chunks the mover could reach this step are loaded there and then if they still aren't resident. Stepping waits for them,
+//     so collisions never depend on how far the loading thread has got. This should only happen when it falls behind.
+//   - chunks in view, or that will be soon at the mover's speed, are asked for, nearest first.
+//   - chunks that aren't wanted are evicted, furthest first, while the resident chunks are over the memory budget.
+// The broadphase setting doesn't apply: each chunk is queried with the hierarchy saved in its file.
+
+namespace game {
+class ExampleWorld : public Example {
+public:
+	static const WorldSpec WORLD;
+	static const ctp::gFloat MOVER_RADIUS;
+	static const ctp::gFloat LOAD_MARGIN;     // How far past the edge of the screen chunks are loaded.
+	static const MS LOOKAHEAD;                // Chunks are loaded around where the mover will be this far ahead, as well as where it is.
+	static const std::size_t MEMORY_BUDGET;   // Bytes. Chunks in view are kept even when they take more.
+	static const MS TIMING_REPORT_INTERVAL;
+
+	ExampleWorld();
+	~ExampleWorld() = default;
+	virtual void update(const Input& input, const MS elapsedTime);
+	virtual void capture(ExampleSnapshot& out);
+	virtual void reset();
+
+private:
+	struct Resident {
+		ChunkCoord coord;
+		std::size_t bytes;
+		std::shared_ptr<const ExampleSnapshot::ObstacleChunk> obstacles;
+	};
+
+	ChunkStreamer streamer_;
+	ChunkedCollisionMap map_;
+	std::vector<Resident> resident_;
+	std::size_t resident_bytes_{0};
+
+	Mover mover_;
+	std::shared_ptr<const ctp::ShapeContainer> mover_shape_; // Shared with snapshots.
+	ctp::Coord2 velocity_; // Over the last step.
+
+	// Buffers reused every step.
+	std::vector<ChunkStreamer::LoadedChunk> loaded_;
+	std::vector<ChunkCoord> needed_;
+	std::vector<ChunkCoord> wanted_;
+	std::vector<ChunkCoord> requests_;
+
+	// Streaming stats, reported once a second.
+	MS timing_elapsed_{0};
+	std::size_t loads_{0};
+	std::size_t generated_{0};
+	std::size_t evictions_{0};
+	std::size_t waits_{0};
+	double load_millis_{0};
+	double wait_millis_{0};
+
+	void _init();
+	void _stream(const MS elapsedTime);
+	void _make_resident(ChunkStreamer::LoadedChunk&& chunk);
+	void _evict();
+	void _report(const MS elapsedTime);
+};
+}
+
+#endif // INCLUDE_GAME_EXAMPLE_WORLD_HPP
@@ -0,0 +1,128 @@
+#include "GridCollisionMap.hpp"
+
+#include <algorithm>
+
+namespace game {
+const ctp::gFloat GridCollisionMap::DEFAULT_CELL_SIZE = 128.0f;
+
+GridCollisionMap::GridCollisionMap(ctp::gFloat cellSize) : cell_size_(cellSize), visit_stamp_(0) {}
+GridCollisionMap::~GridCollisionMap() {
+	clear();
+}
+
+const std::vector<ctp::Collidable*> GridCollisionMap::getColliding(const ctp::Collidable& collidable, ctp::Coord2 delta) const {
+	++stats_.queries;
+	std::vector<ctp::Collidable*> colliding;
+	const ctp::Rect swept(sweepBounds(getQueryBounds(collidable), delta));
+	if (obstacles.empty() || !boundsOverlap(swept, total_bounds_))
+		return colliding;
+	// Only look at cells that are both swept over and occupied.
+	const std::int32_t minX(_to_cell(std::max(swept.x, total_bounds_.x)));
+	const std::int32_t minY(_to_cell(std::max(swept.y, total_bounds_.y)));
+	const std::int32_t maxX(_to_cell(std::min(swept.x + swept.w, total_bounds_.x + total_bounds_.w)));
+	const std::int32_t maxY(_to_cell(std::min(swept.y + swept.h, total_bounds_.y + total_bounds_.h)));
+	_new_visit();
+	for (std::int32_t x = minX; x <= maxX; ++x) {
+		for (std::int32_t y = minY; y <= maxY; ++y) {
+			const auto cell(cells_.find(_key(x, y)));
+			if (cell == cells_.end())
+				continue;
+			for (std::size_t index : cell->second) {
+				if (_visit(index) && _keep_candidate(bounds_[index], swept))
+					obstacles[index]->collect(swept, colliding);
+			}
+		}
+	}
+	return colliding;
+}
+
+void GridCollisionMap::add(PreparedWall* collidable) {
+	const std::size_t index(obstacles.size());
+	const ctp::Rect bounds(collidable->getBounds());
+	obstacles.push_back(collidable);
+	bounds_.push_back(bounds);
+	visited_.push_back(0);
+	total_bounds_ = index == 0 ? bounds : combineBounds(total_bounds_, bounds);
+	_insert_cells(index, bounds);
+}
+PreparedWall* GridCollisionMap::operator[](std::size_t index) const {
+	return obstacles[index];
+}
+std::size_t GridCollisionMap::size() const {
+	return obstacles.size();
+}
+void GridCollisionMap::refit(std::size_t index, const ctp::Coord2&) {
+	const ctp::Rect bounds(obstacles[index]->getBounds());
+	_remove_cells(index, bounds_[index]);
+	_insert_cells(index, bounds);
+	bounds_[index] = bounds;
+	total_bounds_ = combineBounds(total_bounds_, bounds);
+}
+bool GridCollisionMap::findCloserHit(const ctp::Ray& ray, RayHit& inout_hit) const {
+	ctp::gFloat testNear, testFar;
+	ctp::Coord2 testNormNear, testNormFar;
+	bool found(false);
+	// Once the closest hit is inside the current cell, no later cell can hold a closer one.
+	walkRay(ray, [&](const std::vector<std::size_t>& cell, ctp::gFloat cellExit) {
+		for (std::size_t i : cell) {
+			if (obstacles[i]->intersects(ray, testNear, testNormNear, testFar, testNormFar) && testNear < inout_hit.near) {
+				inout_hit = RayHit{i, testNear, testFar, testNormNear, testNormFar};
+				found = true;
+				if (testNear == 0.0f)
+					return true;
+			}
+		}
+		return inout_hit.near <= cellExit;
+	});
+	return found;
+}
+void GridCollisionMap::clear() {
+	for (std::size_t i = 0; i < obstacles.size(); ++i)
+		delete obstacles[i];
+	obstacles.clear();
+	cells_.clear();
+	bounds_.clear();
+	visited_.clear();
+	visit_stamp_ = 0;
+}
+
+std::int32_t GridCollisionMap::_to_cell(ctp::gFloat coord) const {
+	return static_cast<std::int32_t>(std::floor(coord / cell_size_));
+}
+GridCollisionMap::CellKey GridCollisionMap::_key(std::int32_t x, std::int32_t y) {
+	return (static_cast<CellKey>(static_cast<std::uint32_t>(x)) << 32) | static_cast<std::uint32_t>(y);
+}
+void GridCollisionMap::_new_visit() const {
+	if (++visit_stamp_ == 0) { // Wrapped around: old marks could be mistaken for this query's.
+		std::fill(visited_.begin(), visited_.end(), 0);
+		visit_stamp_ = 1;
+	}
+}
+bool GridCollisionMap::_visit(std::size_t index) const {
+	if (visited_[index] == visit_stamp_)
+		return false;
+	visited_[index] = visit_stamp_;
+	return true;
+}
+void GridCollisionMap::_insert_cells(std::size_t index, const ctp::Rect& bounds) {
+	const std::int32_t maxX(_to_cell(bounds.x + bounds.w)), maxY(_to_cell(bounds.y + bounds.h));
+	for (std::int32_t x = _to_cell(bounds.x); x <= maxX; ++x) {
+		for (std::int32_t y = _to_cell(bounds.y); y <= maxY; ++y)
+			cells_[_key(x, y)].push_back(index);
+	}
+}
+void GridCollisionMap::_remove_cells(std::size_t index, const ctp::Rect& bounds) {
+	const std::int32_t maxX(_to_cell(bounds.x + bounds.w)), maxY(_to_cell(bounds.y + bounds.h));
+	for (std::int32_t x = _to_cell(bounds.x); x <= maxX; ++x) {
+		for (std::int32_t y = _to_cell(bounds.y); y <= maxY; ++y) {
+			const auto cell(cells_.find(_key(x, y)));
+			if (cell == cells_.end())
+				continue;
+			std::vector<std::size_t>& indices(cell->second);
+			indices.erase(std::remove(indices.begin(), indices.end(), index), indices.end());
+			if (indices.empty())
+				cells_.erase(cell);
+		}
+	}
+}
+}
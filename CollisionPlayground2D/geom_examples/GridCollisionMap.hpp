@@ -0,0 +1,107 @@
+#ifndef INCLUDE_GAME_GRID_COLLISION_MAP_HPP
+#define INCLUDE_GAME_GRID_COLLISION_MAP_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include <Geometry2D/Geometry.hpp>
+
+#include "Bounds.hpp"
+#include "ObstacleMap.hpp"
+
+// Uniform grid (spatial hash) CollisionMap implementation.
+// Obstacles are bucketed into every cell their bounding box covers, so queries only look at nearby obstacles.
+
+namespace game {
+class GridCollisionMap : public ObstacleMap {
+public:
+	static const ctp::gFloat DEFAULT_CELL_SIZE;
+
+	std::vector<PreparedWall*> obstacles;
+
+	GridCollisionMap(ctp::gFloat cellSize = DEFAULT_CELL_SIZE);
+	~GridCollisionMap() override;
+
+	// Get the obstacles in the cells touched by the collidable's bounds swept along delta.
+	// With swept culling, obstacles in those cells are also checked against the swept bounds.
+	const std::vector<ctp::Collidable*> getColliding(const ctp::Collidable& collidable, ctp::Coord2 delta) const override;
+	void add(PreparedWall* collidable) override;
+	PreparedWall* operator[](std::size_t index) const override;
+	std::size_t size() const override;
+	void clear() override;
+	// Move the obstacle to the cells covered by its new bounds.
+	void refit(std::size_t index, const ctp::Coord2& displacement) override;
+	// Walks the grid along the ray, stopping at the first cell that contains the closest hit.
+	bool findCloserHit(const ctp::Ray& ray, RayHit& inout_hit) const override;
+
+	// Walk the cells a ray passes through in order (DDA), front to back.
+	// visitCell(indices, cellExitDist) is called for each occupied cell with the indices of obstacles not seen earlier in the walk,
+	// and the distance along the ray at which it leaves the cell. Return true from visitCell to stop the walk.
+	template<typename CellVisitor>
+	void walkRay(const ctp::Ray& ray, CellVisitor&& visitCell) const;
+
+private:
+	using CellKey = std::uint64_t;
+
+	ctp::gFloat cell_size_;
+	std::unordered_map<CellKey, std::vector<std::size_t>> cells_;
+	std::vector<ctp::Rect> bounds_; // Bounding box of each obstacle.
+	ctp::Rect total_bounds_;        // Bounding box of all obstacles.
+
+	// Per-query bookkeeping so obstacles spanning several cells are only returned once.
+	mutable std::vector<std::uint32_t> visited_;
+	mutable std::uint32_t visit_stamp_;
+	mutable std::vector<std::size_t> walk_cell_;
+
+	std::int32_t _to_cell(ctp::gFloat coord) const;
+	static CellKey _key(std::int32_t x, std::int32_t y);
+	void _new_visit() const;
+	bool _visit(std::size_t index) const; // Returns false if the obstacle was already visited this query.
+	void _insert_cells(std::size_t index, const ctp::Rect& bounds);
+	void _remove_cells(std::size_t index, const ctp::Rect& bounds);
+};
+
+template<typename CellVisitor>
+void GridCollisionMap::walkRay(const ctp::Ray& ray, CellVisitor&& visitCell) const {
+	ctp::gFloat enter, exit;
+	if (obstacles.empty() || !clipRay(ray, total_bounds_, enter, exit))
+		return;
+	const ctp::Coord2 start(ray.origin + ray.dir * enter);
+	std::int32_t x(_to_cell(start.x)), y(_to_cell(start.y));
+	const std::int32_t stepX(ray.dir.x > 0 ? 1 : -1), stepY(ray.dir.y > 0 ? 1 : -1);
+	// Distance along the ray to cross one cell, and to reach the next cell boundary, on each axis.
+	const ctp::gFloat inf(std::numeric_limits<ctp::gFloat>::infinity());
+	const ctp::gFloat deltaX(ray.dir.x == 0 ? inf : cell_size_ / std::abs(ray.dir.x));
+	const ctp::gFloat deltaY(ray.dir.y == 0 ? inf : cell_size_ / std::abs(ray.dir.y));
+	ctp::gFloat nextX(ray.dir.x == 0 ? inf : ((x + (stepX > 0 ? 1 : 0)) * cell_size_ - ray.origin.x) / ray.dir.x);
+	ctp::gFloat nextY(ray.dir.y == 0 ? inf : ((y + (stepY > 0 ? 1 : 0)) * cell_size_ - ray.origin.y) / ray.dir.y);
+	_new_visit();
+	for (;;) {
+		const ctp::gFloat cellExit(std::min(nextX, nextY));
+		const auto cell(cells_.find(_key(x, y)));
+		if (cell != cells_.end()) {
+			walk_cell_.clear();
+			for (std::size_t index : cell->second) {
+				if (_visit(index))
+					walk_cell_.push_back(index);
+			}
+			if (!walk_cell_.empty() && visitCell(walk_cell_, cellExit))
+				return;
+		}
+		if (cellExit >= exit)
+			return;
+		if (nextX < nextY) {
+			x += stepX;
+			nextX += deltaX;
+		} else {
+			y += stepY;
+			nextY += deltaY;
+		}
+	}
+}
+}
+
+#endif // INCLUDE_GAME_GRID_COLLISION_MAP_HPP
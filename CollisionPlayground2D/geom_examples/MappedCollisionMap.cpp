@@ -0,0 +1,171 @@
+#include "MappedCollisionMap.hpp"
+
+#include <iostream>
+
+#include "BVHCollisionMap.hpp"
+
+namespace game {
+namespace {
+ctp::Rect nodeBounds(const SceneNode& node) {
+	return ctp::Rect(node.bounds[0], node.bounds[1], node.bounds[2], node.bounds[3]);
+}
+}
+
+MappedCollisionMap::~MappedCollisionMap() {
+	clear();
+}
+
+bool MappedCollisionMap::load(const std::string& path) {
+	clear();
+	if (!scene_.open(path))
+		return false;
+	scene_size_ = scene_.shapeCount();
+	walls_.assign(scene_size_, nullptr);
+	if (scene_.hasHierarchy()) {
+		nodes_ = scene_.nodes();
+		order_ = scene_.order();
+	} else {
+		_build_hierarchy();
+	}
+	return true;
+}
+
+const std::vector<ctp::Collidable*> MappedCollisionMap::getColliding(const ctp::Collidable& collidable, ctp::Coord2 delta) const {
+	++stats_.queries;
+	std::vector<ctp::Collidable*> colliding;
+	const ctp::Rect swept(sweepBounds(getQueryBounds(collidable), delta));
+	if (nodes_) {
+		query_stack_.clear();
+		query_stack_.push_back(0);
+		while (!query_stack_.empty()) {
+			const std::uint32_t index(query_stack_.back());
+			const SceneNode& node(nodes_[index]);
+			query_stack_.pop_back();
+			if (!boundsOverlap(nodeBounds(node), swept))
+				continue;
+			if (node.count == 0) {
+				query_stack_.push_back(index + 1);
+				query_stack_.push_back(node.first);
+				continue;
+			}
+			for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+				if (_keep_candidate(scene_.getBounds(order_[i]), swept))
+					_get_wall(order_[i])->collect(swept, colliding);
+			}
+		}
+	}
+	for (std::size_t i = 0; i < added_.size(); ++i) {
+		if (_keep_candidate(added_bounds_[i], swept))
+			added_[i]->collect(swept, colliding);
+	}
+	return colliding;
+}
+
+void MappedCollisionMap::add(PreparedWall* collidable) {
+	added_.push_back(collidable);
+	added_bounds_.push_back(collidable->getBounds());
+}
+PreparedWall* MappedCollisionMap::operator[](std::size_t index) const {
+	return index < scene_size_ ? _get_wall(index) : added_[index - scene_size_];
+}
+std::size_t MappedCollisionMap::size() const {
+	return scene_size_ + added_.size();
+}
+void MappedCollisionMap::clear() {
+	for (std::size_t i = 0; i < walls_.size(); ++i)
+		delete walls_[i];
+	for (std::size_t i = 0; i < added_.size(); ++i)
+		delete added_[i];
+	walls_.clear();
+	added_.clear();
+	added_bounds_.clear();
+	built_nodes_.clear();
+	built_order_.clear();
+	nodes_ = nullptr;
+	order_ = nullptr;
+	scene_size_ = 0;
+	scene_.close();
+}
+void MappedCollisionMap::refit(std::size_t index, const ctp::Coord2&) {
+	if (index < scene_size_) {
+		std::cerr << "Error: Obstacles in a mapped scene can't move.\n";
+		return;
+	}
+	added_bounds_[index - scene_size_] = added_[index - scene_size_]->getBounds();
+}
+
+bool MappedCollisionMap::findCloserHit(const ctp::Ray& ray, RayHit& inout_hit) const {
+	ctp::gFloat testNear, testFar, enter, exit;
+	ctp::Coord2 testNormNear, testNormFar;
+	bool found(false);
+	const auto test = [&](std::size_t index, const PreparedWall& obstacle) {
+		if (obstacle.intersects(ray, testNear, testNormNear, testFar, testNormFar) && testNear < inout_hit.near) {
+			inout_hit = RayHit{index, testNear, testFar, testNormNear, testNormFar};
+			found = true;
+		}
+	};
+	for (std::size_t i = 0; i < added_.size(); ++i) {
+		if (clipRay(ray, added_bounds_[i], enter, exit) && enter <= inout_hit.near)
+			test(scene_size_ + i, *added_[i]);
+	}
+	if (!nodes_ || !clipRay(ray, nodeBounds(nodes_[0]), enter, exit))
+		return found;
+	// Visit nodes front to back, skipping any that start further away than the closest hit so far.
+	ray_stack_.clear();
+	ray_stack_.emplace_back(0, enter);
+	while (!ray_stack_.empty() && inout_hit.near != 0.0f) {
+		const auto [index, nodeEnter] = ray_stack_.back();
+		ray_stack_.pop_back();
+		if (nodeEnter > inout_hit.near)
+			continue;
+		const SceneNode& node(nodes_[index]);
+		if (node.count > 0) {
+			for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+				const std::uint32_t obs(order_[i]);
+				if (clipRay(ray, scene_.getBounds(obs), enter, exit) && enter <= inout_hit.near)
+					test(obs, *_get_wall(obs));
+			}
+			continue;
+		}
+		const std::uint32_t left(index + 1), right(node.first);
+		ctp::gFloat leftEnter, rightEnter;
+		const bool hitLeft(clipRay(ray, nodeBounds(nodes_[left]), leftEnter, exit));
+		const bool hitRight(clipRay(ray, nodeBounds(nodes_[right]), rightEnter, exit));
+		if (hitLeft && hitRight) {
+			if (leftEnter < rightEnter) {
+				ray_stack_.emplace_back(right, rightEnter);
+				ray_stack_.emplace_back(left, leftEnter);
+			} else {
+				ray_stack_.emplace_back(left, leftEnter);
+				ray_stack_.emplace_back(right, rightEnter);
+			}
+		} else if (hitLeft) {
+			ray_stack_.emplace_back(left, leftEnter);
+		} else if (hitRight) {
+			ray_stack_.emplace_back(right, rightEnter);
+		}
+	}
+	return found;
+}
+
+PreparedWall* MappedCollisionMap::_get_wall(std::size_t index) const {
+	if (!walls_[index])
+		walls_[index] = new PreparedWall(scene_.makeShape(index), scene_.getPosition(index));
+	return walls_[index];
+}
+void MappedCollisionMap::_build_hierarchy() {
+	if (scene_size_ == 0)
+		return;
+	std::vector<ctp::Rect> bounds(scene_size_);
+	for (std::size_t i = 0; i < scene_size_; ++i)
+		bounds[i] = scene_.getBounds(i);
+	std::vector<BVHCollisionMap::Node> nodes;
+	std::vector<std::uint32_t> parents;
+	BVHCollisionMap::buildHierarchy(bounds, nodes, built_order_, parents);
+	built_nodes_.resize(nodes.size());
+	for (std::size_t i = 0; i < nodes.size(); ++i)
+		built_nodes_[i] = SceneNode{{nodes[i].bounds.x, nodes[i].bounds.y, nodes[i].bounds.w, nodes[i].bounds.h}, nodes[i].first, nodes[i].count};
+	nodes_ = built_nodes_.data();
+	order_ = built_order_.data();
+}
+}
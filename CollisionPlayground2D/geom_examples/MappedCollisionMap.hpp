@@ -0,0 +1,58 @@
+#ifndef INCLUDE_GAME_MAPPED_COLLISION_MAP_HPP
+#define INCLUDE_GAME_MAPPED_COLLISION_MAP_HPP
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Geometry2D/Geometry.hpp>
+
+#include "ObstacleMap.hpp"
+#include "SceneFile.hpp"
+
+// CollisionMap that queries a memory mapped scene file in place, using the hierarchy saved with it.
+// Loading only maps and checks the file: an obstacle's PreparedWall is made the first time a query needs it.
+// Scene obstacles are static. Obstacles added afterwards are kept in memory and tested one by one.
+
+namespace game {
+class MappedCollisionMap : public ObstacleMap {
+public:
+	MappedCollisionMap() = default;
+	~MappedCollisionMap() override;
+
+	// Map a scene file, replacing any obstacles. A hierarchy is built in memory if the file doesn't have one.
+	bool load(const std::string& path);
+	const SceneFile& getScene() const { return scene_; }
+
+	const std::vector<ctp::Collidable*> getColliding(const ctp::Collidable& collidable, ctp::Coord2 delta) const override;
+	// Added obstacles come after the scene's.
+	void add(PreparedWall* collidable) override;
+	PreparedWall* operator[](std::size_t index) const override;
+	std::size_t size() const override;
+	void clear() override;
+	// Only added obstacles can move.
+	void refit(std::size_t index, const ctp::Coord2& displacement) override;
+	bool findCloserHit(const ctp::Ray& ray, RayHit& inout_hit) const override;
+
+private:
+	SceneFile scene_;
+	std::size_t scene_size_{0};
+	const SceneNode* nodes_{nullptr};
+	const std::uint32_t* order_{nullptr};
+	std::vector<SceneNode> built_nodes_; // Used when the file has no hierarchy.
+	std::vector<std::uint32_t> built_order_;
+
+	mutable std::vector<PreparedWall*> walls_; // Made on first use.
+	std::vector<PreparedWall*> added_;
+	std::vector<ctp::Rect> added_bounds_;
+
+	mutable std::vector<std::uint32_t> query_stack_;
+	mutable std::vector<std::pair<std::uint32_t, ctp::gFloat>> ray_stack_; // Nodes with the distance the ray enters them.
+
+	PreparedWall* _get_wall(std::size_t index) const;
+	void _build_hierarchy();
+};
+}
+
+#endif // INCLUDE_GAME_MAPPED_COLLISION_MAP_HPP
@@ -3,14 +3,30 @@
 #include "../Input.hpp"
 
 namespace game {
+namespace {
+// Passes a mover's prepared data along with each of its movement queries.
+class PreparedQueryMap : public ctp::CollisionMap {
+public:
+	PreparedQueryMap(const ctp::CollisionMap& map, const PreparedShape& prepared) : map_(map), prepared_(prepared) {}
+
+	const std::vector<ctp::Collidable*> getColliding(const ctp::Collidable& collidable, ctp::Coord2 delta) const override {
+		return map_.getColliding(PreparedCollidable(collidable, prepared_), delta);
+	}
+
+private:
+	const ctp::CollisionMap& map_;
+	const PreparedShape& prepared_;
+};
+}
+
 const game::Velocity     Mover::MAX_SPEED = 0.35f;
 const game::Velocity     Mover::MAX_DIAGONAL_SPEED = Mover::MAX_SPEED * (game::Velocity)std::sin(ctp::constants::PI / 4.0f);
 const game::Acceleration Mover::ACCELERATION = 0.0025f;
 const game::Acceleration Mover::DECELERATION = 0.004f;
 
 void Mover::_init() {
-	if (collider_.type() == ctp::ShapeType::POLYGON)
-		collider_.poly().computeNormals();
+	computeNormals(collider_);
+	prepared_ = prepareShape(collider_);
 }
 
 Mover::Mover(ctp::Movable::CollisionType type, const ctp::ShapeContainer& collider, const ctp::Coord2& position) : Movable(type), collider_(collider), position_(position) {
@@ -40,7 +56,7 @@ void Mover::_update_position(const game::MS elapsedTime, const game::Velocity ma
 		velocity_.y = isPos ? (velocity_.y < 0 ? 0.0f : velocity_.y) : (velocity_.y > 0 ? 0.0f : velocity_.y);
 	}
 	const ctp::Coord2 delta(velocity_ * (ctp::gFloat)(elapsedTime));
-	position_ = Movable::move(collider_, position_, delta, map);
+	position_ = Movable::move(collider_, position_, delta, PreparedQueryMap(map, prepared_));
 }
 
 bool Mover::onCollision(ctp::Movable::CollisionInfo& info) {
@@ -91,4 +107,5 @@ void Mover::moveDown() { acceleration_.y = ACCELERATION; }
 void Mover::stopMovingHorizontal() { acceleration_.x = 0.0f; }
 void Mover::stopMovingVertical() { acceleration_.y = 0.0f; }
 void Mover::stopMoving() { acceleration_ = game::Acceleration2D(0, 0); }
+void Mover::halt() { velocity_ = game::Velocity2D(0, 0); }
 }
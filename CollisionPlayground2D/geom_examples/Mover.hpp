@@ -6,6 +6,8 @@
 
 #include <Geometry2D/Geometry.hpp>
 
+#include "PreparedShape.hpp"
+
 namespace geom { class CollisionMap; }
 class Input;
 
@@ -27,6 +29,8 @@ public:
 
 	ctp::Coord2 getPosition() const;
 	ctp::ConstShapeRef getCollider() const;
+	const PreparedShape& getPrepared() const { return prepared_; }
+	ctp::Rect getBounds() const { return prepared_.getBounds(position_); }
 
 	void receiveInput(const Input& input);
 
@@ -37,10 +41,13 @@ public:
 	void stopMovingHorizontal();
 	void stopMovingVertical();
 	void stopMoving();
+	// Lose all speed at once.
+	void halt();
 protected:
 	virtual bool onCollision(ctp::Movable::CollisionInfo& info);
 private:
 	ctp::ShapeContainer collider_{ctp::Rect{}};
+	PreparedShape prepared_;
 	ctp::Coord2 position_;
 
 	game::Acceleration2D acceleration_;
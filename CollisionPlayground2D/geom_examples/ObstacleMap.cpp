@@ -0,0 +1,85 @@
+#include "ObstacleMap.hpp"
+
+#include <iostream>
+#include <limits>
+
+#include "AABBTreeCollisionMap.hpp"
+#include "BVHCollisionMap.hpp"
+#include "GridCollisionMap.hpp"
+#include "PoolCollisionMap.hpp"
+#include "SimpleCollisionMap.hpp"
+
+namespace game {
+void ObstacleMap::addWall(const ctp::ShapeContainer& shape, const ctp::Coord2& position) {
+	add(new PreparedWall(shape, position));
+}
+bool ObstacleMap::findClosestHit(const ctp::Ray& ray,
+	std::size_t& out_ind, ctp::gFloat& out_near, ctp::Coord2& out_norm_near, ctp::gFloat& out_far, ctp::Coord2& out_norm_far) const {
+	RayHit hit{0, std::numeric_limits<ctp::gFloat>::max(), 0, ctp::Coord2(0, 0), ctp::Coord2(0, 0)};
+	if (!findCloserHit(ray, hit))
+		return false;
+	out_ind = hit.index;
+	out_near = hit.near;
+	out_norm_near = hit.normNear;
+	out_far = hit.far;
+	out_norm_far = hit.normFar;
+	return true;
+}
+bool ObstacleMap::findCloserHit(const ctp::Ray& ray, RayHit& inout_hit) const {
+	ctp::gFloat testNear, testFar, enter, exit;
+	ctp::Coord2 testNormNear, testNormFar;
+	bool found(false);
+	const ObstacleMap& map(*this);
+	for (std::size_t i = 0; i < map.size(); ++i) {
+		if (!clipRay(ray, map[i]->getBounds(), enter, exit) || enter > inout_hit.near)
+			continue;
+		if (map[i]->intersects(ray, testNear, testNormNear, testFar, testNormFar) && testNear < inout_hit.near) {
+			inout_hit = RayHit{i, testNear, testFar, testNormNear, testNormFar};
+			found = true;
+			if (testNear == 0.0f)
+				return true;
+		}
+	}
+	return found;
+}
+void ObstacleMap::findHits(const ctp::Ray& ray, std::vector<RayHit>& out_hits) const {
+	RayHit hit;
+	ctp::gFloat enter, exit;
+	const ObstacleMap& map(*this);
+	for (std::size_t i = 0; i < map.size(); ++i) {
+		if (clipRay(ray, map[i]->getBounds(), enter, exit) && map[i]->intersects(ray, hit.near, hit.normNear, hit.far, hit.normFar)) {
+			hit.index = i;
+			out_hits.push_back(hit);
+		}
+	}
+}
+void ObstacleMap::findClosestHits(const std::vector<ctp::Ray>& rays, std::size_t,
+	std::vector<ctp::gFloat>& out_dists, std::vector<std::size_t>& out_inds) const {
+	out_dists.assign(rays.size(), -1);
+	out_inds.assign(rays.size(), 0);
+	ctp::gFloat far;
+	ctp::Coord2 normNear, normFar;
+	for (std::size_t i = 0; i < rays.size(); ++i) {
+		if (!findClosestHit(rays[i], out_inds[i], out_dists[i], normNear, far, normFar))
+			out_dists[i] = -1;
+	}
+}
+
+std::unique_ptr<ObstacleMap> makeObstacleMap(Broadphase broadphase) {
+	switch (broadphase) {
+	case Broadphase::SIMPLE:
+		return std::make_unique<SimpleCollisionMap>();
+	case Broadphase::GRID:
+		return std::make_unique<GridCollisionMap>();
+	case Broadphase::TREE:
+		return std::make_unique<AABBTreeCollisionMap>();
+	case Broadphase::BVH:
+		return std::make_unique<BVHCollisionMap>();
+	case Broadphase::POOL:
+		return std::make_unique<PoolCollisionMap>();
+	default:
+		std::cerr << "Unhandled broadphase type.\n";
+		return std::make_unique<SimpleCollisionMap>();
+	}
+}
+}
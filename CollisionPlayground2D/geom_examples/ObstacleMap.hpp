@@ -0,0 +1,87 @@
+#ifndef INCLUDE_GAME_OBSTACLE_MAP_HPP
+#define INCLUDE_GAME_OBSTACLE_MAP_HPP
+
+#include <memory>
+#include <vector>
+
+#include <Geometry2D/Geometry.hpp>
+
+#include "Bounds.hpp"
+#include "PreparedShape.hpp"
+#include "ShapeBatch.hpp"
+
+// Interface for the CollisionMaps used by the examples: they own a list of obstacles that can be indexed,
+// and can answer ray queries as well as movement queries.
+
+namespace game {
+// Available CollisionMap implementations.
+enum class Broadphase {
+	SIMPLE, // No speedup: every obstacle is tested.
+	GRID,   // Uniform grid.
+	TREE,   // Dynamic bounding volume tree.
+	BVH,    // Static bounding volume hierarchy.
+	POOL,   // Every obstacle is tested, from structure of arrays storage.
+};
+
+class ObstacleMap : public ctp::CollisionMap {
+public:
+	struct QueryStats {
+		std::size_t queries{0};    // Calls to getColliding.
+		std::size_t candidates{0}; // Obstacles the broadphase looked at.
+		std::size_t returned{0};   // Obstacles passed on to the narrowphase.
+	};
+
+	~ObstacleMap() override {}
+
+	// Add an obstacle. The map takes ownership of it, and reads its bounds from its prepared data.
+	virtual void add(PreparedWall* collidable) = 0;
+	// Add a static obstacle. By default, adds a new PreparedWall.
+	virtual void addWall(const ctp::ShapeContainer& shape, const ctp::Coord2& position);
+	virtual PreparedWall* operator[](std::size_t index) const = 0;
+	virtual std::size_t size() const = 0;
+	// Remove and delete all obstacles.
+	virtual void clear() = 0;
+	// Update the map after the obstacle at index has moved by displacement, or had its shape changed.
+	virtual void refit(std::size_t index, const ctp::Coord2& displacement) = 0;
+	// Find the closest obstacle hit by a ray, and the distances and normals where the ray enters and exits it.
+	// Returns false if nothing is hit.
+	bool findClosestHit(const ctp::Ray& ray,
+		std::size_t& out_ind, ctp::gFloat& out_near, ctp::Coord2& out_norm_near, ctp::gFloat& out_far, ctp::Coord2& out_norm_far) const;
+	// Look for an obstacle the ray enters closer than inout_hit.near, and replace inout_hit with it. Returns false if there's none.
+	// A close starting hit (e.g. what the ray hit last frame) lets the map skip everything further away.
+	// By default, tests every obstacle whose bounds the ray passes through.
+	virtual bool findCloserHit(const ctp::Ray& ray, RayHit& inout_hit) const;
+	// Add every obstacle a ray hits to out_hits, in no particular order.
+	// By default, tests every obstacle whose bounds the ray passes through.
+	virtual void findHits(const ctp::Ray& ray, std::vector<RayHit>& out_hits) const;
+	// Find the closest hit of each ray, tracing them in packets of packetSize where the map supports it.
+	// out_dists gets the distance to each hit (-1 for a miss) and out_inds the obstacle hit.
+	// By default, calls findClosestHit for each ray.
+	virtual void findClosestHits(const std::vector<ctp::Ray>& rays, std::size_t packetSize,
+		std::vector<ctp::gFloat>& out_dists, std::vector<std::size_t>& out_inds) const;
+
+	// When enabled (the default), getColliding only returns obstacles whose bounds touch the collidable's bounds swept along delta.
+	// Movable::move queries again with the remaining delta after each deflection, so the swept bounds shrink as the mover slides.
+	void setSweptCulling(bool enabled) { swept_culling_ = enabled; }
+	bool isSweptCulling() const { return swept_culling_; }
+	const QueryStats& getQueryStats() const { return stats_; }
+	void resetQueryStats() { stats_ = QueryStats(); }
+
+protected:
+	bool swept_culling_{true};
+	mutable QueryStats stats_;
+
+	// Check an obstacle's bounds against a query's swept bounds, recording it in the stats.
+	bool _keep_candidate(const ctp::Rect& obstacleBounds, const ctp::Rect& sweptBounds) const {
+		++stats_.candidates;
+		if (swept_culling_ && !boundsOverlap(obstacleBounds, sweptBounds))
+			return false;
+		++stats_.returned;
+		return true;
+	}
+};
+
+std::unique_ptr<ObstacleMap> makeObstacleMap(Broadphase broadphase);
+}
+
+#endif // INCLUDE_GAME_OBSTACLE_MAP_HPP
@@ -0,0 +1,126 @@
+#include "ObstaclePool.hpp"
+
+#include <new>
+
+#include "ShapeUtil.hpp"
+
+namespace game {
+const ObstacleHandle ObstaclePool::NULL_HANDLE{~0u, ~0u};
+
+ObstaclePool::~ObstaclePool() {
+	reset();
+}
+
+ObstacleHandle ObstaclePool::add(ctp::ConstShapeRef shape, const ctp::Coord2& position) {
+	const std::uint32_t index(static_cast<std::uint32_t>(walls_.size()));
+	std::uint32_t slot;
+	if (free_slots_.empty()) {
+		slot = static_cast<std::uint32_t>(slots_.size());
+		slots_.push_back(Slot{index, 0});
+	} else {
+		slot = free_slots_.back();
+		free_slots_.pop_back();
+		slots_[slot].index = index;
+	}
+	pos_x_.push_back(position.x);
+	pos_y_.push_back(position.y);
+	min_x_.emplace_back();
+	min_y_.emplace_back();
+	max_x_.emplace_back();
+	max_y_.emplace_back();
+	PooledWall* storage;
+	if (free_walls_.empty()) {
+		storage = arena_.allocate<PooledWall>();
+	} else {
+		storage = free_walls_.back();
+		free_walls_.pop_back();
+	}
+	walls_.push_back(new (storage) PooledWall(copyShape(shape), position));
+	_set_bounds(index, walls_.back()->getBounds());
+	types_.push_back(shape.type());
+	std::array<float, 4> params{0, 0, 0, 0};
+	if (shape.type() == ctp::ShapeType::RECTANGLE) {
+		const ctp::Rect& r(shape.rect());
+		params = {r.x, r.y, r.w, r.h};
+	} else if (shape.type() == ctp::ShapeType::CIRCLE) {
+		const ctp::Circle& c(shape.circle());
+		params = {c.center.x, c.center.y, c.radius, 0};
+	}
+	params_.push_back(params);
+	slot_of_.push_back(slot);
+	return ObstacleHandle{slot, slots_[slot].generation};
+}
+
+bool ObstaclePool::remove(ObstacleHandle handle) {
+	if (!isValid(handle))
+		return false;
+	const std::size_t index(indexOf(handle));
+	walls_[index]->~PooledWall();
+	free_walls_.push_back(walls_[index]);
+	if (index + 1 < walls_.size())
+		slots_[slot_of_.back()].index = static_cast<std::uint32_t>(index);
+	_move_last(pos_x_, index);
+	_move_last(pos_y_, index);
+	_move_last(min_x_, index);
+	_move_last(min_y_, index);
+	_move_last(max_x_, index);
+	_move_last(max_y_, index);
+	_move_last(types_, index);
+	_move_last(params_, index);
+	_move_last(walls_, index);
+	_move_last(slot_of_, index);
+	++slots_[handle.slot].generation;
+	free_slots_.push_back(handle.slot);
+	return true;
+}
+
+void ObstaclePool::reset() {
+	for (PooledWall* wall : walls_)
+		wall->~PooledWall();
+	free_walls_.clear();
+	arena_.rewind();
+	// Every slot is freed, and its generation bumped so old handles go stale.
+	free_slots_.clear();
+	for (std::uint32_t slot = static_cast<std::uint32_t>(slots_.size()); slot-- > 0;) {
+		++slots_[slot].generation;
+		free_slots_.push_back(slot);
+	}
+	pos_x_.clear();
+	pos_y_.clear();
+	min_x_.clear();
+	min_y_.clear();
+	max_x_.clear();
+	max_y_.clear();
+	types_.clear();
+	params_.clear();
+	walls_.clear();
+	slot_of_.clear();
+}
+
+bool ObstaclePool::isValid(ObstacleHandle handle) const {
+	return handle.slot < slots_.size() && slots_[handle.slot].generation == handle.generation
+		&& slots_[handle.slot].index < walls_.size() && slot_of_[slots_[handle.slot].index] == handle.slot;
+}
+
+void ObstaclePool::translate(std::size_t index, const ctp::Coord2& displacement) {
+	pos_x_[index] += displacement.x;
+	pos_y_[index] += displacement.y;
+	min_x_[index] += displacement.x;
+	min_y_[index] += displacement.y;
+	max_x_[index] += displacement.x;
+	max_y_[index] += displacement.y;
+	walls_[index]->setPosition(position(index));
+}
+
+void ObstaclePool::_set_bounds(std::size_t index, const ctp::Rect& bounds) {
+	min_x_[index] = bounds.x;
+	min_y_[index] = bounds.y;
+	max_x_[index] = bounds.x + bounds.w;
+	max_y_[index] = bounds.y + bounds.h;
+}
+template<typename T>
+void ObstaclePool::_move_last(std::vector<T>& column, std::size_t index) {
+	column[index] = column.back();
+	column.pop_back();
+}
+}
@@ -0,0 +1,100 @@
+#ifndef INCLUDE_GAME_OBSTACLE_POOL_HPP
+#define INCLUDE_GAME_OBSTACLE_POOL_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <Geometry2D/Geometry.hpp>
+
+#include "Arena.hpp"
+#include "PreparedShape.hpp"
+
+// Obstacle storage laid out as a structure of arrays, so scanning positions, bounds or shape types touches contiguous memory.
+// Obstacles are referred to by generational handles, which stay valid while other obstacles are added and removed,
+// and are recognised as stale once their obstacle is gone.
+// Each obstacle's ctp::Collidable view is placed in an arena. The views still own their shape (a polygon's vertices are on the heap),
+// as ctp's narrowphase takes a shape, so reset() destroys each view before rewinding the arena.
+// A removed obstacle's view is destroyed straight away, and its place in the arena is reused by the next obstacle added.
+
+namespace game {
+struct ObstacleHandle {
+	std::uint32_t slot;
+	std::uint32_t generation;
+
+	bool operator==(const ObstacleHandle& o) const { return slot == o.slot && generation == o.generation; }
+	bool operator!=(const ObstacleHandle& o) const { return !(*this == o); }
+};
+
+// The ctp::Collidable view of a pooled obstacle, for the ctp functions that take one.
+class PooledWall : public PreparedWall {
+public:
+	PooledWall(const ctp::ShapeContainer& collider, const ctp::Coord2& position) : PreparedWall(collider, position) {}
+};
+
+class ObstaclePool {
+public:
+	static const ObstacleHandle NULL_HANDLE;
+
+	ObstaclePool() = default;
+	~ObstaclePool();
+	ObstaclePool(const ObstaclePool&) = delete;
+	ObstaclePool& operator=(const ObstaclePool&) = delete;
+
+	// Copy a shape into the pool. Obstacles are indexed in the order they were added, until one is removed.
+	ObstacleHandle add(ctp::ConstShapeRef shape, const ctp::Coord2& position);
+	// Remove an obstacle. The last obstacle is moved into its index. Returns false if the handle is stale.
+	bool remove(ObstacleHandle handle);
+	// Remove every obstacle, invalidating all handles. Keeps the memory for reuse.
+	void reset();
+
+	bool isValid(ObstacleHandle handle) const;
+	// Index of a valid handle's obstacle.
+	std::size_t indexOf(ObstacleHandle handle) const { return slots_[handle.slot].index; }
+	ObstacleHandle handleAt(std::size_t index) const { return ObstacleHandle{slot_of_[index], slots_[slot_of_[index]].generation}; }
+	std::size_t size() const { return walls_.size(); }
+
+	// Move an obstacle, updating its bounds.
+	void translate(std::size_t index, const ctp::Coord2& displacement);
+
+	PooledWall* wall(std::size_t index) const { return walls_[index]; }
+	ctp::ShapeType type(std::size_t index) const { return types_[index]; }
+	ctp::Coord2 position(std::size_t index) const { return ctp::Coord2(pos_x_[index], pos_y_[index]); }
+	ctp::Rect bounds(std::size_t index) const {
+		return ctp::Rect(min_x_[index], min_y_[index], max_x_[index] - min_x_[index], max_y_[index] - min_y_[index]);
+	}
+	// Shape parameters relative to the position. Rectangles: x, y, w, h. Circles: center x, center y, radius. Polygons: none.
+	const std::array<float, 4>& params(std::size_t index) const { return params_[index]; }
+
+	// Bounds columns, for scanning many obstacles at once.
+	const float* minX() const { return min_x_.data(); }
+	const float* minY() const { return min_y_.data(); }
+	const float* maxX() const { return max_x_.data(); }
+	const float* maxY() const { return max_y_.data(); }
+
+private:
+	struct Slot {
+		std::uint32_t index;      // Index of the obstacle using the slot.
+		std::uint32_t generation; // Bumped whenever the slot's obstacle is removed.
+	};
+
+	Arena arena_;
+	std::vector<Slot> slots_;
+	std::vector<std::uint32_t> free_slots_;
+
+	// Columns, one entry per obstacle.
+	std::vector<float> pos_x_, pos_y_;
+	std::vector<float> min_x_, min_y_, max_x_, max_y_;
+	std::vector<ctp::ShapeType> types_;
+	std::vector<std::array<float, 4>> params_;
+	std::vector<PooledWall*> walls_;
+	std::vector<std::uint32_t> slot_of_;
+	std::vector<PooledWall*> free_walls_; // Arena space left by removed obstacles' views.
+
+	void _set_bounds(std::size_t index, const ctp::Rect& bounds);
+	template<typename T>
+	static void _move_last(std::vector<T>& column, std::size_t index);
+};
+}
+
+#endif // INCLUDE_GAME_OBSTACLE_POOL_HPP
@@ -0,0 +1,123 @@
+#include "PoolCollisionMap.hpp"
+
+#include "Bounds.hpp"
+
+namespace game {
+PoolCollisionMap::~PoolCollisionMap() {
+	clear();
+}
+
+const std::vector<ctp::Collidable*> PoolCollisionMap::getColliding(const ctp::Collidable& collidable, ctp::Coord2 delta) const {
+	++stats_.queries;
+	const ctp::Rect swept(sweepBounds(getQueryBounds(collidable), delta));
+	const float left(swept.x), top(swept.y), right(swept.x + swept.w), bottom(swept.y + swept.h);
+	const float* minX(pool_.minX());
+	const float* minY(pool_.minY());
+	const float* maxX(pool_.maxX());
+	const float* maxY(pool_.maxY());
+	std::vector<ctp::Collidable*> colliding;
+	for (std::size_t i = 0; i < pool_.size(); ++i) {
+		++stats_.candidates;
+		if (swept_culling_ && (minX[i] > right || maxX[i] < left || minY[i] > bottom || maxY[i] < top))
+			continue;
+		++stats_.returned;
+		_wall(i)->collect(swept, colliding);
+	}
+	return colliding;
+}
+
+void PoolCollisionMap::add(PreparedWall* collidable) {
+	pool_.add(collidable->getCollider(), collidable->getPosition());
+	originals_.push_back(collidable);
+	is_batched_ = false;
+}
+void PoolCollisionMap::addWall(const ctp::ShapeContainer& shape, const ctp::Coord2& position) {
+	pool_.add(shape, position);
+	originals_.push_back(nullptr);
+	is_batched_ = false;
+}
+PreparedWall* PoolCollisionMap::operator[](std::size_t index) const {
+	return _wall(index);
+}
+std::size_t PoolCollisionMap::size() const {
+	return pool_.size();
+}
+void PoolCollisionMap::clear() {
+	for (std::size_t i = 0; i < originals_.size(); ++i)
+		delete originals_[i];
+	originals_.clear();
+	pool_.reset();
+	is_batched_ = false;
+}
+void PoolCollisionMap::refit(std::size_t index, const ctp::Coord2& displacement) {
+	pool_.translate(index, displacement);
+	is_batched_ = false;
+}
+bool PoolCollisionMap::remove(ObstacleHandle handle) {
+	if (!pool_.isValid(handle))
+		return false;
+	const std::size_t index(pool_.indexOf(handle));
+	delete originals_[index];
+	originals_[index] = originals_.back();
+	originals_.pop_back();
+	is_batched_ = false;
+	return pool_.remove(handle);
+}
+
+PreparedWall* PoolCollisionMap::_wall(std::size_t index) const {
+	// The pool only holds a compound's bounds, so the compound itself is used.
+	return originals_[index] && originals_[index]->isCompound() ? originals_[index] : pool_.wall(index);
+}
+
+void PoolCollisionMap::_update_batch() const {
+	if (is_batched_)
+		return;
+	batch_.clear();
+	unbatched_.clear();
+	for (std::size_t i = 0; i < pool_.size(); ++i) {
+		const std::array<float, 4>& params(pool_.params(i));
+		const ctp::Coord2 position(pool_.position(i));
+		if (originals_[i] && originals_[i]->isCompound())
+			unbatched_.push_back(i);
+		else if (pool_.type(i) == ctp::ShapeType::CIRCLE)
+			batch_.addCircle(i, ctp::Coord2(params[0], params[1]) + position, params[2]);
+		else if (pool_.type(i) == ctp::ShapeType::RECTANGLE)
+			batch_.addRect(i, ctp::Rect(params[0] + position.x, params[1] + position.y, params[2], params[3]));
+		else
+			unbatched_.push_back(i);
+	}
+	is_batched_ = true;
+}
+
+bool PoolCollisionMap::findCloserHit(const ctp::Ray& ray, RayHit& inout_hit) const {
+	_update_batch();
+	ctp::gFloat testNear, testFar, enter, exit;
+	ctp::Coord2 testNormNear, testNormFar;
+	bool found(batch_.findCloserHit(ray, inout_hit));
+	if (found && inout_hit.near == 0.0f)
+		return true;
+	for (std::size_t i : unbatched_) {
+		if (!clipRay(ray, pool_.bounds(i), enter, exit) || enter > inout_hit.near)
+			continue;
+		if (_wall(i)->intersects(ray, testNear, testNormNear, testFar, testNormFar) && testNear < inout_hit.near) {
+			inout_hit = RayHit{i, testNear, testFar, testNormNear, testNormFar};
+			found = true;
+			if (testNear == 0.0f)
+				return true;
+		}
+	}
+	return found;
+}
+void PoolCollisionMap::findHits(const ctp::Ray& ray, std::vector<RayHit>& out_hits) const {
+	_update_batch();
+	batch_.findHits(ray, out_hits);
+	RayHit hit;
+	ctp::gFloat enter, exit;
+	for (std::size_t i : unbatched_) {
+		if (clipRay(ray, pool_.bounds(i), enter, exit) && _wall(i)->intersects(ray, hit.near, hit.normNear, hit.far, hit.normFar)) {
+			hit.index = i;
+			out_hits.push_back(hit);
+		}
+	}
+}
+}
@@ -0,0 +1,52 @@
+#ifndef INCLUDE_GAME_POOL_COLLISION_MAP_HPP
+#define INCLUDE_GAME_POOL_COLLISION_MAP_HPP
+
+#include <vector>
+
+#include <Geometry2D/Geometry.hpp>
+
+#include "ObstacleMap.hpp"
+#include "ObstaclePool.hpp"
+
+// CollisionMap that tests every obstacle like the simple map, but keeps them in an ObstaclePool.
+// Queries scan the pool's bounds columns, and only touch an obstacle's shape once its bounds pass.
+// Obstacles given to add are copied into the pool. The originals are kept for their owner (e.g. to drift them), and deleted on clear.
+// Compound walls are the exception: the pool only has their bounds, and queries go to the compound itself.
+// Rays are tested against the circles and rectangles in blocks of 8 with SIMD, from a ShapeBatch built on the first ray query after a change.
+
+namespace game {
+class PoolCollisionMap : public ObstacleMap {
+public:
+	PoolCollisionMap() = default;
+	~PoolCollisionMap() override;
+
+	const std::vector<ctp::Collidable*> getColliding(const ctp::Collidable& collidable, ctp::Coord2 delta) const override;
+	void add(PreparedWall* collidable) override;
+	// Copies the shape straight into the pool, without making a PreparedWall on the heap.
+	void addWall(const ctp::ShapeContainer& shape, const ctp::Coord2& position) override;
+	PreparedWall* operator[](std::size_t index) const override;
+	std::size_t size() const override;
+	void clear() override;
+	void refit(std::size_t index, const ctp::Coord2& displacement) override;
+	// Tests the batched circles and rectangles first, then skips obstacles whose bounds the ray enters beyond the closest hit so far.
+	bool findCloserHit(const ctp::Ray& ray, RayHit& inout_hit) const override;
+	void findHits(const ctp::Ray& ray, std::vector<RayHit>& out_hits) const override;
+
+	// Handles to the obstacles. Removing one moves the last obstacle into its index.
+	ObstacleHandle getHandle(std::size_t index) const { return pool_.handleAt(index); }
+	bool remove(ObstacleHandle handle);
+	const ObstaclePool& getPool() const { return pool_; }
+
+private:
+	ObstaclePool pool_;
+	std::vector<PreparedWall*> originals_; // What was given to add, in the same order as the pool. Null for addWall.
+	mutable ShapeBatch batch_;
+	mutable std::vector<std::size_t> unbatched_; // Obstacles the batch can't hold: polygons and compounds.
+	mutable bool is_batched_{false};
+
+	PreparedWall* _wall(std::size_t index) const;
+	void _update_batch() const;
+};
+}
+
+#endif // INCLUDE_GAME_POOL_COLLISION_MAP_HPP
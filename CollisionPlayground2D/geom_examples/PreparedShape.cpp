@@ -0,0 +1,103 @@
+#include "PreparedShape.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Bounds.hpp"
+#include "ShapeUtil.hpp"
+
+namespace game {
+namespace {
+// Check whether one of a shape's axes separates it from a circle.
+bool separates(const PreparedShape& shape, const ctp::Coord2& pos, const ctp::Coord2& center, ctp::gFloat radius) {
+	for (const PreparedShape::Axis& axis : shape.axes) {
+		const ctp::gFloat offset(pos.x * axis.normal.x + pos.y * axis.normal.y);
+		const ctp::gFloat c(center.x * axis.normal.x + center.y * axis.normal.y);
+		if (c + radius < axis.min + offset || c - radius > axis.max + offset)
+			return true;
+	}
+	return false;
+}
+}
+
+PreparedShape prepareShape(ctp::ConstShapeRef shape) {
+	PreparedShape prepared;
+	prepared.bounds = getBounds(shape, ctp::Coord2(0, 0));
+	prepared.circle = getBoundingCircle(shape);
+	if (shape.type() != ctp::ShapeType::POLYGON)
+		return prepared;
+	const ctp::Polygon& p(shape.poly());
+	prepared.axes.reserve(p.size());
+	for (std::size_t i = 0; i < p.size(); ++i) {
+		const ctp::Coord2 edge(p[(i + 1) % p.size()] - p[i]);
+		const ctp::gFloat length(std::sqrt(edge.x * edge.x + edge.y * edge.y));
+		if (length == 0)
+			continue;
+		PreparedShape::Axis axis{ctp::Coord2(edge.y / length, -edge.x / length), 0, 0};
+		axis.min = axis.max = p[0].x * axis.normal.x + p[0].y * axis.normal.y;
+		for (std::size_t j = 1; j < p.size(); ++j) {
+			const ctp::gFloat projected(p[j].x * axis.normal.x + p[j].y * axis.normal.y);
+			axis.min = std::min(axis.min, projected);
+			axis.max = std::max(axis.max, projected);
+		}
+		prepared.axes.push_back(axis);
+	}
+	return prepared;
+}
+
+void computeNormals(ctp::ShapeContainer& shape) {
+	if (shape.type() == ctp::ShapeType::POLYGON)
+		shape.poly().computeNormals();
+}
+
+bool mayOverlap(const PreparedShape& a, const ctp::Coord2& posA, const PreparedShape& b, const ctp::Coord2& posB) {
+	if (!boundsOverlap(a.getBounds(posA), b.getBounds(posB)))
+		return false;
+	const ctp::Coord2 centerA(a.circle.center + posA), centerB(b.circle.center + posB);
+	const ctp::Coord2 d(centerB - centerA);
+	const ctp::gFloat reach(a.circle.radius + b.circle.radius);
+	if (d.x * d.x + d.y * d.y > reach * reach)
+		return false;
+	return !separates(a, posA, centerB, b.circle.radius) && !separates(b, posB, centerA, a.circle.radius);
+}
+
+ctp::Rect getQueryBounds(const ctp::Collidable& collidable) {
+	if (const PreparedCollidable* prepared = dynamic_cast<const PreparedCollidable*>(&collidable))
+		return prepared->getPrepared().getBounds(prepared->getPosition());
+	if (const PreparedWall* wall = dynamic_cast<const PreparedWall*>(&collidable))
+		return wall->getBounds();
+	return getBounds(collidable);
+}
+
+PreparedWall::PreparedWall(const ctp::ShapeContainer& collider, const ctp::Coord2& position) : collider_(collider), position_(position) {
+	computeNormals(collider_);
+}
+
+void PreparedWall::setCollider(const ctp::ShapeContainer& collider) {
+	collider_ = collider;
+	computeNormals(collider_);
+	is_prepared_ = false;
+}
+
+void PreparedWall::collect(const ctp::Rect&, std::vector<ctp::Collidable*>& out) {
+	out.push_back(this);
+}
+bool PreparedWall::intersects(const ctp::Ray& ray,
+	ctp::gFloat& out_near, ctp::Coord2& out_norm_near, ctp::gFloat& out_far, ctp::Coord2& out_norm_far) const {
+	return ctp::intersects(ray, collider_, position_, out_near, out_norm_near, out_far, out_norm_far);
+}
+bool PreparedWall::overlaps(ctp::ConstShapeRef shape, const ctp::Coord2& pos, const PreparedShape& prepared) const {
+	return mayOverlap(prepared, pos, getPrepared(), position_) && ctp::overlaps(shape, pos, collider_, position_);
+}
+bool PreparedWall::overlaps(const PreparedWall& other) const {
+	// The other wall may be a compound, so it does the testing.
+	return other.overlaps(collider_, position_, getPrepared());
+}
+
+void PreparedWall::prepare() const {
+	if (is_prepared_)
+		return;
+	prepared_ = prepareShape(collider_);
+	is_prepared_ = true;
+}
+}
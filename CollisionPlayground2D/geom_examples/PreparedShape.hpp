@@ -0,0 +1,100 @@
+#ifndef INCLUDE_GAME_PREPARED_SHAPE_HPP
+#define INCLUDE_GAME_PREPARED_SHAPE_HPP
+
+#include <vector>
+
+#include <Geometry2D/Geometry.hpp>
+
+// Data derived from a shape that collision tests need again and again: its bounding box, bounding circle,
+// and for polygons its edge normals and how far the polygon reaches along each of them.
+// It's all relative to the shape's position, so it stays valid while the shape moves and only has to be made again when it changes.
+// Obstacles are PreparedWalls, which make their data when they're added to a map and keep it until their shape is changed.
+// Maps and examples test obstacles through PreparedWall's functions rather than with ctp's directly,
+// so obstacles made of several shapes (see CompoundWall) can test just the shapes a query reaches.
+
+namespace game {
+struct PreparedShape {
+	// An edge normal of a polygon (unit length), and the range of the polygon's vertices projected onto it.
+	struct Axis {
+		ctp::Coord2 normal;
+		ctp::gFloat min, max;
+	};
+
+	ctp::Rect bounds;
+	ctp::Circle circle;
+	std::vector<Axis> axes; // Polygons only: a rectangle's axes are its bounds'.
+
+	// Bounding box of the shape placed at a position.
+	ctp::Rect getBounds(const ctp::Coord2& pos) const { return ctp::Rect(bounds.x + pos.x, bounds.y + pos.y, bounds.w, bounds.h); }
+};
+
+// Work out a shape's prepared data.
+PreparedShape prepareShape(ctp::ConstShapeRef shape);
+// Work out the edge normals ctp's own tests use, if the shape is a polygon.
+void computeNormals(ctp::ShapeContainer& shape);
+// Check whether two prepared shapes might overlap, using their bounding boxes, bounding circles, and each one's axes
+// against the other's bounding circle. false means they certainly don't. true means ctp::overlaps is needed to be sure.
+bool mayOverlap(const PreparedShape& a, const ctp::Coord2& posA, const PreparedShape& b, const ctp::Coord2& posB);
+
+// A movement query's collidable, with its shape's prepared data, so maps can read its bounds rather than work them out again.
+// Movers query through one of these (see Mover::update). It refers to the collidable and data it's made with.
+class PreparedCollidable : public ctp::Collidable {
+public:
+	PreparedCollidable(const ctp::Collidable& collidable, const PreparedShape& prepared) : collidable_(collidable), prepared_(prepared) {}
+
+	ctp::ConstShapeRef getCollider() const override { return collidable_.getCollider(); }
+	ctp::Coord2 getPosition() const override { return collidable_.getPosition(); }
+	const PreparedShape& getPrepared() const { return prepared_; }
+
+private:
+	const ctp::Collidable& collidable_;
+	const PreparedShape& prepared_;
+};
+
+// Bounding box of a movement query's collidable: from its prepared data if it's a PreparedCollidable or PreparedWall,
+// otherwise from its shape.
+ctp::Rect getQueryBounds(const ctp::Collidable& collidable);
+
+// An obstacle that keeps its shape's prepared data.
+// The data is made the first time it's asked for after the shape is set, which maps do when the wall is added.
+// Asking for it isn't safe from several threads at once while the shape has changed and the data hasn't been made again.
+class PreparedWall : public ctp::Collidable {
+public:
+	PreparedWall(const ctp::ShapeContainer& collider, const ctp::Coord2& position);
+
+	ctp::ConstShapeRef getCollider() const override { return collider_; }
+	ctp::Coord2 getPosition() const override { return position_; }
+	void setPosition(const ctp::Coord2& position) { position_ = position; }
+	// Change the shape. Its prepared data is made again the next time it's needed.
+	void setCollider(const ctp::ShapeContainer& collider);
+
+	// Make the prepared data now, unless it's up to date.
+	void prepare() const;
+	const PreparedShape& getPrepared() const {
+		prepare();
+		return prepared_;
+	}
+	ctp::Rect getBounds() const { return getPrepared().getBounds(position_); }
+
+	virtual bool isCompound() const { return false; }
+	// Add what ctp should test a query against, given the bounds the query reaches: this wall, or the parts of it inside them.
+	virtual void collect(const ctp::Rect& bounds, std::vector<ctp::Collidable*>& out);
+	// Find where a ray enters and exits the wall, as ctp::intersects does.
+	virtual bool intersects(const ctp::Ray& ray,
+		ctp::gFloat& out_near, ctp::Coord2& out_norm_near, ctp::gFloat& out_far, ctp::Coord2& out_norm_far) const;
+	// Check whether a shape overlaps the wall, as ctp::overlaps does.
+	virtual bool overlaps(ctp::ConstShapeRef shape, const ctp::Coord2& pos, const PreparedShape& prepared) const;
+	// Check whether another wall overlaps this one.
+	virtual bool overlaps(const PreparedWall& other) const;
+
+protected:
+	ctp::ShapeContainer collider_;
+	ctp::Coord2 position_;
+
+private:
+	mutable PreparedShape prepared_;
+	mutable bool is_prepared_{false};
+};
+}
+
+#endif // INCLUDE_GAME_PREPARED_SHAPE_HPP
@@ -0,0 +1,63 @@
+#include "QueryCache.hpp"
+
+#include <chrono>
+#include <limits>
+
+#include "Bounds.hpp"
+
+namespace game {
+const std::size_t RayCache::NO_HIT = std::numeric_limits<std::size_t>::max();
+
+bool RayCache::findClosestHit(const ObstacleMap& map, std::size_t depth, const ctp::Ray& ray, RayHit& out_hit) {
+	++stats_.queries;
+	if (last_.size() <= depth)
+		last_.resize(depth + 1, NO_HIT);
+	const std::size_t cached(last_[depth]);
+	out_hit.index = NO_HIT;
+	if (cached >= map.size() || !map[cached]->intersects(ray, out_hit.near, out_hit.normNear, out_hit.far, out_hit.normFar))
+		out_hit.near = std::numeric_limits<ctp::gFloat>::max();
+	else
+		out_hit.index = cached;
+	// The map only replaces the cached hit with a closer one.
+	map.findCloserHit(ray, out_hit);
+	if (out_hit.index != NO_HIT && out_hit.index == cached)
+		++stats_.hits;
+	last_[depth] = out_hit.index;
+	return out_hit.index != NO_HIT;
+}
+void RayCache::invalidate() {
+	last_.clear();
+}
+
+const ctp::gFloat ContactCache::MARGIN = 32.0f;
+
+const std::vector<ctp::Collidable*> ContactCache::getColliding(const ctp::Collidable& collidable, ctp::Coord2 delta) const {
+	if (!map_->isSweptCulling()) // The map returns everything anyway.
+		return map_->getColliding(collidable, delta);
+	const auto start(std::chrono::steady_clock::now());
+	++stats_.queries;
+	const ctp::Rect swept(sweepBounds(getQueryBounds(collidable), delta));
+	const bool hit(is_valid_ && boundsContain(region_, swept));
+	if (hit) {
+		++stats_.hits;
+	} else {
+		region_ = expandBounds(swept, MARGIN);
+		nearby_ = map_->getColliding(ctp::Wall(ctp::ShapeContainer(region_), ctp::Coord2(0, 0)), ctp::Coord2(0, 0));
+		nearby_bounds_.clear();
+		for (const ctp::Collidable* c : nearby_)
+			nearby_bounds_.push_back(getBounds(*c));
+		is_valid_ = true;
+	}
+	std::vector<ctp::Collidable*> colliding;
+	for (std::size_t i = 0; i < nearby_.size(); ++i) {
+		if (boundsOverlap(nearby_bounds_[i], swept))
+			colliding.push_back(nearby_[i]);
+	}
+	(hit ? stats_.hitMicros : stats_.missMicros) += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	return colliding;
+}
+void ContactCache::setMap(const ObstacleMap& map) {
+	map_ = &map;
+	is_valid_ = false;
+}
+}
@@ -0,0 +1,72 @@
+#ifndef INCLUDE_GAME_QUERY_CACHE_HPP
+#define INCLUDE_GAME_QUERY_CACHE_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <Geometry2D/Geometry.hpp>
+
+#include "ObstacleMap.hpp"
+
+// Frame to frame caches for queries that barely change between steps: a turning ray usually hits what it hit last step,
+// and a mover only moves a few pixels. Both caches must be invalidated when the map's obstacles change.
+
+namespace game {
+// Remembers the obstacle each ray in a chain (e.g. a ray and its reflections) hit last time, and tests it first.
+// Its hit seeds the map's search with a close bound, so the map can skip everything further away.
+class RayCache {
+public:
+	static const std::size_t NO_HIT;
+
+	struct Stats {
+		std::size_t queries{0};
+		std::size_t hits{0}; // Queries where last time's obstacle was still the closest hit.
+	};
+
+	// Find the closest hit of the ray at a depth in the chain. Returns false if nothing is hit.
+	bool findClosestHit(const ObstacleMap& map, std::size_t depth, const ctp::Ray& ray, RayHit& out_hit);
+	void invalidate();
+
+	const Stats& getStats() const { return stats_; }
+	void resetStats() { stats_ = Stats(); }
+
+private:
+	std::vector<std::size_t> last_; // The obstacle hit at each depth, or NO_HIT.
+	Stats stats_;
+};
+
+// A CollisionMap for one mover, which remembers the obstacles around it. Each miss fetches the obstacles within MARGIN
+// of the query's swept bounds from the map. Later queries whose swept bounds stay inside that region are answered from
+// the list, without walking the map's broadphase.
+class ContactCache : public ctp::CollisionMap {
+public:
+	static const ctp::gFloat MARGIN;
+
+	struct Stats {
+		std::size_t queries{0};
+		std::size_t hits{0}; // Queries answered from the list.
+		double hitMicros{0};
+		double missMicros{0};
+	};
+
+	explicit ContactCache(const ObstacleMap& map) : map_(&map) {}
+
+	const std::vector<ctp::Collidable*> getColliding(const ctp::Collidable& collidable, ctp::Coord2 delta) const override;
+	// Use another map, e.g. after a scene is loaded.
+	void setMap(const ObstacleMap& map);
+	void invalidate() { is_valid_ = false; }
+
+	const Stats& getStats() const { return stats_; }
+	void resetStats() { stats_ = Stats(); }
+
+private:
+	const ObstacleMap* map_;
+	mutable ctp::Rect region_;
+	mutable std::vector<ctp::Collidable*> nearby_;
+	mutable std::vector<ctp::Rect> nearby_bounds_;
+	mutable bool is_valid_{false};
+	mutable Stats stats_;
+};
+}
+
+#endif // INCLUDE_GAME_QUERY_CACHE_HPP
@@ -0,0 +1,367 @@
+#include "RayPacket.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)) && !defined(__EMSCRIPTEN__)
+#define GAME_SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang need to be told a function may use instructions beyond the compile target. MSVC allows them anywhere.
+#if defined(GAME_SIMD_X86) && defined(__GNUC__)
+#define GAME_TARGET_SSE __attribute__((target("sse2")))
+#define GAME_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define GAME_TARGET_SSE
+#define GAME_TARGET_AVX2
+#endif
+
+namespace game {
+namespace {
+// Coordinates stay far below 1e8, so products with this stay finite.
+const float MAX_INVERSE = 1e30f;
+}
+
+float inverseDirection(float d) {
+	return std::abs(d) < 1 / MAX_INVERSE ? std::copysign(MAX_INVERSE, d) : 1.0f / d;
+}
+
+const std::uint32_t RayPacket::NO_HIT = std::numeric_limits<std::uint32_t>::max();
+
+void RayPacket::load(const ctp::Ray* rays, std::size_t count) {
+	size = std::min(count, MAX_SIZE);
+	for (std::size_t i = 0; i < MAX_SIZE; ++i) {
+		const ctp::Ray& ray(rays[i < size ? i : 0]); // Fill unused lanes with valid numbers.
+		originX[i] = ray.origin.x;
+		originY[i] = ray.origin.y;
+		dirX[i] = ray.dir.x;
+		dirY[i] = ray.dir.y;
+		invDirX[i] = inverseDirection(ray.dir.x);
+		invDirY[i] = inverseDirection(ray.dir.y);
+		closest[i] = i < size ? std::numeric_limits<float>::max() : -1.0f;
+		hit[i] = NO_HIT;
+	}
+}
+ctp::Ray RayPacket::getRay(std::size_t lane) const {
+	return ctp::Ray{ctp::Coord2(originX[lane], originY[lane]), ctp::Coord2(dirX[lane], dirY[lane])};
+}
+std::uint32_t RayPacket::lanes() const {
+	return size >= 32 ? ~0u : (1u << size) - 1;
+}
+
+namespace simd {
+namespace {
+using BoxKernel = std::uint32_t(*)(const RayPacket&, const ctp::Rect&, float*);
+using CircleKernel = std::uint32_t(*)(const RayPacket&, const ctp::Coord2&, ctp::gFloat, float*);
+using CircleBlockKernel = std::uint32_t(*)(const ctp::Ray&, const CircleBlock&, float, float*, float*);
+using RectBlockKernel = std::uint32_t(*)(const ctp::Ray&, const RectBlock&, float, float*, float*);
+
+// Lanes rounded up to a multiple of the SIMD width. Unused lanes hold valid data, and never hit.
+std::size_t paddedSize(const RayPacket& packet, std::size_t width) {
+	return (packet.size + width - 1) / width * width;
+}
+
+std::uint32_t boxScalar(const RayPacket& p, const ctp::Rect& box, float* out_enter) {
+	std::uint32_t mask(0);
+	for (std::size_t i = 0; i < p.size; ++i) {
+		const float x1((box.x - p.originX[i]) * p.invDirX[i]), x2((box.x + box.w - p.originX[i]) * p.invDirX[i]);
+		const float y1((box.y - p.originY[i]) * p.invDirY[i]), y2((box.y + box.h - p.originY[i]) * p.invDirY[i]);
+		const float enter(std::max(std::max(std::min(x1, x2), std::min(y1, y2)), 0.0f));
+		const float exit(std::min(std::max(x1, x2), std::max(y1, y2)));
+		out_enter[i] = enter;
+		if (enter <= exit && enter <= p.closest[i])
+			mask |= 1u << i;
+	}
+	return mask;
+}
+std::uint32_t circleScalar(const RayPacket& p, const ctp::Coord2& center, ctp::gFloat radius, float* out_near) {
+	std::uint32_t mask(0);
+	for (std::size_t i = 0; i < p.size; ++i) {
+		const float ox(p.originX[i] - center.x), oy(p.originY[i] - center.y);
+		const float b(ox * p.dirX[i] + oy * p.dirY[i]);
+		const float disc(b * b - (ox * ox + oy * oy - radius * radius));
+		const float root(std::sqrt(std::max(disc, 0.0f)));
+		const float near(std::max(-b - root, 0.0f));
+		out_near[i] = near;
+		if (disc >= 0 && -b + root >= 0 && near <= p.closest[i])
+			mask |= 1u << i;
+	}
+	return mask;
+}
+std::uint32_t circlesScalar(const ctp::Ray& ray, const CircleBlock& block, float closest, float* out_near, float* out_far) {
+	std::uint32_t mask(0);
+	for (std::size_t i = 0; i < block.size; ++i) {
+		const float ox(ray.origin.x - block.centerX[i]), oy(ray.origin.y - block.centerY[i]);
+		const float b(ox * ray.dir.x + oy * ray.dir.y);
+		const float disc(b * b - (ox * ox + oy * oy - block.radius[i] * block.radius[i]));
+		const float root(std::sqrt(std::max(disc, 0.0f)));
+		out_near[i] = std::max(-b - root, 0.0f);
+		out_far[i] = -b + root;
+		if (disc >= 0 && out_far[i] >= 0 && out_near[i] <= closest)
+			mask |= 1u << i;
+	}
+	return mask;
+}
+std::uint32_t rectsScalar(const ctp::Ray& ray, const RectBlock& block, float closest, float* out_near, float* out_far) {
+	const float invX(inverseDirection(ray.dir.x)), invY(inverseDirection(ray.dir.y));
+	std::uint32_t mask(0);
+	for (std::size_t i = 0; i < block.size; ++i) {
+		const float x1((block.minX[i] - ray.origin.x) * invX), x2((block.maxX[i] - ray.origin.x) * invX);
+		const float y1((block.minY[i] - ray.origin.y) * invY), y2((block.maxY[i] - ray.origin.y) * invY);
+		out_near[i] = std::max(std::max(std::min(x1, x2), std::min(y1, y2)), 0.0f);
+		out_far[i] = std::min(std::max(x1, x2), std::max(y1, y2));
+		if (out_near[i] <= out_far[i] && out_near[i] <= closest)
+			mask |= 1u << i;
+	}
+	return mask;
+}
+
+#ifdef GAME_SIMD_X86
+GAME_TARGET_SSE std::uint32_t boxSSE(const RayPacket& p, const ctp::Rect& box, float* out_enter) {
+	const __m128 left(_mm_set1_ps(box.x)), right(_mm_set1_ps(box.x + box.w));
+	const __m128 top(_mm_set1_ps(box.y)), bottom(_mm_set1_ps(box.y + box.h));
+	const __m128 zero(_mm_setzero_ps());
+	std::uint32_t mask(0);
+	const std::size_t size(paddedSize(p, 4));
+	for (std::size_t i = 0; i < size; i += 4) {
+		const __m128 ox(_mm_load_ps(p.originX + i)), oy(_mm_load_ps(p.originY + i));
+		const __m128 ix(_mm_load_ps(p.invDirX + i)), iy(_mm_load_ps(p.invDirY + i));
+		const __m128 x1(_mm_mul_ps(_mm_sub_ps(left, ox), ix)), x2(_mm_mul_ps(_mm_sub_ps(right, ox), ix));
+		const __m128 y1(_mm_mul_ps(_mm_sub_ps(top, oy), iy)), y2(_mm_mul_ps(_mm_sub_ps(bottom, oy), iy));
+		const __m128 enter(_mm_max_ps(_mm_max_ps(_mm_min_ps(x1, x2), _mm_min_ps(y1, y2)), zero));
+		const __m128 exit(_mm_min_ps(_mm_max_ps(x1, x2), _mm_max_ps(y1, y2)));
+		const __m128 hit(_mm_and_ps(_mm_cmple_ps(enter, exit), _mm_cmple_ps(enter, _mm_load_ps(p.closest + i))));
+		_mm_storeu_ps(out_enter + i, enter);
+		mask |= static_cast<std::uint32_t>(_mm_movemask_ps(hit)) << i;
+	}
+	return mask & p.lanes();
+}
+GAME_TARGET_SSE std::uint32_t circleSSE(const RayPacket& p, const ctp::Coord2& center, ctp::gFloat radius, float* out_near) {
+	const __m128 cx(_mm_set1_ps(center.x)), cy(_mm_set1_ps(center.y)), r2(_mm_set1_ps(radius * radius));
+	const __m128 zero(_mm_setzero_ps());
+	std::uint32_t mask(0);
+	const std::size_t size(paddedSize(p, 4));
+	for (std::size_t i = 0; i < size; i += 4) {
+		const __m128 ox(_mm_sub_ps(_mm_load_ps(p.originX + i), cx)), oy(_mm_sub_ps(_mm_load_ps(p.originY + i), cy));
+		const __m128 b(_mm_add_ps(_mm_mul_ps(ox, _mm_load_ps(p.dirX + i)), _mm_mul_ps(oy, _mm_load_ps(p.dirY + i))));
+		const __m128 c(_mm_sub_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)), r2));
+		const __m128 disc(_mm_sub_ps(_mm_mul_ps(b, b), c));
+		const __m128 root(_mm_sqrt_ps(_mm_max_ps(disc, zero)));
+		const __m128 negB(_mm_sub_ps(zero, b));
+		const __m128 near(_mm_max_ps(_mm_sub_ps(negB, root), zero));
+		const __m128 hit(_mm_and_ps(_mm_and_ps(_mm_cmpge_ps(disc, zero), _mm_cmpge_ps(_mm_add_ps(negB, root), zero)),
+			_mm_cmple_ps(near, _mm_load_ps(p.closest + i))));
+		_mm_storeu_ps(out_near + i, near);
+		mask |= static_cast<std::uint32_t>(_mm_movemask_ps(hit)) << i;
+	}
+	return mask & p.lanes();
+}
+GAME_TARGET_SSE std::uint32_t circlesSSE(const ctp::Ray& ray, const CircleBlock& block, float closest, float* out_near, float* out_far) {
+	const __m128 ox(_mm_set1_ps(ray.origin.x)), oy(_mm_set1_ps(ray.origin.y));
+	const __m128 dx(_mm_set1_ps(ray.dir.x)), dy(_mm_set1_ps(ray.dir.y));
+	const __m128 limit(_mm_set1_ps(closest)), zero(_mm_setzero_ps());
+	std::uint32_t mask(0);
+	for (std::size_t i = 0; i < CircleBlock::SIZE; i += 4) {
+		const __m128 px(_mm_sub_ps(ox, _mm_load_ps(block.centerX + i))), py(_mm_sub_ps(oy, _mm_load_ps(block.centerY + i)));
+		const __m128 r(_mm_load_ps(block.radius + i));
+		const __m128 b(_mm_add_ps(_mm_mul_ps(px, dx), _mm_mul_ps(py, dy)));
+		const __m128 c(_mm_sub_ps(_mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py)), _mm_mul_ps(r, r)));
+		const __m128 disc(_mm_sub_ps(_mm_mul_ps(b, b), c));
+		const __m128 root(_mm_sqrt_ps(_mm_max_ps(disc, zero)));
+		const __m128 negB(_mm_sub_ps(zero, b));
+		const __m128 near(_mm_max_ps(_mm_sub_ps(negB, root), zero));
+		const __m128 far(_mm_add_ps(negB, root));
+		const __m128 hit(_mm_and_ps(_mm_and_ps(_mm_cmpge_ps(disc, zero), _mm_cmpge_ps(far, zero)), _mm_cmple_ps(near, limit)));
+		_mm_storeu_ps(out_near + i, near);
+		_mm_storeu_ps(out_far + i, far);
+		mask |= static_cast<std::uint32_t>(_mm_movemask_ps(hit)) << i;
+	}
+	return mask & block.lanes();
+}
+GAME_TARGET_SSE std::uint32_t rectsSSE(const ctp::Ray& ray, const RectBlock& block, float closest, float* out_near, float* out_far) {
+	const __m128 ox(_mm_set1_ps(ray.origin.x)), oy(_mm_set1_ps(ray.origin.y));
+	const __m128 ix(_mm_set1_ps(inverseDirection(ray.dir.x))), iy(_mm_set1_ps(inverseDirection(ray.dir.y)));
+	const __m128 limit(_mm_set1_ps(closest)), zero(_mm_setzero_ps());
+	std::uint32_t mask(0);
+	for (std::size_t i = 0; i < RectBlock::SIZE; i += 4) {
+		const __m128 x1(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(block.minX + i), ox), ix)), x2(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(block.maxX + i), ox), ix));
+		const __m128 y1(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(block.minY + i), oy), iy)), y2(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(block.maxY + i), oy), iy));
+		const __m128 near(_mm_max_ps(_mm_max_ps(_mm_min_ps(x1, x2), _mm_min_ps(y1, y2)), zero));
+		const __m128 far(_mm_min_ps(_mm_max_ps(x1, x2), _mm_max_ps(y1, y2)));
+		const __m128 hit(_mm_and_ps(_mm_cmple_ps(near, far), _mm_cmple_ps(near, limit)));
+		_mm_storeu_ps(out_near + i, near);
+		_mm_storeu_ps(out_far + i, far);
+		mask |= static_cast<std::uint32_t>(_mm_movemask_ps(hit)) << i;
+	}
+	return mask & block.lanes();
+}
+GAME_TARGET_AVX2 std::uint32_t boxAVX2(const RayPacket& p, const ctp::Rect& box, float* out_enter) {
+	const __m256 left(_mm256_set1_ps(box.x)), right(_mm256_set1_ps(box.x + box.w));
+	const __m256 top(_mm256_set1_ps(box.y)), bottom(_mm256_set1_ps(box.y + box.h));
+	const __m256 zero(_mm256_setzero_ps());
+	std::uint32_t mask(0);
+	const std::size_t size(paddedSize(p, 8));
+	for (std::size_t i = 0; i < size; i += 8) {
+		const __m256 ox(_mm256_load_ps(p.originX + i)), oy(_mm256_load_ps(p.originY + i));
+		const __m256 ix(_mm256_load_ps(p.invDirX + i)), iy(_mm256_load_ps(p.invDirY + i));
+		const __m256 x1(_mm256_mul_ps(_mm256_sub_ps(left, ox), ix)), x2(_mm256_mul_ps(_mm256_sub_ps(right, ox), ix));
+		const __m256 y1(_mm256_mul_ps(_mm256_sub_ps(top, oy), iy)), y2(_mm256_mul_ps(_mm256_sub_ps(bottom, oy), iy));
+		const __m256 enter(_mm256_max_ps(_mm256_max_ps(_mm256_min_ps(x1, x2), _mm256_min_ps(y1, y2)), zero));
+		const __m256 exit(_mm256_min_ps(_mm256_max_ps(x1, x2), _mm256_max_ps(y1, y2)));
+		const __m256 hit(_mm256_and_ps(_mm256_cmp_ps(enter, exit, _CMP_LE_OQ), _mm256_cmp_ps(enter, _mm256_load_ps(p.closest + i), _CMP_LE_OQ)));
+		_mm256_storeu_ps(out_enter + i, enter);
+		mask |= static_cast<std::uint32_t>(_mm256_movemask_ps(hit)) << i;
+	}
+	return mask & p.lanes();
+}
+GAME_TARGET_AVX2 std::uint32_t circleAVX2(const RayPacket& p, const ctp::Coord2& center, ctp::gFloat radius, float* out_near) {
+	const __m256 cx(_mm256_set1_ps(center.x)), cy(_mm256_set1_ps(center.y)), r2(_mm256_set1_ps(radius * radius));
+	const __m256 zero(_mm256_setzero_ps());
+	std::uint32_t mask(0);
+	const std::size_t size(paddedSize(p, 8));
+	for (std::size_t i = 0; i < size; i += 8) {
+		const __m256 ox(_mm256_sub_ps(_mm256_load_ps(p.originX + i), cx)), oy(_mm256_sub_ps(_mm256_load_ps(p.originY + i), cy));
+		const __m256 b(_mm256_add_ps(_mm256_mul_ps(ox, _mm256_load_ps(p.dirX + i)), _mm256_mul_ps(oy, _mm256_load_ps(p.dirY + i))));
+		const __m256 c(_mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(ox, ox), _mm256_mul_ps(oy, oy)), r2));
+		const __m256 disc(_mm256_sub_ps(_mm256_mul_ps(b, b), c));
+		const __m256 root(_mm256_sqrt_ps(_mm256_max_ps(disc, zero)));
+		const __m256 negB(_mm256_sub_ps(zero, b));
+		const __m256 near(_mm256_max_ps(_mm256_sub_ps(negB, root), zero));
+		const __m256 hit(_mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(disc, zero, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_add_ps(negB, root), zero, _CMP_GE_OQ)),
+			_mm256_cmp_ps(near, _mm256_load_ps(p.closest + i), _CMP_LE_OQ)));
+		_mm256_storeu_ps(out_near + i, near);
+		mask |= static_cast<std::uint32_t>(_mm256_movemask_ps(hit)) << i;
+	}
+	return mask & p.lanes();
+}
+GAME_TARGET_AVX2 std::uint32_t circlesAVX2(const ctp::Ray& ray, const CircleBlock& block, float closest, float* out_near, float* out_far) {
+	const __m256 zero(_mm256_setzero_ps());
+	const __m256 px(_mm256_sub_ps(_mm256_set1_ps(ray.origin.x), _mm256_load_ps(block.centerX)));
+	const __m256 py(_mm256_sub_ps(_mm256_set1_ps(ray.origin.y), _mm256_load_ps(block.centerY)));
+	const __m256 r(_mm256_load_ps(block.radius));
+	const __m256 b(_mm256_add_ps(_mm256_mul_ps(px, _mm256_set1_ps(ray.dir.x)), _mm256_mul_ps(py, _mm256_set1_ps(ray.dir.y))));
+	const __m256 c(_mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(px, px), _mm256_mul_ps(py, py)), _mm256_mul_ps(r, r)));
+	const __m256 disc(_mm256_sub_ps(_mm256_mul_ps(b, b), c));
+	const __m256 root(_mm256_sqrt_ps(_mm256_max_ps(disc, zero)));
+	const __m256 negB(_mm256_sub_ps(zero, b));
+	const __m256 near(_mm256_max_ps(_mm256_sub_ps(negB, root), zero));
+	const __m256 far(_mm256_add_ps(negB, root));
+	const __m256 hit(_mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(disc, zero, _CMP_GE_OQ), _mm256_cmp_ps(far, zero, _CMP_GE_OQ)),
+		_mm256_cmp_ps(near, _mm256_set1_ps(closest), _CMP_LE_OQ)));
+	_mm256_storeu_ps(out_near, near);
+	_mm256_storeu_ps(out_far, far);
+	return static_cast<std::uint32_t>(_mm256_movemask_ps(hit)) & block.lanes();
+}
+GAME_TARGET_AVX2 std::uint32_t rectsAVX2(const ctp::Ray& ray, const RectBlock& block, float closest, float* out_near, float* out_far) {
+	const __m256 ox(_mm256_set1_ps(ray.origin.x)), oy(_mm256_set1_ps(ray.origin.y));
+	const __m256 ix(_mm256_set1_ps(inverseDirection(ray.dir.x))), iy(_mm256_set1_ps(inverseDirection(ray.dir.y)));
+	const __m256 x1(_mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(block.minX), ox), ix)), x2(_mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(block.maxX), ox), ix));
+	const __m256 y1(_mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(block.minY), oy), iy)), y2(_mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(block.maxY), oy), iy));
+	const __m256 near(_mm256_max_ps(_mm256_max_ps(_mm256_min_ps(x1, x2), _mm256_min_ps(y1, y2)), _mm256_setzero_ps()));
+	const __m256 far(_mm256_min_ps(_mm256_max_ps(x1, x2), _mm256_max_ps(y1, y2)));
+	const __m256 hit(_mm256_and_ps(_mm256_cmp_ps(near, far, _CMP_LE_OQ), _mm256_cmp_ps(near, _mm256_set1_ps(closest), _CMP_LE_OQ)));
+	_mm256_storeu_ps(out_near, near);
+	_mm256_storeu_ps(out_far, far);
+	return static_cast<std::uint32_t>(_mm256_movemask_ps(hit)) & block.lanes();
+}
+#endif
+
+SimdLevel detectLevel() {
+#if defined(GAME_SIMD_X86) && defined(__GNUC__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return SimdLevel::AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return SimdLevel::SSE;
+#elif defined(GAME_SIMD_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	const int maxLeaf(info[0]);
+	__cpuid(info, 1);
+	const bool sse2((info[3] & (1 << 26)) != 0);
+	const bool osAVX((info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0); // OSXSAVE and AVX.
+	if (maxLeaf >= 7 && osAVX && (_xgetbv(0) & 6) == 6) { // The OS saves the AVX registers.
+		__cpuidex(info, 7, 0);
+		if ((info[1] & (1 << 5)) != 0)
+			return SimdLevel::AVX2;
+	}
+	if (sse2)
+		return SimdLevel::SSE;
+#endif
+	return SimdLevel::SCALAR;
+}
+
+struct Kernels {
+	SimdLevel level;
+	BoxKernel box;
+	CircleKernel circle;
+	CircleBlockKernel circles;
+	RectBlockKernel rects;
+};
+Kernels getKernels(SimdLevel level) {
+	switch (level) {
+#ifdef GAME_SIMD_X86
+	case SimdLevel::AVX2:
+		return Kernels{level, boxAVX2, circleAVX2, circlesAVX2, rectsAVX2};
+	case SimdLevel::SSE:
+		return Kernels{level, boxSSE, circleSSE, circlesSSE, rectsSSE};
+#endif
+	default:
+		return Kernels{SimdLevel::SCALAR, boxScalar, circleScalar, circlesScalar, rectsScalar};
+	}
+}
+
+const SimdLevel maxLevel(detectLevel());
+Kernels kernels(getKernels(maxLevel));
+} // namespace
+
+SimdLevel getMaxLevel() {
+	return maxLevel;
+}
+SimdLevel getLevel() {
+	return kernels.level;
+}
+void setLevel(SimdLevel level) {
+	kernels = getKernels(static_cast<int>(level) > static_cast<int>(maxLevel) ? maxLevel : level);
+}
+const char* getLevelName(SimdLevel level) {
+	switch (level) {
+	case SimdLevel::SSE:
+		return "SSE";
+	case SimdLevel::AVX2:
+		return "AVX2";
+	default:
+		return "scalar";
+	}
+}
+
+std::uint32_t intersectBox(const RayPacket& packet, const ctp::Rect& box, float* out_enter) {
+	return kernels.box(packet, box, out_enter);
+}
+std::uint32_t intersectCircle(const RayPacket& packet, const ctp::Coord2& center, ctp::gFloat radius, float* out_near) {
+	return kernels.circle(packet, center, radius, out_near);
+}
+std::uint32_t intersectCircles(const ctp::Ray& ray, const CircleBlock& block, float closest, float* out_near, float* out_far) {
+	return kernels.circles(ray, block, closest, out_near, out_far);
+}
+std::uint32_t intersectRects(const ctp::Ray& ray, const RectBlock& block, float closest, float* out_near, float* out_far) {
+	return kernels.rects(ray, block, closest, out_near, out_far);
+}
+std::size_t closestLane(std::uint32_t mask, const float* dists) {
+	std::size_t closest(0);
+	bool found(false);
+	for (std::size_t i = 0; mask != 0; ++i, mask >>= 1) {
+		if ((mask & 1u) != 0 && (!found || dists[i] < dists[closest])) {
+			closest = i;
+			found = true;
+		}
+	}
+	return closest;
+}
+} // namespace simd
+} // namespace game
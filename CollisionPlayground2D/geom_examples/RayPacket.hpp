@@ -0,0 +1,98 @@
+#ifndef INCLUDE_GAME_RAY_PACKET_HPP
+#define INCLUDE_GAME_RAY_PACKET_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <Geometry2D/Geometry.hpp>
+
+// Ray packets: groups of rays traced together, so boxes and simple shapes can be tested against several rays at once with SIMD.
+// Shape blocks turn that around: groups of circles or rectangles, so one ray can be tested against several shapes at once.
+// The instruction set is chosen at runtime, falling back to plain scalar code.
+
+namespace game {
+enum class SimdLevel {
+	SCALAR,
+	SSE,  // 4 lanes.
+	AVX2, // 8 lanes.
+};
+
+// The reciprocal of a ray direction's component, for slab tests. An axis-parallel direction gets a large finite value rather than infinity:
+// for a ray starting on a box's edge that would give 0 * inf = NaN, which std::min and the SIMD min instructions treat differently.
+float inverseDirection(float d);
+
+// Rays stored as a structure of arrays. Directions must be normalized, so distances are the same as ctp::intersects gives.
+struct RayPacket {
+	static constexpr std::size_t MAX_SIZE = 16;
+	static const std::uint32_t NO_HIT;
+
+	std::size_t size{0};
+	alignas(32) float originX[MAX_SIZE];
+	alignas(32) float originY[MAX_SIZE];
+	alignas(32) float dirX[MAX_SIZE];
+	alignas(32) float dirY[MAX_SIZE];
+	alignas(32) float invDirX[MAX_SIZE];
+	alignas(32) float invDirY[MAX_SIZE];
+	alignas(32) float closest[MAX_SIZE]; // Closest hit distance so far. Unused lanes are negative so they never hit.
+	std::uint32_t hit[MAX_SIZE];         // Index of the closest obstacle hit so far.
+
+	// Set up the packet with count rays (up to MAX_SIZE), clearing any hits.
+	void load(const ctp::Ray* rays, std::size_t count);
+	ctp::Ray getRay(std::size_t lane) const;
+	// Bit mask of the lanes in use.
+	std::uint32_t lanes() const;
+};
+
+// Up to 8 circles in world space, stored as a structure of arrays. Unused lanes hold copies of lane 0.
+struct CircleBlock {
+	static constexpr std::size_t SIZE = 8;
+
+	std::size_t size{0};
+	alignas(32) float centerX[SIZE];
+	alignas(32) float centerY[SIZE];
+	alignas(32) float radius[SIZE];
+	std::uint32_t index[SIZE]; // What the owner calls each circle, e.g. its obstacle index.
+
+	// Bit mask of the lanes in use.
+	std::uint32_t lanes() const { return (1u << size) - 1; }
+};
+// Up to 8 rectangles in world space, stored as a structure of arrays. Unused lanes hold copies of lane 0.
+struct RectBlock {
+	static constexpr std::size_t SIZE = 8;
+
+	std::size_t size{0};
+	alignas(32) float minX[SIZE];
+	alignas(32) float minY[SIZE];
+	alignas(32) float maxX[SIZE];
+	alignas(32) float maxY[SIZE];
+	std::uint32_t index[SIZE];
+
+	std::uint32_t lanes() const { return (1u << size) - 1; }
+};
+
+namespace simd {
+// Best instruction set the CPU supports.
+SimdLevel getMaxLevel();
+SimdLevel getLevel();
+// Choose the instruction set for the packet kernels. Clamped to what the CPU supports.
+void setLevel(SimdLevel level);
+const char* getLevelName(SimdLevel level);
+
+// Test each ray against a box, writing the distance each enters it (0 if inside).
+// Returns a bit mask of the rays that hit it no further away than their closest hit.
+std::uint32_t intersectBox(const RayPacket& packet, const ctp::Rect& box, float* out_enter);
+// Test each ray against a circle, writing the distance each enters it (0 if inside).
+// Returns a bit mask of the rays that hit it no further away than their closest hit.
+std::uint32_t intersectCircle(const RayPacket& packet, const ctp::Coord2& center, ctp::gFloat radius, float* out_near);
+// Test a ray against each circle in a block, writing the distances where it enters (0 if inside) and exits each.
+// The ray's direction must be normalized. Returns a bit mask of the circles it enters no further away than closest.
+std::uint32_t intersectCircles(const ctp::Ray& ray, const CircleBlock& block, float closest, float* out_near, float* out_far);
+// Test a ray against each rectangle in a block, writing the distances where it enters (0 if inside) and exits each.
+// Returns a bit mask of the rectangles it enters no further away than closest.
+std::uint32_t intersectRects(const ctp::Ray& ray, const RectBlock& block, float closest, float* out_near, float* out_far);
+// The lane in mask with the smallest distance. The mask must not be empty.
+std::size_t closestLane(std::uint32_t mask, const float* dists);
+}
+}
+
+#endif // INCLUDE_GAME_RAY_PACKET_HPP
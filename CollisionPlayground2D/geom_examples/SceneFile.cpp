@@ -0,0 +1,307 @@
+#include "SceneFile.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+#include "BVHCollisionMap.hpp"
+#include "ObstacleMap.hpp"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#define GAME_SCENE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace game {
+namespace {
+std::uint64_t alignOffset(std::uint64_t offset) {
+	return (offset + SCENE_ALIGNMENT - 1) / SCENE_ALIGNMENT * SCENE_ALIGNMENT;
+}
+ctp::Rect toRect(const float (&r)[4]) {
+	return ctp::Rect(r[0], r[1], r[2], r[3]);
+}
+void fromRect(const ctp::Rect& r, float (&out_r)[4]) {
+	out_r[0] = r.x;
+	out_r[1] = r.y;
+	out_r[2] = r.w;
+	out_r[3] = r.h;
+}
+}
+
+SceneFile::~SceneFile() {
+	close();
+}
+
+bool SceneFile::open(const std::string& path) {
+	close();
+	if (!_map(path))
+		return false;
+	if (!_validate(path)) {
+		close();
+		return false;
+	}
+	return true;
+}
+void SceneFile::close() {
+#if defined(_WIN32)
+	if (mapped_)
+		UnmapViewOfFile(data_);
+#elif defined(GAME_SCENE_MMAP)
+	if (mapped_)
+		munmap(const_cast<char*>(data_), size_);
+#endif
+	mapped_ = false;
+	buffer_.clear();
+	buffer_.shrink_to_fit();
+	data_ = nullptr;
+	size_ = 0;
+	header_ = nullptr;
+	shapes_ = nullptr;
+	vertices_ = nullptr;
+	nodes_ = nullptr;
+	order_ = nullptr;
+}
+
+ctp::Rect SceneFile::getRegion() const {
+	return toRect(header_->region);
+}
+ctp::ShapeContainer SceneFile::makeShape(std::size_t index) const {
+	const SceneShape& s(shapes_[index]);
+	switch (s.type) {
+	case SceneShapeType::RECTANGLE:
+		return ctp::ShapeContainer(ctp::Rect(s.params[0], s.params[1], s.params[2], s.params[3]));
+	case SceneShapeType::POLYGON: {
+		std::vector<ctp::Coord2> verts;
+		verts.reserve(s.vertexCount);
+		for (std::uint32_t i = s.firstVertex; i < s.firstVertex + s.vertexCount; ++i)
+			verts.push_back(ctp::Coord2(vertices_[i].x, vertices_[i].y));
+		return ctp::ShapeContainer(ctp::Polygon(verts));
+	}
+	case SceneShapeType::CIRCLE: {
+		ctp::Circle circle(s.params[2]);
+		circle.center = ctp::Coord2(s.params[0], s.params[1]);
+		return ctp::ShapeContainer(circle);
+	}
+	default: // Checked when opened.
+		return ctp::ShapeContainer(ctp::Rect());
+	}
+}
+ctp::Coord2 SceneFile::getPosition(std::size_t index) const {
+	return ctp::Coord2(shapes_[index].position[0], shapes_[index].position[1]);
+}
+ctp::Rect SceneFile::getBounds(std::size_t index) const {
+	return toRect(shapes_[index].bounds);
+}
+
+bool SceneFile::_map(const std::string& path) {
+#if defined(_WIN32)
+	const HANDLE file(CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
+	if (file != INVALID_HANDLE_VALUE) {
+		LARGE_INTEGER fileSize;
+		HANDLE mapping(nullptr);
+		if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+			mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping) {
+			data_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			size_ = static_cast<std::size_t>(fileSize.QuadPart);
+			CloseHandle(mapping); // The view keeps the mapping alive.
+		}
+		CloseHandle(file);
+		if (data_) {
+			mapped_ = true;
+			return true;
+		}
+	}
+#elif defined(GAME_SCENE_MMAP)
+	const int file(::open(path.c_str(), O_RDONLY));
+	if (file >= 0) {
+		struct stat info;
+		if (fstat(file, &info) == 0 && info.st_size > 0) {
+			void* mapped(mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0));
+			if (mapped != MAP_FAILED) {
+				data_ = static_cast<const char*>(mapped);
+				size_ = static_cast<std::size_t>(info.st_size);
+				mapped_ = true;
+			}
+		}
+		::close(file);
+		if (mapped_)
+			return true;
+	}
+#endif
+	// Fall back to reading the whole file.
+	std::ifstream stream(path, std::ios::binary | std::ios::ate);
+	if (!stream) {
+		std::cerr << "Error: Could not open scene file \"" << path << "\".\n";
+		return false;
+	}
+	buffer_.resize(static_cast<std::size_t>(stream.tellg()));
+	stream.seekg(0);
+	if (!stream.read(buffer_.data(), buffer_.size())) {
+		std::cerr << "Error: Could not read scene file \"" << path << "\".\n";
+		buffer_.clear();
+		return false;
+	}
+	data_ = buffer_.data();
+	size_ = buffer_.size();
+	return true;
+}
+bool SceneFile::_validate(const std::string& path) {
+	const auto fail = [&](const char* reason) {
+		std::cerr << "Error: Scene file \"" << path << "\" " << reason << ".\n";
+		return false;
+	};
+	if (size_ < sizeof(SceneHeader))
+		return fail("is too small");
+	const SceneHeader* header(reinterpret_cast<const SceneHeader*>(data_));
+	if (std::memcmp(header->magic, SCENE_MAGIC, sizeof(SCENE_MAGIC)) != 0)
+		return fail("is not a scene file");
+	if (header->endianCheck != SCENE_ENDIAN_CHECK)
+		return fail("has the wrong byte order");
+	if (header->version != SCENE_VERSION)
+		return fail("has an unsupported version");
+	// Sections must be aligned and lie inside the file.
+	const auto fits = [&](std::uint64_t offset, std::uint64_t count, std::uint64_t elemSize) {
+		return offset % SCENE_ALIGNMENT == 0 && offset <= size_ && count <= (size_ - offset) / elemSize;
+	};
+	if (header->shapeCount > std::numeric_limits<std::uint32_t>::max() || !fits(header->shapesOffset, header->shapeCount, sizeof(SceneShape))
+		|| !fits(header->verticesOffset, header->vertexCount, sizeof(SceneVertex)))
+		return fail("has a bad shape or vertex section");
+	const SceneShape* shapes(reinterpret_cast<const SceneShape*>(data_ + header->shapesOffset));
+	for (std::uint64_t i = 0; i < header->shapeCount; ++i) {
+		const SceneShape& s(shapes[i]);
+		if (s.type != SceneShapeType::RECTANGLE && s.type != SceneShapeType::POLYGON && s.type != SceneShapeType::CIRCLE)
+			return fail("has an unknown shape type");
+		if (s.type == SceneShapeType::POLYGON && (s.vertexCount < 3 || std::uint64_t(s.firstVertex) + s.vertexCount > header->vertexCount))
+			return fail("has a polygon with bad vertices");
+	}
+	const bool hasHierarchy((header->flags & SCENE_HAS_HIERARCHY) != 0 && header->shapeCount > 0);
+	if (hasHierarchy) {
+		if (header->nodeCount == 0 || header->nodeCount > std::numeric_limits<std::uint32_t>::max()
+			|| !fits(header->nodesOffset, header->nodeCount, sizeof(SceneNode)) || !fits(header->orderOffset, header->shapeCount, sizeof(std::uint32_t)))
+			return fail("has a bad hierarchy section");
+		const SceneNode* nodes(reinterpret_cast<const SceneNode*>(data_ + header->nodesOffset));
+		const std::uint32_t* order(reinterpret_cast<const std::uint32_t*>(data_ + header->orderOffset));
+		for (std::uint64_t i = 0; i < header->nodeCount; ++i) {
+			const SceneNode& n(nodes[i]);
+			// Children always come after their parent, so traversal can't loop.
+			const bool valid(n.count > 0 ? std::uint64_t(n.first) + n.count <= header->shapeCount
+			                             : i + 1 < header->nodeCount && n.first > i + 1 && n.first < header->nodeCount);
+			if (!valid)
+				return fail("has a bad hierarchy node");
+		}
+		for (std::uint64_t i = 0; i < header->shapeCount; ++i) {
+			if (order[i] >= header->shapeCount)
+				return fail("has a bad hierarchy order");
+		}
+		nodes_ = nodes;
+		order_ = order;
+	}
+	header_ = header;
+	shapes_ = shapes;
+	vertices_ = reinterpret_cast<const SceneVertex*>(data_ + header->verticesOffset);
+	return true;
+}
+
+bool saveScene(const std::string& path, const ObstacleMap& map, const ctp::Rect& region) {
+	std::vector<SceneShape> shapes(map.size());
+	std::vector<SceneVertex> vertices;
+	std::vector<ctp::Rect> bounds(map.size());
+	for (std::size_t i = 0; i < map.size(); ++i) {
+		if (map[i]->isCompound()) {
+			std::cerr << "Error: Scene files can't hold compound shapes.\n";
+			return false;
+		}
+		const ctp::ConstShapeRef collider(map[i]->getCollider());
+		const ctp::Coord2 position(map[i]->getPosition());
+		SceneShape& s(shapes[i]);
+		s = SceneShape();
+		s.position[0] = position.x;
+		s.position[1] = position.y;
+		switch (collider.type()) {
+		case ctp::ShapeType::RECTANGLE:
+			s.type = SceneShapeType::RECTANGLE;
+			fromRect(collider.rect(), s.params);
+			break;
+		case ctp::ShapeType::POLYGON: {
+			const ctp::Polygon& poly(collider.poly());
+			if (vertices.size() + poly.size() > std::numeric_limits<std::uint32_t>::max()) {
+				std::cerr << "Error: Too many polygon vertices to save the scene.\n";
+				return false;
+			}
+			s.type = SceneShapeType::POLYGON;
+			s.firstVertex = static_cast<std::uint32_t>(vertices.size());
+			s.vertexCount = static_cast<std::uint32_t>(poly.size());
+			for (std::size_t v = 0; v < poly.size(); ++v)
+				vertices.push_back(SceneVertex{poly[v].x, poly[v].y});
+			break;
+		}
+		case ctp::ShapeType::CIRCLE:
+			s.type = SceneShapeType::CIRCLE;
+			s.params[0] = collider.circle().center.x;
+			s.params[1] = collider.circle().center.y;
+			s.params[2] = collider.circle().radius;
+			break;
+		default:
+			std::cerr << "Error: Unhandled shape type while saving the scene.\n";
+			return false;
+		}
+		bounds[i] = getBounds(*map[i]);
+		fromRect(bounds[i], s.bounds);
+	}
+	std::vector<BVHCollisionMap::Node> bvhNodes;
+	std::vector<std::uint32_t> order, parents;
+	BVHCollisionMap::buildHierarchy(bounds, bvhNodes, order, parents);
+	std::vector<SceneNode> nodes(bvhNodes.size());
+	for (std::size_t i = 0; i < nodes.size(); ++i) {
+		fromRect(bvhNodes[i].bounds, nodes[i].bounds);
+		nodes[i].first = bvhNodes[i].first;
+		nodes[i].count = bvhNodes[i].count;
+	}
+
+	SceneHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, SCENE_MAGIC, sizeof(SCENE_MAGIC));
+	header.version = SCENE_VERSION;
+	header.endianCheck = SCENE_ENDIAN_CHECK;
+	header.flags = nodes.empty() ? 0 : SCENE_HAS_HIERARCHY;
+	fromRect(region, header.region);
+	header.shapeCount = shapes.size();
+	header.vertexCount = vertices.size();
+	header.nodeCount = nodes.size();
+	header.shapesOffset = alignOffset(sizeof(SceneHeader));
+	header.verticesOffset = alignOffset(header.shapesOffset + shapes.size() * sizeof(SceneShape));
+	header.nodesOffset = alignOffset(header.verticesOffset + vertices.size() * sizeof(SceneVertex));
+	header.orderOffset = alignOffset(header.nodesOffset + nodes.size() * sizeof(SceneNode));
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		std::cerr << "Error: Could not create scene file \"" << path << "\".\n";
+		return false;
+	}
+	const auto writeSection = [&](std::uint64_t offset, const void* data, std::size_t bytes) {
+		static const char padding[SCENE_ALIGNMENT] = {};
+		const std::uint64_t pos(static_cast<std::uint64_t>(file.tellp()));
+		file.write(padding, static_cast<std::streamsize>(offset - pos));
+		file.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+	};
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	writeSection(header.shapesOffset, shapes.data(), shapes.size() * sizeof(SceneShape));
+	writeSection(header.verticesOffset, vertices.data(), vertices.size() * sizeof(SceneVertex));
+	writeSection(header.nodesOffset, nodes.data(), nodes.size() * sizeof(SceneNode));
+	writeSection(header.orderOffset, order.data(), order.size() * sizeof(std::uint32_t));
+	if (!file) {
+		std::cerr << "Error: Could not write scene file \"" << path << "\".\n";
+		return false;
+	}
+	return true;
+}
+}
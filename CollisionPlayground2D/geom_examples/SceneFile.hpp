@@ -0,0 +1,115 @@
+#ifndef INCLUDE_GAME_SCENE_FILE_HPP
+#define INCLUDE_GAME_SCENE_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <Geometry2D/Geometry.hpp>
+
+// Binary scene files: a flat array of shape records, a pool of polygon vertices, and optionally a prebuilt bounding volume
+// hierarchy over the shapes. Everything is fixed size and little endian, so a file can be memory mapped and read in place.
+//
+// Layout: SceneHeader, then each section at the offset the header gives (aligned to SCENE_ALIGNMENT):
+//   shapes   - SceneShape[shapeCount]
+//   vertices - SceneVertex[vertexCount]
+//   nodes    - SceneNode[nodeCount]       (if SCENE_HAS_HIERARCHY)
+//   order    - std::uint32_t[shapeCount] (if SCENE_HAS_HIERARCHY) Shape indices, grouped by leaf.
+
+namespace game {
+class ObstacleMap;
+
+constexpr char SCENE_MAGIC[4] = {'C', 'P', 'S', 'N'};
+constexpr std::uint32_t SCENE_VERSION = 1;
+constexpr std::uint32_t SCENE_ENDIAN_CHECK = 0x01020304;
+constexpr std::uint32_t SCENE_HAS_HIERARCHY = 1; // Header flag.
+constexpr std::uint64_t SCENE_ALIGNMENT = 16;
+
+enum class SceneShapeType : std::uint32_t {
+	RECTANGLE = 0, // params: x, y, w, h.
+	POLYGON = 1,   // Vertices are firstVertex to firstVertex + vertexCount in the vertex pool.
+	CIRCLE = 2,    // params: center x, center y, radius.
+};
+
+struct SceneHeader {
+	char magic[4];
+	std::uint32_t version;
+	std::uint32_t endianCheck;
+	std::uint32_t flags;
+	float region[4]; // Level region: x, y, w, h.
+	std::uint64_t shapeCount;
+	std::uint64_t vertexCount;
+	std::uint64_t nodeCount;
+	std::uint64_t shapesOffset;
+	std::uint64_t verticesOffset;
+	std::uint64_t nodesOffset;
+	std::uint64_t orderOffset;
+};
+struct SceneShape {
+	SceneShapeType type;
+	std::uint32_t firstVertex;
+	std::uint32_t vertexCount;
+	std::uint32_t reserved;
+	float position[2];
+	float params[4];
+	float bounds[4]; // Bounding box at the shape's position: x, y, w, h.
+};
+struct SceneVertex {
+	float x, y;
+};
+// Same layout as BVHCollisionMap's nodes: the left child of an internal node directly follows it.
+struct SceneNode {
+	float bounds[4];
+	std::uint32_t first; // First entry in order for leaves, or the right child for internal nodes.
+	std::uint32_t count; // Number of shapes in a leaf. 0 for internal nodes.
+};
+
+// A read-only view of a scene file. The file is memory mapped where the platform supports it, and read into memory otherwise.
+class SceneFile {
+public:
+	SceneFile() = default;
+	~SceneFile();
+	SceneFile(const SceneFile&) = delete;
+	SceneFile& operator=(const SceneFile&) = delete;
+
+	// Open and validate a scene file. Returns false (printing why) if it can't be used.
+	bool open(const std::string& path);
+	void close();
+	bool isOpen() const { return header_ != nullptr; }
+
+	ctp::Rect getRegion() const;
+	std::size_t shapeCount() const { return static_cast<std::size_t>(header_->shapeCount); }
+	const SceneShape& shape(std::size_t index) const { return shapes_[index]; }
+	const SceneVertex* vertices() const { return vertices_; }
+	bool hasHierarchy() const { return nodes_ != nullptr; }
+	std::size_t nodeCount() const { return static_cast<std::size_t>(header_->nodeCount); }
+	const SceneNode* nodes() const { return nodes_; }
+	const std::uint32_t* order() const { return order_; }
+
+	// Make a copy of a shape. Its position is separate, as with ctp::Wall.
+	ctp::ShapeContainer makeShape(std::size_t index) const;
+	ctp::Coord2 getPosition(std::size_t index) const;
+	ctp::Rect getBounds(std::size_t index) const;
+
+private:
+	const char* data_{nullptr};
+	std::size_t size_{0};
+	bool mapped_{false};
+	std::vector<char> buffer_; // Used when the file can't be mapped.
+
+	const SceneHeader* header_{nullptr};
+	const SceneShape* shapes_{nullptr};
+	const SceneVertex* vertices_{nullptr};
+	const SceneNode* nodes_{nullptr};
+	const std::uint32_t* order_{nullptr};
+
+	bool _map(const std::string& path);
+	bool _validate(const std::string& path);
+};
+
+// Write a map's obstacles to a scene file, with a prebuilt hierarchy. Returns false (printing why) on failure.
+bool saveScene(const std::string& path, const ObstacleMap& map, const ctp::Rect& region);
+}
+
+#endif // INCLUDE_GAME_SCENE_FILE_HPP
@@ -0,0 +1,113 @@
+#include "ShapeBatch.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace game {
+namespace {
+// Start a block with every lane a copy of its first shape, so the unused lanes hold valid numbers.
+template<typename Block, typename Fill>
+void addToBlocks(std::vector<Block>& blocks, std::size_t index, Fill fill) {
+	if (blocks.empty() || blocks.back().size == Block::SIZE) {
+		blocks.emplace_back();
+		for (std::size_t i = 0; i < Block::SIZE; ++i)
+			fill(blocks.back(), i);
+	}
+	Block& block(blocks.back());
+	fill(block, block.size);
+	block.index[block.size] = static_cast<std::uint32_t>(index);
+	++block.size;
+}
+std::size_t lowestLane(std::uint32_t mask) {
+	std::size_t lane(0);
+	while ((mask & (1u << lane)) == 0)
+		++lane;
+	return lane;
+}
+}
+
+void ShapeBatch::clear() {
+	circles_.clear();
+	rects_.clear();
+	size_ = 0;
+}
+
+void ShapeBatch::addCircle(std::size_t index, const ctp::Coord2& center, ctp::gFloat radius) {
+	addToBlocks(circles_, index, [&](CircleBlock& block, std::size_t lane) {
+		block.centerX[lane] = center.x;
+		block.centerY[lane] = center.y;
+		block.radius[lane] = radius;
+	});
+	++size_;
+}
+void ShapeBatch::addRect(std::size_t index, const ctp::Rect& rect) {
+	addToBlocks(rects_, index, [&](RectBlock& block, std::size_t lane) {
+		block.minX[lane] = rect.x;
+		block.minY[lane] = rect.y;
+		block.maxX[lane] = rect.x + rect.w;
+		block.maxY[lane] = rect.y + rect.h;
+	});
+	++size_;
+}
+
+// Only the closest hit of each block is worked out in full, and each block only looks for hits nearer than the last.
+bool ShapeBatch::findCloserHit(const ctp::Ray& ray, RayHit& inout_hit) const {
+	float near[CircleBlock::SIZE], far[CircleBlock::SIZE];
+	bool found(false);
+	for (const CircleBlock& block : circles_) {
+		const std::uint32_t mask(simd::intersectCircles(ray, block, inout_hit.near, near, far));
+		if (mask == 0)
+			continue;
+		const std::size_t lane(simd::closestLane(mask, near));
+		if (near[lane] == inout_hit.near)
+			continue; // Only as close: keep the hit we started with.
+		inout_hit = _circle_hit(ray, block, lane, near[lane], far[lane]);
+		found = true;
+	}
+	for (const RectBlock& block : rects_) {
+		const std::uint32_t mask(simd::intersectRects(ray, block, inout_hit.near, near, far));
+		if (mask == 0)
+			continue;
+		const std::size_t lane(simd::closestLane(mask, near));
+		if (near[lane] == inout_hit.near)
+			continue;
+		inout_hit = _rect_hit(ray, block, lane, near[lane], far[lane]);
+		found = true;
+	}
+	return found;
+}
+void ShapeBatch::findHits(const ctp::Ray& ray, std::vector<RayHit>& out_hits) const {
+	const float limit(std::numeric_limits<float>::max());
+	float near[CircleBlock::SIZE], far[CircleBlock::SIZE];
+	for (const CircleBlock& block : circles_) {
+		for (std::uint32_t mask(simd::intersectCircles(ray, block, limit, near, far)); mask != 0; mask &= mask - 1) {
+			const std::size_t lane(lowestLane(mask));
+			out_hits.push_back(_circle_hit(ray, block, lane, near[lane], far[lane]));
+		}
+	}
+	for (const RectBlock& block : rects_) {
+		for (std::uint32_t mask(simd::intersectRects(ray, block, limit, near, far)); mask != 0; mask &= mask - 1) {
+			const std::size_t lane(lowestLane(mask));
+			out_hits.push_back(_rect_hit(ray, block, lane, near[lane], far[lane]));
+		}
+	}
+}
+
+// Normals point out of the shape, at the points where the ray enters and exits it.
+RayHit ShapeBatch::_circle_hit(const ctp::Ray& ray, const CircleBlock& block, std::size_t lane, float near, float far) {
+	const ctp::Coord2 center(block.centerX[lane], block.centerY[lane]);
+	const float scale(block.radius[lane] > 0 ? 1.0f / block.radius[lane] : 0.0f);
+	return RayHit{block.index[lane], near, far,
+		(ray.origin + ray.dir * near - center) * scale, (ray.origin + ray.dir * far - center) * scale};
+}
+RayHit ShapeBatch::_rect_hit(const ctp::Ray& ray, const RectBlock& block, std::size_t lane, float near, float far) {
+	// The ray enters through the side of the last slab it enters, and exits through the first slab it leaves.
+	const float invX(inverseDirection(ray.dir.x)), invY(inverseDirection(ray.dir.y));
+	const float x1((block.minX[lane] - ray.origin.x) * invX), x2((block.maxX[lane] - ray.origin.x) * invX);
+	const float y1((block.minY[lane] - ray.origin.y) * invY), y2((block.maxY[lane] - ray.origin.y) * invY);
+	const ctp::Coord2 sideX(invX > 0 ? 1.0f : -1.0f, 0.0f), sideY(0.0f, invY > 0 ? 1.0f : -1.0f);
+	return RayHit{block.index[lane], near, far,
+		std::min(x1, x2) > std::min(y1, y2) ? -sideX : -sideY,
+		std::max(x1, x2) < std::max(y1, y2) ? sideX : sideY};
+}
+}
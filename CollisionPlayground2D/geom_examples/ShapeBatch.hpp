@@ -0,0 +1,46 @@
+#ifndef INCLUDE_GAME_SHAPE_BATCH_HPP
+#define INCLUDE_GAME_SHAPE_BATCH_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <Geometry2D/Geometry.hpp>
+
+#include "RayPacket.hpp"
+
+// Circles and rectangles copied into blocks of 8, so a ray is tested against a whole block at once with the SIMD kernels,
+// rather than one shape at a time with a branch on each shape's type. Other shapes aren't batched: the owner tests those itself.
+
+namespace game {
+// Where a ray enters and exits an obstacle.
+struct RayHit {
+	std::size_t index;
+	ctp::gFloat near, far;
+	ctp::Coord2 normNear, normFar;
+};
+
+class ShapeBatch {
+public:
+	void clear();
+	// Add a shape in world space, with the index to report for it.
+	void addCircle(std::size_t index, const ctp::Coord2& center, ctp::gFloat radius);
+	void addRect(std::size_t index, const ctp::Rect& rect);
+	std::size_t size() const { return size_; }
+
+	// Look for a shape the ray enters closer than inout_hit.near, and replace inout_hit with it. Returns false if there's none.
+	// Ray directions must be normalized.
+	bool findCloserHit(const ctp::Ray& ray, RayHit& inout_hit) const;
+	// Add every shape the ray hits to out_hits, in no particular order.
+	void findHits(const ctp::Ray& ray, std::vector<RayHit>& out_hits) const;
+
+private:
+	std::vector<CircleBlock> circles_;
+	std::vector<RectBlock> rects_;
+	std::size_t size_{0};
+
+	static RayHit _circle_hit(const ctp::Ray& ray, const CircleBlock& block, std::size_t lane, float near, float far);
+	static RayHit _rect_hit(const ctp::Ray& ray, const RectBlock& block, std::size_t lane, float near, float far);
+};
+}
+
+#endif // INCLUDE_GAME_SHAPE_BATCH_HPP
@@ -0,0 +1,115 @@
+#include "ShapePlacer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ShapeUtil.hpp"
+#include "../generator.hpp"
+
+namespace game {
+const std::size_t ShapePlacer::RANDOM_ATTEMPTS = 8;
+const std::size_t ShapePlacer::ATTEMPTS = 30;
+const std::uint32_t ShapePlacer::NONE = ~0u;
+
+ShapePlacer::ShapePlacer(const ctp::Rect& region, ctp::gFloat cellSize)
+	: region_(region), cell_size_(std::max(cellSize, ctp::gFloat(1))),
+	cols_(std::max(1, static_cast<std::int32_t>(std::ceil(region.w / cell_size_)))),
+	rows_(std::max(1, static_cast<std::int32_t>(std::ceil(region.h / cell_size_)))) {
+	clear();
+}
+
+void ShapePlacer::clear() {
+	max_radius_ = 0;
+	centers_.clear();
+	radii_.clear();
+	next_.clear();
+	active_.clear();
+	cell_head_.assign(static_cast<std::size_t>(cols_) * rows_, NONE);
+}
+
+bool ShapePlacer::place(ctp::ConstShapeRef shape, ctp::Coord2& out_position) {
+	return place(getBoundingCircle(shape), out_position);
+}
+bool ShapePlacer::place(const ctp::Circle& bounds, ctp::Coord2& out_position) {
+	ctp::Coord2 center;
+	if (!placeCircle(bounds.radius, center))
+		return false;
+	out_position = center - bounds.center;
+	return true;
+}
+
+bool ShapePlacer::placeCircle(ctp::gFloat radius, ctp::Coord2& out_center) {
+	for (std::size_t attempt = 0; attempt < RANDOM_ATTEMPTS; ++attempt) {
+		const ctp::Coord2 candidate(gen::coord2(region_));
+		if (isClear(candidate, radius)) {
+			out_center = candidate;
+			_add_circle(candidate, radius);
+			return true;
+		}
+	}
+	while (!active_.empty()) {
+		const std::uint32_t around(active_.back());
+		// Try in a ring from touching the circle out to twice as far.
+		const ctp::gFloat near(radii_[around] + radius);
+		for (std::size_t attempt = 0; attempt < ATTEMPTS; ++attempt) {
+			const ctp::gFloat angle(gen::gFloat(0, ctp::constants::TAU));
+			const ctp::gFloat dist(gen::gFloat(near, near * 2));
+			const ctp::Coord2 candidate(centers_[around].x + std::cos(angle) * dist, centers_[around].y + std::sin(angle) * dist);
+			if (_inside(candidate) && isClear(candidate, radius)) {
+				out_center = candidate;
+				_add_circle(candidate, radius);
+				return true;
+			}
+		}
+		active_.pop_back();
+	}
+	return false;
+}
+
+void ShapePlacer::add(ctp::ConstShapeRef shape, const ctp::Coord2& position) {
+	const ctp::Circle bounds(getBoundingCircle(shape));
+	_add_circle(position + bounds.center, bounds.radius);
+}
+void ShapePlacer::addBounds(const ctp::Rect& bounds) {
+	_add_circle(bounds.center(), std::sqrt(bounds.w * bounds.w + bounds.h * bounds.h) / 2);
+}
+
+bool ShapePlacer::isClear(const ctp::Coord2& center, ctp::gFloat radius) const {
+	const ctp::gFloat reach(radius + max_radius_);
+	const std::int32_t firstCol(_col(center.x - reach)), lastCol(_col(center.x + reach));
+	const std::int32_t firstRow(_row(center.y - reach)), lastRow(_row(center.y + reach));
+	for (std::int32_t row = firstRow; row <= lastRow; ++row) {
+		for (std::int32_t col = firstCol; col <= lastCol; ++col) {
+			for (std::uint32_t i = cell_head_[static_cast<std::size_t>(row) * cols_ + col]; i != NONE; i = next_[i]) {
+				const ctp::Coord2 d(centers_[i] - center);
+				const ctp::gFloat apart(radius + radii_[i]);
+				if (d.x * d.x + d.y * d.y <= apart * apart)
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+void ShapePlacer::_add_circle(const ctp::Coord2& center, ctp::gFloat radius) {
+	const std::uint32_t index(static_cast<std::uint32_t>(centers_.size()));
+	const std::size_t cell(static_cast<std::size_t>(_row(center.y)) * cols_ + _col(center.x));
+	centers_.push_back(center);
+	radii_.push_back(radius);
+	next_.push_back(cell_head_[cell]);
+	cell_head_[cell] = index;
+	active_.push_back(index);
+	max_radius_ = std::max(max_radius_, radius);
+}
+
+bool ShapePlacer::_inside(const ctp::Coord2& point) const {
+	return point.x >= region_.x && point.x <= region_.x + region_.w && point.y >= region_.y && point.y <= region_.y + region_.h;
+}
+// Circles outside the region are kept in its border cells.
+std::int32_t ShapePlacer::_col(ctp::gFloat x) const {
+	return static_cast<std::int32_t>(std::clamp(std::floor((x - region_.x) / cell_size_), ctp::gFloat(0), static_cast<ctp::gFloat>(cols_ - 1)));
+}
+std::int32_t ShapePlacer::_row(ctp::gFloat y) const {
+	return static_cast<std::int32_t>(std::clamp(std::floor((y - region_.y) / cell_size_), ctp::gFloat(0), static_cast<ctp::gFloat>(rows_ - 1)));
+}
+}
@@ -0,0 +1,69 @@
+#ifndef INCLUDE_GAME_SHAPE_PLACER_HPP
+#define INCLUDE_GAME_SHAPE_PLACER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <Geometry2D/Geometry.hpp>
+
+// Places shapes in a region without overlapping each other, by Poisson disk sampling with a radius per shape (after Bridson).
+// Each shape is placed as its bounding circle, and candidates are only checked against the circles in nearby cells of a uniform grid,
+// so each placement takes about the same time however many shapes are already placed.
+// A few candidates are tried anywhere in the region first, which spreads sparse scenes evenly over it.
+// After that, candidates are tried in a ring just outside the newest circle on the active list, which keeps the search near
+// recently placed circles in memory. A circle with no room found around it in ATTEMPTS tries is dropped from the list.
+// Once the list is empty the region is saturated: place() returns false rather than searching forever.
+// Circles are dropped whatever size was being placed, so when a region is nearly full a small shape may be turned away
+// while there's still a little room for it.
+// Circles' centers are kept inside the region. The shapes can reach outside it, as with the examples' random placement.
+
+namespace game {
+class ShapePlacer {
+public:
+	static const std::size_t RANDOM_ATTEMPTS; // Candidates tried anywhere in the region before trying around active circles.
+	static const std::size_t ATTEMPTS;        // Candidates tried around an active circle before dropping it.
+
+	// cellSize should be around the diameter of a typical shape.
+	ShapePlacer(const ctp::Rect& region, ctp::gFloat cellSize);
+
+	// Forget every circle, to place into the region again.
+	void clear();
+
+	// Find room for a shape, returning the position to put it at. Returns false if the region is saturated.
+	bool place(ctp::ConstShapeRef shape, ctp::Coord2& out_position);
+	// The same, for a shape given by its bounding circle relative to its position.
+	bool place(const ctp::Circle& bounds, ctp::Coord2& out_position);
+	// Find room for a circle. Returns false if the region is saturated.
+	bool placeCircle(ctp::gFloat radius, ctp::Coord2& out_center);
+	// Reserve a shape that's already placed, e.g. from a loaded scene. It may overlap others.
+	void add(ctp::ConstShapeRef shape, const ctp::Coord2& position);
+	// The same, by the circle around a shape's bounding box, for when the shape itself isn't at hand, e.g. in a scene file.
+	void addBounds(const ctp::Rect& bounds);
+
+	// Check whether a circle is clear of every placed circle (touching counts as overlapping).
+	bool isClear(const ctp::Coord2& center, ctp::gFloat radius) const;
+	bool isSaturated() const { return active_.empty() && !centers_.empty(); }
+	std::size_t size() const { return centers_.size(); }
+
+private:
+	static const std::uint32_t NONE;
+
+	ctp::Rect region_;
+	ctp::gFloat cell_size_;
+	std::int32_t cols_, rows_;
+	ctp::gFloat max_radius_{0};
+
+	std::vector<ctp::Coord2> centers_;
+	std::vector<ctp::gFloat> radii_;
+	std::vector<std::uint32_t> next_;       // The next circle in the same cell.
+	std::vector<std::uint32_t> cell_head_;  // The first circle in each cell.
+	std::vector<std::uint32_t> active_;     // Circles that may still have room around them.
+
+	void _add_circle(const ctp::Coord2& center, ctp::gFloat radius);
+	bool _inside(const ctp::Coord2& point) const;
+	std::int32_t _col(ctp::gFloat x) const;
+	std::int32_t _row(ctp::gFloat y) const;
+};
+}
+
+#endif // INCLUDE_GAME_SHAPE_PLACER_HPP
@@ -0,0 +1,49 @@
+#ifndef INCLUDE_GAME_SHAPE_UTIL_HPP
+#define INCLUDE_GAME_SHAPE_UTIL_HPP
+
+#include <algorithm>
+#include <cmath>
+
+#include <Geometry2D/Geometry.hpp>
+
+#include "Bounds.hpp"
+
+namespace game {
+// Copy a referenced shape into a container of its own.
+inline ctp::ShapeContainer copyShape(ctp::ConstShapeRef shape) {
+	switch (shape.type()) {
+	case ctp::ShapeType::POLYGON:
+		return ctp::ShapeContainer(shape.poly());
+	case ctp::ShapeType::CIRCLE:
+		return ctp::ShapeContainer(shape.circle());
+	case ctp::ShapeType::RECTANGLE:
+	default:
+		return ctp::ShapeContainer(shape.rect());
+	}
+}
+// Get a circle containing a shape, relative to its position.
+inline ctp::Circle getBoundingCircle(ctp::ConstShapeRef shape) {
+	switch (shape.type()) {
+	case ctp::ShapeType::CIRCLE:
+		return shape.circle();
+	case ctp::ShapeType::POLYGON: {
+		// Centred on the bounds, reaching the furthest vertex.
+		const ctp::Polygon& p(shape.poly());
+		const ctp::Coord2 center(getBounds(shape, ctp::Coord2(0, 0)).center());
+		ctp::gFloat radius2(0);
+		for (std::size_t i = 0; i < p.size(); ++i) {
+			const ctp::Coord2 d(p[i] - center);
+			radius2 = std::max(radius2, d.x * d.x + d.y * d.y);
+		}
+		return ctp::Circle(center, std::sqrt(radius2));
+	}
+	case ctp::ShapeType::RECTANGLE:
+	default: {
+		const ctp::Rect& r(shape.rect());
+		return ctp::Circle(ctp::Coord2(r.x + r.w / 2, r.y + r.h / 2), std::sqrt(r.w * r.w + r.h * r.h) / 2);
+	}
+	}
+}
+}
+
+#endif // INCLUDE_GAME_SHAPE_UTIL_HPP
@@ -3,32 +3,50 @@
 
 #include <Geometry2D/Geometry.hpp>
 
+#include "Bounds.hpp"
+#include "ObstacleMap.hpp"
+
 // Extremely simple CollisionMap implementation: no data structure speedup at all.
+// Obstacles are only culled by a bounding box test (see ObstacleMap::setSweptCulling).
 
 namespace game {
-class SimpleCollisionMap : public ctp::CollisionMap {
+class SimpleCollisionMap : public ObstacleMap {
 public:
-	std::vector<ctp::Collidable*> obstacles;
+	std::vector<PreparedWall*> obstacles;
 	~SimpleCollisionMap() override {
 		clear();
 	}
-	const std::vector<ctp::Collidable*> getColliding(const ctp::Collidable&, ctp::Coord2) const override {
-		return std::vector<ctp::Collidable*>(obstacles.begin(), obstacles.end());
+	const std::vector<ctp::Collidable*> getColliding(const ctp::Collidable& collidable, ctp::Coord2 delta) const override {
+		++stats_.queries;
+		const ctp::Rect swept(sweepBounds(getQueryBounds(collidable), delta));
+		std::vector<ctp::Collidable*> colliding;
+		for (std::size_t i = 0; i < obstacles.size(); ++i) {
+			if (_keep_candidate(bounds_[i], swept))
+				obstacles[i]->collect(swept, colliding);
+		}
+		return colliding;
 	}
-	void add(ctp::Collidable* collidable) {
+	void add(PreparedWall* collidable) override {
 		obstacles.push_back(collidable);
+		bounds_.push_back(collidable->getBounds());
 	}
-	ctp::Collidable* operator[](std::size_t index) const {
+	PreparedWall* operator[](std::size_t index) const override {
 		return obstacles[index];
 	}
-	std::size_t size() const {
+	std::size_t size() const override {
 		return obstacles.size();
 	}
-	void clear() {
+	void clear() override {
 		for (std::size_t i = 0; i < obstacles.size(); ++i)
 			delete obstacles[i];
 		obstacles.clear();
+		bounds_.clear();
+	}
+	void refit(std::size_t index, const ctp::Coord2&) override {
+		bounds_[index] = obstacles[index]->getBounds();
 	}
+private:
+	std::vector<ctp::Rect> bounds_; // Bounding box of each obstacle.
 };
 }
 
@@ -0,0 +1,131 @@
+#include "SweepAndPrune.hpp"
+
+#include <algorithm>
+
+#include "Bounds.hpp"
+
+namespace game {
+const std::size_t SweepAndPrune::FULL_SORT_ADDS = 64;
+const std::size_t SweepAndPrune::BODIES_PER_TASK = 1024;
+const std::size_t SweepAndPrune::PAIRS_PER_TASK = 1024;
+
+std::uint32_t SweepAndPrune::add(const PreparedWall* body) {
+	body->prepare();
+	std::uint32_t proxy;
+	if (free_.empty()) {
+		proxy = static_cast<std::uint32_t>(bodies_.size());
+		bodies_.push_back(body);
+	} else {
+		proxy = free_.back();
+		free_.pop_back();
+		bodies_[proxy] = body;
+	}
+	added_.push_back(proxy);
+	return proxy;
+}
+
+bool SweepAndPrune::remove(std::uint32_t proxy) {
+	if (proxy >= bodies_.size() || !bodies_[proxy])
+		return false;
+	bodies_[proxy] = nullptr;
+	// The id can't be reused until the sweep has taken it out of the entries.
+	removed_.push_back(proxy);
+	return true;
+}
+
+void SweepAndPrune::clear() {
+	bodies_.clear();
+	free_.clear();
+	removed_.clear();
+	added_.clear();
+	entries_.clear();
+	candidates_.clear();
+}
+
+void SweepAndPrune::findPairs(ThreadPool& pool, std::vector<OverlapPair>& out_pairs) {
+	stats_ = Stats();
+	const bool fullSort(added_.size() > FULL_SORT_ADDS);
+	_update_entries();
+
+	// Refresh every entry's bounds in place, keeping last step's order.
+	pool.parallelFor(entries_.size(), BODIES_PER_TASK, [this](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			const ctp::Rect b(bodies_[entries_[i].proxy]->getBounds());
+			entries_[i] = Entry{b.x, b.x + b.w, b.y, b.y + b.h, entries_[i].proxy};
+		}
+	});
+	const auto byMinX = [](const Entry& a, const Entry& b) { return a.minX < b.minX; };
+	if (fullSort) {
+		std::sort(entries_.begin(), entries_.end(), byMinX);
+	} else {
+		// Insertion sort, which is close to linear when few bodies have passed each other since the last step.
+		for (std::size_t i = 1; i < entries_.size(); ++i) {
+			if (!byMinX(entries_[i], entries_[i - 1]))
+				continue;
+			const Entry entry(entries_[i]);
+			std::size_t j(i);
+			for (; j > 0 && byMinX(entry, entries_[j - 1]); --j)
+				entries_[j] = entries_[j - 1];
+			entries_[j] = entry;
+			stats_.moves += i - j;
+		}
+	}
+	stats_.bodies = entries_.size();
+	stats_.fullSort = fullSort;
+
+	// Sweep, with each chunk of bodies writing the candidates it finds to its own list.
+	const std::size_t numChunks((entries_.size() + BODIES_PER_TASK - 1) / BODIES_PER_TASK);
+	if (chunk_candidates_.size() < numChunks)
+		chunk_candidates_.resize(numChunks);
+	pool.parallelFor(entries_.size(), BODIES_PER_TASK, [this](std::size_t begin, std::size_t end) { _sweep(begin, end); });
+	candidates_.clear();
+	for (std::size_t c = 0; c < numChunks; ++c)
+		candidates_.insert(candidates_.end(), chunk_candidates_[c].begin(), chunk_candidates_[c].end());
+	stats_.candidates = candidates_.size();
+
+	// Check the candidates' shapes.
+	overlapping_.resize(candidates_.size());
+	pool.parallelFor(candidates_.size(), PAIRS_PER_TASK, [this](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			const PreparedWall& a(*bodies_[candidates_[i].a]);
+			const PreparedWall& b(*bodies_[candidates_[i].b]);
+			overlapping_[i] = a.overlaps(b);
+		}
+	});
+	out_pairs.clear();
+	for (std::size_t i = 0; i < candidates_.size(); ++i) {
+		if (overlapping_[i])
+			out_pairs.push_back(candidates_[i]);
+	}
+	stats_.pairs = out_pairs.size();
+}
+
+void SweepAndPrune::_update_entries() {
+	if (!removed_.empty()) {
+		entries_.erase(std::remove_if(entries_.begin(), entries_.end(), [this](const Entry& e) { return !bodies_[e.proxy]; }), entries_.end());
+		free_.insert(free_.end(), removed_.begin(), removed_.end());
+		removed_.clear();
+	}
+	// New entries go on the end, and are sorted into place with the rest once their bounds are read.
+	for (std::uint32_t proxy : added_) {
+		if (bodies_[proxy]) // Not removed again before the sweep.
+			entries_.push_back(Entry{0, 0, 0, 0, proxy});
+	}
+	added_.clear();
+}
+
+void SweepAndPrune::_sweep(std::size_t begin, std::size_t end) {
+	std::vector<OverlapPair>& out(chunk_candidates_[begin / BODIES_PER_TASK]);
+	out.clear();
+	const std::size_t numEntries(entries_.size());
+	for (std::size_t i = begin; i < end; ++i) {
+		const Entry& a(entries_[i]);
+		// Entries are sorted by left edge, so once one starts right of a's right edge, so do all the rest.
+		for (std::size_t j = i + 1; j < numEntries && entries_[j].minX <= a.maxX; ++j) {
+			const Entry& b(entries_[j]);
+			if (a.minY <= b.maxY && b.minY <= a.maxY)
+				out.push_back(a.proxy < b.proxy ? OverlapPair{a.proxy, b.proxy} : OverlapPair{b.proxy, a.proxy});
+		}
+	}
+}
+}
@@ -0,0 +1,78 @@
+#ifndef INCLUDE_GAME_SWEEP_AND_PRUNE_HPP
+#define INCLUDE_GAME_SWEEP_AND_PRUNE_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <Geometry2D/Geometry.hpp>
+
+#include "PreparedShape.hpp"
+#include "../ThreadPool.hpp"
+
+// Finds every pair of bodies whose shapes overlap, out of a large set of moving bodies.
+// Bodies' bounds are kept sorted by their left edge. Bodies only move a little each step, so the order barely changes,
+// and an insertion sort puts it right again in close to linear time.
+// A sweep then checks each body against the bodies after it until their left edges pass its right edge,
+// and the candidate pairs whose boxes overlap are checked with PreparedWall::overlaps, which tries their prepared shapes before ctp::overlaps.
+// The sweep and the overlap checks are spread over a thread pool. Each chunk writes its own output,
+// and the outputs are joined in order, so the pairs come out in the same order on any number of threads.
+
+namespace game {
+// Two overlapping bodies, by proxy id. a is less than b.
+struct OverlapPair {
+	std::uint32_t a, b;
+
+	bool operator==(const OverlapPair& o) const { return a == o.a && b == o.b; }
+	bool operator<(const OverlapPair& o) const { return a < o.a || (a == o.a && b < o.b); }
+};
+
+class SweepAndPrune {
+public:
+	static const std::size_t FULL_SORT_ADDS;   // Sort from scratch rather than by insertion when more bodies than this were added.
+	static const std::size_t BODIES_PER_TASK;  // Bodies in each chunk of the sweep.
+	static const std::size_t PAIRS_PER_TASK;   // Candidate pairs in each chunk of the overlap checks.
+
+	struct Stats {
+		std::size_t bodies{0};
+		std::size_t moves{0};      // Places bodies were moved by the insertion sort.
+		bool fullSort{false};
+		std::size_t candidates{0}; // Pairs whose boxes overlap.
+		std::size_t pairs{0};      // Pairs whose shapes overlap.
+	};
+
+	// Add a body, returning its proxy id. The body isn't copied, and must stay alive until it's removed.
+	// Ids of removed bodies are reused.
+	std::uint32_t add(const PreparedWall* body);
+	// Returns false if the id isn't in use.
+	bool remove(std::uint32_t proxy);
+	void clear();
+	std::size_t size() const { return bodies_.size() - free_.size() - removed_.size(); }
+	const PreparedWall* getBody(std::uint32_t proxy) const { return bodies_[proxy]; }
+
+	// Read every body's bounds where it is now, and put the pairs whose shapes overlap into out_pairs.
+	// Bodies are read from the pool's threads, so they mustn't change until this returns.
+	void findPairs(ThreadPool& pool, std::vector<OverlapPair>& out_pairs);
+	const Stats& getStats() const { return stats_; }
+
+private:
+	struct Entry {
+		ctp::gFloat minX, maxX, minY, maxY;
+		std::uint32_t proxy;
+	};
+
+	std::vector<const PreparedWall*> bodies_; // By proxy id. Null for free ids.
+	std::vector<std::uint32_t> free_;
+	std::vector<std::uint32_t> removed_;         // Removed since the last sweep, so still in entries_.
+	std::vector<std::uint32_t> added_;           // Added since the last sweep, so not in entries_ yet.
+	std::vector<Entry> entries_;                 // Sorted by minX.
+	std::vector<std::vector<OverlapPair>> chunk_candidates_;
+	std::vector<OverlapPair> candidates_;
+	std::vector<std::uint8_t> overlapping_;
+	Stats stats_;
+
+	void _update_entries();
+	void _sweep(std::size_t begin, std::size_t end);
+};
+}
+
+#endif // INCLUDE_GAME_SWEEP_AND_PRUNE_HPP
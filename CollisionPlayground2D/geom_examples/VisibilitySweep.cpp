@@ -0,0 +1,376 @@
+#include "VisibilitySweep.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Bounds.hpp"
+
+namespace game {
+namespace {
+constexpr ctp::gFloat PI = ctp::constants::PI;
+constexpr ctp::gFloat TAU = ctp::constants::TAU;
+constexpr ctp::gFloat MIN_ARC_ANGLE = 1e-5f;  // Circle splits closer together than this are merged.
+constexpr ctp::gFloat MIN_VERTEX_GAP2 = 1e-6f; // Squared distance under which consecutive polygon vertices are merged.
+constexpr ctp::gFloat ARC_STEP = 0.1f;         // Most angle around a circle between the vertices along a visible arc.
+
+ctp::gFloat cross(const ctp::Coord2& a, const ctp::Coord2& b) {
+	return a.x * b.y - a.y * b.x;
+}
+ctp::gFloat dot(const ctp::Coord2& a, const ctp::Coord2& b) {
+	return a.x * b.x + a.y * b.y;
+}
+ctp::gFloat angleOf(const ctp::Coord2& v) {
+	return std::atan2(v.y, v.x);
+}
+ctp::Coord2 onCircle(const ctp::Coord2& center, ctp::gFloat radius, ctp::gFloat angle) {
+	return ctp::Coord2(center.x + radius * std::cos(angle), center.y + radius * std::sin(angle));
+}
+}
+
+const std::uint32_t VisibilitySweep::NONE = std::numeric_limits<std::uint32_t>::max();
+const ctp::gFloat VisibilitySweep::SPLIT_EPSILON = 1e-5f;
+
+void VisibilitySweep::clear() {
+	outlines_.clear();
+	edges_.clear();
+	circles_.clear();
+	segments_.clear();
+	arcs_.clear();
+}
+
+void VisibilitySweep::addShape(ctp::ConstShapeRef shape, const ctp::Coord2& position) {
+	switch (shape.type()) {
+	case ctp::ShapeType::RECTANGLE: {
+		const ctp::Rect& r(shape.rect());
+		const ctp::gFloat left(r.x + position.x), top(r.y + position.y);
+		addPolygon({ctp::Coord2(left, top), ctp::Coord2(left + r.w, top), ctp::Coord2(left + r.w, top + r.h), ctp::Coord2(left, top + r.h)});
+		break;
+	}
+	case ctp::ShapeType::POLYGON: {
+		const ctp::Polygon& p(shape.poly());
+		std::vector<ctp::Coord2> vertices(p.size());
+		for (std::size_t i = 0; i < p.size(); ++i)
+			vertices[i] = p[i] + position;
+		addPolygon(vertices);
+		break;
+	}
+	case ctp::ShapeType::CIRCLE:
+		addCircle(shape.circle().center + position, shape.circle().radius);
+		break;
+	default:
+		break;
+	}
+}
+void VisibilitySweep::addPolygon(const std::vector<ctp::Coord2>& vertices) {
+	const std::size_t size(vertices.size());
+	if (size < 3)
+		return;
+	ctp::gFloat area(0);
+	for (std::size_t i = 0, k = size - 1; i < size; k = i++)
+		area += cross(vertices[k], vertices[i]);
+	const std::uint32_t first(static_cast<std::uint32_t>(edges_.size()));
+	for (std::size_t i = 0, k = size - 1; i < size; k = i++) {
+		if (area > 0) // Keep the polygon on the left of its edges.
+			edges_.push_back(Segment{vertices[k], vertices[i]});
+		else
+			edges_.push_back(Segment{vertices[size - 1 - k], vertices[size - 1 - i]});
+	}
+	_add_outline(first, static_cast<std::uint32_t>(size));
+}
+void VisibilitySweep::addCircle(const ctp::Coord2& center, ctp::gFloat radius) {
+	if (radius <= 0)
+		return;
+	circles_.push_back(Circle{center, radius});
+	outlines_.push_back(Outline{ctp::Rect(center.x - radius, center.y - radius, radius * 2, radius * 2),
+		static_cast<std::uint32_t>(circles_.size() - 1), 0});
+}
+void VisibilitySweep::_add_outline(std::uint32_t first, std::uint32_t count) {
+	ctp::gFloat left(edges_[first].a.x), right(left), top(edges_[first].a.y), bottom(top);
+	for (std::uint32_t i = first; i < first + count; ++i) {
+		left = std::min(left, edges_[i].a.x);
+		right = std::max(right, edges_[i].a.x);
+		top = std::min(top, edges_[i].a.y);
+		bottom = std::max(bottom, edges_[i].a.y);
+	}
+	outlines_.push_back(Outline{ctp::Rect(left, top, right - left, bottom - top), first, count});
+}
+
+void VisibilitySweep::build() {
+	// The bounds are an outline too, wound with the solid side outside them, so obstacles reaching past them split them.
+	// They are only added while building.
+	const std::size_t numEdges(edges_.size()), numOutlines(outlines_.size());
+	const ctp::Coord2 topLeft(bounds_.x, bounds_.y), topRight(bounds_.x + bounds_.w, bounds_.y);
+	const ctp::Coord2 botLeft(bounds_.x, bounds_.y + bounds_.h), botRight(bounds_.x + bounds_.w, bounds_.y + bounds_.h);
+	edges_.push_back(Segment{topLeft, botLeft});
+	edges_.push_back(Segment{botLeft, botRight});
+	edges_.push_back(Segment{botRight, topRight});
+	edges_.push_back(Segment{topRight, topLeft});
+	outlines_.push_back(Outline{bounds_, static_cast<std::uint32_t>(numEdges), 4});
+
+	// Sweep the outlines' bounds along x to find the pairs that may cross.
+	std::vector<std::uint32_t> order(outlines_.size());
+	for (std::uint32_t i = 0; i < order.size(); ++i)
+		order[i] = i;
+	std::sort(order.begin(), order.end(), [this](std::uint32_t lhs, std::uint32_t rhs) { return outlines_[lhs].bounds.x < outlines_[rhs].bounds.x; });
+	edge_splits_.clear();
+	circle_splits_.clear();
+	for (std::size_t i = 0; i < order.size(); ++i) {
+		const Outline& outline(outlines_[order[i]]);
+		const ctp::gFloat right(outline.bounds.x + outline.bounds.w);
+		for (std::size_t j = i + 1; j < order.size() && outlines_[order[j]].bounds.x <= right; ++j) {
+			if (boundsOverlap(outline.bounds, outlines_[order[j]].bounds))
+				_split(outline, outlines_[order[j]]);
+		}
+	}
+	_cut_edges();
+	_cut_circles();
+	edges_.resize(numEdges);
+	outlines_.resize(numOutlines);
+	stats_.segments = segments_.size();
+	stats_.arcs = arcs_.size();
+}
+void VisibilitySweep::_split(const Outline& lhs, const Outline& rhs) {
+	if (lhs.count > 0 && rhs.count > 0) {
+		for (std::uint32_t i = lhs.first; i < lhs.first + lhs.count; ++i) {
+			for (std::uint32_t j = rhs.first; j < rhs.first + rhs.count; ++j)
+				_split_edges(i, j);
+		}
+	} else if (lhs.count > 0) {
+		for (std::uint32_t i = lhs.first; i < lhs.first + lhs.count; ++i)
+			_split_edge_circle(i, rhs.first);
+	} else if (rhs.count > 0) {
+		for (std::uint32_t i = rhs.first; i < rhs.first + rhs.count; ++i)
+			_split_edge_circle(i, lhs.first);
+	} else {
+		_split_circles(lhs.first, rhs.first);
+	}
+}
+void VisibilitySweep::_split_edges(std::uint32_t lhs, std::uint32_t rhs) {
+	const Segment& l(edges_[lhs]);
+	const Segment& r(edges_[rhs]);
+	const ctp::Coord2 dl(l.b - l.a), dr(r.b - r.a), offset(r.a - l.a);
+	const ctp::gFloat denom(cross(dl, dr));
+	if (denom == 0) // Parallel. Overlapping collinear edges are the same distance away, so they don't need splitting.
+		return;
+	const ctp::gFloat t(cross(offset, dr) / denom), u(cross(offset, dl) / denom);
+	if (t < 0 || t > 1 || u < 0 || u > 1)
+		return;
+	// Where one edge ends on the other, only the other is split.
+	if (t > SPLIT_EPSILON && t < 1 - SPLIT_EPSILON)
+		edge_splits_.emplace_back(lhs, t);
+	if (u > SPLIT_EPSILON && u < 1 - SPLIT_EPSILON)
+		edge_splits_.emplace_back(rhs, u);
+}
+void VisibilitySweep::_split_edge_circle(std::uint32_t edge, std::uint32_t circle) {
+	const Segment& s(edges_[edge]);
+	const Circle& c(circles_[circle]);
+	const ctp::Coord2 d(s.b - s.a), f(s.a - c.center);
+	const ctp::gFloat a(dot(d, d)), b(dot(f, d)), k(dot(f, f) - c.radius * c.radius);
+	const ctp::gFloat disc(b * b - a * k);
+	if (a == 0 || disc <= 0) // A tangent edge only touches.
+		return;
+	const ctp::gFloat root(std::sqrt(disc));
+	for (const ctp::gFloat t : {(-b - root) / a, (-b + root) / a}) {
+		if (t < 0 || t > 1)
+			continue;
+		if (t > SPLIT_EPSILON && t < 1 - SPLIT_EPSILON)
+			edge_splits_.emplace_back(edge, t);
+		circle_splits_.emplace_back(circle, angleOf(f + d * t));
+	}
+}
+void VisibilitySweep::_split_circles(std::uint32_t lhs, std::uint32_t rhs) {
+	const Circle& l(circles_[lhs]);
+	const Circle& r(circles_[rhs]);
+	const ctp::Coord2 between(r.center - l.center);
+	const ctp::gFloat dist(std::sqrt(dot(between, between)));
+	if (dist == 0 || dist >= l.radius + r.radius || dist <= std::abs(l.radius - r.radius))
+		return;
+	const ctp::gFloat along((l.radius * l.radius - r.radius * r.radius + dist * dist) / (2 * dist));
+	const ctp::gFloat across(std::sqrt(std::max(l.radius * l.radius - along * along, 0.0f)));
+	const ctp::Coord2 dir(between * (1 / dist));
+	const ctp::Coord2 mid(l.center + dir * along), perp(-dir.y, dir.x);
+	for (const ctp::Coord2& point : {mid + perp * across, mid - perp * across}) {
+		circle_splits_.emplace_back(lhs, angleOf(point - l.center));
+		circle_splits_.emplace_back(rhs, angleOf(point - r.center));
+	}
+}
+void VisibilitySweep::_cut_edges() {
+	std::sort(edge_splits_.begin(), edge_splits_.end());
+	segments_.clear();
+	std::size_t split(0);
+	for (std::uint32_t i = 0; i < edges_.size(); ++i) {
+		const Segment& edge(edges_[i]);
+		ctp::Coord2 start(edge.a);
+		ctp::gFloat last(0);
+		for (; split < edge_splits_.size() && edge_splits_[split].first == i; ++split) {
+			const ctp::gFloat t(edge_splits_[split].second);
+			if (t - last < SPLIT_EPSILON)
+				continue;
+			const ctp::Coord2 end(edge.a + (edge.b - edge.a) * t);
+			segments_.push_back(Segment{start, end});
+			start = end;
+			last = t;
+		}
+		segments_.push_back(Segment{start, edge.b});
+	}
+}
+void VisibilitySweep::_cut_circles() {
+	std::sort(circle_splits_.begin(), circle_splits_.end());
+	arcs_.clear();
+	std::vector<ctp::gFloat> angles;
+	std::size_t split(0);
+	for (std::uint32_t i = 0; i < circles_.size(); ++i) {
+		angles.clear();
+		for (; split < circle_splits_.size() && circle_splits_[split].first == i; ++split) {
+			if (angles.empty() || circle_splits_[split].second - angles.back() >= MIN_ARC_ANGLE)
+				angles.push_back(circle_splits_[split].second);
+		}
+		if (angles.size() > 1 && angles.front() + TAU - angles.back() < MIN_ARC_ANGLE)
+			angles.pop_back();
+		if (angles.empty()) {
+			arcs_.push_back(Arc{i, -PI, PI});
+			continue;
+		}
+		for (std::size_t k = 1; k < angles.size(); ++k)
+			arcs_.push_back(Arc{i, angles[k - 1], angles[k]});
+		arcs_.push_back(Arc{i, angles.back(), angles.front() + TAU}); // Around past the angles' wrap.
+	}
+}
+
+bool VisibilitySweep::compute(const ctp::Coord2& origin, std::vector<ctp::Coord2>& out_polygon) {
+	out_polygon.clear();
+	if (origin.x <= bounds_.x || origin.y <= bounds_.y || origin.x >= bounds_.x + bounds_.w || origin.y >= bounds_.y + bounds_.h)
+		return false;
+	origin_ = origin;
+	elements_.clear();
+	for (const Segment& s : segments_) {
+		if (cross(s.b - s.a, origin - s.a) < 0) // The origin is outside the obstacle.
+			_add_element(s.a, s.b, s.a, s.b, 0);
+	}
+	for (const Arc& arc : arcs_) {
+		// The near side of the circle, between the tangents from the origin.
+		const Circle& c(circles_[arc.circle]);
+		const ctp::Coord2 toOrigin(origin - c.center);
+		const ctp::gFloat dist2(dot(toOrigin, toOrigin));
+		if (dist2 <= c.radius * c.radius)
+			continue;
+		const ctp::gFloat mid(angleOf(toOrigin)), half(std::acos(c.radius / std::sqrt(dist2)));
+		for (const ctp::gFloat shift : {-TAU, 0.0f, TAU}) {
+			const ctp::gFloat start(std::max(arc.start, mid - half + shift)), end(std::min(arc.end, mid + half + shift));
+			if (start < end)
+				_add_element(onCircle(c.center, c.radius, start), onCircle(c.center, c.radius, end), c.center, c.center, c.radius);
+		}
+	}
+	stats_.facing = elements_.size();
+
+	events_.clear();
+	for (std::uint32_t i = 0; i < elements_.size(); ++i) {
+		events_.push_back(Event{elements_[i].start, i, false});
+		events_.push_back(Event{elements_[i].end, i, true});
+	}
+	std::sort(events_.begin(), events_.end(), [](const Event& lhs, const Event& rhs) { return lhs.angle < rhs.angle; });
+
+	// Each batch of events at the same angle ends elements, then starts them. Only then is the closest one looked at,
+	// so a vertex shared by two elements isn't mistaken for a change of the visible element.
+	ActiveSet active(CloserElement{this});
+	handles_.resize(elements_.size());
+	std::uint32_t visible(NONE);
+	const auto addPoint = [&](const ctp::Coord2& vertex) {
+		if (out_polygon.empty() || dot(vertex - out_polygon.back(), vertex - out_polygon.back()) > MIN_VERTEX_GAP2)
+			out_polygon.push_back(vertex);
+	};
+	const auto pointOn = [&](std::uint32_t element, ctp::gFloat angle) {
+		const ctp::Coord2 dir(std::cos(angle), std::sin(angle));
+		return origin + dir * _distance(elements_[element], dir);
+	};
+	for (std::size_t i = 0; i < events_.size();) {
+		const ctp::gFloat angle(events_[i].angle);
+		std::size_t end(i);
+		for (; end < events_.size() && events_[end].angle == angle; ++end) {
+			if (events_[end].isEnd)
+				active.erase(handles_[events_[end].element]);
+		}
+		for (; i < end; ++i) {
+			if (!events_[i].isEnd)
+				handles_[events_[i].element] = active.insert(events_[i].element).first;
+		}
+		const std::uint32_t closest(active.empty() ? NONE : *active.begin());
+		if (closest != visible) {
+			if (visible != NONE) {
+				const ctp::Coord2 end(pointOn(visible, angle));
+				const Element& e(elements_[visible]);
+				if (e.radius > 0 && !out_polygon.empty()) {
+					// Follow the curve from the last vertex, where it became visible. The near side is less than half the circle.
+					const ctp::gFloat from(angleOf(out_polygon.back() - e.a));
+					ctp::gFloat turn(angleOf(end - e.a) - from);
+					turn += turn > PI ? -TAU : turn < -PI ? TAU : 0;
+					const int steps(static_cast<int>(std::ceil(std::abs(turn) / ARC_STEP)));
+					for (int step = 1; step < steps; ++step)
+						addPoint(onCircle(e.a, e.radius, from + turn * step / steps));
+				}
+				addPoint(end);
+			}
+			if (closest != NONE)
+				addPoint(pointOn(closest, angle));
+			visible = closest;
+		}
+	}
+	// The sweep starts and ends on the same ray.
+	if (out_polygon.size() > 1 && dot(out_polygon.back() - out_polygon.front(), out_polygon.back() - out_polygon.front()) <= MIN_VERTEX_GAP2)
+		out_polygon.pop_back();
+	return true;
+}
+void VisibilitySweep::_add_element(ctp::Coord2 p0, ctp::Coord2 p1, const ctp::Coord2& a, const ctp::Coord2& b, ctp::gFloat radius) {
+	const ctp::gFloat turn(cross(p0 - origin_, p1 - origin_));
+	if (turn == 0) // Edge on to the origin.
+		return;
+	if (turn < 0)
+		std::swap(p0, p1);
+	const ctp::Coord2 d0(p0 - origin_), d1(p1 - origin_);
+	const ctp::gFloat start(angleOf(d0)), end(angleOf(d1));
+	const ctp::Coord2 startDir(d0 * (1 / std::sqrt(dot(d0, d0)))), endDir(d1 * (1 / std::sqrt(dot(d1, d1))));
+	if (start < end) {
+		elements_.push_back(Element{a, b, radius, start, end, startDir, endDir});
+	} else if (start - end > PI) { // Across the angles' wrap, so it's split there.
+		if (start < PI)
+			elements_.push_back(Element{a, b, radius, start, PI, startDir, ctp::Coord2(-1, 0)});
+		if (end > -PI)
+			elements_.push_back(Element{a, b, radius, -PI, end, ctp::Coord2(-1, 0), endDir});
+	}
+}
+ctp::gFloat VisibilitySweep::_distance(const Element& element, const ctp::Coord2& dir) const {
+	if (element.radius > 0) { // Where the ray enters the circle.
+		const ctp::Coord2 toCenter(element.a - origin_);
+		const ctp::gFloat along(dot(dir, toCenter));
+		const ctp::gFloat disc(along * along - dot(toCenter, toCenter) + element.radius * element.radius);
+		return along - std::sqrt(std::max(disc, 0.0f));
+	}
+	const ctp::Coord2 edge(element.b - element.a), toA(element.a - origin_);
+	const ctp::gFloat denom(cross(dir, edge));
+	if (denom == 0) { // Along the edge: its nearest end.
+		const ctp::Coord2 toB(element.b - origin_);
+		return std::sqrt(std::min(dot(toA, toA), dot(toB, toB)));
+	}
+	return cross(toA, edge) / denom;
+}
+
+bool VisibilitySweep::CloserElement::operator()(std::uint32_t lhs, std::uint32_t rhs) const {
+	if (lhs == rhs)
+		return false;
+	// Pieces don't cross, so their order is the same wherever both are under the sweep. The middle of that range is
+	// compared rather than the sweep's angle, as pieces that touch where they start or end are the same distance away there.
+	// The halfway direction is found from the unit vectors at the ends of the range, which is less than half a turn.
+	// It's found the same way whichever way round the pair is, so swapping them always flips the result.
+	const Element& l(sweep->elements_[lhs]);
+	const Element& r(sweep->elements_[rhs]);
+	const Element& first(lhs < rhs ? l : r);
+	const Element& second(lhs < rhs ? r : l);
+	const ctp::Coord2 mid((first.start >= second.start ? first.startDir : second.startDir) + (first.end <= second.end ? first.endDir : second.endDir));
+	const ctp::Coord2 dir(mid * (1 / std::sqrt(dot(mid, mid))));
+	const ctp::gFloat lDist(sweep->_distance(l, dir)), rDist(sweep->_distance(r, dir));
+	if (lDist != rDist)
+		return lDist < rDist;
+	return lhs < rhs;
+}
+}
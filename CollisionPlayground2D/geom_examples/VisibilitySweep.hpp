@@ -0,0 +1,115 @@
+#ifndef INCLUDE_GAME_VISIBILITY_SWEEP_HPP
+#define INCLUDE_GAME_VISIBILITY_SWEEP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <Geometry2D/Geometry.hpp>
+
+// Finds the exact region visible from a point, as a polygon, with an angular sweep rather than by casting rays.
+// Obstacles are added as outlines: polygon edges and circles. Outlines of overlapping obstacles cross, so build() splits them
+// where they do, finding the crossing pairs by sweeping their bounds. After that, no two pieces cross, only touch,
+// so the order of the pieces along any ray from the origin stays the same for as long as they are both under the sweep.
+// compute() keeps only the pieces facing the origin: edges with the origin outside them, and each circle's near arc between
+// its tangent points. The ends of the pieces, sorted by angle, are the sweep's events. The pieces under the sweep are kept
+// ordered by distance in a balanced tree, and the closest one is the visible one. A polygon vertex is added wherever that changes.
+// With n pieces that is O(n log n) per origin, and the splitting is only redone when the obstacles change.
+
+namespace game {
+class VisibilitySweep {
+public:
+	struct Stats {
+		std::size_t segments{0}; // Edge pieces after splitting.
+		std::size_t arcs{0};     // Circle pieces after splitting.
+		std::size_t facing{0};   // Pieces facing the origin in the last compute.
+	};
+
+	// Forget every outline.
+	void clear();
+	// The visible region never reaches past the bounds, which must contain the origin.
+	void setBounds(const ctp::Rect& bounds) { bounds_ = bounds; }
+	void addShape(ctp::ConstShapeRef shape, const ctp::Coord2& position);
+	// A convex polygon in world space, in either winding.
+	void addPolygon(const std::vector<ctp::Coord2>& vertices);
+	void addCircle(const ctp::Coord2& center, ctp::gFloat radius);
+	// Split the outlines where they cross. Call after adding outlines, before computing.
+	void build();
+
+	// Put the visibility polygon from origin into out_polygon, ordered by angle around the origin.
+	// Obstacles the origin is inside are seen through. Returns false, with an empty polygon, if the origin is outside the bounds.
+	bool compute(const ctp::Coord2& origin, std::vector<ctp::Coord2>& out_polygon);
+
+	const Stats& getStats() const { return stats_; }
+
+private:
+	static const std::uint32_t NONE;
+	static const ctp::gFloat SPLIT_EPSILON; // Crossings closer than this to an end, as a fraction of the edge, don't split it.
+
+	struct Segment {
+		ctp::Coord2 a, b; // The obstacle is on the left, going from a to b.
+	};
+	struct Circle {
+		ctp::Coord2 center;
+		ctp::gFloat radius;
+	};
+	struct Arc {
+		std::uint32_t circle;
+		ctp::gFloat start, end; // Angles around the center, with start < end.
+	};
+	// The edges of one obstacle, or a circle.
+	struct Outline {
+		ctp::Rect bounds;
+		std::uint32_t first, count; // Edges in edges_, or the circle in circles_ if count is 0.
+	};
+	// A piece facing the origin. Segments have no radius. Arcs have their circle's center in a.
+	struct Element {
+		ctp::Coord2 a, b;
+		ctp::gFloat radius;
+		ctp::gFloat start, end; // Angles around the origin it covers, with start < end.
+		ctp::Coord2 startDir, endDir; // Unit vectors at those angles.
+	};
+	// Orders the elements under the sweep by distance from the origin, where both are under it.
+	struct CloserElement {
+		const VisibilitySweep* sweep;
+		bool operator()(std::uint32_t lhs, std::uint32_t rhs) const;
+	};
+	struct Event {
+		ctp::gFloat angle;
+		std::uint32_t element;
+		bool isEnd;
+	};
+	using ActiveSet = std::set<std::uint32_t, CloserElement>;
+
+	ctp::Rect bounds_;
+	std::vector<Outline> outlines_;
+	std::vector<Segment> edges_;
+	std::vector<Circle> circles_;
+	// Built.
+	std::vector<std::pair<std::uint32_t, ctp::gFloat>> edge_splits_;   // Edge and fraction along it.
+	std::vector<std::pair<std::uint32_t, ctp::gFloat>> circle_splits_; // Circle and angle around it.
+	std::vector<Segment> segments_;
+	std::vector<Arc> arcs_;
+	// Computed.
+	ctp::Coord2 origin_;
+	std::vector<Element> elements_;
+	std::vector<Event> events_;
+	std::vector<ActiveSet::iterator> handles_;
+	Stats stats_;
+
+	void _add_outline(std::uint32_t first, std::uint32_t count);
+	void _split(const Outline& lhs, const Outline& rhs);
+	void _split_edges(std::uint32_t lhs, std::uint32_t rhs);
+	void _split_edge_circle(std::uint32_t edge, std::uint32_t circle);
+	void _split_circles(std::uint32_t lhs, std::uint32_t rhs);
+	void _cut_edges();
+	void _cut_circles();
+	void _add_element(ctp::Coord2 p0, ctp::Coord2 p1, const ctp::Coord2& a, const ctp::Coord2& b, ctp::gFloat radius);
+	// Distance from the origin to an element along a ray, given its unit direction.
+	ctp::gFloat _distance(const Element& element, const ctp::Coord2& dir) const;
+};
+}
+
+#endif // INCLUDE_GAME_VISIBILITY_SWEEP_HPP